@@ -19,6 +19,9 @@ TCP_TIMEOUT=30
 UDP_SERVER_PORT=9090
 UDP_TIMEOUT=28
 
+IPC_MSGS=100000
+IPC_MARGIN=10   # --check tolerance, percent
+
 # --- Colors ---
 GREEN='\033[1;32m'
 BLUE='\033[1;34m'
@@ -81,6 +84,8 @@ cleanup() {
     pkill -9 -f bench_udp_mt || true
     pkill -9 -f bench_udp_flood || true
 
+    pkill -9 -f bench_ipc || true
+
     sleep 0.1
 }
 trap cleanup EXIT INT TERM
@@ -128,6 +133,8 @@ fi
 
 run_shm_test() {
     local name="$1" topic="$2" type="$3" writers="${4:-1}" size="${5:-64}"
+    local mode=""
+    [[ "${6:-}" == "inline" ]] && mode="--inline"   # header-only hot path (SWMR)
     
     echo -e "\n${YELLOW}>>> SHM: $name (${type}, W:$writers, ${size}B) ${NC}"
     
@@ -135,7 +142,7 @@ run_shm_test() {
     
     # Subscriber
     pushd "$BENCH_DIR" > /dev/null
-    ./bench_sub "$topic" > "$SUBLOG" 2>&1 &
+    ./bench_sub "$topic" $mode > "$SUBLOG" 2>&1 &
     local sub_pid=$!
     popd > /dev/null
     
@@ -144,7 +151,7 @@ run_shm_test() {
     # Publisher(s)
     pushd "$BENCH_DIR" > /dev/null
     if [[ "$type" == "SWMR" ]]; then
-        run_with_timeout 25 ./bench_pub_swmr "$topic" "$size"
+        run_with_timeout 25 ./bench_pub_swmr "$topic" "$size" $mode
     else
         run_with_timeout 25 ./bench_pub_mwmr "$topic" "$writers" "$size"
     fi
@@ -287,11 +294,34 @@ run_udp_flood_test() {
 }
 
 ###############################################################################
-# 5. Master Execution
+# 5. IPC Baseline Helper
+###############################################################################
+
+run_ipc_test() {
+    echo -e "\n${YELLOW}>>> IPC: USRL vs pipe / unix / eventfd / mq / TCP / UDP ${NC}"
+
+    # Same workloads over every transport; --check fails if USRL falls more
+    # than IPC_MARGIN behind on a cell with a core per process
+    pushd "$BENCH_DIR" > /dev/null
+    local rc=0
+    ./bench_ipc --msgs "$IPC_MSGS" --check --margin "$IPC_MARGIN" || rc=$?
+    if [ "$rc" -eq 0 ]; then
+        echo -e "${GREEN}✓ IPC Baseline Complete${NC}"
+    elif [ "$rc" -eq 3 ]; then
+        echo -e "${YELLOW}! IPC Baseline: check skipped, fewer cores than processes (see above)${NC}"
+    else
+        echo -e "${RED}✗ IPC Baseline: USRL did not lead every cell (see above)${NC}"
+    fi
+    popd > /dev/null
+}
+
+###############################################################################
+# 6. Master Execution
 ###############################################################################
 
 echo -e "\n${BLUE}=== SHM BENCHMARKS ===${NC}"
 run_shm_test "Small Ring"        "small_ring_swmr"   "SWMR" 1 64
+run_shm_test "Small Ring Inline" "small_ring_swmr"   "SWMR" 1 64 inline
 run_shm_test "Large Ring"        "large_ring_swmr"   "SWMR" 1 64  
 run_shm_test "Huge Messages"     "huge_msg_swmr"     "SWMR" 1 8192
 run_shm_test "MWMR Standard"     "mwmr_std"          "MWMR" 4 64
@@ -308,8 +338,11 @@ run_udp_mt_test 4
 run_udp_mt_test 8
 run_udp_flood_test
 
+echo -e "\n${BLUE}=== IPC BASELINE ===${NC}"
+run_ipc_test
+
 ###############################################################################
-# 6. Footer
+# 7. Footer
 ###############################################################################
 
 echo -e "\n"
@@ -0,0 +1,141 @@
+#include "usrl_book.h"
+#include "usrl_core.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+/*
+ * Order book builder throughput, single core.
+ *
+ *  1. apply : usrl_book_apply() over a pre-generated update stream
+ *  2. ring  : publish chunks into a USRL ring and drain them with
+ *             usrl_book_poll() (batch views + conflated top-of-book output)
+ */
+
+#define SHM_PATH    "/usrl-bench-book"
+#define SHM_SIZE    (64 * 1024 * 1024)
+#define RING_SLOTS  65536
+#define CHUNK       4096
+#define WINDOW      1024
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static inline uint64_t xorshift64(void)
+{
+    uint64_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return rng_state = x;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Random walk around a per-symbol mid, most activity near the touch */
+static void generate(UsrlBookUpdate *u, uint64_t n, uint32_t symbols)
+{
+    int64_t *mid = malloc(sizeof(int64_t) * symbols);
+    for (uint32_t i = 0; i < symbols; i++) mid[i] = 10000 + (int64_t)i * 100;
+
+    for (uint64_t k = 0; k < n; k++) {
+        uint64_t r = xorshift64();
+        uint32_t sym = (uint32_t)(r % symbols);
+
+        if ((r >> 20) % 64 == 0) mid[sym] += ((r >> 26) & 1) ? 1 : -1;
+
+        int side = (int)((r >> 27) & 1);
+        int64_t depth = (int64_t)((r >> 28) % 8) + (int64_t)(((r >> 31) % 16 == 0) ? (r >> 35) % 64 : 0);
+        int64_t price = (side == USRL_BOOK_BID) ? mid[sym] - 1 - depth : mid[sym] + 1 + depth;
+
+        memset(&u[k], 0, sizeof(u[k]));
+        u[k].timestamp_ns = k;
+        u[k].symbol_id = sym;
+        u[k].side = (uint8_t)side;
+        u[k].action = USRL_BOOK_SET;
+        u[k].price_ticks = price;
+        u[k].qty = ((r >> 40) % 5 == 0) ? 0 : 100 + (r >> 44) % 1000;
+    }
+    free(mid);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t symbols = (argc > 1) ? (uint32_t)atoi(argv[1]) : 512;
+    uint64_t total = (argc > 2) ? (uint64_t)atoll(argv[2]) : 10000000ULL;
+    if (symbols == 0 || total < CHUNK) {
+        printf("Usage: %s [symbols] [updates >= %d]\n", argv[0], CHUNK);
+        return 1;
+    }
+    total -= total % CHUNK;
+
+    printf("[BENCH] Book builder: %u symbols, %lu updates, window %d ticks\n",
+           symbols, (unsigned long)total, WINDOW);
+
+    UsrlBookUpdate *stream = malloc(sizeof(UsrlBookUpdate) * total);
+    if (!stream) return 1;
+    generate(stream, total, symbols);
+
+    /* 1. Apply only */
+    UsrlBookBuilder b;
+    if (usrl_book_init(&b, symbols, WINDOW) != 0) return 1;
+
+    double t0 = now_sec();
+    for (uint64_t k = 0; k < total; k++) usrl_book_apply(&b, &stream[k]);
+    double apply_s = now_sec() - t0;
+    uint64_t dirty = b.dirty_count;
+    usrl_book_free(&b);
+
+    /* 2. Through the ring */
+    UsrlTopicConfig topics[] = {
+        {"book_in", RING_SLOTS, sizeof(UsrlBookUpdate), USRL_RING_TYPE_SWMR},
+        {"book_tob", RING_SLOTS, sizeof(UsrlTopOfBook), USRL_RING_TYPE_SWMR},
+    };
+    shm_unlink(SHM_PATH);
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, topics, 2) != 0) {
+        printf("[BENCH] Error: usrl_core_init failed\n");
+        return 1;
+    }
+    void *core = usrl_core_map(SHM_PATH, SHM_SIZE);
+    if (!core) return 1;
+
+    UsrlPublisher pub;
+    usrl_pub_init(&pub, core, "book_in", 1);
+    if (usrl_book_init(&b, symbols, WINDOW) != 0 ||
+        usrl_book_attach(&b, core, "book_in", "book_tob", 2) != 0) {
+        printf("[BENCH] Error: book attach failed\n");
+        return 1;
+    }
+
+    double pub_s = 0, poll_s = 0;
+    for (uint64_t k = 0; k < total; k += CHUNK) {
+        double a = now_sec();
+        for (uint32_t j = 0; j < CHUNK; j++)
+            usrl_pub_publish(&pub, &stream[k + j], sizeof(UsrlBookUpdate));
+        double m = now_sec();
+        while (usrl_book_poll(&b, USRL_BOOK_MAX_BATCH) > 0) {}
+        pub_s += m - a;
+        poll_s += now_sec() - m;
+    }
+
+    printf("[BENCH] apply : %.2f M upd/sec/core | %.1f ns/upd\n",
+           total / apply_s / 1e6, apply_s * 1e9 / total);
+    printf("[BENCH] ring  : %.2f M upd/sec/core | %.1f ns/upd (publish %.1f ns/upd excluded)\n",
+           total / poll_s / 1e6, poll_s * 1e9 / total, pub_s * 1e9 / total);
+    printf("[BENCH] applied=%lu rejected=%lu lapped=%lu out_of_window=%lu dropped_levels=%lu\n",
+           (unsigned long)b.updates, (unsigned long)b.rejected, (unsigned long)b.lapped,
+           (unsigned long)b.out_of_window, (unsigned long)b.dropped_levels);
+    printf("[BENCH] top-of-book published=%lu (%.1f%% of updates, %lu pending in apply run)\n",
+           (unsigned long)b.tob_published, 100.0 * b.tob_published / total, (unsigned long)dirty);
+
+    usrl_book_free(&b);
+    free(stream);
+    shm_unlink(SHM_PATH);
+    return 0;
+}
@@ -0,0 +1,1081 @@
+/* =============================================================================
+ * USRL IPC BASELINE COMPARISON
+ * =============================================================================
+ *
+ * Runs the same workloads over USRL and the usual kernel IPC mechanisms so
+ * the numbers can be compared directly:
+ *
+ *   usrl-swmr   one topic, SWMR publisher(s)            (not for N:1)
+ *   usrl-mwmr   one topic, MWMR publishers
+ *   pipe        pipe(2), one per producer/consumer pair
+ *   unix        socketpair(AF_UNIX, SOCK_STREAM), one per pair
+ *   eventfd     SPSC ring in a shared mapping, eventfd wake-ups, one per pair
+ *   mq          POSIX message queue, one per consumer
+ *   tcp         loopback usrl_net TCP transport, one connection per pair
+ *   udp         loopback usrl_net UDP transport, one socket per consumer
+ *
+ * Patterns are 1:1, 1:N (every consumer gets every message) and N:1.
+ * Producers and consumers are separate processes. Every payload starts with
+ * the CLOCK_MONOTONIC send time.
+ *
+ * Each cell runs twice:
+ *   - Throughput: producers send as fast as the transport accepts. Reports
+ *     delivered msg/s, MB/s, and CPU per delivered message (user + sys of
+ *     all producer and consumer processes, from getrusage).
+ *   - Latency: producers are paced (open loop, sleeping between sends) at
+ *     --lat-rate per producer, or a quarter of the throughput just measured
+ *     if that is lower, and consumers record the one-way latency; p50 / p99
+ *     are reported. Paced, so queue depth does not turn into latency.
+ *
+ * Flow control: every transport except UDP is lossless. A single USRL
+ * consumer is a pipeline stage (usrl_stage.h), so the publisher never laps
+ * it. In 1:N the consumers are independent subscribers reading the same
+ * ring in parallel; each publishes how many messages it has copied out and
+ * the publisher waits for the slowest, as the eventfd rings do. Kernel
+ * fan-out writes each message once per consumer. UDP losses are reported.
+ *
+ * --check exits with status 2 if, for any pattern and size, the best USRL
+ * variant is more than --margin percent slower than the best other
+ * transport, or has a p50 more than --margin percent higher. Cells with
+ * fewer CPUs than processes are not checked (polling USRL consumers share
+ * a core with the producers there); if any were, the run reports the
+ * check as skipped and exits with status 3 unless another cell failed.
+ * =============================================================================
+ */
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_stage.h"
+#include "usrl_net.h"
+#include "usrl_tcp.h" /* transport sockfd: poll(), UDP receive timeout */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <mqueue.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+#define SHM_PATH "/usrl_ipc_bench"
+#define MQ_PREFIX "/usrl_ipc_bench_mq"
+#define TOPIC "ipc"
+
+#define MAX_PEERS 8             /* N; USRL fan-out needs one stage each */
+#define MAX_SIZES 16
+#define MAX_SAMPLES 65536       /* latency samples per consumer */
+#define UDP_MAX_PAYLOAD 65507
+
+#define DEFAULT_PEERS 4
+#define DEFAULT_MSGS 200000     /* per producer, throughput run */
+#define DEFAULT_BYTES (256ull << 20) /* per producer cap, throughput run */
+#define DEFAULT_LAT_MSGS 5000
+#define DEFAULT_LAT_RATE 20000  /* msg/s per producer, latency run */
+#define DEFAULT_RING_BYTES (4u << 20)
+#define DEFAULT_PORT 19700
+#define DEFAULT_TIMEOUT_S 60
+#define DEFAULT_MARGIN_PCT 10   /* --check tolerance */
+
+#define USRL_BATCH 64
+#define SPIN_LIMIT 64
+#define UDP_IDLE_MS 100
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+/* --------------------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------------------- */
+
+typedef enum {
+    T_USRL_SWMR, T_USRL_MWMR, T_PIPE, T_UNIX, T_EVENTFD, T_MQ, T_TCP, T_UDP, T_COUNT
+} Transport;
+
+static const char *const g_transport_names[T_COUNT] = {
+    "usrl-swmr", "usrl-mwmr", "pipe", "unix", "eventfd", "mq", "tcp", "udp"
+};
+
+typedef enum { P_1_1, P_1_N, P_N_1, P_COUNT } Pattern;
+
+static const char *const g_pattern_names[P_COUNT] = { "1:1", "1:N", "N:1" };
+
+static inline int is_usrl(Transport t) {
+    return t == T_USRL_SWMR || t == T_USRL_MWMR;
+}
+
+/* One cell of the report */
+typedef struct {
+    int ran;                    /* 0: not applicable, see skip */
+    const char *skip;
+    double msg_per_s;           /* delivered, all consumers */
+    double mb_per_s;
+    double cpu_ns;              /* per delivered message */
+    double p50_us, p99_us;
+    uint64_t lost;
+} CellResult;
+
+/* Shared with the children of one run (MAP_SHARED | MAP_ANONYMOUS) */
+typedef struct {
+    uint64_t received;
+    uint64_t last_ns;
+    uint32_t nsamples;
+    uint32_t ok;
+} ConsResult;
+
+/* USRL 1:N: messages a subscriber has copied out, one line each */
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t done;
+} ReadPos;
+
+typedef struct {
+    atomic_uint ready;
+    atomic_uint go;
+    atomic_uint prod_done;
+    uint64_t start_ns;
+    ReadPos read_pos[MAX_PEERS];
+    ConsResult cons[MAX_PEERS];
+    uint64_t samples[MAX_PEERS][MAX_SAMPLES];
+} Control;
+
+/* eventfd transport: SPSC ring per pair, sleeping side flags itself */
+typedef struct {
+    _Alignas(64) atomic_int waiting;
+    int efd;
+} Waiter;
+
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t head;     /* producer */
+    _Alignas(64) atomic_uint_fast64_t tail;     /* consumer */
+    uint32_t prod, cons;
+    uint64_t data_off;                          /* from the mapping base */
+} EfdChan;
+
+typedef struct {
+    Transport t;
+    Pattern pat;
+    uint32_t nprod, ncons, nchan;
+    uint32_t size;
+    uint64_t msgs;              /* per producer */
+    uint64_t rate;              /* 0 = as fast as possible */
+    uint32_t depth;             /* ring slots (USRL, eventfd) */
+    int port;
+
+    Control *ctl;
+
+    /* Per transport */
+    void *core;
+    uint64_t core_bytes;
+    int fds[MAX_PEERS][2];                      /* pipe / unix, per channel: [0] read, [1] write */
+    usrl_transport_t *srv[MAX_PEERS];           /* tcp / udp, per consumer */
+    mqd_t mq[MAX_PEERS];
+    uint8_t *efd_map;
+    size_t efd_map_len;
+    EfdChan *chan;
+    Waiter *rx;                                 /* per consumer */
+    Waiter *tx;                                 /* per producer */
+} Run;
+
+typedef struct {
+    uint32_t peers;
+    uint64_t msgs, bytes, lat_msgs, lat_rate;
+    uint32_t ring_bytes;
+    int port;
+    int timeout_s;
+    int margin_pct;
+} Options;
+
+static Options g_opt;
+
+/* --------------------------------------------------------------------------
+ * HELPERS
+ * -------------------------------------------------------------------------- */
+
+static inline uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Spin a little, then give the CPU away (fair on few cores) */
+static inline void backoff(uint32_t *spins) {
+    if (++*spins < SPIN_LIMIT) {
+        CPU_RELAX();
+        return;
+    }
+    *spins = 0;
+    sched_yield();
+}
+
+static int write_full(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int read_full(int fd, void *buf, size_t len) {
+    uint8_t *p = buf;
+    while (len) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static uint64_t read_proc_u64(const char *path, uint64_t fallback) {
+    FILE *f = fopen(path, "r");
+    if (!f) return fallback;
+    unsigned long long v = fallback;
+    if (fscanf(f, "%llu", &v) != 1) v = fallback;
+    fclose(f);
+    return (uint64_t)v;
+}
+
+static inline uint32_t floor_pow2(uint64_t v) {
+    uint32_t p = 1;
+    while ((uint64_t)p * 2 <= v && p < (1u << 30)) p *= 2;
+    return p;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Channel index of producer p -> consumer c (one side is always 0) */
+static inline uint32_t chan_of(const Run *r, uint32_t p, uint32_t c) {
+    return r->pat == P_N_1 ? p : c;
+}
+
+/* --------------------------------------------------------------------------
+ * CONSUMER SIDE
+ * -------------------------------------------------------------------------- */
+
+typedef struct {
+    ConsResult *res;
+    uint64_t *samples;
+    uint64_t stride;
+    uint64_t expected;
+} Sink;
+
+static inline void sink_take(Sink *s, const uint8_t *msg) {
+    uint64_t now = mono_ns(), sent;
+    memcpy(&sent, msg, sizeof(sent));
+    if (s->res->received % s->stride == 0 && s->res->nsamples < MAX_SAMPLES)
+        s->samples[s->res->nsamples++] = now - sent;
+    s->res->received++;
+    s->res->last_ns = now;
+}
+
+/* 1:N: an independent subscriber; the count it publishes gates the publisher */
+static void consume_usrl_fanout(Run *r, uint32_t c, Sink *s, uint8_t *buf, UsrlSubscriber *sub) {
+    ReadPos *pos = &r->ctl->read_pos[c];
+    uint32_t spins = 0, unreported = 0;
+    while (s->res->received < s->expected) {
+        int n = usrl_sub_next(sub, buf, r->size, NULL);
+        if (n == USRL_RING_NO_DATA) {
+            if (unreported) {
+                atomic_store_explicit(&pos->done, s->res->received, memory_order_release);
+                unreported = 0;
+            }
+            backoff(&spins);
+            continue;
+        }
+        if (n != (int)r->size) return; /* lapped or truncated: flow control broken */
+        spins = 0;
+        sink_take(s, buf);
+        if (++unreported == USRL_BATCH) {
+            atomic_store_explicit(&pos->done, s->res->received, memory_order_release);
+            unreported = 0;
+        }
+    }
+    atomic_store_explicit(&pos->done, s->res->received, memory_order_release);
+    s->res->ok = 1;
+}
+
+static void consume_usrl(Run *r, uint32_t c, Sink *s, uint8_t *buf) {
+    UsrlStage st;
+    if (usrl_stage_init(&st, r->core, TOPIC, c) != 0) return;
+
+    UsrlStageSlot slots[USRL_BATCH];
+    uint32_t spins = 0;
+    while (s->res->received < s->expected) {
+        int n = usrl_stage_claim(&st, slots, USRL_BATCH);
+        if (n <= 0) {
+            backoff(&spins);
+            continue;
+        }
+        spins = 0;
+        for (int i = 0; i < n; i++) {
+            memcpy(buf, slots[i].data, slots[i].len); /* same copy-out as read() */
+            sink_take(s, buf);
+        }
+        usrl_stage_commit(&st);
+    }
+    s->res->ok = 1;
+}
+
+static void consume_eventfd(Run *r, uint32_t c, Sink *s, uint8_t *buf) {
+    uint32_t mine[MAX_PEERS], k = 0;
+    for (uint32_t i = 0; i < r->nchan; i++)
+        if (r->chan[i].cons == c) mine[k++] = i;
+    Waiter *w = &r->rx[c];
+
+    while (s->res->received < s->expected) {
+        int got = 0;
+        for (uint32_t j = 0; j < k; j++) {
+            EfdChan *ch = &r->chan[mine[j]];
+            uint64_t tail = atomic_load_explicit(&ch->tail, memory_order_relaxed);
+            if (tail == atomic_load_explicit(&ch->head, memory_order_acquire)) continue;
+
+            const uint8_t *slot = r->efd_map + ch->data_off + (tail & (r->depth - 1)) * (uint64_t)r->size;
+            memcpy(buf, slot, r->size);
+            atomic_store_explicit(&ch->tail, tail + 1, memory_order_seq_cst);
+            sink_take(s, buf);
+            got = 1;
+
+            Waiter *tx = &r->tx[ch->prod];
+            if (atomic_load(&tx->waiting) && atomic_exchange(&tx->waiting, 0)) {
+                uint64_t one = 1;
+                write_full(tx->efd, &one, sizeof(one));
+            }
+        }
+        if (got) continue;
+
+        /* Announce the sleep, then re-check: a producer either sees the flag or
+         * published before the re-check */
+        atomic_store(&w->waiting, 1);
+        int empty = 1;
+        for (uint32_t j = 0; j < k && empty; j++) {
+            EfdChan *ch = &r->chan[mine[j]];
+            empty = atomic_load(&ch->tail) == atomic_load(&ch->head);
+        }
+        if (empty) {
+            uint64_t v;
+            read_full(w->efd, &v, sizeof(v));
+        }
+        atomic_store(&w->waiting, 0);
+    }
+    s->res->ok = 1;
+}
+
+/* pipe / unix / tcp: one byte stream per producer, fixed-size messages */
+static void consume_stream(Run *r, uint32_t c, Sink *s, uint8_t *buf) {
+    usrl_transport_t *conn[MAX_PEERS] = {0};
+    struct pollfd pfd[MAX_PEERS];
+    uint64_t left[MAX_PEERS];
+    uint32_t k = (r->pat == P_N_1) ? r->nprod : 1;
+
+    for (uint32_t i = 0; i < k; i++) {
+        if (r->t == T_TCP) {
+            uint64_t deadline = mono_ns() + (uint64_t)g_opt.timeout_s * 1000000000ULL;
+            while (usrl_trans_accept(r->srv[c], &conn[i]) != 0)
+                if (mono_ns() > deadline) return;
+            /* Accepted sockets inherit the listener's 100 ms SO_RCVTIMEO */
+            struct timeval tv = { 0, 0 };
+            setsockopt(conn[i]->sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            pfd[i].fd = conn[i]->sockfd;
+        } else {
+            pfd[i].fd = r->fds[chan_of(r, i, c)][0];
+        }
+        pfd[i].events = POLLIN;
+        left[i] = r->msgs;
+    }
+
+    while (s->res->received < s->expected) {
+        if (k > 1 && poll(pfd, k, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        for (uint32_t i = 0; i < k; i++) {
+            if (k > 1 && !(pfd[i].revents & POLLIN)) continue;
+            int rc = conn[i] ? (usrl_trans_recv(conn[i], buf, r->size) == (ssize_t)r->size ? 0 : -1)
+                             : read_full(pfd[i].fd, buf, r->size);
+            if (rc != 0) return;
+            sink_take(s, buf);
+            if (--left[i] == 0) pfd[i].fd = -1; /* done; its EOF would poll readable */
+        }
+    }
+    for (uint32_t i = 0; i < k; i++) usrl_trans_destroy(conn[i]);
+    s->res->ok = 1;
+}
+
+static void consume_mq(Run *r, uint32_t c, Sink *s, uint8_t *buf, size_t cap) {
+    while (s->res->received < s->expected) {
+        ssize_t n = mq_receive(r->mq[c], (char *)buf, cap, NULL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        sink_take(s, buf);
+    }
+    s->res->ok = 1;
+}
+
+/* Lossy: stop once every producer is done and the socket stays idle */
+static void consume_udp(Run *r, uint32_t c, Sink *s, uint8_t *buf) {
+    int fd = r->srv[c]->sockfd;
+    struct timeval tv = { 0, UDP_IDLE_MS * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    while (s->res->received < s->expected) {
+        ssize_t n = usrl_trans_recv(r->srv[c], buf, r->size);
+        if (n == (ssize_t)r->size) {
+            sink_take(s, buf);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+            atomic_load(&r->ctl->prod_done) == r->nprod)
+            break;
+    }
+    s->res->ok = 1;
+}
+
+static void consumer_main(Run *r, uint32_t c) {
+    size_t cap = r->size;
+    if (r->t == T_MQ) {
+        struct mq_attr a;
+        mq_getattr(r->mq[c], &a);
+        cap = (size_t)a.mq_msgsize;
+    }
+    uint8_t *buf = malloc(cap);
+    if (!buf) return;
+
+    Sink s;
+    s.res = &r->ctl->cons[c];
+    s.samples = r->ctl->samples[c];
+    s.expected = r->msgs * (r->pat == P_N_1 ? r->nprod : 1);
+    s.stride = s.expected / MAX_SAMPLES + 1;
+
+    /* A subscriber starts at the head: attach before anything is published */
+    UsrlSubscriber sub;
+    int fanout = is_usrl(r->t) && r->ncons > 1;
+    if (fanout) usrl_sub_init(&sub, r->core, TOPIC);
+
+    atomic_fetch_add(&r->ctl->ready, 1);
+    while (!atomic_load(&r->ctl->go)) sched_yield();
+
+    switch (r->t) {
+    case T_USRL_SWMR:
+    case T_USRL_MWMR:
+        if (fanout) consume_usrl_fanout(r, c, &s, buf, &sub);
+        else consume_usrl(r, c, &s, buf);
+        break;
+    case T_EVENTFD: consume_eventfd(r, c, &s, buf); break;
+    case T_PIPE:
+    case T_UNIX:
+    case T_TCP: consume_stream(r, c, &s, buf); break;
+    case T_MQ: consume_mq(r, c, &s, buf, cap); break;
+    case T_UDP: consume_udp(r, c, &s, buf); break;
+    default: break;
+    }
+    free(buf);
+}
+
+/* --------------------------------------------------------------------------
+ * PRODUCER SIDE
+ * -------------------------------------------------------------------------- */
+
+/* USRL 1:N: message n overwrites n - depth, so wait until every subscriber
+ * has copied that one out. `floor` caches the slowest count seen. */
+static void wait_fanout(Run *r, uint64_t n, uint64_t *floor, uint32_t *spins) {
+    while (n - *floor >= r->depth) {
+        uint64_t slowest = UINT64_MAX;
+        for (uint32_t c = 0; c < r->ncons; c++) {
+            uint64_t done = atomic_load_explicit(&r->ctl->read_pos[c].done, memory_order_acquire);
+            if (done < slowest) slowest = done;
+        }
+        *floor = slowest;
+        if (n - slowest >= r->depth) backoff(spins);
+    }
+}
+
+static int send_eventfd(Run *r, uint32_t p, uint32_t ch_idx, const uint8_t *msg) {
+    EfdChan *ch = &r->chan[ch_idx];
+    Waiter *w = &r->tx[p];
+    uint64_t head = atomic_load_explicit(&ch->head, memory_order_relaxed);
+
+    while (head - atomic_load_explicit(&ch->tail, memory_order_acquire) >= r->depth) {
+        atomic_store(&w->waiting, 1);
+        if (head - atomic_load(&ch->tail) >= r->depth) {
+            uint64_t v;
+            read_full(w->efd, &v, sizeof(v));
+        }
+        atomic_store(&w->waiting, 0);
+    }
+
+    uint8_t *slot = r->efd_map + ch->data_off + (head & (r->depth - 1)) * (uint64_t)r->size;
+    memcpy(slot, msg, r->size);
+    atomic_store_explicit(&ch->head, head + 1, memory_order_seq_cst);
+
+    Waiter *rx = &r->rx[ch->cons];
+    if (atomic_load(&rx->waiting) && atomic_exchange(&rx->waiting, 0)) {
+        uint64_t one = 1;
+        return write_full(rx->efd, &one, sizeof(one));
+    }
+    return 0;
+}
+
+static void producer_main(Run *r, uint32_t p) {
+    uint8_t *msg = calloc(1, r->size);
+    if (!msg) return;
+    memset(msg + sizeof(uint64_t), 0xA5, r->size - sizeof(uint64_t));
+
+    UsrlPublisher pub;
+    UsrlMwmrPublisher mpub;
+    usrl_transport_t *conn[MAX_PEERS] = {0};
+    uint32_t k = (r->pat == P_1_N) ? r->ncons : 1;
+
+    for (uint32_t i = 0; i < k; i++) {
+        uint32_t c = (r->pat == P_1_N) ? i : 0;
+        if (r->t == T_TCP || r->t == T_UDP) {
+            conn[i] = usrl_trans_create(r->t == T_TCP ? USRL_TRANS_TCP : USRL_TRANS_UDP,
+                                        "127.0.0.1", r->port + (int)c, 0, USRL_SWMR, false);
+            if (!conn[i]) {
+                fprintf(stderr, "[IPC] producer %u: cannot connect to port %d\n", p, r->port + (int)c);
+                free(msg);
+                return;
+            }
+        }
+    }
+    if (r->t == T_USRL_SWMR) usrl_pub_init(&pub, r->core, TOPIC, (uint16_t)(p + 1));
+    if (r->t == T_USRL_MWMR) usrl_mwmr_pub_init(&mpub, r->core, TOPIC, (uint16_t)(p + 1));
+
+    atomic_fetch_add(&r->ctl->ready, 1);
+    while (!atomic_load(&r->ctl->go)) sched_yield();
+
+    /* Paced runs sleep to each deadline, leaving the CPU to the consumers */
+    uint64_t interval = r->rate ? 1000000000ULL / r->rate : 0;
+    uint64_t deadline = r->ctl->start_ns;
+    uint32_t spins = 0;
+    uint64_t floor = 0;
+    int fanout = is_usrl(r->t) && r->ncons > 1;
+
+    for (uint64_t n = 0; n < r->msgs; n++) {
+        if (interval) {
+            deadline += interval;
+            struct timespec ts = { (time_t)(deadline / 1000000000ULL), (long)(deadline % 1000000000ULL) };
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+        }
+        uint64_t now = mono_ns();
+        memcpy(msg, &now, sizeof(now));
+
+        int rc = 0;
+        if (fanout) wait_fanout(r, n, &floor, &spins);
+        switch (r->t) {
+        case T_USRL_SWMR:
+            while ((rc = usrl_pub_publish(&pub, msg, r->size)) == USRL_RING_FULL) backoff(&spins);
+            break;
+        case T_USRL_MWMR:
+            while ((rc = usrl_mwmr_pub_publish(&mpub, msg, r->size)) == USRL_RING_FULL) backoff(&spins);
+            break;
+        default:
+            for (uint32_t i = 0; i < k && rc == 0; i++) {
+                uint32_t c = (r->pat == P_1_N) ? i : 0;
+                uint32_t ch = chan_of(r, p, c);
+                switch (r->t) {
+                case T_EVENTFD: rc = send_eventfd(r, p, ch, msg); break;
+                case T_PIPE:
+                case T_UNIX: rc = write_full(r->fds[ch][1], msg, r->size); break;
+                case T_MQ:
+                    while ((rc = mq_send(r->mq[c], (const char *)msg, r->size, 0)) < 0 && errno == EINTR) {}
+                    break;
+                case T_TCP: rc = usrl_trans_send(conn[i], msg, r->size) == (ssize_t)r->size ? 0 : -1; break;
+                case T_UDP: usrl_trans_send(conn[i], msg, r->size); break; /* drops are counted by the consumer */
+                default: break;
+                }
+            }
+            break;
+        }
+        if (rc < 0) {
+            fprintf(stderr, "[IPC] producer %u: %s send failed: %s\n", p, g_transport_names[r->t],
+                    strerror(errno));
+            break;
+        }
+        spins = 0;
+    }
+
+    atomic_fetch_add(&r->ctl->prod_done, 1);
+    for (uint32_t i = 0; i < k; i++) usrl_trans_destroy(conn[i]);
+    free(msg);
+}
+
+/* --------------------------------------------------------------------------
+ * RUN SETUP
+ * -------------------------------------------------------------------------- */
+
+/* Returns NULL on success, or why the cell does not apply */
+static const char *run_open(Run *r) {
+    switch (r->t) {
+    case T_USRL_SWMR:
+    case T_USRL_MWMR: {
+        if (r->t == T_USRL_SWMR && r->nprod > 1) return "single writer";
+        UsrlTopicConfig tc;
+        memset(&tc, 0, sizeof(tc));
+        snprintf(tc.name, sizeof(tc.name), "%s", TOPIC);
+        tc.slot_count = r->depth;
+        tc.slot_size = r->size;
+        tc.type = (r->t == T_USRL_SWMR) ? USRL_RING_TYPE_SWMR : USRL_RING_TYPE_MWMR;
+
+        r->core_bytes = (uint64_t)r->depth * (r->size + sizeof(SlotHeader) + 64) + (1u << 20);
+        shm_unlink(SHM_PATH);
+        if (usrl_core_init(SHM_PATH, r->core_bytes, &tc, 1) != 0) return "usrl_core_init failed";
+        r->core = usrl_core_map(SHM_PATH, r->core_bytes);
+        if (!r->core) return "usrl_core_map failed";
+
+        /* A single consumer is stage 0, registered before anything is
+         * published; 1:N subscribers are gated through Control instead */
+        if (r->ncons == 1) {
+            UsrlStage st;
+            if (usrl_stage_init(&st, r->core, TOPIC, 0) != 0) return "usrl_stage_init failed";
+        }
+        return NULL;
+    }
+    case T_PIPE:
+    case T_UNIX:
+        for (uint32_t i = 0; i < r->nchan; i++) {
+            int rc = (r->t == T_PIPE) ? pipe(r->fds[i]) : socketpair(AF_UNIX, SOCK_STREAM, 0, r->fds[i]);
+            if (rc != 0) return strerror(errno);
+        }
+        return NULL;
+    case T_EVENTFD: {
+        size_t hdr = sizeof(EfdChan) * r->nchan + sizeof(Waiter) * (r->nprod + r->ncons);
+        hdr = (hdr + 63) & ~(size_t)63;
+        r->efd_map_len = hdr + (size_t)r->nchan * r->depth * r->size;
+        r->efd_map = mmap(NULL, r->efd_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (r->efd_map == MAP_FAILED) {
+            r->efd_map = NULL;
+            return strerror(errno);
+        }
+        r->chan = (EfdChan *)r->efd_map;
+        r->rx = (Waiter *)(r->chan + r->nchan);
+        r->tx = r->rx + r->ncons;
+        for (uint32_t i = 0; i < r->nchan; i++) {
+            r->chan[i].prod = (r->pat == P_N_1) ? i : 0;
+            r->chan[i].cons = (r->pat == P_N_1) ? 0 : i;
+            r->chan[i].data_off = hdr + (uint64_t)i * r->depth * r->size;
+        }
+        for (uint32_t i = 0; i < r->nprod + r->ncons; i++) {
+            if ((r->rx[i].efd = eventfd(0, 0)) < 0) return strerror(errno);
+        }
+        return NULL;
+    }
+    case T_MQ: {
+        uint64_t max_msg = read_proc_u64("/proc/sys/fs/mqueue/msg_max", 10);
+        uint64_t max_size = read_proc_u64("/proc/sys/fs/mqueue/msgsize_max", 8192);
+        if (r->size > max_size) return "over msgsize_max";
+
+        struct mq_attr a;
+        memset(&a, 0, sizeof(a));
+        a.mq_maxmsg = (long)(r->depth < max_msg ? r->depth : max_msg);
+        a.mq_msgsize = (long)r->size;
+        for (uint32_t c = 0; c < r->ncons; c++) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s%u", MQ_PREFIX, c);
+            mq_unlink(name);
+            r->mq[c] = mq_open(name, O_CREAT | O_RDWR, 0600, &a);
+            if (r->mq[c] == (mqd_t)-1) return strerror(errno);
+            mq_unlink(name); /* children inherit the descriptor */
+        }
+        return NULL;
+    }
+    case T_TCP:
+    case T_UDP:
+        if (r->t == T_UDP && r->size > UDP_MAX_PAYLOAD) return "over max datagram";
+        for (uint32_t c = 0; c < r->ncons; c++) {
+            r->srv[c] = usrl_trans_create(r->t == T_TCP ? USRL_TRANS_TCP : USRL_TRANS_UDP,
+                                          "127.0.0.1", r->port + (int)c, 0, USRL_SWMR, true);
+            if (!r->srv[c]) return "bind failed";
+            if (r->t == T_UDP) {
+                int sz = 8 << 20;
+                setsockopt(r->srv[c]->sockfd, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+            }
+        }
+        return NULL;
+    default:
+        return "unknown transport";
+    }
+}
+
+static void run_close(Run *r) {
+    if (r->core) {
+        usrl_core_unmap(r->core, r->core_bytes);
+        shm_unlink(SHM_PATH);
+    }
+    for (uint32_t i = 0; i < MAX_PEERS; i++) {
+        if (r->fds[i][0] > 0) close(r->fds[i][0]);
+        if (r->fds[i][1] > 0) close(r->fds[i][1]);
+        if (r->mq[i] != (mqd_t)-1 && r->mq[i] != 0) mq_close(r->mq[i]);
+        usrl_trans_destroy(r->srv[i]);
+    }
+    if (r->efd_map) {
+        for (uint32_t i = 0; i < r->nprod + r->ncons; i++)
+            if (r->rx[i].efd > 0) close(r->rx[i].efd);
+        munmap(r->efd_map, r->efd_map_len);
+    }
+}
+
+static uint64_t rusage_children_ns(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_CHILDREN, &ru);
+    return (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000ULL +
+           (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ULL;
+}
+
+/* One run: fork the peers, start them together, wait, collect */
+static void run_cell(Transport t, Pattern pat, uint32_t size, uint64_t msgs, uint64_t rate,
+                     CellResult *out) {
+    memset(out, 0, sizeof(*out));
+
+    Run r;
+    memset(&r, 0, sizeof(r));
+    r.t = t;
+    r.pat = pat;
+    r.nprod = (pat == P_N_1) ? g_opt.peers : 1;
+    r.ncons = (pat == P_1_N) ? g_opt.peers : 1;
+    r.nchan = r.nprod * r.ncons;
+    r.size = size;
+    r.msgs = msgs;
+    r.rate = rate;
+    r.depth = floor_pow2(g_opt.ring_bytes / size);
+    if (r.depth < 16) r.depth = 16;
+    if (r.depth > 4096) r.depth = 4096;
+    r.port = g_opt.port;
+
+    r.ctl = mmap(NULL, sizeof(Control), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (r.ctl == MAP_FAILED) {
+        out->skip = "mmap failed";
+        return;
+    }
+
+    const char *why = run_open(&r);
+    if (why) {
+        out->skip = why;
+        run_close(&r);
+        munmap(r.ctl, sizeof(Control));
+        return;
+    }
+
+    uint64_t cpu0 = rusage_children_ns();
+    pid_t pids[2 * MAX_PEERS];
+    uint32_t npids = 0;
+    fflush(stdout);
+
+    for (uint32_t i = 0; i < r.ncons + r.nprod; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (i < r.ncons) consumer_main(&r, i);
+            else producer_main(&r, i - r.ncons);
+            _exit(0);
+        }
+        if (pid < 0) break;
+        pids[npids++] = pid;
+    }
+
+    /* Children hold their own descriptors now */
+    for (uint32_t c = 0; c < MAX_PEERS; c++) {
+        usrl_trans_destroy(r.srv[c]);
+        r.srv[c] = NULL;
+    }
+
+    uint64_t deadline = mono_ns() + (uint64_t)g_opt.timeout_s * 1000000000ULL;
+    while (atomic_load(&r.ctl->ready) < npids && mono_ns() < deadline) usleep(1000);
+    r.ctl->start_ns = mono_ns();
+    atomic_store(&r.ctl->go, 1);
+
+    uint32_t alive = npids;
+    int timed_out = 0;
+    while (alive) {
+        pid_t pid = waitpid(-1, NULL, WNOHANG);
+        if (pid > 0) {
+            alive--;
+            continue;
+        }
+        if (pid < 0 && errno != EINTR) break;
+        if (!timed_out && mono_ns() > deadline) {
+            for (uint32_t i = 0; i < npids; i++) kill(pids[i], SIGKILL);
+            timed_out = 1;
+        }
+        usleep(1000);
+    }
+    uint64_t cpu = rusage_children_ns() - cpu0;
+
+    uint64_t received = 0, end_ns = r.ctl->start_ns, nsamples = 0;
+    int ok = (npids == r.ncons + r.nprod) && !timed_out;
+    for (uint32_t c = 0; c < r.ncons; c++) {
+        ConsResult *cr = &r.ctl->cons[c];
+        received += cr->received;
+        nsamples += cr->nsamples;
+        if (cr->last_ns > end_ns) end_ns = cr->last_ns;
+        ok &= cr->ok;
+    }
+
+    if (!ok) {
+        out->skip = timed_out ? "timeout" : "failed";
+    } else {
+        out->ran = 1;
+        uint64_t expected = msgs * r.nprod * r.ncons;
+        out->lost = expected > received ? expected - received : 0;
+        double secs = (double)(end_ns - r.ctl->start_ns) / 1e9;
+        out->msg_per_s = secs > 0 ? (double)received / secs : 0.0;
+        out->mb_per_s = out->msg_per_s * size / (1024.0 * 1024.0);
+        out->cpu_ns = received ? (double)cpu / (double)received : 0.0;
+
+        uint64_t *all = malloc((nsamples ? nsamples : 1) * sizeof(uint64_t));
+        if (all && nsamples) {
+            uint64_t k = 0;
+            for (uint32_t c = 0; c < r.ncons; c++) {
+                memcpy(all + k, r.ctl->samples[c], r.ctl->cons[c].nsamples * sizeof(uint64_t));
+                k += r.ctl->cons[c].nsamples;
+            }
+            qsort(all, nsamples, sizeof(uint64_t), cmp_u64);
+            out->p50_us = (double)all[nsamples / 2] / 1000.0;
+            out->p99_us = (double)all[(nsamples * 99) / 100] / 1000.0;
+        }
+        free(all);
+    }
+
+    run_close(&r);
+    munmap(r.ctl, sizeof(Control));
+}
+
+/* --------------------------------------------------------------------------
+ * MAIN
+ * -------------------------------------------------------------------------- */
+
+static void usage(void) {
+    printf("Usage: bench_ipc [options]\n");
+    printf("  -t <list>          Transports, comma separated (default all):\n");
+    printf("                     usrl-swmr,usrl-mwmr,pipe,unix,eventfd,mq,tcp,udp\n");
+    printf("  -p <list>          Patterns: 1:1,1:N,N:1 (default all)\n");
+    printf("  -s <list>          Payload sizes in bytes, >= 8 (default 8,64,512,4096,65536)\n");
+    printf("  -n <peers>         N for 1:N and N:1 (default %d, max %d)\n", DEFAULT_PEERS, MAX_PEERS);
+    printf("  --msgs <n>         Messages per producer, throughput run (default %d)\n", DEFAULT_MSGS);
+    printf("  --bytes <mb>       Cap per producer, throughput run (default %llu)\n",
+           (unsigned long long)(DEFAULT_BYTES >> 20));
+    printf("  --lat-msgs <n>     Messages per producer, latency run (default %d, 0 = skip)\n", DEFAULT_LAT_MSGS);
+    printf("  --lat-rate <hz>    Max paced rate per producer, latency run (default %d)\n", DEFAULT_LAT_RATE);
+    printf("  --ring-kb <kb>     Ring size for usrl-* and eventfd (default %u)\n", DEFAULT_RING_BYTES >> 10);
+    printf("  --port <n>         First loopback port (default %d)\n", DEFAULT_PORT);
+    printf("  --timeout <sec>    Per run (default %d)\n", DEFAULT_TIMEOUT_S);
+    printf("  --csv              Machine-readable output\n");
+    printf("  --check            Exit 2 unless USRL leads every pattern and size,\n");
+    printf("                     3 if cells were skipped for lack of cores\n");
+    printf("  --margin <pct>     Tolerance for --check (default %d)\n", DEFAULT_MARGIN_PCT);
+    exit(1);
+}
+
+/* Parse a comma separated list of names into a bitmask */
+static int parse_names(const char *list, const char *const *names, int count, uint32_t *mask) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s", list);
+    *mask = 0;
+    for (char *save = NULL, *tok = strtok_r(tmp, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        int i = 0;
+        while (i < count && strcasecmp(tok, names[i]) != 0) i++;
+        if (i == count) return -1;
+        *mask |= 1u << i;
+    }
+    return *mask ? 0 : -1;
+}
+
+static int parse_sizes(const char *list, uint32_t *sizes, uint32_t *n) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s", list);
+    *n = 0;
+    for (char *save = NULL, *tok = strtok_r(tmp, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        long v = atol(tok);
+        if (v < (long)sizeof(uint64_t) || v > (64 << 20) || *n == MAX_SIZES) return -1;
+        sizes[(*n)++] = (uint32_t)v;
+    }
+    return *n ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    uint32_t tmask = (1u << T_COUNT) - 1, pmask = (1u << P_COUNT) - 1;
+    uint32_t sizes[MAX_SIZES] = { 8, 64, 512, 4096, 65536 }, nsizes = 5;
+    int csv = 0, check = 0;
+
+    g_opt.peers = DEFAULT_PEERS;
+    g_opt.msgs = DEFAULT_MSGS;
+    g_opt.bytes = DEFAULT_BYTES;
+    g_opt.lat_msgs = DEFAULT_LAT_MSGS;
+    g_opt.lat_rate = DEFAULT_LAT_RATE;
+    g_opt.ring_bytes = DEFAULT_RING_BYTES;
+    g_opt.port = DEFAULT_PORT;
+    g_opt.timeout_s = DEFAULT_TIMEOUT_S;
+    g_opt.margin_pct = DEFAULT_MARGIN_PCT;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = 1;
+
+        if (strcmp(a, "--csv") == 0) { csv = 1; continue; }
+        if (strcmp(a, "--check") == 0) { check = 1; continue; }
+
+        if (strcmp(a, "-t") == 0 && v) ok = (parse_names(v, g_transport_names, T_COUNT, &tmask) == 0);
+        else if (strcmp(a, "-p") == 0 && v) ok = (parse_names(v, g_pattern_names, P_COUNT, &pmask) == 0);
+        else if (strcmp(a, "-s") == 0 && v) ok = (parse_sizes(v, sizes, &nsizes) == 0);
+        else if (strcmp(a, "-n") == 0 && v) g_opt.peers = (uint32_t)atoi(v);
+        else if (strcmp(a, "--msgs") == 0 && v) g_opt.msgs = strtoull(v, NULL, 10);
+        else if (strcmp(a, "--bytes") == 0 && v) g_opt.bytes = strtoull(v, NULL, 10) << 20;
+        else if (strcmp(a, "--lat-msgs") == 0 && v) g_opt.lat_msgs = strtoull(v, NULL, 10);
+        else if (strcmp(a, "--lat-rate") == 0 && v) g_opt.lat_rate = strtoull(v, NULL, 10);
+        else if (strcmp(a, "--ring-kb") == 0 && v) g_opt.ring_bytes = (uint32_t)atoi(v) << 10;
+        else if (strcmp(a, "--port") == 0 && v) g_opt.port = atoi(v);
+        else if (strcmp(a, "--timeout") == 0 && v) g_opt.timeout_s = atoi(v);
+        else if (strcmp(a, "--margin") == 0 && v) ok = ((g_opt.margin_pct = atoi(v)) >= 0);
+        else usage();
+
+        if (!ok) {
+            fprintf(stderr, "Bad value for %s: %s\n", a, v);
+            return 1;
+        }
+        i++;
+    }
+    if (g_opt.peers < 2 || g_opt.peers > MAX_PEERS || g_opt.msgs == 0 || g_opt.lat_rate == 0) usage();
+
+    signal(SIGPIPE, SIG_IGN);
+
+    if (csv) printf("pattern,size,transport,msg_per_s,mb_per_s,cpu_ns_per_msg,p50_us,p99_us,lost\n");
+    else printf("[IPC] %u producer/consumer process(es) per N; throughput runs up to %llu msgs, "
+                "latency runs %llu msgs at %llu msg/s per producer\n",
+                g_opt.peers, (unsigned long long)g_opt.msgs, (unsigned long long)g_opt.lat_msgs,
+                (unsigned long long)g_opt.lat_rate);
+
+    /* Spinning USRL consumers compete with the producers on a shared core */
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0 && (uint32_t)cpus < g_opt.peers + 1)
+        fprintf(stderr, "[IPC] note: %ld CPU(s) for up to %u processes per run; USRL consumers "
+                "poll instead of sleeping, so shared cores understate USRL\n", cpus, g_opt.peers + 1);
+
+    int failed = 0, skipped = 0;
+    for (int p = 0; p < P_COUNT; p++) {
+        if (!(pmask & (1u << p))) continue;
+        for (uint32_t si = 0; si < nsizes; si++) {
+            uint32_t size = sizes[si];
+            uint64_t msgs = g_opt.bytes / size;
+            if (msgs > g_opt.msgs) msgs = g_opt.msgs;
+            if (msgs == 0) msgs = 1;
+
+            if (!csv) {
+                printf("\n--- %s, %u B ---\n", g_pattern_names[p], size);
+                printf("%-10s %10s %10s %12s %10s %10s %10s\n",
+                       "TRANSPORT", "Mmsg/s", "MB/s", "CPU ns/msg", "P50 us", "P99 us", "LOST");
+            }
+
+            CellResult res[T_COUNT];
+            memset(res, 0, sizeof(res));
+            for (int t = 0; t < T_COUNT; t++) {
+                if (!(tmask & (1u << t))) continue;
+                CellResult *c = &res[t];
+                run_cell((Transport)t, (Pattern)p, size, msgs, 0, c);
+                if (c->ran && g_opt.lat_msgs) {
+                    /* Pace well below what this cell sustains, so no queue builds */
+                    uint64_t rate = g_opt.lat_rate;
+                    double cap = c->msg_per_s / 4.0 / (p == P_1_1 ? 1.0 : (double)g_opt.peers);
+                    if (cap < (double)rate) rate = cap >= 1.0 ? (uint64_t)cap : 1;
+                    CellResult lat;
+                    run_cell((Transport)t, (Pattern)p, size, g_opt.lat_msgs, rate, &lat);
+                    c->p50_us = lat.ran ? lat.p50_us : 0.0;
+                    c->p99_us = lat.ran ? lat.p99_us : 0.0;
+                }
+
+                if (csv) {
+                    if (c->ran)
+                        printf("%s,%u,%s,%.0f,%.2f,%.1f,%.2f,%.2f,%llu\n", g_pattern_names[p], size,
+                               g_transport_names[t], c->msg_per_s, c->mb_per_s, c->cpu_ns,
+                               c->p50_us, c->p99_us, (unsigned long long)c->lost);
+                } else if (c->ran) {
+                    printf("%-10s %10.3f %10.1f %12.0f %10.2f %10.2f %10llu\n", g_transport_names[t],
+                           c->msg_per_s / 1e6, c->mb_per_s, c->cpu_ns, c->p50_us, c->p99_us,
+                           (unsigned long long)c->lost);
+                } else {
+                    printf("%-10s %10s (%s)\n", g_transport_names[t], "n/a", c->skip);
+                }
+                fflush(stdout);
+            }
+
+            if (!check) continue;
+
+            /* Best USRL variant against the best of the rest */
+            int bu = -1, bo = -1;
+            for (int t = 0; t < T_COUNT; t++) {
+                if (!res[t].ran) continue;
+                int *best = is_usrl((Transport)t) ? &bu : &bo;
+                if (*best < 0 || res[t].msg_per_s > res[*best].msg_per_s) *best = t;
+            }
+            if (bu < 0 || bo < 0) continue;
+
+            /* Checked only with a core per process */
+            uint32_t procs = (p == P_1_1) ? 2 : g_opt.peers + 1;
+            if (cpus > 0 && (uint32_t)cpus < procs) {
+                fprintf(stderr, "[IPC] CHECK SKIPPED %s %u B: %ld CPU(s) for %u processes\n",
+                        g_pattern_names[p], size, cpus, procs);
+                skipped++;
+                continue;
+            }
+
+            double lu = 0.0, lo = 0.0;
+            for (int t = 0; t < T_COUNT; t++) {
+                if (!res[t].ran || res[t].p50_us <= 0.0) continue;
+                double *l = is_usrl((Transport)t) ? &lu : &lo;
+                if (*l == 0.0 || res[t].p50_us < *l) *l = res[t].p50_us;
+            }
+
+            double tol = g_opt.margin_pct / 100.0;
+            if (res[bu].msg_per_s < res[bo].msg_per_s * (1.0 - tol)) {
+                fprintf(stderr, "[IPC] CHECK FAILED %s %u B: %s %.0f msg/s < %s %.0f msg/s - %d%%\n",
+                        g_pattern_names[p], size, g_transport_names[bu], res[bu].msg_per_s,
+                        g_transport_names[bo], res[bo].msg_per_s, g_opt.margin_pct);
+                failed = 1;
+            }
+            if (lu > 0.0 && lo > 0.0 && lu > lo * (1.0 + tol)) {
+                fprintf(stderr, "[IPC] CHECK FAILED %s %u B: USRL p50 %.2f us > %.2f us + %d%%\n",
+                        g_pattern_names[p], size, lu, lo, g_opt.margin_pct);
+                failed = 1;
+            }
+        }
+    }
+
+    if (check) {
+        if (failed) return 2;
+        if (skipped) {
+            fprintf(stderr, "\n[IPC] CHECK SKIPPED: %d cell(s) not checked, %ld CPU(s) for up to %u "
+                    "processes per run\n", skipped, cpus, g_opt.peers + 1);
+            return 3;
+        }
+        if (!csv)
+            printf("\n[IPC] CHECK PASSED: USRL leads every measured pattern and size (within %d%%)\n",
+                   g_opt.margin_pct);
+    }
+    return 0;
+}
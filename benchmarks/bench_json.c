@@ -0,0 +1,148 @@
+#include "usrl_json.h"
+#include "usrl_core.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+/*
+ * JSON transcoder throughput, single core.
+ *
+ * Payloads look like crypto.py's embed_ts_json ticks (8-byte timestamp +
+ * compact JSON, a few extra keys the schema ignores).
+ *
+ *  1. scalar : usrl_json_transcode() with the scalar stage-1 scanner
+ *  2. simd   : the same with the compiled-in vector backend
+ *  3. ring   : publish chunks into a USRL ring and drain them with
+ *              usrl_json_tc_poll() into a binary output topic
+ */
+
+#define SHM_PATH    "/usrl-bench-json"
+#define SHM_SIZE    (128 * 1024 * 1024)
+#define RING_SLOTS  65536
+#define MSG_SIZE    512
+#define CHUNK       4096
+#define NMSG        4096    /* distinct payloads, replayed */
+
+static const char *coins[] = {"BTC-USD", "ETH-USD", "SOL-USD", "DOGE-USD", "ADA-USD", "XRP-USD"};
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run(const UsrlJsonMap *m, uint8_t (*msg)[MSG_SIZE], const uint32_t *len,
+                  uint64_t total, uint64_t *bytes)
+{
+    uint8_t rec[256];
+    uint64_t b = 0;
+    double t0 = now_sec();
+    for (uint64_t k = 0; k < total; k++) {
+        uint32_t i = (uint32_t)(k % NMSG);
+        if (usrl_json_transcode(m, msg[i], len[i], rec, sizeof(rec), NULL) < 0) {
+            printf("[BENCH] Error: transcode rejected payload %u\n", i);
+            exit(1);
+        }
+        b += len[i];
+    }
+    *bytes = b;
+    return now_sec() - t0;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t total = (argc > 1) ? (uint64_t)atoll(argv[1]) : 5000000ULL;
+    if (total < CHUNK) {
+        printf("Usage: %s [messages >= %d]\n", argv[0], CHUNK);
+        return 1;
+    }
+    total -= total % CHUNK;
+
+    UsrlSchema *s = usrl_schema_create(1, "tick");
+    usrl_schema_add_field(s, "recv_ns", USRL_FIELD_U64, 8);
+    usrl_schema_add_field(s, "ts", USRL_FIELD_U64, 8);
+    usrl_schema_add_field(s, "price", USRL_FIELD_F64, 8);
+    usrl_schema_add_field(s, "size", USRL_FIELD_F64, 8);
+    usrl_schema_add_field(s, "symbol", USRL_FIELD_STRING, 16);
+    usrl_schema_add_field(s, "src", USRL_FIELD_STRING, 8);
+    usrl_schema_finalize(s);
+
+    static uint8_t msg[NMSG][MSG_SIZE];
+    static uint32_t len[NMSG];
+    srand(7);
+    for (uint32_t i = 0; i < NMSG; i++) {
+        uint64_t ts = 1700000000000000000ULL + (uint64_t)i * 1000003ULL;
+        double price = 10.0 + (rand() / (double)RAND_MAX) * 50000.0;
+        double size = (rand() % 100000) / 1000.0;
+        memcpy(msg[i], &ts, 8);
+        len[i] = 8 + (uint32_t)snprintf((char *)msg[i] + 8, MSG_SIZE - 8,
+            "{\"symbol\":\"%s\",\"price\":%.*f,\"size\":%.3f,\"ts\":%lu,\"src\":\"sim\","
+            "\"seq\":%u,\"meta\":{\"venue\":\"cb\",\"flags\":[1,2,3]}}",
+            coins[i % 6], (i & 1) ? 2 : 12, price, size, (unsigned long)ts, i);
+    }
+
+    printf("[BENCH] JSON transcoder: %lu messages, %u-byte records, backend %s\n",
+           (unsigned long)total, s->total_size, usrl_json_backend());
+
+    UsrlJsonMap m;
+    usrl_json_map_init(&m, s);
+    usrl_json_map_prefix(&m, 8, "recv_ns");
+
+    uint64_t bytes;
+    m.flags = USRL_JSON_F_SCALAR;
+    double scalar_s = run(&m, msg, len, total, &bytes);
+    m.flags = 0;
+    double simd_s = run(&m, msg, len, total, &bytes);
+
+    /* 3. Through the ring */
+    UsrlTopicConfig topics[] = {
+        {"json_in", RING_SLOTS, MSG_SIZE, USRL_RING_TYPE_SWMR},
+        {"json_bin", RING_SLOTS, 64, USRL_RING_TYPE_SWMR},
+    };
+    shm_unlink(SHM_PATH);
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, topics, 2) != 0) {
+        printf("[BENCH] Error: usrl_core_init failed\n");
+        return 1;
+    }
+    void *core = usrl_core_map(SHM_PATH, SHM_SIZE);
+    if (!core) return 1;
+
+    UsrlPublisher pub;
+    usrl_pub_init(&pub, core, "json_in", 1);
+    UsrlJsonTranscoder t;
+    if (usrl_json_tc_init(&t, s) != 0 ||
+        usrl_json_map_prefix(&t.map, 8, "recv_ns") != 0 ||
+        usrl_json_tc_attach(&t, core, "json_in", "json_bin", 2) != 0) {
+        printf("[BENCH] Error: transcoder attach failed\n");
+        return 1;
+    }
+
+    double poll_s = 0;
+    for (uint64_t k = 0; k < total; k += CHUNK) {
+        for (uint32_t j = 0; j < CHUNK; j++) {
+            uint32_t i = (uint32_t)((k + j) % NMSG);
+            usrl_pub_publish(&pub, msg[i], len[i]);
+        }
+        double a = now_sec();
+        while (usrl_json_tc_poll(&t, USRL_JSON_MAX_BATCH) > 0) {}
+        poll_s += now_sec() - a;
+    }
+
+    printf("[BENCH] scalar : %.2f M msg/sec/core | %.1f ns/msg | %.0f MB/s\n",
+           total / scalar_s / 1e6, scalar_s * 1e9 / total, bytes / scalar_s / 1e6);
+    printf("[BENCH] %-6s : %.2f M msg/sec/core | %.1f ns/msg | %.0f MB/s\n", usrl_json_backend(),
+           total / simd_s / 1e6, simd_s * 1e9 / total, bytes / simd_s / 1e6);
+    printf("[BENCH] ring   : %.2f M msg/sec/core | %.1f ns/msg (publish excluded)\n",
+           total / poll_s / 1e6, poll_s * 1e9 / total);
+    printf("[BENCH] records=%lu rejected=%lu lapped=%lu published=%lu\n",
+           (unsigned long)t.records, (unsigned long)t.rejected,
+           (unsigned long)t.lapped, (unsigned long)t.published);
+
+    usrl_json_tc_free(&t);
+    usrl_schema_free(s);
+    shm_unlink(SHM_PATH);
+    return 0;
+}
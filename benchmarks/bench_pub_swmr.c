@@ -1,4 +1,5 @@
 #include "usrl_ring.h"
+#include "usrl_ring_inline.h"
 #include "usrl_core.h"
 #include <stdio.h>
 #include <string.h>
@@ -12,12 +13,13 @@ int main(int argc, char **argv)
 {
     if (argc < 3)
     {
-        printf("Usage: %s <topic> <payload_size>\n", argv[0]);
+        printf("Usage: %s <topic> <payload_size> [--inline]\n", argv[0]);
         return 1;
     }
 
     char *topic = argv[1];
     int payload_size = atoi(argv[2]);
+    int use_inline = (argc > 3 && strcmp(argv[3], "--inline") == 0);
 
     void *core = usrl_core_map("/usrl_core", 128 * 1024 * 1024);
     if (!core)
@@ -36,17 +38,32 @@ int main(int argc, char **argv)
     uint8_t *payload = malloc(payload_size);
     memset(payload, 0xAA, payload_size);
 
-    printf("[BENCH] SWMR Publisher starting on '%s' (Size: %d bytes)...\n", topic, payload_size);
+    printf("[BENCH] SWMR Publisher starting on '%s' (Size: %d bytes, %s)...\n", topic, payload_size,
+           use_inline ? "inline" : "library");
 
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    for (int i = 0; i < BATCH_SIZE; i++)
+    if (use_inline)
     {
-        // Spin wait if ring is full
-        while (usrl_pub_publish(&pub, payload, payload_size) != 0)
+        // Header-only hot path (usrl_ring_inline.h)
+        for (int i = 0; i < BATCH_SIZE; i++)
         {
-            __asm__ volatile("nop");
+            while (usrl_pub_publish_inline(&pub, payload, payload_size) != 0)
+            {
+                __asm__ volatile("nop");
+            }
+        }
+    }
+    else
+    {
+        for (int i = 0; i < BATCH_SIZE; i++)
+        {
+            // Spin wait if ring is full
+            while (usrl_pub_publish(&pub, payload, payload_size) != 0)
+            {
+                __asm__ volatile("nop");
+            }
         }
     }
 
@@ -57,8 +74,8 @@ int main(int argc, char **argv)
     double bw_mbps = ((double)BATCH_SIZE * payload_size / 1024.0 / 1024.0) / elapsed;
     double avg_ns = (elapsed * 1e9) / BATCH_SIZE;
 
-    printf("[BENCH] SWMR Result: %.2f M msg/sec | %.2f MB/s | Avg Latency: %.2f ns\n",
-           rate_mpps, bw_mbps, avg_ns);
+    printf("[BENCH] SWMR Result%s: %.2f M msg/sec | %.2f MB/s | Avg Latency: %.2f ns\n",
+           use_inline ? " (inline)" : "", rate_mpps, bw_mbps, avg_ns);
 
     free(payload);
     return 0;
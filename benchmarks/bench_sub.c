@@ -1,6 +1,8 @@
 #include "usrl_ring.h"
+#include "usrl_ring_inline.h"
 #include "usrl_core.h"
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 // Print stats every 100k messages
@@ -11,7 +13,7 @@ int main(int argc, char **argv)
     if (argc < 2)
     {
         // Print to stderr so it shows up in logs if redirected
-        fprintf(stderr, "Usage: %s <topic>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <topic> [--inline]\n", argv[0]);
         return 1;
     }
 
@@ -21,6 +23,7 @@ int main(int argc, char **argv)
 
     UsrlSubscriber sub;
     usrl_sub_init(&sub, core, argv[1]);
+    int use_inline = (argc > 2 && strcmp(argv[2], "--inline") == 0);
 
     // We won't use this buffer for benchmarks to save "printing to screen" time,
     // but we need it for the API.
@@ -35,7 +38,9 @@ int main(int argc, char **argv)
 
     while (1)
     {
-        int n = usrl_sub_next(&sub, buf, sizeof(buf), &pid);
+        // Header-only hot path (usrl_ring_inline.h) or the library call
+        int n = use_inline ? usrl_sub_next_inline(&sub, buf, sizeof(buf), &pid)
+                           : usrl_sub_next(&sub, buf, sizeof(buf), &pid);
 
         if (n > 0)
         {
@@ -46,8 +51,8 @@ int main(int argc, char **argv)
                 double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
 
                 // IMPORTANT: Use stderr and flush immediately to ensure it hits the log file
-                fprintf(stderr, "[SUB] Rate: %.2f M msg/s | Last ID: %d\n",
-                        (count / 1e6) / elapsed, pid);
+                fprintf(stderr, "[SUB] Rate%s: %.2f M msg/s | Last ID: %d\n",
+                        use_inline ? " (inline)" : "", (count / 1e6) / elapsed, pid);
                 fflush(stderr);
             }
             continue;
@@ -82,6 +82,7 @@ typedef struct {
     uint64_t rate_hz;       // Throughput
     uint64_t lag;           // Subscriber lag (0 for pubs)
     bool healthy;           // Based on internal thresholds
+    uint64_t expired;       // Skipped as older than the subscriber TTL
 } usrl_health_t;
 
 /* ============================================================================
@@ -121,6 +122,13 @@ int usrl_pub_send(usrl_pub_t *pub, const void *data, uint32_t len);
  */
 void usrl_pub_get_health(usrl_pub_t *pub, usrl_health_t *out);
 
+/**
+ * @brief Wait until the last message sent is on disk.
+ * Needs a durable writer on the topic (usrl_durable.h, usrl_journal record
+ * --durable). Returns 0, or -1 on timeout.
+ */
+int usrl_pub_wait_durable(usrl_pub_t *pub, uint64_t timeout_ns);
+
 /**
  * @brief Destroy publisher.
  */
@@ -140,6 +148,12 @@ usrl_sub_t *usrl_sub_create(usrl_ctx_t *ctx, const char *topic);
  */
 int usrl_sub_recv(usrl_sub_t *sub, void *buffer, uint32_t max_len);
 
+/**
+ * @brief Set a max message age. Older slots are skipped without copying.
+ * 0 disables the TTL (default).
+ */
+void usrl_sub_set_ttl(usrl_sub_t *sub, uint64_t max_age_ns);
+
 /**
  * @brief Get health metrics for this specific subscriber (Lag, throughput).
  */
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "usrl_core.h"
 
 typedef struct {
     uint64_t publish_quota;          /* messages allowed per window */
@@ -58,8 +59,32 @@ static inline void usrl_quota_init(PublishQuota *quota, uint64_t msgs_per_sec)
 }
 
 int usrl_quota_check(PublishQuota *quota); /* returns 1 when throttled, 0 when allowed */
+int usrl_quota_check_share(PublishQuota *quota, uint32_t num, uint32_t den); /* only num/den of the window */
 int usrl_backpressure_check_lag(uint64_t lag, uint64_t threshold);
 uint64_t usrl_backoff_exponential(uint32_t attempt); /* ns */
 uint64_t usrl_backoff_linear(uint64_t lag, uint64_t max_lag); /* us (as currently implemented) */
 
+/*
+ * Live policy (UsrlTopicCtl in the region, set with `usrl-ctl set`).
+ *
+ * Publishers keep the version they applied and compare it at batch
+ * boundaries; only a changed version costs a read. Fields whose
+ * USRL_POLICY_* flag is clear fall back to the creation-time config.
+ */
+typedef struct {
+    uint32_t flags;                  /* USRL_POLICY_* */
+    UsrlBackpressureMode bp_mode;
+    uint64_t rate_limit_hz;
+    uint64_t lag_threshold;
+} UsrlPolicy;
+
+static inline uint64_t usrl_policy_version(const UsrlTopicCtl *ctl)
+{
+    return atomic_load_explicit(&((UsrlTopicCtl *)ctl)->version, memory_order_relaxed);
+}
+
+int usrl_policy_read(const UsrlTopicCtl *ctl, UsrlPolicy *out, uint64_t *version); /* 0, or -1 while a writer holds it */
+int usrl_policy_update(UsrlTopicCtl *ctl, const UsrlPolicy *set, uint32_t clear_flags); /* set->flags fields, then clear; -1 if the lock stays held */
+int usrl_policy_reset(UsrlTopicCtl *ctl); /* drop every override, breaking a dead writer's lock */
+
 #endif /* USRL_BACKPRESSURE_H */
@@ -84,7 +84,7 @@ typedef struct
 typedef struct
 {
     uint32_t magic;              /* must equal USRL_MAGIC */
-    uint32_t version;            /* layout version (starts at 1) */
+    uint32_t version;            /* layout version (2: adds TopicExt, 3: TopicExt.ctl) */
     uint64_t mmap_size;          /* total size of the mapped region */
     uint64_t topic_table_offset; /* offset to TopicEntry[topic_count] */
     uint32_t topic_count;        /* number of topics in the table */
@@ -103,18 +103,38 @@ typedef struct
  *   timestamp_ns : wall-clock timestamp for the write
  *   payload_len  : number of bytes in the payload
  *   pub_id       : publisher id (new field — who wrote this slot)
+ *   flags        : USRL_SLOT_F_* (rewritten on every publish)
+ *                  USRL_SLOT_F_PROBE marks a latency probe (usrl-ctl
+ *                  probe); subscribers skip those slots.
+ *
+ * The rest of the cache line carries optional trace context, only valid
+ * when USRL_SLOT_F_TRACED is set (see usrl_trace.h):
+ *   trace_id     : origin pub_id << 48 | per-publisher counter
+ *   origin_ns    : CLOCK_REALTIME at the origin publish
+ *   hop_count    : hops after the origin (may exceed USRL_TRACE_MAX_HOPS)
+ *   hop_id/ns    : who handled each hop, and when (ns after origin_ns)
  * -------------------------------------------------------------------------- */
+#define USRL_SLOT_F_TRACED 0x01
+#define USRL_SLOT_F_PROBE 0x02
+#define USRL_TRACE_MAX_HOPS 4
+
 typedef struct __attribute__((aligned(64)))
 {
     atomic_uint_fast64_t seq; /* commit sequence; 0 == empty/uninitialized */
     uint64_t timestamp_ns;
     uint32_t payload_len;
     uint16_t pub_id; /* publisher identity */
-    uint16_t _pad;   /* pad to 8-byte boundary */
+    uint8_t flags;
+    uint8_t hop_count;
+    uint64_t trace_id;
+    uint64_t origin_ns;
+    uint16_t hop_id[USRL_TRACE_MAX_HOPS];
+    uint32_t hop_ns[USRL_TRACE_MAX_HOPS];
 } SlotHeader;
 
 #ifndef __cplusplus
 _Static_assert(sizeof(SlotHeader) % 8 == 0, "header size alignment wrong");
+_Static_assert(sizeof(SlotHeader) == 64, "trace context must fit the header line");
 #endif
 
 /* --------------------------------------------------------------------------
@@ -136,9 +156,65 @@ typedef struct __attribute__((aligned(USRL_ALIGNMENT)))
     uint32_t slot_size;
     uint64_t base_offset;        /* offset to first slot (from region base) */
     atomic_uint_fast64_t w_head; /* writers atomically increment this */
-    uint8_t _pad[32];            /* reserved for future extension */
+    uint64_t ext_offset;         /* TopicExt (layout v2+), 0 if absent */
+    uint8_t _pad[24];            /* reserved for future extension */
 } RingDesc;
 
+/* --------------------------------------------------------------------------
+ * Topic Extension Block (layout v2+)
+ *
+ * Shared per-topic state kept out of RingDesc so the w_head cache line
+ * stays small. The publish path reads stage_count (one relaxed load per
+ * publish) and, on a gated ring, the last stage's cursor when near a lap.
+ *
+ *   stage_count : pipeline stages registered on this ring (0 = ungated)
+ *   stages[k]   : highest seq stage k has finished with. Stage k only
+ *                 consumes seqs stage k-1 has finished; the publisher never
+ *                 laps the last stage. See usrl_stage.h.
+ *   durable_seq : every seq up to here is fdatasynced to the topic journal
+ *                 (0 = no durable writer). See usrl_durable.h.
+ *   ctl         : live publisher policy (layout v3+), see below.
+ * -------------------------------------------------------------------------- */
+#define USRL_MAX_STAGES 8
+
+typedef struct __attribute__((aligned(USRL_ALIGNMENT)))
+{
+    atomic_uint_fast64_t seq;
+} UsrlStageCursor;
+
+/* --------------------------------------------------------------------------
+ * Topic Control Block (layout v3+)
+ *
+ * Rate limit, backpressure mode and lag threshold that override what
+ * publishers and subscribers were created with, changed at runtime by
+ * `usrl-ctl set`. Written under a seqlock: version is odd while an update
+ * is in progress and moves by 2 per update (0 = never set). Readers
+ * compare version with the one they applied; see usrl_policy_read().
+ * -------------------------------------------------------------------------- */
+#define USRL_POLICY_RATE 0x01u   /* rate_limit_hz is set */
+#define USRL_POLICY_BP   0x02u   /* bp_mode is set */
+#define USRL_POLICY_LAG  0x04u   /* lag_threshold is set */
+
+typedef struct __attribute__((aligned(USRL_ALIGNMENT)))
+{
+    atomic_uint_fast64_t version;
+    uint32_t flags;              /* USRL_POLICY_* overrides in effect */
+    uint32_t bp_mode;            /* UsrlBackpressureMode */
+    uint64_t rate_limit_hz;      /* 0 = unlimited */
+    uint64_t lag_threshold;      /* slots */
+    uint8_t _reserved[32];
+} UsrlTopicCtl;
+
+typedef struct __attribute__((aligned(USRL_ALIGNMENT)))
+{
+    atomic_uint_fast32_t stage_count;
+    uint32_t _pad;
+    atomic_uint_fast64_t durable_seq;
+    uint8_t _reserved[48];       /* reserved for future extension */
+    UsrlStageCursor stages[USRL_MAX_STAGES];
+    UsrlTopicCtl ctl;            /* layout v3+ only */
+} TopicExt;
+
 /* --------------------------------------------------------------------------
  * Public API (core)
  *
@@ -158,6 +234,11 @@ void *usrl_core_map(const char *path, uint64_t size);
 
 TopicEntry *usrl_get_topic(void *base, const char *name);
 
+TopicExt *usrl_topic_ext(void *base, const TopicEntry *t);
+
+/* NULL on regions created before layout v3 */
+UsrlTopicCtl *usrl_topic_ctl(void *base, const TopicEntry *t);
+
 void usrl_core_unmap(void *base, size_t size);
 
 #endif /* USRL_CORE_H */
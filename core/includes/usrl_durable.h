@@ -0,0 +1,90 @@
+#ifndef USRL_DURABLE_H
+#define USRL_DURABLE_H
+
+/* --------------------------------------------------------------------------
+ * USRL Durable Publish — group-committed journal with a durable watermark
+ *
+ * A durable writer is a pipeline stage (usrl_stage.h) that appends every
+ * committed slot to the topic journal (usrl_journal.h), fdatasyncs in
+ * groups and then publishes TopicExt.durable_seq: every seq up to it is on
+ * disk. Publishers poll or wait on the watermark for their own seq
+ * (UsrlPublisher.last_seq), so one sync acknowledges a whole group.
+ *
+ *   - A group is synced when it reaches group_records, when its oldest
+ *     record is group_ns old, or as soon as the ring is drained. Under
+ *     load groups grow while the previous sync runs; idle, a publish is
+ *     acknowledged after one sync.
+ *   - As the last registered stage the writer is never lapped: a publisher
+ *     more than a ring ahead of the disk gets USRL_RING_FULL. Nothing
+ *     published after the writer registered can be lost.
+ *   - The stage cursor only moves after a sync, so a restarted writer
+ *     resumes at the last durable seq and skips what its journal already
+ *     holds. The watermark always comes from the journal: on open it is
+ *     the journal's last seq (0 if empty), afterwards the last seq an
+ *     fdatasync covered.
+ *
+ * Start the writer before publishers whose messages must be durable.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_stage.h"
+#include "usrl_journal.h"
+
+#define USRL_DURABLE_GROUP_RECORDS 4096    /* default */
+#define USRL_DURABLE_GROUP_NS 1000000ull   /* default: 1 ms */
+
+/* Writer Handle */
+typedef struct {
+    UsrlJournalWriter w;
+    UsrlStage stage;
+    TopicExt *ext;
+    uint32_t group_records;     /* sync at this many pending records */
+    uint64_t group_ns;          /* ... or when the oldest is this old */
+
+    uint64_t pending;           /* appended since the last sync */
+    uint64_t pending_since_ns;
+
+    /* Stats */
+    uint64_t groups;
+    uint64_t max_group;
+    uint64_t sync_ns_total;
+    uint64_t sync_ns_max;
+} UsrlDurableWriter;
+
+/*
+ * Register as pipeline stage `stage` of topic (after any processing
+ * stages) and open its journal under dir. group_records / group_ns of 0
+ * take the defaults. Returns 0 or -1.
+ */
+int usrl_durable_open(UsrlDurableWriter *d, void *core_base, const char *topic, uint32_t stage,
+                      const char *dir, uint64_t segment_bytes, uint32_t group_records,
+                      uint64_t group_ns);
+
+/* Sync what is pending and close the journal (the stage stays registered) */
+int usrl_durable_close(UsrlDurableWriter *d);
+
+/* Writer step: append ready slots, sync if a group is due. Returns the
+ * number of records appended, -1 on I/O error. */
+int usrl_durable_poll(UsrlDurableWriter *d);
+
+/* Sync now and advance the watermark */
+int usrl_durable_sync(UsrlDurableWriter *d);
+
+/* --------------------------------------------------------------------------
+ * Publisher side
+ * -------------------------------------------------------------------------- */
+static inline uint64_t usrl_durable_seq(const TopicExt *x)
+{
+    return x ? atomic_load_explicit(&((TopicExt *)x)->durable_seq, memory_order_acquire) : 0;
+}
+
+/*
+ * Wait until seq is durable: spins briefly, then sleeps. timeout_ns 0
+ * polls once. Returns USRL_RING_OK or USRL_RING_TIMEOUT.
+ */
+int usrl_durable_wait(const TopicExt *x, uint64_t seq, uint64_t timeout_ns);
+
+#endif /* USRL_DURABLE_H */
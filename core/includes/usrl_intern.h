@@ -0,0 +1,77 @@
+#ifndef USRL_INTERN_H
+#define USRL_INTERN_H
+
+/* --------------------------------------------------------------------------
+ * USRL Symbol Interning — dense 32-bit ids for symbol strings
+ *
+ * A shared table that assigns ids 0, 1, 2, ... to symbol strings on first
+ * use. Every process sees the same id for the same string, so payloads and
+ * consumers can carry/index by id (plain arrays, compact bitmaps) instead
+ * of hashing strings or trusting a CRC that may collide.
+ *
+ *   - id -> name : direct array index, one cache line per symbol.
+ *   - name -> id : open-addressing index (2x capacity) of id+1 values.
+ *     New symbols are published by claiming an index slot (CAS to PENDING
+ *     tagged with the inserter's pid), taking the next id, writing the
+ *     entry and then storing id+1. Lookups never lock; they only wait out
+ *     a slot that is mid-insert, and reclaim it if the inserter has died.
+ *   - Entries are never removed, so ids stay valid for the table lifetime.
+ *
+ * Like UsrlMap the table is position independent: create it as its own
+ * SHM object or format it into an existing mapping.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "usrl_core.h"
+
+#define USRL_INTERN_MAGIC 0x5553494E /* 'USIN' */
+#define USRL_SYMBOL_MAX 48           /* bytes including NUL */
+#define USRL_INTERN_INVALID UINT32_MAX
+
+typedef struct __attribute__((aligned(USRL_ALIGNMENT)))
+{
+    uint32_t magic;               /* must equal USRL_INTERN_MAGIC */
+    uint32_t version;
+    uint64_t size;                /* total bytes including this header */
+    uint32_t capacity;            /* max symbols */
+    uint32_t index_slots;         /* power-of-two, >= 2 * capacity */
+    atomic_uint_fast32_t next_id; /* ids handed out so far */
+} UsrlInternHeader;
+
+typedef struct __attribute__((aligned(USRL_ALIGNMENT)))
+{
+    atomic_uint_fast32_t ready;   /* 1 once name/len/hash are written */
+    uint32_t hash;
+    uint32_t len;
+    char name[USRL_SYMBOL_MAX];   /* NUL-terminated */
+} UsrlSymbolEntry;
+
+/* Process-local handle */
+typedef struct
+{
+    UsrlInternHeader *hdr;
+    UsrlSymbolEntry *entries;
+    _Atomic uint32_t *index;
+    uint32_t mask;
+    size_t map_size;              /* non-zero when mapped by usrl_intern_open() */
+} UsrlIntern;
+
+/* Layout */
+uint64_t usrl_intern_required_size(uint32_t capacity);
+int usrl_intern_format(void *mem, uint64_t size, uint32_t capacity);
+int usrl_intern_attach(UsrlIntern *t, void *mem);
+
+/* Standalone SHM object (same return convention as usrl_core_init) */
+int usrl_intern_create(const char *path, uint32_t capacity);
+int usrl_intern_open(UsrlIntern *t, const char *path);
+void usrl_intern_close(UsrlIntern *t);
+
+/* Operations */
+uint32_t usrl_intern_id(UsrlIntern *t, const char *name, uint32_t len);     /* get or assign */
+uint32_t usrl_intern_lookup(const UsrlIntern *t, const char *name, uint32_t len);
+const char *usrl_intern_name(const UsrlIntern *t, uint32_t id);
+uint32_t usrl_intern_count(const UsrlIntern *t);
+
+#endif /* USRL_INTERN_H */
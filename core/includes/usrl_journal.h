@@ -0,0 +1,283 @@
+#ifndef USRL_JOURNAL_H
+#define USRL_JOURNAL_H
+
+/* --------------------------------------------------------------------------
+ * USRL Journal — append-only segment files recorded from a topic
+ *
+ * A topic's journal is a directory of segments, "<dir>/<topic>/<seq>.usj",
+ * where <seq> (20 digits) is the first seq the segment covers:
+ *
+ *   [UsrlJournalSegHeader][record][record]...[index]
+ *   record = UsrlJournalRecord + payload, padded to 8 bytes
+ *            [+ UsrlJournalTrace when rflags has USRL_JREC_F_TRACE]
+ *
+ *   - Records keep the ring's seq, timestamp_ns, pub_id and flags. Seqs
+ *     ascend but may have gaps (lapped recorder, compaction).
+ *   - A traced message (USRL_SLOT_F_TRACED) keeps its trace id and hop
+ *     stamps in a trailer after the payload; usrl_jrec_trace() and
+ *     usrl_view_trace() read it back (usrl_trace.h).
+ *   - The newest segment is the active one and has no SEALED flag: readers
+ *     scan it up to the first incomplete record. Sealing writes a sparse
+ *     (seq, time, offset) index after the last record and the final header.
+ *   - A segment "covers" first_seq..last_seq. After a compaction crash a
+ *     seq can be covered twice; readers skip seqs they have already seen.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "usrl_core.h"
+#include "usrl_ring.h"
+
+#define USRL_JOURNAL_MAGIC 0x524A5355  /* 'USJR' */
+#define USRL_JOURNAL_VERSION 1
+#define USRL_JOURNAL_EXT ".usj"
+#define USRL_JOURNAL_PATH_MAX 512
+
+#define USRL_JSEG_F_SEALED    0x0001
+#define USRL_JSEG_F_COMPACTED 0x0002
+
+#define USRL_JREC_F_TRACE     0x01      /* record carries a UsrlJournalTrace */
+
+#define USRL_JOURNAL_SEGMENT_BYTES (256ull << 20)  /* default roll size */
+#define USRL_JOURNAL_INDEX_EVERY   (64u << 10)     /* index entry per 64 KB */
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;             /* USRL_JSEG_F_* */
+    uint32_t hdr_size;          /* offset of the first record */
+    uint32_t _pad;
+    uint64_t first_seq;         /* covered range */
+    uint64_t last_seq;          /* sealed only */
+    uint64_t first_ns;          /* sealed only */
+    uint64_t last_ns;           /* sealed only */
+    uint64_t count;             /* records, sealed only */
+    uint64_t data_end;          /* end of the last record, sealed only */
+    uint64_t index_offset;      /* sealed only */
+    uint32_t index_count;
+    uint32_t _pad2;
+    char topic[USRL_MAX_TOPIC_NAME];
+    uint8_t _reserved[112];
+} UsrlJournalSegHeader;
+
+typedef struct
+{
+    uint64_t seq;
+    uint64_t timestamp_ns;
+    uint32_t len;
+    uint16_t pub_id;
+    uint8_t flags;              /* SlotHeader flags */
+    uint8_t rflags;             /* USRL_JREC_F_* */
+} UsrlJournalRecord;
+
+/* SlotHeader trace context, as journaled */
+typedef struct
+{
+    uint64_t trace_id;
+    uint64_t origin_ns;
+    uint8_t hop_count;
+    uint8_t _pad;
+    uint16_t hop_id[USRL_TRACE_MAX_HOPS];
+    uint16_t _pad2;
+    uint32_t hop_ns[USRL_TRACE_MAX_HOPS];
+} UsrlJournalTrace;
+
+typedef struct
+{
+    uint64_t seq;
+    uint64_t timestamp_ns;
+    uint64_t offset;
+} UsrlJournalIndexEntry;
+
+#ifndef __cplusplus
+_Static_assert(sizeof(UsrlJournalSegHeader) == 256, "segment header size");
+_Static_assert(sizeof(UsrlJournalRecord) == 24, "record header size");
+_Static_assert(sizeof(UsrlJournalTrace) == 48, "record trace size");
+#endif
+
+/* Untraced record size; a trace trailer adds sizeof(UsrlJournalTrace) */
+static inline uint64_t usrl_journal_record_size(uint32_t len)
+{
+    return usrl_align_up(sizeof(UsrlJournalRecord) + len, 8);
+}
+
+static inline uint64_t usrl_jrec_size(const UsrlJournalRecord *r)
+{
+    return usrl_journal_record_size(r->len) +
+           ((r->rflags & USRL_JREC_F_TRACE) ? sizeof(UsrlJournalTrace) : 0);
+}
+
+/* The record's trace trailer, or NULL */
+static inline const UsrlJournalTrace *usrl_jrec_trailer(const UsrlJournalRecord *r)
+{
+    if (!(r->rflags & USRL_JREC_F_TRACE)) return NULL;
+    return (const UsrlJournalTrace *)((const uint8_t *)r + usrl_journal_record_size(r->len));
+}
+
+/* Trace context of a slot; returns 0 (and leaves t alone) if it is not traced */
+static inline int usrl_jrec_trace_from_slot(const SlotHeader *h, UsrlJournalTrace *t)
+{
+    if (!(h->flags & USRL_SLOT_F_TRACED)) return 0;
+    t->trace_id = h->trace_id;
+    t->origin_ns = h->origin_ns;
+    t->hop_count = h->hop_count;
+    t->_pad = 0;
+    t->_pad2 = 0;
+    for (int i = 0; i < USRL_TRACE_MAX_HOPS; i++) {
+        t->hop_id[i] = h->hop_id[i];
+        t->hop_ns[i] = h->hop_ns[i];
+    }
+    return 1;
+}
+
+/* --------------------------------------------------------------------------
+ * Writer
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    char dir[USRL_JOURNAL_PATH_MAX];    /* "<dir>/<topic>" */
+    char topic[USRL_MAX_TOPIC_NAME];
+    uint64_t segment_bytes;
+    uint16_t seg_flags;                 /* extra flags for new segments */
+    const char *suffix;                 /* appended to new segment names */
+
+    int fd;                             /* active segment, -1 = none */
+    int dir_dirty;                      /* segment created since the last sync */
+    uint64_t seg_first_seq;
+    uint64_t file_off;                  /* bytes written to fd */
+    uint8_t *buf;
+    uint32_t buf_len;
+    uint32_t buf_cap;
+
+    UsrlJournalIndexEntry *index;
+    uint32_t index_count;
+    uint32_t index_cap;
+    uint64_t next_index_off;
+
+    uint64_t seg_count;
+    uint64_t seg_first_ns;
+    uint64_t last_seq;                  /* last appended, across segments */
+    uint64_t last_ns;
+    uint64_t cover_first;               /* override for the next segment's first_seq */
+    uint64_t cover_last;                /* override for the final last_seq */
+
+    /* Stats */
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t segments;
+    uint64_t syncs;
+    uint64_t lapped;                    /* recorder: overwritten before copied */
+} UsrlJournalWriter;
+
+/*
+ * Open a topic journal under dir (created if missing). An unsealed segment
+ * left by a previous run is repaired (torn tail cut) and sealed; appends go
+ * to a new segment. Returns 0 or -1.
+ */
+int usrl_journal_writer_open(UsrlJournalWriter *w, const char *dir, const char *topic,
+                             uint64_t segment_bytes);
+void usrl_journal_writer_close(UsrlJournalWriter *w);
+
+/* Append one record (buffered); rolls to a new segment past segment_bytes.
+ * usrl_journal_append() has no trace context and clears USRL_SLOT_F_TRACED. */
+int usrl_journal_append(UsrlJournalWriter *w, uint64_t seq, uint64_t timestamp_ns,
+                        uint16_t pub_id, uint8_t flags, const void *data, uint32_t len);
+int usrl_journal_append_traced(UsrlJournalWriter *w, uint64_t seq, uint64_t timestamp_ns,
+                               uint16_t pub_id, uint8_t flags, const UsrlJournalTrace *trace,
+                               const void *data, uint32_t len);
+
+/* Write buffered records to the file / also fdatasync */
+int usrl_journal_flush(UsrlJournalWriter *w);
+int usrl_journal_sync(UsrlJournalWriter *w);
+
+/* Seal the active segment; the next append starts a new one */
+int usrl_journal_roll(UsrlJournalWriter *w);
+
+/* Recorder step: append up to max_batch committed records from sub */
+int usrl_journal_record(UsrlJournalWriter *w, UsrlSubscriber *sub, uint32_t max_batch);
+
+/* --------------------------------------------------------------------------
+ * Reader (mmap)
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    char path[USRL_JOURNAL_PATH_MAX];
+    const uint8_t *base;
+    uint64_t size;                      /* mapped bytes */
+    const UsrlJournalSegHeader *hdr;
+    uint64_t data_end;                  /* sealed: header; active: scanned at open */
+    const UsrlJournalIndexEntry *index;
+    uint32_t index_count;
+} UsrlJournalSegment;
+
+int usrl_jseg_open(UsrlJournalSegment *s, const char *path);
+void usrl_jseg_close(UsrlJournalSegment *s);
+
+/* Record at off, or NULL at the end of the data */
+static inline const UsrlJournalRecord *usrl_jseg_record(const UsrlJournalSegment *s, uint64_t off)
+{
+    if (off + sizeof(UsrlJournalRecord) > s->data_end) return NULL;
+    return (const UsrlJournalRecord *)(s->base + off);
+}
+
+static inline const uint8_t *usrl_jseg_payload(const UsrlJournalRecord *r)
+{
+    return (const uint8_t *)(r + 1);
+}
+
+static inline uint64_t usrl_jseg_next(const UsrlJournalRecord *r, uint64_t off)
+{
+    return off + usrl_jrec_size(r);
+}
+
+static inline uint64_t usrl_jseg_begin(const UsrlJournalSegment *s)
+{
+    return s->hdr->hdr_size;
+}
+
+/* Offset of the first record with seq >= seq / timestamp_ns >= ts */
+uint64_t usrl_jseg_seek_seq(const UsrlJournalSegment *s, uint64_t seq);
+uint64_t usrl_jseg_seek_time(const UsrlJournalSegment *s, uint64_t ts);
+
+/* Segments of a topic, sorted by first_seq. Fills up to max entries and
+ * returns the total count (out may be NULL with max 0 to size it). */
+typedef struct {
+    char path[USRL_JOURNAL_PATH_MAX];
+    uint64_t first_seq;
+} UsrlJournalSegInfo;
+
+int usrl_journal_list(const char *dir, const char *topic, UsrlJournalSegInfo *out, uint32_t max);
+
+/* --------------------------------------------------------------------------
+ * Compaction
+ *
+ * Rewrites a topic's sealed segments keeping, per key, only the newest
+ * record, plus every record within horizon_ns of the newest timestamp. The
+ * active segment is never touched, so it runs beside a live recorder.
+ *
+ *   - One sequential pass builds a hash index key -> newest record, a second
+ *     pass copies the survivors in seq order into new segments.
+ *   - Outputs are written under a temporary name, synced, then renamed over
+ *     the inputs; records with no key (too short) are kept.
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    uint32_t key_offset;                /* key bytes in the payload */
+    uint32_t key_len;                   /* 0 = key is pub_id */
+    uint64_t horizon_ns;                /* 0 = newest per key only */
+    uint64_t segment_bytes;             /* output roll size, 0 = default */
+} UsrlCompactSpec;
+
+typedef struct {
+    uint64_t segments_in;
+    uint64_t segments_out;
+    uint64_t records_in;
+    uint64_t records_out;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t keys;
+} UsrlCompactStats;
+
+/* Returns 0 (nothing to do is success), -1 on error */
+int usrl_journal_compact(const char *dir, const char *topic, const UsrlCompactSpec *spec,
+                         UsrlCompactStats *stats);
+
+#endif /* USRL_JOURNAL_H */
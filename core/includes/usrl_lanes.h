@@ -0,0 +1,81 @@
+#ifndef USRL_LANES_H
+#define USRL_LANES_H
+
+/* --------------------------------------------------------------------------
+ * USRL Priority Lanes
+ *
+ * One logical topic backed by up to USRL_MAX_LANES rings in the same region,
+ * named "<topic>#p0" .. "<topic>#pN-1". Lane 0 is the most urgent.
+ *
+ *  - Subscribers always drain higher lanes before lower ones, re-checking
+ *    the higher lanes after every lower-lane message.
+ *  - Publishers shed low lanes first, on two signals:
+ *      - rate: lanes share one budget, and lane k may only use (N - k) / N
+ *        of it, so lane 0 always keeps headroom;
+ *      - fill: lane k sheds while a more urgent lane's ring is over
+ *        (N - k) / N full. Only gated rings (with pipeline stages) fill;
+ *        on ungated lanes without a rate budget nothing is shed.
+ *    An MWMR writer timeout is returned, not retried: a retry would claim
+ *    a second seq.
+ *
+ * Lanes are a core-level API: create them with usrl_lanes_expand() and
+ * usrl_core_init(). The usrl_pub_create() facade and usrl.py do not
+ * expose them.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_backpressure.h"
+
+#define USRL_MAX_LANES 4
+#define USRL_LANE_NAME_FMT "%s#p%u"
+
+/* Publisher Handle (lanes share ring type with lane 0) */
+typedef struct {
+    uint32_t lane_count;
+    bool is_mwmr;
+    UsrlPublisher swmr[USRL_MAX_LANES];
+    UsrlMwmrPublisher mwmr[USRL_MAX_LANES];
+    PublishQuota quota;             /* shared budget for all lanes */
+    bool use_limiter;
+    uint32_t shed_mask;             /* bit k: lane k shed for ring fill */
+    uint32_t fill_countdown;        /* publishes until the next fill check */
+    uint64_t shed[USRL_MAX_LANES];  /* messages dropped per lane */
+} UsrlLanePublisher;
+
+/* Subscriber Handle */
+typedef struct {
+    uint32_t lane_count;
+    UsrlSubscriber lanes[USRL_MAX_LANES];
+} UsrlLaneSubscriber;
+
+/* One message returned by a batch read; data points into the caller arena */
+typedef struct {
+    uint8_t *data;
+    uint32_t len;
+    uint16_t pub_id;
+    uint16_t lane;
+} UsrlLaneMsg;
+
+/*
+ * Expand one topic config into `lanes` lane configs for usrl_core_init().
+ * Returns the number of configs written, or -1 if the name does not fit.
+ */
+int usrl_lanes_expand(const UsrlTopicConfig *topic, uint32_t lanes,
+                      UsrlTopicConfig *out, uint32_t max_out);
+
+/* Publisher: returns lane count found (0 = topic has no lanes) */
+int usrl_lanes_pub_init(UsrlLanePublisher *p, void *core_base, const char *topic,
+                        uint16_t pub_id, uint64_t rate_limit_hz);
+int usrl_lanes_publish(UsrlLanePublisher *p, uint32_t lane, const void *data, uint32_t len);
+
+/* Subscriber: returns lane count found (0 = topic has no lanes) */
+int usrl_lanes_sub_init(UsrlLaneSubscriber *s, void *core_base, const char *topic);
+int usrl_lanes_sub_next(UsrlLaneSubscriber *s, uint8_t *out_buf, uint32_t buf_len,
+                        uint16_t *out_pub_id, uint32_t *out_lane);
+int usrl_lanes_sub_next_batch(UsrlLaneSubscriber *s, UsrlLaneMsg *msgs, uint32_t max_msgs,
+                              uint8_t *arena, uint32_t arena_len);
+
+#endif /* USRL_LANES_H */
@@ -0,0 +1,94 @@
+#ifndef USRL_MAP_H
+#define USRL_MAP_H
+
+/* --------------------------------------------------------------------------
+ * USRL Shared Map — fixed-capacity concurrent hash map in shared memory
+ *
+ * Reference data (e.g. ticker_crc -> instrument) shared by every process
+ * instead of being rebuilt per process.
+ *
+ *   - Open addressing with linear probing over a power-of-two bucket array.
+ *   - Keys are uint64_t; 0 is reserved as the empty marker.
+ *   - Each bucket carries its own seqlock. Readers only retry while a
+ *     writer holds that one bucket.
+ *   - Writers claim empty buckets with a CAS on the key and serialise
+ *     updates to a bucket through its seqlock, so any number of processes
+ *     may update concurrently.
+ *   - The seqlock word carries the writer's pid. A bucket whose writer died
+ *     mid-update is taken back by the next reader or writer that waits on
+ *     it: the half-written value is dropped (the key reads as erased).
+ *   - A bucket (header + value) is padded to whole cache lines; small
+ *     values are found in one or two cache misses.
+ *   - Keys are never removed from their bucket; erase only clears the value,
+ *     which keeps probe chains intact.
+ *
+ * The map is position independent (no pointers), so it can be formatted
+ * into any shared mapping with usrl_map_format(), or created as its own
+ * POSIX SHM object with usrl_map_create().
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "usrl_core.h"
+
+#define USRL_MAP_MAGIC 0x55534D50 /* 'USMP' */
+#define USRL_MAP_VERSION 2        /* 2: writer pid in the bucket seqlock */
+#define USRL_MAP_EMPTY_KEY 0
+
+/* Return codes (aligned with USRL_RING_*) */
+#define USRL_MAP_OK          0
+#define USRL_MAP_ERROR      -1
+#define USRL_MAP_FULL       -2   /* No free bucket / value too large */
+#define USRL_MAP_TRUNC      -3   /* Output buffer too small */
+#define USRL_MAP_NOT_FOUND  -11
+
+typedef struct __attribute__((aligned(USRL_ALIGNMENT)))
+{
+    uint32_t magic;             /* must equal USRL_MAP_MAGIC */
+    uint32_t version;
+    uint64_t size;              /* total bytes including this header */
+    uint32_t capacity;          /* buckets, power-of-two */
+    uint32_t value_size;        /* max bytes per value */
+    uint32_t bucket_size;       /* bucket stride (cache-line multiple) */
+    uint32_t _pad;
+    atomic_uint_fast32_t count; /* live keys */
+} UsrlMapHeader;
+
+typedef struct
+{
+    atomic_uint_fast64_t key;   /* USRL_MAP_EMPTY_KEY until claimed */
+    atomic_uint_fast64_t seq;   /* seqlock: low 32 bits odd while written, high 32 = writer pid */
+    uint16_t value_len;
+    uint16_t live;              /* 0 = erased / never written */
+    uint32_t _pad;
+    /* value bytes follow */
+} UsrlMapBucket;
+
+/* Process-local handle */
+typedef struct
+{
+    UsrlMapHeader *hdr;
+    uint8_t *buckets;
+    uint32_t mask;
+    uint32_t stride;
+    size_t map_size;            /* non-zero when mapped by usrl_map_open() */
+} UsrlMap;
+
+/* Layout */
+uint64_t usrl_map_required_size(uint32_t capacity, uint32_t value_size);
+int usrl_map_format(void *mem, uint64_t size, uint32_t capacity, uint32_t value_size);
+int usrl_map_attach(UsrlMap *m, void *mem);
+
+/* Standalone SHM object (same return convention as usrl_core_init) */
+int usrl_map_create(const char *path, uint32_t capacity, uint32_t value_size);
+int usrl_map_open(UsrlMap *m, const char *path);
+void usrl_map_close(UsrlMap *m);
+
+/* Operations */
+int usrl_map_put(UsrlMap *m, uint64_t key, const void *value, uint32_t len);
+int usrl_map_get(const UsrlMap *m, uint64_t key, void *out, uint32_t max_len);
+int usrl_map_erase(UsrlMap *m, uint64_t key);
+uint32_t usrl_map_count(const UsrlMap *m);
+
+#endif /* USRL_MAP_H */
@@ -0,0 +1,128 @@
+#ifndef USRL_METRICS_H
+#define USRL_METRICS_H
+
+/* --------------------------------------------------------------------------
+ * USRL Metrics Registry — counters, gauges and histograms by name
+ *
+ * Metrics are cells in a fixed-capacity table. Registration (by name) is a
+ * lock-free claim done once; after that an update is a single relaxed
+ * atomic on the cell (histograms: one for the bucket, one for the sum).
+ *
+ *   - The table is position independent. Keep it process-local
+ *     (usrl_metrics_init) or put it in SHM (usrl_metrics_create/open):
+ *     every process that registers the same name updates the same cell,
+ *     so values aggregate across processes for free.
+ *   - A background flusher scrapes the table periodically; readers never
+ *     stall writers.
+ *   - usrl_log_metric() records into the default registry (a gauge named
+ *     "<module>.<metric>") and the logging flusher writes it out.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "usrl_core.h"
+
+#define USRL_METRICS_MAGIC 0x55534D54 /* 'USMT' */
+#define USRL_METRIC_NAME_MAX 48       /* bytes including NUL */
+#define USRL_METRIC_HIST_BUCKETS 32   /* bucket i: [2^i, 2^(i+1)), last is open */
+#define USRL_METRIC_CLAIMING 0x80000000u /* cell state: | registrant pid */
+
+typedef enum {
+    USRL_METRIC_COUNTER = 1,
+    USRL_METRIC_GAUGE   = 2,
+    USRL_METRIC_HIST    = 3,
+} UsrlMetricKind;
+
+typedef struct __attribute__((aligned(USRL_ALIGNMENT)))
+{
+    uint32_t magic;               /* must equal USRL_METRICS_MAGIC */
+    uint32_t version;
+    uint64_t size;                /* total bytes including this header */
+    uint32_t capacity;            /* cells, power-of-two */
+    uint32_t _pad;
+    atomic_uint_fast32_t count;   /* registered cells */
+} UsrlMetricsHeader;
+
+typedef struct __attribute__((aligned(USRL_ALIGNMENT)))
+{
+    atomic_uint_fast32_t state;   /* 0 free, 2 ready, USRL_METRIC_CLAIMING | pid while named */
+    uint32_t kind;                /* UsrlMetricKind */
+    char name[USRL_METRIC_NAME_MAX];
+
+    /* Hot fields start on their own cache line */
+    atomic_int_fast64_t value __attribute__((aligned(USRL_ALIGNMENT))); /* counter / gauge / hist sum */
+    atomic_uint_fast64_t buckets[USRL_METRIC_HIST_BUCKETS];             /* histograms only */
+} UsrlMetricCell;
+
+/* Process-local handle */
+typedef struct UsrlMetrics
+{
+    UsrlMetricsHeader *hdr;
+    UsrlMetricCell *cells;
+    uint32_t mask;
+    size_t map_size;              /* non-zero when mapped by usrl_metrics_open() */
+    int owned;                    /* heap table from usrl_metrics_init() */
+
+    /* Flusher */
+    pthread_t flusher;
+    atomic_int flusher_run;
+    uint32_t flush_interval_ms;
+    void (*sink)(const struct UsrlMetrics *m, void *arg);
+    void *sink_arg;
+} UsrlMetrics;
+
+/* Layout */
+uint64_t usrl_metrics_required_size(uint32_t capacity);
+int usrl_metrics_format(void *mem, uint64_t size, uint32_t capacity);
+int usrl_metrics_attach(UsrlMetrics *m, void *mem);
+
+/* Process-local table */
+int usrl_metrics_init(UsrlMetrics *m, uint32_t capacity);
+void usrl_metrics_free(UsrlMetrics *m);
+
+/* Standalone SHM object (same return convention as usrl_core_init) */
+int usrl_metrics_create(const char *path, uint32_t capacity);
+int usrl_metrics_open(UsrlMetrics *m, const char *path);
+void usrl_metrics_close(UsrlMetrics *m);
+
+/* Registration (get or create; NULL if full or registered with another kind) */
+UsrlMetricCell *usrl_metric_counter(UsrlMetrics *m, const char *name);
+UsrlMetricCell *usrl_metric_gauge(UsrlMetrics *m, const char *name);
+UsrlMetricCell *usrl_metric_hist(UsrlMetrics *m, const char *name);
+
+/* Updates */
+static inline void usrl_metric_add(UsrlMetricCell *c, int64_t v) {
+    atomic_fetch_add_explicit(&c->value, v, memory_order_relaxed);
+}
+
+static inline void usrl_metric_set(UsrlMetricCell *c, int64_t v) {
+    atomic_store_explicit(&c->value, v, memory_order_relaxed);
+}
+
+static inline void usrl_metric_observe(UsrlMetricCell *c, uint64_t v) {
+    uint32_t b = (v == 0) ? 0 : (uint32_t)(63 - __builtin_clzll(v));
+    if (b >= USRL_METRIC_HIST_BUCKETS) b = USRL_METRIC_HIST_BUCKETS - 1;
+    atomic_fetch_add_explicit(&c->buckets[b], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->value, (int64_t)v, memory_order_relaxed);
+}
+
+/* Scrape */
+int64_t usrl_metric_read(const UsrlMetricCell *c);
+uint64_t usrl_metric_hist_count(const UsrlMetricCell *c);
+uint64_t usrl_metric_hist_quantile(const UsrlMetricCell *c, double q);
+uint32_t usrl_metrics_count(const UsrlMetrics *m);
+int usrl_metrics_dump(const UsrlMetrics *m, FILE *out);
+
+/* Background flusher: calls sink(m, arg) every interval_ms (default sink dumps to stderr) */
+int usrl_metrics_flusher_start(UsrlMetrics *m, uint32_t interval_ms,
+                               void (*sink)(const UsrlMetrics *m, void *arg), void *arg);
+void usrl_metrics_flusher_stop(UsrlMetrics *m);
+
+/* Default registry used by usrl_log_metric() (heap table until replaced) */
+UsrlMetrics *usrl_metrics_default(void);
+void usrl_metrics_set_default(UsrlMetrics *m);
+
+#endif /* USRL_METRICS_H */
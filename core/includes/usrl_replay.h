@@ -0,0 +1,97 @@
+#ifndef USRL_REPLAY_H
+#define USRL_REPLAY_H
+
+/* --------------------------------------------------------------------------
+ * USRL Replay Subscriber — journal history, then the live ring
+ *
+ * Starts at a seq or timestamp in the topic journal (usrl_journal.h),
+ * streams the mmap'd segments in batches, and hands over to the ring once
+ * it has caught up within the ring's retained window. Delivery is in seq
+ * order with no duplicates:
+ *
+ *   - History: records come straight from the segment mappings. When the
+ *     journal runs out the segment list is reloaded (at most every
+ *     USRL_REPLAY_RESCAN_NS), so a live recorder's active segment is
+ *     followed as it grows.
+ *   - Hand-over: once the next seq is still held by the ring, reading
+ *     continues there from the same seq.
+ *   - Live: if the ring laps the reader it falls back to the journal for
+ *     the missed seqs instead of skipping them.
+ *   - A seq neither source holds (no recorder, a journal gap the ring no
+ *     longer covers, or a recorder that fell behind for longer than
+ *     stall_timeout_ns) is counted in gap_count and skipped.
+ *
+ * Timestamps are SlotHeader.timestamp_ns (CLOCK_MONOTONIC).
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_journal.h"
+#include "usrl_trace.h"
+
+#define USRL_REPLAY_STALL_NS 1000000000ull    /* default: 1 s */
+#define USRL_REPLAY_RESCAN_NS 1000000ull      /* segment re-list interval once caught up */
+
+typedef struct {
+    UsrlSubscriber sub;             /* sub.last_seq = last delivered seq */
+    char dir[USRL_JOURNAL_PATH_MAX];
+    char topic[USRL_MAX_TOPIC_NAME];
+    uint64_t from_ns;               /* skip older records until the first delivery */
+    uint64_t stall_timeout_ns;      /* wait for the journal before skipping a gap */
+    int live;
+
+    /* History cursor */
+    UsrlJournalSegment seg;
+    int seg_open;
+    uint64_t off;
+    uint64_t stall_since_ns;
+    uint64_t rescan_at_ns;          /* no segment re-list before this (0 = now) */
+    const UsrlJournalRecord *last_rec; /* usrl_replay_next() from the journal, else NULL */
+
+    /* Stats */
+    uint64_t replayed;              /* delivered from the journal */
+    uint64_t handovers;             /* journal -> ring switches */
+    uint64_t fallbacks;             /* ring -> journal after a lap */
+    uint64_t gap_count;             /* seqs in neither source */
+} UsrlReplaySubscriber;
+
+/*
+ * from_seq: first seq to deliver (0 = the start of the journal).
+ * from_ns:  first timestamp to deliver (0 = no time bound).
+ * Returns 0 or -1 (unknown topic).
+ */
+int usrl_replay_init(UsrlReplaySubscriber *s, void *core_base, const char *topic,
+                     const char *journal_dir, uint64_t from_seq, uint64_t from_ns);
+void usrl_replay_close(UsrlReplaySubscriber *s);
+
+/* Copy the next message; like usrl_sub_next(), plus its seq */
+int usrl_replay_next(UsrlReplaySubscriber *s, uint8_t *out_buf, uint32_t buf_len,
+                     uint16_t *out_pub_id, uint64_t *out_seq);
+
+/* Trace context of the message usrl_replay_next() last returned, from
+ * either source; same results as usrl_sub_last_trace() */
+int usrl_replay_last_trace(const UsrlReplaySubscriber *s, UsrlTraceContext *out);
+
+/*
+ * Up to max_views zero-copy views, all from one source. Journal views
+ * (hdr == NULL) stay valid until the next call; ring views must pass
+ * usrl_replay_view_valid(). If one does not, usrl_replay_rewind() to its
+ * seq re-reads it from the journal. usrl_view_trace() works on both.
+ */
+int usrl_replay_batch(UsrlReplaySubscriber *s, UsrlSlotView *views, uint32_t max_views);
+
+static inline int usrl_replay_view_valid(const UsrlSlotView *v)
+{
+    return v->hdr == NULL || usrl_view_valid(v);
+}
+
+/* Deliver again from seq (<= the last delivered), reading the journal */
+void usrl_replay_rewind(UsrlReplaySubscriber *s, uint64_t seq);
+
+static inline int usrl_replay_is_live(const UsrlReplaySubscriber *s)
+{
+    return s->live;
+}
+
+#endif /* USRL_REPLAY_H */
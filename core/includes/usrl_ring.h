@@ -19,9 +19,10 @@
  */
 #define USRL_RING_OK          0
 #define USRL_RING_ERROR      -1
-#define USRL_RING_FULL       -2   /* Payload too large for slot */
+#define USRL_RING_FULL       -2   /* Payload too large / gated by a stage */
 #define USRL_RING_TRUNC      -3   /* Buffer too small (Reader) */
 #define USRL_RING_TIMEOUT    -4   /* Spinlock timeout (MWMR Writer) */
+#define USRL_RING_SKIPPED    -5   /* Hole timed out (reorder subscriber) */
 #define USRL_RING_NO_DATA    -11  /* EAGAIN style - Nothing to read */
 
 /* Publisher Handle (SWMR) */
@@ -30,6 +31,14 @@ typedef struct {
     uint8_t *base_ptr;
     uint32_t mask;
     uint16_t pub_id;
+    TopicExt *ext;  /* stage cursors (NULL on v1 regions) */
+    uint64_t gate;  /* cached last-stage cursor */
+    uint64_t last_seq; /* seq of the last successful publish */
+
+    /* Trace sampling (0 = off), see usrl_trace.h */
+    uint32_t trace_every;
+    uint32_t trace_countdown;
+    uint64_t trace_count;
 } UsrlPublisher;
 
 /* Subscriber Handle (Shared SWMR/MWMR) */
@@ -39,16 +48,90 @@ typedef struct {
     uint32_t mask;
     uint64_t last_seq;
     uint64_t skipped_count; /* Internal skip tracker */
+
+    /* Message TTL (0 = disabled), see usrl_sub_set_max_age() */
+    uint64_t max_age_ns;
+    uint64_t expired_count; /* Slots fast-forwarded as stale */
+    uint64_t clock_ns;      /* Cached CLOCK_MONOTONIC */
+    uint32_t clock_tick;
 } UsrlSubscriber;
 
+/* Zero-copy view of one committed slot.
+ *
+ * The payload stays in shared memory; a writer may lap the slot at any
+ * time. Read what you need, then confirm with usrl_view_valid() before
+ * acting on it.
+ */
+typedef struct {
+    const uint8_t *data;
+    uint32_t len;
+    uint16_t pub_id;
+    uint64_t seq;
+    uint64_t timestamp_ns;
+    const SlotHeader *hdr;
+    const RingDesc *desc;
+} UsrlSlotView;
+
+/* Still intact if the slot kept its seq and no writer has claimed it since
+ * (w_head moves before a writer touches the payload). */
+static inline int usrl_view_valid(const UsrlSlotView *v) {
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t seq = atomic_load_explicit(&((SlotHeader *)v->hdr)->seq, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&((RingDesc *)v->desc)->w_head, memory_order_relaxed);
+    return seq == v->seq && head - v->seq < v->desc->slot_count;
+}
+
 /* Publisher Handle (MWMR) */
 typedef struct {
     RingDesc *desc;
     uint8_t *base_ptr;
     uint32_t mask;
     uint16_t pub_id;
+    TopicExt *ext;  /* stage cursors (NULL on v1 regions) */
+    uint64_t gate;  /* cached last-stage cursor */
+    uint64_t last_seq; /* seq of the last successful publish */
+
+    /* Trace sampling (0 = off), see usrl_trace.h */
+    uint32_t trace_every;
+    uint32_t trace_countdown;
+    uint64_t trace_count;
 } UsrlMwmrPublisher;
 
+/* --------------------------------------------------------------------------
+ * Stage gate
+ *
+ * True if claiming seq `next` would overwrite a slot the last pipeline
+ * stage has not finished. The last-stage cursor is cached in the publisher
+ * and only reloaded when the cached value would block.
+ * -------------------------------------------------------------------------- */
+static inline int usrl_stage_gated(TopicExt *x, uint64_t *gate, uint64_t next, uint32_t slots) {
+    uint32_t n = (uint32_t)atomic_load_explicit(&x->stage_count, memory_order_relaxed);
+    if (USRL_LIKELY(n == 0)) return 0;
+    if (USRL_LIKELY(next <= *gate + slots)) return 0;
+    *gate = atomic_load_explicit(&x->stages[n - 1].seq, memory_order_acquire);
+    return next > *gate + slots;
+}
+
+/* Subscriber Handle (MWMR, out-of-order consumption)
+ *
+ * Delivers committed slots past an uncommitted hole, up to `window` seqs
+ * ahead of the oldest unresolved one. Bit i of `done_mask` marks seq
+ * sub.last_seq + 1 + i as already delivered (or skipped); every seq up to
+ * sub.last_seq is resolved. A hole open for longer than hole_timeout_ns
+ * is reported once as USRL_RING_SKIPPED.
+ */
+#define USRL_REORDER_MAX_WINDOW 64
+
+typedef struct {
+    UsrlSubscriber sub;
+    uint64_t done_mask;
+    uint32_t window;
+    uint64_t hole_timeout_ns;
+    uint64_t hole_seq;       /* oldest hole being timed (0 = none) */
+    uint64_t hole_since_ns;
+    uint64_t reordered_count; /* delivered ahead of an older hole */
+} UsrlReorderSubscriber;
+
 /* --------------------------------------------------------------------------
  * API Prototypes
  * -------------------------------------------------------------------------- */
@@ -61,9 +144,20 @@ int usrl_pub_publish(UsrlPublisher *p, const void *data, uint32_t len);
 void usrl_mwmr_pub_init(UsrlMwmrPublisher *p, void *core_base, const char *topic, uint16_t pub_id);
 int usrl_mwmr_pub_publish(UsrlMwmrPublisher *p, const void *data, uint32_t len);
 
+/* Publish a latency probe: flagged USRL_SLOT_F_PROBE, skipped by subscribers */
+int usrl_mwmr_pub_probe(UsrlMwmrPublisher *p, const void *data, uint32_t len);
+
 /* Subscriber (Common) */
 void usrl_sub_init(UsrlSubscriber *s, void *core_base, const char *topic);
 int usrl_sub_next(UsrlSubscriber *s, uint8_t *out_buf, uint32_t buf_len, uint16_t *out_pub_id);
+void usrl_sub_set_max_age(UsrlSubscriber *s, uint64_t max_age_ns);
+int usrl_sub_view_batch(UsrlSubscriber *s, UsrlSlotView *views, uint32_t max_views);
+
+/* Reorder Subscriber (MWMR) */
+void usrl_reorder_sub_init(UsrlReorderSubscriber *s, void *core_base, const char *topic,
+                           uint32_t window, uint64_t hole_timeout_ns);
+int usrl_reorder_sub_next(UsrlReorderSubscriber *s, uint8_t *out_buf, uint32_t buf_len,
+                          uint16_t *out_pub_id, uint64_t *out_seq);
 
 /* Telemetry Helpers */
 uint64_t usrl_swmr_total_published(void *ring_desc);
@@ -0,0 +1,126 @@
+#ifndef USRL_RING_INLINE_H
+#define USRL_RING_INLINE_H
+
+/* --------------------------------------------------------------------------
+ * USRL Ring Hot Paths — header-only SWMR publish / subscriber read
+ *
+ * usrl_pub_publish() and usrl_sub_next() are out-of-line in libusrl_core,
+ * so every message pays a call through the PLT and the compiler cannot
+ * specialise on a constant length. These inline versions work on the same
+ * handles and shared-memory layout, and mix freely with the library calls
+ * on the same handle:
+ *
+ *   - Only the common case is inlined. Trace sampling, TTL skipping, lag
+ *     jumps, lapped slots and probes call the library function, which
+ *     handles them exactly as before.
+ *   - Handle null checks are debug checks: compiled in without
+ *     optimisation or with USRL_DEBUG_CHECKS, compiled out otherwise.
+ *   - Define USRL_INLINE_HOT_PATH before including this header to route
+ *     usrl_pub_publish() / usrl_sub_next() calls in that translation unit
+ *     here. The exported symbols are unchanged.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "usrl_core.h"
+#include "usrl_ring.h"
+
+#if defined(USRL_DEBUG_CHECKS) || !defined(__OPTIMIZE__)
+#define USRL_HOT_CHECK(cond, rc) do { if (USRL_UNLIKELY(!(cond))) return (rc); } while (0)
+#else
+#define USRL_HOT_CHECK(cond, rc) do { } while (0)
+#endif
+
+static inline uint64_t usrl_hot_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* SWMR publish; same contract as usrl_pub_publish() */
+static inline int usrl_pub_publish_inline(UsrlPublisher *p, const void *data, uint32_t len)
+{
+    USRL_HOT_CHECK(p && p->desc && data, USRL_RING_ERROR);
+    if (USRL_UNLIKELY(p->trace_every)) return usrl_pub_publish(p, data, len);
+
+    RingDesc *d = p->desc;
+    if (USRL_UNLIKELY(len > (d->slot_size - sizeof(SlotHeader)))) return USRL_RING_FULL;
+
+    uint64_t head = atomic_load_explicit(&d->w_head, memory_order_relaxed);
+    if (p->ext && USRL_UNLIKELY(usrl_stage_gated(p->ext, &p->gate, head + 1, d->slot_count)))
+        return USRL_RING_FULL;
+
+    /* Single writer: a plain store replaces the locked fetch_add. The fence
+     * keeps w_head ahead of the payload stores (usrl_view_valid). */
+    uint64_t commit_seq = head + 1;
+    atomic_store_explicit(&d->w_head, commit_seq, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    uint8_t *slot = p->base_ptr + ((uint64_t)((commit_seq - 1) & p->mask) * d->slot_size);
+    SlotHeader *hdr = (SlotHeader *)slot;
+
+    memcpy(slot + sizeof(SlotHeader), data, len);
+    hdr->payload_len = len;
+    hdr->pub_id = p->pub_id;
+    hdr->timestamp_ns = usrl_hot_clock_ns();
+    hdr->flags = 0;
+
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&hdr->seq, commit_seq, memory_order_release);
+    p->last_seq = commit_seq;
+    return USRL_RING_OK;
+}
+
+/* Subscriber read; same contract as usrl_sub_next() */
+static inline int usrl_sub_next_inline(UsrlSubscriber *s, uint8_t *out_buf, uint32_t buf_len,
+                                       uint16_t *out_pub_id)
+{
+    USRL_HOT_CHECK(s && s->desc && out_buf, USRL_RING_ERROR);
+    if (USRL_UNLIKELY(s->max_age_ns)) return usrl_sub_next(s, out_buf, buf_len, out_pub_id);
+
+    RingDesc *d = s->desc;
+    uint64_t w_head = atomic_load_explicit(&d->w_head, memory_order_acquire);
+    uint64_t next = s->last_seq + 1;
+    if (next > w_head) return USRL_RING_NO_DATA;
+    if (USRL_UNLIKELY(w_head - next >= d->slot_count))
+        return usrl_sub_next(s, out_buf, buf_len, out_pub_id); /* lag jump */
+
+    const uint8_t *slot = s->base_ptr + ((uint64_t)((next - 1) & s->mask) * d->slot_size);
+    const SlotHeader *hdr = (const SlotHeader *)slot;
+
+    uint64_t seq = atomic_load_explicit(&((SlotHeader *)hdr)->seq, memory_order_acquire);
+    if (USRL_UNLIKELY(seq != next)) {
+        if (seq == 0 || seq < next) return USRL_RING_NO_DATA;
+        return usrl_sub_next(s, out_buf, buf_len, out_pub_id); /* lapped */
+    }
+    if (USRL_UNLIKELY(hdr->flags & USRL_SLOT_F_PROBE))
+        return usrl_sub_next(s, out_buf, buf_len, out_pub_id);
+
+    uint32_t payload_len = hdr->payload_len;
+    if (USRL_UNLIKELY(payload_len > buf_len)) {
+        s->last_seq = next;
+        return USRL_RING_TRUNC;
+    }
+
+    memcpy(out_buf, slot + sizeof(SlotHeader), payload_len);
+    if (out_pub_id) *out_pub_id = hdr->pub_id;
+
+    atomic_thread_fence(memory_order_acquire);
+    if (USRL_UNLIKELY(atomic_load_explicit(&((SlotHeader *)hdr)->seq, memory_order_relaxed) != seq)) {
+        s->skipped_count++;
+        s->last_seq = w_head;
+        return USRL_RING_NO_DATA;
+    }
+
+    s->last_seq = next;
+    return (int)payload_len;
+}
+
+#ifdef USRL_INLINE_HOT_PATH
+#define usrl_pub_publish(p, data, len) usrl_pub_publish_inline((p), (data), (len))
+#define usrl_sub_next(s, buf, len, pub_id) usrl_sub_next_inline((s), (buf), (len), (pub_id))
+#endif
+
+#endif /* USRL_RING_INLINE_H */
@@ -57,4 +57,40 @@ int usrl_message_decode(UsrlMessage *msg, const uint8_t *data, uint32_t len);
 void usrl_message_free(UsrlMessage *msg);
 void usrl_schema_free(UsrlSchema *schema);
 
+/* Field handles: resolve a name once, then read values straight from records */
+const UsrlField *usrl_schema_field(const UsrlSchema *schema, const char *field_name);
+
+static inline bool usrl_field_numeric(const UsrlField *f)
+{
+    return f->type <= USRL_FIELD_F32;
+}
+
+static inline double usrl_field_f64(const UsrlField *f, const uint8_t *rec)
+{
+    const uint8_t *p = rec + f->offset;
+    switch (f->type) {
+    case USRL_FIELD_U64: { uint64_t v; memcpy(&v, p, 8); return (double)v; }
+    case USRL_FIELD_I64: { int64_t v; memcpy(&v, p, 8); return (double)v; }
+    case USRL_FIELD_F64: { double v; memcpy(&v, p, 8); return v; }
+    case USRL_FIELD_U32: { uint32_t v; memcpy(&v, p, 4); return (double)v; }
+    case USRL_FIELD_I32: { int32_t v; memcpy(&v, p, 4); return (double)v; }
+    case USRL_FIELD_F32: { float v; memcpy(&v, p, 4); return (double)v; }
+    default: return 0.0;
+    }
+}
+
+static inline int64_t usrl_field_i64(const UsrlField *f, const uint8_t *rec)
+{
+    const uint8_t *p = rec + f->offset;
+    switch (f->type) {
+    case USRL_FIELD_U64:
+    case USRL_FIELD_I64: { int64_t v; memcpy(&v, p, 8); return v; }
+    case USRL_FIELD_U32: { uint32_t v; memcpy(&v, p, 4); return (int64_t)v; }
+    case USRL_FIELD_I32: { int32_t v; memcpy(&v, p, 4); return (int64_t)v; }
+    case USRL_FIELD_F64:
+    case USRL_FIELD_F32: return (int64_t)usrl_field_f64(f, rec);
+    default: return 0;
+    }
+}
+
 #endif /* USRL_SCHEMA_H */
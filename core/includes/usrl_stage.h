@@ -0,0 +1,81 @@
+#ifndef USRL_STAGE_H
+#define USRL_STAGE_H
+
+/* --------------------------------------------------------------------------
+ * USRL Pipeline Stages — dependent consumers on one ring
+ *
+ * A chain of stages (e.g. decode -> enrich -> route) processes every
+ * message in place instead of copying it between one topic per stage.
+ *
+ *   - Stage k publishes its progress in TopicExt.stages[k] (shared memory).
+ *   - Stage 0 consumes committed slots; stage k > 0 only sees seqs that
+ *     stage k-1 has committed.
+ *   - The publisher never laps the last registered stage: a publish that
+ *     would overwrite an unfinished slot returns USRL_RING_FULL.
+ *   - Slots handed to a stage cannot be overwritten until it commits them,
+ *     so payloads may be read and annotated in place without copying or
+ *     seq re-validation.
+ *
+ * Register stages in order, before publishing starts. Plain subscribers
+ * keep working on a staged ring; they observe payloads before (or while)
+ * stages annotate them.
+ *
+ * Recovery: a stage that dies freezes its cursor, and the publisher gets
+ * USRL_RING_FULL once it is a ring ahead. Restarting the stage resumes
+ * from the cursor. Otherwise usrl_stage_skip() passes its unfinished seqs
+ * on unprocessed and usrl_stage_detach() unregisters the last stage
+ * (`usrl-ctl stage <topic> skip|detach <k>`).
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include "usrl_core.h"
+#include "usrl_ring.h"
+
+/* One claimed slot; data is writable up to cap bytes */
+typedef struct {
+    uint8_t *data;
+    uint32_t len;
+    uint32_t cap;
+    uint16_t pub_id;
+    uint64_t seq;
+    uint64_t timestamp_ns;
+    SlotHeader *hdr;
+} UsrlStageSlot;
+
+/* Stage Handle */
+typedef struct {
+    RingDesc *desc;
+    TopicExt *ext;
+    uint8_t *base_ptr;
+    uint32_t mask;
+    uint32_t stage;
+    atomic_uint_fast64_t *upstream; /* stage-1 cursor, or w_head for stage 0 */
+    uint64_t next;                  /* next seq to claim */
+    uint64_t avail;                 /* cached upstream bound */
+    uint32_t claimed;               /* slots claimed but not committed */
+} UsrlStage;
+
+int usrl_stage_init(UsrlStage *s, void *core_base, const char *topic, uint32_t stage);
+
+/* Claim up to max_slots consecutive seqs; returns count (0 = nothing ready) */
+int usrl_stage_claim(UsrlStage *s, UsrlStageSlot *slots, uint32_t max_slots);
+
+/* Change a claimed slot's payload length after annotating it in place */
+int usrl_stage_resize(UsrlStageSlot *slot, uint32_t len);
+
+/* Release everything claimed so far to the next stage (or the publisher) */
+void usrl_stage_commit(UsrlStage *s);
+
+uint64_t usrl_stage_cursor(const UsrlStage *s);
+
+/* Registered stages of a topic (0 = ungated), -1 if unknown or v1 */
+int usrl_stage_count(void *core_base, const char *topic);
+
+/* Move stage k's cursor up to its upstream, as if it had committed
+ * everything it could see. Returns the seqs skipped, or -1. */
+int64_t usrl_stage_skip(void *core_base, const char *topic, uint32_t stage);
+
+/* Unregister stage k; only the last registered stage. Returns 0 or -1. */
+int usrl_stage_detach(void *core_base, const char *topic, uint32_t stage);
+
+#endif /* USRL_STAGE_H */
@@ -0,0 +1,109 @@
+#ifndef USRL_TRACE_H
+#define USRL_TRACE_H
+
+/* --------------------------------------------------------------------------
+ * USRL Tracing — end-to-end trace ids and per-hop latency stamps
+ *
+ * A sampled 1-in-N subset of messages carries a trace context in the spare
+ * bytes of its SlotHeader: a trace id, the origin time, and up to
+ * USRL_TRACE_MAX_HOPS (hop id, ns since origin) stamps appended by each
+ * router / bridge / replay tool that forwards it.
+ *
+ *   - Origin   : usrl_pub_set_trace_sampling(p, N) starts a trace on every
+ *                Nth publish. Unsampled publishes only clear the flags byte.
+ *   - Forward  : read the context off the input (usrl_sub_last_trace(),
+ *                usrl_view_trace() or usrl_replay_last_trace()) and
+ *                republish with usrl_pub_forward();
+ *                the forwarding publisher's pub_id is appended as a hop.
+ *                Bridges carry UsrlTraceContext on the wire as-is.
+ *   - Journal  : recorders keep the context with each traced record, so
+ *                replayed messages carry it too (usrl_jrec_trace()).
+ *   - Collect  : usrl_trace_collect() groups traces by path (origin + hop
+ *                ids) and keeps a log2 latency histogram per segment.
+ *
+ * Trace stamps use CLOCK_REALTIME (SlotHeader.timestamp_ns stays
+ * CLOCK_MONOTONIC), so hops on other hosts line up as well as their clocks
+ * are synchronised.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_journal.h"
+
+#define USRL_TRACE_MAX_PATHS 64
+#define USRL_TRACE_HIST_BUCKETS 40   /* log2(ns) buckets, top one ~ 9 min */
+#define USRL_TRACE_COLLECTOR_ID 0xFFFF
+
+/* Trace context (process-local copy; also the bridge wire format) */
+typedef struct __attribute__((packed)) {
+    uint64_t trace_id;       /* origin pub_id << 48 | counter; 0 = none */
+    uint64_t origin_ns;
+    uint8_t flags;           /* USRL_SLOT_F_TRACED when valid */
+    uint8_t hop_count;
+    uint16_t hop_id[USRL_TRACE_MAX_HOPS];
+    uint32_t hop_ns[USRL_TRACE_MAX_HOPS];
+} UsrlTraceContext;
+
+static inline uint64_t usrl_trace_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint16_t usrl_trace_origin(const UsrlTraceContext *c) {
+    return (uint16_t)(c->trace_id >> 48);
+}
+
+/* Context */
+void usrl_trace_begin(UsrlTraceContext *ctx, uint16_t origin_id, uint64_t counter);
+void usrl_trace_hop(UsrlTraceContext *ctx, uint16_t hop_id);
+void usrl_trace_stamp(SlotHeader *hdr, const UsrlTraceContext *ctx);
+
+/* Read side: 1 = traced, 0 = not traced, -1 = slot was overwritten.
+ * usrl_view_trace() also takes journal views from usrl_replay_batch(). */
+int usrl_sub_last_trace(const UsrlSubscriber *s, UsrlTraceContext *out);
+int usrl_view_trace(const UsrlSlotView *v, UsrlTraceContext *out);
+int usrl_jrec_trace(const UsrlJournalRecord *r, UsrlTraceContext *out);
+
+/* Publish side */
+void usrl_pub_set_trace_sampling(UsrlPublisher *p, uint32_t every_n);
+void usrl_mwmr_pub_set_trace_sampling(UsrlMwmrPublisher *p, uint32_t every_n);
+int usrl_pub_forward(UsrlPublisher *p, const void *data, uint32_t len, const UsrlTraceContext *in);
+int usrl_mwmr_pub_forward(UsrlMwmrPublisher *p, const void *data, uint32_t len,
+                          const UsrlTraceContext *in);
+
+/* --------------------------------------------------------------------------
+ * Collector
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t buckets[USRL_TRACE_HIST_BUCKETS]; /* bucket i: [2^i, 2^(i+1)) ns */
+} UsrlTraceHist;
+
+typedef struct {
+    uint16_t origin;
+    uint8_t hops;                           /* recorded hops on this path */
+    uint16_t hop_id[USRL_TRACE_MAX_HOPS];
+    UsrlTraceHist seg[USRL_TRACE_MAX_HOPS]; /* previous hop (or origin) -> hop i */
+    UsrlTraceHist total;                    /* origin -> last hop */
+} UsrlTracePath;
+
+typedef struct {
+    UsrlTracePath paths[USRL_TRACE_MAX_PATHS];
+    uint32_t path_count;
+    uint64_t collected;
+    uint64_t overflow;   /* paths table full */
+    uint64_t truncated;  /* more hops than USRL_TRACE_MAX_HOPS */
+} UsrlTraceCollector;
+
+void usrl_trace_collector_init(UsrlTraceCollector *c);
+int usrl_trace_collect(UsrlTraceCollector *c, const UsrlTraceContext *ctx);
+uint64_t usrl_trace_hist_quantile(const UsrlTraceHist *h, double q);
+void usrl_trace_report(const UsrlTraceCollector *c, FILE *out);
+
+#endif /* USRL_TRACE_H */
@@ -13,6 +13,7 @@
 
 #include "usrl_core.h"
 #include "usrl_ring.h"
+#include "usrl_trace.h"
 #include <stdio.h>
 #include <string.h>
 #include <sched.h>
@@ -39,15 +40,43 @@ void usrl_mwmr_pub_init(UsrlMwmrPublisher *p, void *core_base, const char *topic
     p->base_ptr = (uint8_t *)core_base + p->desc->base_offset;
     p->mask = p->desc->slot_count - 1;
     p->pub_id = pub_id;
+    p->ext = usrl_topic_ext(core_base, t);
+    p->gate = 0;
+    p->last_seq = 0;
+    p->trace_every = 0;
+    p->trace_countdown = 0;
+    p->trace_count = 0;
 }
 
-int usrl_mwmr_pub_publish(UsrlMwmrPublisher *p, const void *data, uint32_t len) {
+/* Claim the next seq without passing the last pipeline stage. */
+static inline int mwmr_claim_gated(UsrlMwmrPublisher *p, uint64_t *old_head) {
+    RingDesc *d = p->desc;
+    uint64_t head = atomic_load_explicit(&d->w_head, memory_order_relaxed);
+    for (;;) {
+        if (usrl_stage_gated(p->ext, &p->gate, head + 1, d->slot_count)) return USRL_RING_FULL;
+        if (atomic_compare_exchange_weak_explicit(&d->w_head, &head, head + 1,
+                                                  memory_order_acq_rel,
+                                                  memory_order_relaxed)) {
+            *old_head = head;
+            return USRL_RING_OK;
+        }
+        CPU_RELAX();
+    }
+}
+
+static inline int mwmr_publish(UsrlMwmrPublisher *p, const void *data, uint32_t len,
+                               const UsrlTraceContext *fwd, uint8_t flags) {
     if (USRL_UNLIKELY(!p || !p->desc || !data)) return USRL_RING_ERROR;
     RingDesc *d = p->desc;
 
     if (USRL_UNLIKELY(len > (d->slot_size - sizeof(SlotHeader)))) return USRL_RING_FULL;
 
-    uint64_t old_head = atomic_fetch_add_explicit(&d->w_head, 1, memory_order_acq_rel);
+    uint64_t old_head;
+    if (p->ext && atomic_load_explicit(&p->ext->stage_count, memory_order_relaxed)) {
+        if (mwmr_claim_gated(p, &old_head) != USRL_RING_OK) return USRL_RING_FULL;
+    } else {
+        old_head = atomic_fetch_add_explicit(&d->w_head, 1, memory_order_acq_rel);
+    }
     uint64_t commit_seq = old_head + 1;
 
     uint32_t idx = (uint32_t)((commit_seq - 1) & p->mask);
@@ -80,12 +109,49 @@ int usrl_mwmr_pub_publish(UsrlMwmrPublisher *p, const void *data, uint32_t len)
     hdr->pub_id = p->pub_id;
     hdr->timestamp_ns = usrl_timestamp_ns();
 
+    if (USRL_UNLIKELY(fwd != NULL)) {
+        usrl_trace_stamp(hdr, fwd);
+    } else if (USRL_UNLIKELY(flags)) {
+        hdr->flags = flags; /* probes are never traced */
+    } else if (USRL_UNLIKELY(p->trace_every) && --p->trace_countdown == 0) {
+        UsrlTraceContext ctx;
+        p->trace_countdown = p->trace_every;
+        usrl_trace_begin(&ctx, p->pub_id, ++p->trace_count);
+        usrl_trace_stamp(hdr, &ctx);
+    } else {
+        hdr->flags = 0;
+    }
+
     atomic_thread_fence(memory_order_release);
     atomic_store_explicit(&hdr->seq, commit_seq, memory_order_release);
+    p->last_seq = commit_seq;
 
     return USRL_RING_OK;
 }
 
+int usrl_mwmr_pub_publish(UsrlMwmrPublisher *p, const void *data, uint32_t len) {
+    return mwmr_publish(p, data, len, NULL, 0);
+}
+
+int usrl_mwmr_pub_probe(UsrlMwmrPublisher *p, const void *data, uint32_t len) {
+    return mwmr_publish(p, data, len, NULL, USRL_SLOT_F_PROBE);
+}
+
+void usrl_mwmr_pub_set_trace_sampling(UsrlMwmrPublisher *p, uint32_t every_n) {
+    if (!p) return;
+    p->trace_every = every_n;
+    p->trace_countdown = every_n;
+}
+
+int usrl_mwmr_pub_forward(UsrlMwmrPublisher *p, const void *data, uint32_t len,
+                          const UsrlTraceContext *in) {
+    if (!in || !(in->flags & USRL_SLOT_F_TRACED)) return mwmr_publish(p, data, len, NULL, 0);
+
+    UsrlTraceContext ctx = *in;
+    usrl_trace_hop(&ctx, p ? p->pub_id : 0);
+    return mwmr_publish(p, data, len, &ctx, 0);
+}
+
 /* MWMR subscribers share UsrlSubscriber with SWMR, so they use usrl_sub_init/next in ring_swmr.c */
 /* We just need the initialization wrapper if strictly needed, but SWMR init works fine for generic subs */
 
@@ -93,6 +159,131 @@ void usrl_mwmr_sub_init(UsrlSubscriber *s, void *core_base, const char *topic) {
     usrl_sub_init(s, core_base, topic); // Reuse SWMR init logic
 }
 
+/* --------------------------------------------------------------------------
+ * Out-of-order consumption
+ *
+ * A writer that has claimed a seq but not committed it (slow, preempted or
+ * timed out) would stall usrl_sub_next() for every reader. The reorder
+ * subscriber keeps reading past such holes within a bounded window and
+ * tracks which seqs it has already handed out in a 64-bit mask.
+ * -------------------------------------------------------------------------- */
+
+/* Drop the resolved prefix of the window and advance the base cursor. */
+static inline void reorder_collapse(UsrlReorderSubscriber *s) {
+    uint64_t mask = s->done_mask;
+    if (mask == UINT64_MAX) {
+        s->done_mask = 0;
+        s->sub.last_seq += 64;
+        return;
+    }
+    uint32_t n = (uint32_t)__builtin_ctzll(~mask);
+    if (n == 0) return;
+    s->done_mask = mask >> n;
+    s->sub.last_seq += n;
+}
+
+void usrl_reorder_sub_init(UsrlReorderSubscriber *s, void *core_base, const char *topic,
+                           uint32_t window, uint64_t hole_timeout_ns) {
+    if (!s) return;
+    memset(s, 0, sizeof(*s));
+    usrl_sub_init(&s->sub, core_base, topic);
+    if (!s->sub.desc) return;
+
+    if (window == 0 || window > USRL_REORDER_MAX_WINDOW) window = USRL_REORDER_MAX_WINDOW;
+    if (window > s->sub.desc->slot_count) window = s->sub.desc->slot_count;
+    s->window = window;
+    s->hole_timeout_ns = hole_timeout_ns;
+}
+
+int usrl_reorder_sub_next(UsrlReorderSubscriber *s, uint8_t *out_buf, uint32_t buf_len,
+                          uint16_t *out_pub_id, uint64_t *out_seq) {
+    if (USRL_UNLIKELY(!s || !s->sub.desc || !out_buf)) return USRL_RING_ERROR;
+
+    RingDesc *d = s->sub.desc;
+    uint64_t w_head = atomic_load_explicit(&d->w_head, memory_order_acquire);
+    uint64_t base = s->sub.last_seq;
+
+    if (base >= w_head) return USRL_RING_NO_DATA;
+
+    /* Lag Jump: everything older than one lap is gone */
+    if (w_head - base > d->slot_count) {
+        uint64_t n = (w_head - d->slot_count) - base;
+        uint64_t done = (n >= 64) ? __builtin_popcountll(s->done_mask)
+                                  : __builtin_popcountll(s->done_mask & ((1ULL << n) - 1));
+        s->sub.skipped_count += n - done;
+        s->done_mask = (n >= 64) ? 0 : (s->done_mask >> n);
+        s->sub.last_seq += n;
+        reorder_collapse(s); /* bit 0 must be pending, or i > 0 is not a reorder */
+        base = s->sub.last_seq;
+        if (base >= w_head) return USRL_RING_NO_DATA;
+    }
+
+    uint64_t avail = w_head - base;
+    uint32_t limit = (avail < s->window) ? (uint32_t)avail : s->window;
+
+    for (uint32_t i = 0; i < limit; i++) {
+        uint64_t bit = 1ULL << i;
+        if (s->done_mask & bit) continue;
+
+        uint64_t want = base + 1 + i;
+        uint32_t idx = (uint32_t)((want - 1) & s->sub.mask);
+        uint8_t *slot = s->sub.base_ptr + ((uint64_t)idx * d->slot_size);
+        SlotHeader *hdr = (SlotHeader *)slot;
+
+        uint64_t seq = atomic_load_explicit(&hdr->seq, memory_order_acquire);
+        if (seq < want) continue; /* Hole: claimed but not committed yet */
+
+        s->done_mask |= bit;
+        if (seq > want) {
+            s->sub.skipped_count++; /* Lapped before we got to it */
+            continue;
+        }
+        if (USRL_UNLIKELY(hdr->flags & USRL_SLOT_F_PROBE)) continue;
+
+        uint32_t payload_len = hdr->payload_len;
+        if (USRL_UNLIKELY(payload_len > buf_len)) {
+            if (out_seq) *out_seq = want;
+            reorder_collapse(s);
+            return USRL_RING_TRUNC;
+        }
+
+        memcpy(out_buf, slot + sizeof(SlotHeader), payload_len);
+        if (out_pub_id) *out_pub_id = hdr->pub_id;
+
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t post_seq = atomic_load_explicit(&hdr->seq, memory_order_relaxed);
+        if (USRL_UNLIKELY(post_seq != seq)) {
+            s->sub.skipped_count++;
+            continue;
+        }
+
+        if (i > 0) s->reordered_count++;
+        if (out_seq) *out_seq = want;
+        reorder_collapse(s);
+        return (int)payload_len;
+    }
+
+    reorder_collapse(s);
+    if (s->sub.last_seq >= w_head) return USRL_RING_NO_DATA;
+
+    /* Oldest seq is still a hole: start (or check) its timer */
+    uint64_t hole = s->sub.last_seq + 1;
+    uint64_t now = usrl_timestamp_ns();
+    if (s->hole_seq != hole) {
+        s->hole_seq = hole;
+        s->hole_since_ns = now;
+        return USRL_RING_NO_DATA;
+    }
+    if (now - s->hole_since_ns < s->hole_timeout_ns) return USRL_RING_NO_DATA;
+
+    s->done_mask |= 1ULL;
+    s->sub.skipped_count++;
+    s->hole_seq = 0;
+    if (out_seq) *out_seq = hole;
+    reorder_collapse(s);
+    return USRL_RING_SKIPPED;
+}
+
 uint64_t usrl_mwmr_total_published(void *ring_desc) {
     if (!ring_desc) return 0;
     RingDesc *d = (RingDesc *)ring_desc;
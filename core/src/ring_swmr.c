@@ -5,6 +5,7 @@
 
 #include "usrl_core.h"
 #include "usrl_ring.h"
+#include "usrl_trace.h"
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -25,15 +26,27 @@ void usrl_pub_init(UsrlPublisher *p, void *core_base, const char *topic, uint16_
     p->base_ptr = (uint8_t *)core_base + p->desc->base_offset;
     p->mask = p->desc->slot_count - 1;
     p->pub_id = pub_id;
+    p->ext = usrl_topic_ext(core_base, t);
+    p->gate = 0;
+    p->last_seq = 0;
+    p->trace_every = 0;
+    p->trace_countdown = 0;
+    p->trace_count = 0;
 }
 
-int usrl_pub_publish(UsrlPublisher *p, const void *data, uint32_t len) {
+static inline int swmr_publish(UsrlPublisher *p, const void *data, uint32_t len,
+                               const UsrlTraceContext *fwd) {
     if (USRL_UNLIKELY(!p || !p->desc || !data)) return USRL_RING_ERROR;
     RingDesc *d = p->desc;
 
     /* Check size */
     if (USRL_UNLIKELY(len > (d->slot_size - sizeof(SlotHeader)))) return USRL_RING_FULL;
 
+    /* Single writer: nobody else moves w_head between the check and the add */
+    if (p->ext && USRL_UNLIKELY(usrl_stage_gated(p->ext, &p->gate,
+            atomic_load_explicit(&d->w_head, memory_order_relaxed) + 1, d->slot_count)))
+        return USRL_RING_FULL;
+
     uint64_t old_head = atomic_fetch_add_explicit(&d->w_head, 1, memory_order_acq_rel);
     uint64_t commit_seq = old_head + 1;
 
@@ -48,12 +61,43 @@ int usrl_pub_publish(UsrlPublisher *p, const void *data, uint32_t len) {
     hdr->pub_id = p->pub_id;
     hdr->timestamp_ns = usrl_timestamp_ns();
 
+    if (USRL_UNLIKELY(fwd != NULL)) {
+        usrl_trace_stamp(hdr, fwd);
+    } else if (USRL_UNLIKELY(p->trace_every) && --p->trace_countdown == 0) {
+        UsrlTraceContext ctx;
+        p->trace_countdown = p->trace_every;
+        usrl_trace_begin(&ctx, p->pub_id, ++p->trace_count);
+        usrl_trace_stamp(hdr, &ctx);
+    } else {
+        hdr->flags = 0;
+    }
+
     atomic_thread_fence(memory_order_release);
     atomic_store_explicit(&hdr->seq, commit_seq, memory_order_release);
+    p->last_seq = commit_seq;
     
     return USRL_RING_OK;
 }
 
+int usrl_pub_publish(UsrlPublisher *p, const void *data, uint32_t len) {
+    return swmr_publish(p, data, len, NULL);
+}
+
+void usrl_pub_set_trace_sampling(UsrlPublisher *p, uint32_t every_n) {
+    if (!p) return;
+    p->trace_every = every_n;
+    p->trace_countdown = every_n;
+}
+
+/* Republish with the input's trace context plus a hop for this publisher */
+int usrl_pub_forward(UsrlPublisher *p, const void *data, uint32_t len, const UsrlTraceContext *in) {
+    if (!in || !(in->flags & USRL_SLOT_F_TRACED)) return swmr_publish(p, data, len, NULL);
+
+    UsrlTraceContext ctx = *in;
+    usrl_trace_hop(&ctx, p ? p->pub_id : 0);
+    return swmr_publish(p, data, len, &ctx);
+}
+
 void usrl_sub_init(UsrlSubscriber *s, void *core_base, const char *topic) {
     if (!s || !core_base || !topic) return;
     TopicEntry *t = usrl_get_topic(core_base, topic);
@@ -63,16 +107,161 @@ void usrl_sub_init(UsrlSubscriber *s, void *core_base, const char *topic) {
     s->mask = s->desc->slot_count - 1;
     s->last_seq = 0;
     s->skipped_count = 0;
+    s->max_age_ns = 0;
+    s->expired_count = 0;
+    s->clock_ns = 0;
+    s->clock_tick = 0;
+}
+
+/* --------------------------------------------------------------------------
+ * Message TTL
+ *
+ * Slots older than max_age_ns (by SlotHeader.timestamp_ns) are skipped
+ * without touching their payloads. The clock is cached: it is refreshed
+ * whenever the reader goes idle, every USRL_TTL_CLOCK_EVERY reads, and more
+ * often while a backlog is pending. A stale cache only ever makes messages
+ * look younger, so nothing fresh is dropped.
+ * -------------------------------------------------------------------------- */
+#define USRL_TTL_CLOCK_EVERY 64
+#define USRL_TTL_BACKLOG     64
+
+void usrl_sub_set_max_age(UsrlSubscriber *s, uint64_t max_age_ns) {
+    if (!s) return;
+    s->max_age_ns = max_age_ns;
+    s->clock_ns = usrl_timestamp_ns();
+    s->clock_tick = 0;
+}
+
+static inline SlotHeader *sub_slot_hdr(UsrlSubscriber *s, uint64_t seq) {
+    uint32_t idx = (uint32_t)((seq - 1) & s->mask);
+    return (SlotHeader *)(s->base_ptr + ((uint64_t)idx * s->desc->slot_size));
+}
+
+/* Returns the first seq to read; everything before it was stale. */
+static uint64_t sub_skip_expired(UsrlSubscriber *s, uint64_t next, uint64_t w_head) {
+    uint32_t tick = s->clock_tick++;
+    if ((tick & (USRL_TTL_CLOCK_EVERY - 1)) == 0 ||
+        (w_head - next >= USRL_TTL_BACKLOG && (tick & 7) == 0)) {
+        s->clock_ns = usrl_timestamp_ns();
+    }
+    if (s->clock_ns <= s->max_age_ns) return next;
+    uint64_t cutoff = s->clock_ns - s->max_age_ns;
+
+    SlotHeader *hdr = sub_slot_hdr(s, next);
+    if (atomic_load_explicit(&hdr->seq, memory_order_acquire) != next) return next;
+    if (hdr->timestamp_ns >= cutoff) return next;
+
+    /* Binary search the backlog for the first fresh slot. Timestamps are
+     * monotonic in seq order (near-monotonic on MWMR); a slot that is not
+     * committed as expected counts as fresh, which ends the skip early. */
+    uint64_t lo = next;       /* known stale */
+    uint64_t hi = w_head + 1; /* treated as fresh */
+    while (hi - lo > 1) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        SlotHeader *m = sub_slot_hdr(s, mid);
+        uint64_t ts = m->timestamp_ns;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&m->seq, memory_order_acquire) == mid && ts < cutoff) lo = mid;
+        else hi = mid;
+    }
+
+    s->expired_count += lo - next + 1;
+    s->last_seq = lo;
+    return lo + 1;
 }
 
 int usrl_sub_next(UsrlSubscriber *s, uint8_t *out_buf, uint32_t buf_len, uint16_t *out_pub_id) {
     if (USRL_UNLIKELY(!s || !s->desc || !out_buf)) return USRL_RING_ERROR;
 
+    RingDesc *d = s->desc;
+
+    /* Loops only to step over probe slots */
+    for (;;) {
+        uint64_t w_head = atomic_load_explicit(&d->w_head, memory_order_acquire);
+        uint64_t next = s->last_seq + 1;
+
+        if (next > w_head) {
+            if (s->max_age_ns) s->clock_ns = usrl_timestamp_ns(); /* Idle: refresh TTL clock */
+            return USRL_RING_NO_DATA; /* Nothing new */
+        }
+
+        /* Lag Jump */
+        if (w_head - next >= d->slot_count) {
+            uint64_t new_start = w_head - d->slot_count + 1;
+            s->skipped_count += (new_start - next);
+            s->last_seq = new_start - 1;
+            next = new_start;
+            w_head = atomic_load_explicit(&d->w_head, memory_order_acquire);
+            if (next > w_head) return USRL_RING_NO_DATA;
+        }
+
+        if (s->max_age_ns) {
+            next = sub_skip_expired(s, next, w_head);
+            if (next > w_head) return USRL_RING_NO_DATA;
+        }
+
+        uint32_t idx = (uint32_t)((next - 1) & s->mask);
+        uint8_t *slot = s->base_ptr + ((uint64_t)idx * d->slot_size);
+        SlotHeader *hdr = (SlotHeader *)slot;
+        USRL_PREFETCH_R(s->base_ptr + ((uint64_t)(next & s->mask) * d->slot_size));
+
+        uint64_t seq = atomic_load_explicit(&hdr->seq, memory_order_acquire);
+
+        if (seq == 0 || seq < next) return USRL_RING_NO_DATA;
+
+        if (seq > next) {
+            s->skipped_count += (seq - next);
+            s->last_seq = seq - 1;
+            return USRL_RING_NO_DATA;
+        }
+
+        /* Latency probes (usrl-ctl probe) are not application data */
+        if (USRL_UNLIKELY(hdr->flags & USRL_SLOT_F_PROBE)) {
+            s->last_seq = next;
+            continue;
+        }
+
+        uint32_t payload_len = hdr->payload_len;
+        if (USRL_UNLIKELY(payload_len > buf_len)) {
+            s->last_seq = next;
+            return USRL_RING_TRUNC; /* Buffer too small */
+        }
+
+        memcpy(out_buf, slot + sizeof(SlotHeader), payload_len);
+        if (out_pub_id) *out_pub_id = hdr->pub_id;
+
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t post_seq = atomic_load_explicit(&hdr->seq, memory_order_relaxed);
+
+        if (USRL_UNLIKELY(post_seq != seq)) {
+            s->skipped_count++;
+            s->last_seq = w_head;
+            return USRL_RING_NO_DATA;
+        }
+
+        s->last_seq = next;
+        return (int)payload_len; /* Safe to return 0 for empty payload */
+    }
+}
+
+/* --------------------------------------------------------------------------
+ * Batch zero-copy consume
+ *
+ * Returns up to max_views views of consecutive committed slots and moves
+ * the cursor past them, loading w_head once per batch. Stops early at an
+ * uncommitted (MWMR) slot. Returns 0 when there is nothing to read.
+ * -------------------------------------------------------------------------- */
+int usrl_sub_view_batch(UsrlSubscriber *s, UsrlSlotView *views, uint32_t max_views) {
+    if (USRL_UNLIKELY(!s || !s->desc || !views)) return USRL_RING_ERROR;
+
     RingDesc *d = s->desc;
     uint64_t w_head = atomic_load_explicit(&d->w_head, memory_order_acquire);
     uint64_t next = s->last_seq + 1;
 
-    if (next > w_head) return USRL_RING_NO_DATA; /* Nothing new */
+    if (next > w_head) {
+        if (s->max_age_ns) s->clock_ns = usrl_timestamp_ns();
+        return 0;
+    }
 
     /* Lag Jump */
     if (w_head - next >= d->slot_count) {
@@ -80,45 +269,41 @@ int usrl_sub_next(UsrlSubscriber *s, uint8_t *out_buf, uint32_t buf_len, uint16_
         s->skipped_count += (new_start - next);
         s->last_seq = new_start - 1;
         next = new_start;
-        w_head = atomic_load_explicit(&d->w_head, memory_order_acquire);
-        if (next > w_head) return USRL_RING_NO_DATA;
     }
 
-    uint32_t idx = (uint32_t)((next - 1) & s->mask);
-    uint8_t *slot = s->base_ptr + ((uint64_t)idx * d->slot_size);
-    SlotHeader *hdr = (SlotHeader *)slot;
-    USRL_PREFETCH_R(s->base_ptr + ((uint64_t)(next & s->mask) * d->slot_size));
-
-    uint64_t seq = atomic_load_explicit(&hdr->seq, memory_order_acquire);
-
-    if (seq == 0 || seq < next) return USRL_RING_NO_DATA;
-
-    if (seq > next) {
-        s->skipped_count += (seq - next);
-        s->last_seq = seq - 1;
-        return USRL_RING_NO_DATA;
+    if (s->max_age_ns) {
+        next = sub_skip_expired(s, next, w_head);
+        if (next > w_head) return 0;
     }
 
-    uint32_t payload_len = hdr->payload_len;
-    if (USRL_UNLIKELY(payload_len > buf_len)) {
-        s->last_seq = next;
-        return USRL_RING_TRUNC; /* Buffer too small */
-    }
+    uint32_t n = 0;
+    while (n < max_views && next <= w_head) {
+        SlotHeader *hdr = sub_slot_hdr(s, next);
+        uint64_t seq = atomic_load_explicit(&hdr->seq, memory_order_acquire);
 
-    memcpy(out_buf, slot + sizeof(SlotHeader), payload_len);
-    if (out_pub_id) *out_pub_id = hdr->pub_id;
+        if (seq < next) break; /* Not committed yet */
+        if (seq > next) {       /* Lapped: resync like usrl_sub_next() */
+            s->skipped_count += (seq - next);
+            s->last_seq = seq - 1;
+            break;
+        }
+        if (USRL_UNLIKELY(hdr->flags & USRL_SLOT_F_PROBE)) {
+            s->last_seq = next++;
+            continue;
+        }
 
-    atomic_thread_fence(memory_order_acquire);
-    uint64_t post_seq = atomic_load_explicit(&hdr->seq, memory_order_relaxed);
+        UsrlSlotView *v = &views[n++];
+        v->data = (const uint8_t *)hdr + sizeof(SlotHeader);
+        v->len = hdr->payload_len;
+        v->pub_id = hdr->pub_id;
+        v->seq = seq;
+        v->timestamp_ns = hdr->timestamp_ns;
+        v->hdr = hdr;
+        v->desc = d;
 
-    if (USRL_UNLIKELY(post_seq != seq)) {
-        s->skipped_count++;
-        s->last_seq = w_head;
-        return USRL_RING_NO_DATA;
+        s->last_seq = next++;
     }
-
-    s->last_seq = next;
-    return (int)payload_len; /* Safe to return 0 for empty payload */
+    return (int)n;
 }
 
 uint64_t usrl_swmr_total_published(void *ring_desc) {
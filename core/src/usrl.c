@@ -7,6 +7,7 @@
 #include "usrl.h"
 #include "usrl_core.h"
 #include "usrl_ring.h"
+#include "usrl_durable.h"
 #include "usrl_backpressure.h"
 #include "usrl_health.h"
 #include "usrl_logging.h"
@@ -94,6 +95,14 @@ struct usrl_pub {
     bool block_on_full;
     bool use_limiter;
     bool is_mwmr;
+
+    /* Live policy (usrl-ctl set); cfg_* are the creation-time values */
+    UsrlTopicCtl *ctl;
+    uint64_t ctl_version;
+    uint32_t ctl_countdown;
+    uint64_t rate_hz;
+    uint64_t cfg_rate_hz;
+    bool cfg_block_on_full;
     char topic[64];
     void *shm_base;
     size_t map_size;
@@ -103,6 +112,7 @@ struct usrl_pub {
 struct usrl_sub {
     usrl_ctx_t *ctx;
     UsrlSubscriber core;
+    UsrlTopicCtl *ctl;
     char topic[64];
     void *shm_base;
     size_t map_size;
@@ -143,6 +153,42 @@ void usrl_shutdown(usrl_ctx_t *ctx)
  * PUBLISHER
  * ============================================================================ */
 
+/* Policy version check every this many sends */
+#define USRL_POLICY_CHECK_EVERY 64
+
+static void usrl__pub_set_rate(usrl_pub_t *pub, uint64_t hz)
+{
+    pub->rate_hz = hz;
+    pub->use_limiter = (hz > 0);
+    if (hz == 0) return;
+
+    uint64_t throttled = pub->quota.total_throttled;
+    usrl_quota_init(&pub->quota, hz);
+    pub->quota.total_throttled = throttled;
+}
+
+static void usrl__pub_apply_policy(usrl_pub_t *pub)
+{
+    UsrlPolicy pol;
+    uint64_t version;
+    if (usrl_policy_read(pub->ctl, &pol, &version) != 0) return; /* writer busy: next batch */
+    pub->ctl_version = version;
+
+    uint64_t hz = (pol.flags & USRL_POLICY_RATE) ? pol.rate_limit_hz : pub->cfg_rate_hz;
+    if (hz != pub->rate_hz) usrl__pub_set_rate(pub, hz);
+
+    pub->block_on_full = (pol.flags & USRL_POLICY_BP) ? (pol.bp_mode == USRL_BP_BLOCK)
+                                                      : pub->cfg_block_on_full;
+    USRL_INFO("API", "Policy v%llu applied topic=%s rate_hz=%llu block_on_full=%d",
+              (unsigned long long)version, pub->topic, (unsigned long long)hz, pub->block_on_full);
+}
+
+/* The single version check */
+static inline void usrl__pub_poll_policy(usrl_pub_t *pub)
+{
+    if (pub->ctl && usrl_policy_version(pub->ctl) != pub->ctl_version) usrl__pub_apply_policy(pub);
+}
+
 usrl_pub_t *usrl_pub_create(usrl_ctx_t *ctx, const usrl_pub_config_t *config)
 {
     if (!ctx || !config || !config->topic) return NULL;
@@ -202,16 +248,18 @@ usrl_pub_t *usrl_pub_create(usrl_ctx_t *ctx, const usrl_pub_config_t *config)
     strncpy(pub->topic, config->topic, 63);
     pub->topic[63] = '\0';
 
-    if (config->rate_limit_hz > 0) {
-        usrl_quota_init(&pub->quota, (uint64_t)config->rate_limit_hz);
-        pub->use_limiter = true;
-    }
+    pub->cfg_rate_hz = config->rate_limit_hz;
+    pub->cfg_block_on_full = config->block_on_full;
+    usrl__pub_set_rate(pub, config->rate_limit_hz);
 
     uint32_t my_id = __sync_fetch_and_add(&g_pub_id_seq, 1);
 
     if (pub->is_mwmr) usrl_mwmr_pub_init(&pub->core_mw, base, config->topic, my_id);
     else             usrl_pub_init(&pub->core,    base, config->topic, my_id);
 
+    pub->ctl = usrl_topic_ctl(base, usrl_get_topic(base, config->topic));
+    pub->ctl_countdown = 1; /* apply a policy set before we started */
+
     return pub;
 }
 
@@ -219,6 +267,11 @@ int usrl_pub_send(usrl_pub_t *pub, const void *data, uint32_t len)
 {
     if (!pub || !data) return -1;
 
+    if (USRL_UNLIKELY(--pub->ctl_countdown == 0)) {
+        pub->ctl_countdown = USRL_POLICY_CHECK_EVERY;
+        usrl__pub_poll_policy(pub);
+    }
+
     /* usrl_quota_check(): 1 = THROTTLED, 0 = allowed */
     if (pub->use_limiter) {
         if (usrl_quota_check(&pub->quota)) {
@@ -237,12 +290,14 @@ int usrl_pub_send(usrl_pub_t *pub, const void *data, uint32_t len)
         res = usrl_mwmr_pub_publish(&pub->core_mw, data, len);
         while ((res == USRL_RING_FULL || res == USRL_RING_TIMEOUT) && pub->block_on_full) {
             usleep(1);
+            usrl__pub_poll_policy(pub); /* a live switch to drop releases us */
             res = usrl_mwmr_pub_publish(&pub->core_mw, data, len);
         }
     } else {
         res = usrl_pub_publish(&pub->core, data, len);
         while (res == USRL_RING_FULL && pub->block_on_full) {
             usleep(1);
+            usrl__pub_poll_policy(pub);
             res = usrl_pub_publish(&pub->core, data, len);
         }
     }
@@ -253,6 +308,14 @@ int usrl_pub_send(usrl_pub_t *pub, const void *data, uint32_t len)
     return -1;
 }
 
+int usrl_pub_wait_durable(usrl_pub_t *pub, uint64_t timeout_ns)
+{
+    if (!pub) return -1;
+    const TopicExt *x = pub->is_mwmr ? pub->core_mw.ext : pub->core.ext;
+    uint64_t seq = pub->is_mwmr ? pub->core_mw.last_seq : pub->core.last_seq;
+    return usrl_durable_wait(x, seq, timeout_ns) == USRL_RING_OK ? 0 : -1;
+}
+
 void usrl_pub_get_health(usrl_pub_t *pub, usrl_health_t *out)
 {
     if (!pub || !out) return;
@@ -264,6 +327,7 @@ void usrl_pub_get_health(usrl_pub_t *pub, usrl_health_t *out)
         out->errors     = pub->local_drops;
         out->lag        = 0;
         out->healthy    = (out->errors == 0);
+        out->expired    = 0;
         usrl_health_free(rh);
     } else {
         memset(out, 0, sizeof(*out));
@@ -316,6 +380,7 @@ usrl_sub_t *usrl_sub_create(usrl_ctx_t *ctx, const char *topic)
     sub->topic[63] = '\0';
 
     usrl_sub_init(&sub->core, base, topic);
+    sub->ctl = usrl_topic_ctl(base, usrl_get_topic(base, topic));
     return sub;
 }
 
@@ -341,6 +406,12 @@ int usrl_sub_recv(usrl_sub_t *sub, void *buffer, uint32_t max_len)
     return ret;
 }
 
+void usrl_sub_set_ttl(usrl_sub_t *sub, uint64_t max_age_ns)
+{
+    if (!sub) return;
+    usrl_sub_set_max_age(&sub->core, max_age_ns);
+}
+
 void usrl_sub_get_health(usrl_sub_t *sub, usrl_health_t *out)
 {
     if (!sub || !out) return;
@@ -357,7 +428,14 @@ void usrl_sub_get_health(usrl_sub_t *sub, usrl_health_t *out)
         out->lag = 0;
     }
 
-    out->healthy = (out->lag < 100 && out->errors == 0);
+    /* The lag threshold can be changed live (usrl-ctl set <topic> lag=N) */
+    uint64_t lag_threshold = 100;
+    UsrlPolicy pol;
+    if (sub->ctl && usrl_policy_read(sub->ctl, &pol, NULL) == 0 && (pol.flags & USRL_POLICY_LAG))
+        lag_threshold = pol.lag_threshold;
+
+    out->healthy = (out->lag < lag_threshold && out->errors == 0);
+    out->expired = sub->core.expired_count;
 }
 
 void usrl_sub_destroy(usrl_sub_t *sub)
@@ -1,3 +1,11 @@
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
 #include "usrl_backpressure.h"
 #include <time.h>
 #include <stdint.h>
@@ -32,6 +40,35 @@ int usrl_quota_check(PublishQuota *quota)
     return 0;
 }
 
+/* Same window as usrl_quota_check(), but the caller may only use num/den of
+ * the per-window quota. Used to keep headroom for higher-priority traffic.
+ */
+int usrl_quota_check_share(PublishQuota *quota, uint32_t num, uint32_t den)
+{
+    if (!quota || den == 0) return 0;
+
+    uint64_t now = usrl_now_ns();
+
+    if (now - quota->last_window_start_ns > quota->publish_window_ns) {
+        quota->last_window_start_ns = now;
+        quota->msgs_in_window = 0;
+    }
+
+    uint64_t limit = quota->publish_quota;
+    if (num < den) {
+        limit = (limit / den) * num;
+        if (limit == 0) limit = 1;
+    }
+
+    if (quota->msgs_in_window >= limit) {
+        quota->total_throttled++;
+        return 1;
+    }
+
+    quota->msgs_in_window++;
+    return 0;
+}
+
 int usrl_backpressure_check_lag(uint64_t lag, uint64_t threshold)
 {
     return (lag > threshold) ? 1 : 0;
@@ -55,3 +92,76 @@ uint64_t usrl_backoff_linear(uint64_t lag, uint64_t max_lag)
     if (lag >= max_lag) return 100000;
     return (lag * 100000) / max_lag;
 }
+
+/* ============================================================================
+ * LIVE POLICY (seqlock over UsrlTopicCtl)
+ * ============================================================================ */
+#define POLICY_READ_TRIES 64
+#define POLICY_WRITE_TRIES (1u << 20) /* a writer holds it for a few stores */
+
+int usrl_policy_read(const UsrlTopicCtl *ctl, UsrlPolicy *out, uint64_t *version)
+{
+    if (!ctl || !out) return -1;
+    UsrlTopicCtl *c = (UsrlTopicCtl *)ctl;
+
+    for (int i = 0; i < POLICY_READ_TRIES; i++) {
+        uint64_t v = atomic_load_explicit(&c->version, memory_order_acquire);
+        if (v & 1) continue;
+
+        out->flags = c->flags;
+        out->bp_mode = (UsrlBackpressureMode)c->bp_mode;
+        out->rate_limit_hz = c->rate_limit_hz;
+        out->lag_threshold = c->lag_threshold;
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&c->version, memory_order_relaxed) == v) {
+            if (version) *version = v;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int usrl_policy_update(UsrlTopicCtl *ctl, const UsrlPolicy *set, uint32_t clear_flags)
+{
+    if (!ctl) return -1;
+
+    /* Writers take the lock by moving version from even to odd */
+    uint64_t v = atomic_load_explicit(&ctl->version, memory_order_relaxed);
+    for (uint32_t i = 0;; i++) {
+        if (i == POLICY_WRITE_TRIES) return -1; /* writer died holding it */
+        if (v & 1) {
+            CPU_RELAX();
+            v = atomic_load_explicit(&ctl->version, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&ctl->version, &v, v + 1,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+            break;
+    }
+    atomic_thread_fence(memory_order_release);
+
+    uint32_t flags = set ? set->flags : 0;
+    if (flags & USRL_POLICY_RATE) ctl->rate_limit_hz = set->rate_limit_hz;
+    if (flags & USRL_POLICY_BP) ctl->bp_mode = (uint32_t)set->bp_mode;
+    if (flags & USRL_POLICY_LAG) ctl->lag_threshold = set->lag_threshold;
+    ctl->flags = (ctl->flags | flags) & ~clear_flags;
+
+    atomic_store_explicit(&ctl->version, v + 2, memory_order_release);
+    return 0;
+}
+
+/* Breaks a lock left odd by a dead writer. Its half-written fields are
+ * dropped with every override, back to the creation-time config. */
+int usrl_policy_reset(UsrlTopicCtl *ctl)
+{
+    if (!ctl) return -1;
+
+    uint64_t v = atomic_load_explicit(&ctl->version, memory_order_acquire);
+    if (!(v & 1)) return usrl_policy_update(ctl, NULL, ~0u);
+
+    ctl->flags = 0;
+    atomic_store_explicit(&ctl->version, v + 1, memory_order_release);
+    return 0;
+}
@@ -89,7 +89,7 @@ int usrl_core_init(
 
     CoreHeader *hdr = (CoreHeader *)base;
     hdr->magic = USRL_MAGIC;
-    hdr->version = 1;
+    hdr->version = 3;
     hdr->mmap_size = size;
 
     uint64_t current_offset = usrl_align_up(sizeof(CoreHeader), USRL_ALIGNMENT);
@@ -101,10 +101,14 @@ int usrl_core_init(
         current_offset + (sizeof(TopicEntry) * count),
         USRL_ALIGNMENT);
 
-    uint64_t slots_start = usrl_align_up(
+    uint64_t ext_start = usrl_align_up(
         ring_desc_start + (sizeof(RingDesc) * count),
         USRL_ALIGNMENT);
 
+    uint64_t slots_start = usrl_align_up(
+        ext_start + (sizeof(TopicExt) * count),
+        USRL_ALIGNMENT);
+
     uint64_t next_free_slot_offset = slots_start;
 
     for (uint32_t i = 0; i < count; ++i) {
@@ -129,6 +133,7 @@ int usrl_core_init(
         r->slot_count = slots_pow2;
         r->slot_size = slot_sz_aligned;
         r->base_offset = next_free_slot_offset;
+        r->ext_offset = ext_start + (i * sizeof(TopicExt));
         atomic_store_explicit(&r->w_head, 0, memory_order_relaxed);
 
         uint64_t total_bytes_for_topic = (uint64_t)slots_pow2 * slot_sz_aligned;
@@ -210,6 +215,25 @@ TopicEntry *usrl_get_topic(void *base, const char *name)
     return NULL;
 }
 
+TopicExt *usrl_topic_ext(void *base, const TopicEntry *t)
+{
+    if (!base || !t) return NULL;
+
+    CoreHeader *hdr = (CoreHeader *)base;
+    if (hdr->magic != USRL_MAGIC || hdr->version < 2) return NULL;
+
+    RingDesc *r = (RingDesc *)((uint8_t *)base + t->ring_desc_offset);
+    if (r->ext_offset == 0) return NULL;
+    return (TopicExt *)((uint8_t *)base + r->ext_offset);
+}
+
+UsrlTopicCtl *usrl_topic_ctl(void *base, const TopicEntry *t)
+{
+    TopicExt *x = usrl_topic_ext(base, t);
+    if (!x || ((CoreHeader *)base)->version < 3) return NULL;
+    return &x->ctl;
+}
+
 void usrl_core_unmap(void *base, size_t size)
 {
     if (base && size) munmap(base, size);
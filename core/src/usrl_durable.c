@@ -0,0 +1,151 @@
+/**
+ * @file usrl_durable.c
+ * @brief Group-committed journal writer and the durable-seq watermark.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+#include "usrl_durable.h"
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#define DURABLE_BATCH 256
+#define WAIT_SPINS 2000
+#define WAIT_SLEEP_NS 20000     /* 20 us */
+
+static inline uint64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * WRITER
+ * ============================================================================ */
+
+int usrl_durable_open(UsrlDurableWriter *d, void *core_base, const char *topic, uint32_t stage,
+                      const char *dir, uint64_t segment_bytes, uint32_t group_records,
+                      uint64_t group_ns)
+{
+    if (!d || !core_base || !topic || !dir) return -1;
+    memset(d, 0, sizeof(*d));
+    d->w.fd = -1;
+
+    if (usrl_stage_init(&d->stage, core_base, topic, stage) != 0) return -1;
+    d->ext = d->stage.ext;
+    d->group_records = group_records ? group_records : USRL_DURABLE_GROUP_RECORDS;
+    d->group_ns = group_ns ? group_ns : USRL_DURABLE_GROUP_NS;
+
+    if (usrl_journal_writer_open(&d->w, dir, topic, segment_bytes) != 0) return -1;
+
+    /* A journal past the ring head belongs to an earlier region */
+    uint64_t head = atomic_load_explicit(&d->stage.desc->w_head, memory_order_acquire);
+    if (d->w.last_seq > head) {
+        usrl_journal_writer_close(&d->w);
+        errno = ESTALE;
+        return -1;
+    }
+
+    /* Opening sealed every earlier segment with an fdatasync, so the journal
+     * holds everything up to its last seq; the stage cursor may say more
+     * (another journal directory) or less (a crash between sync and commit). */
+    atomic_store_explicit(&d->ext->durable_seq, d->w.last_seq, memory_order_release);
+    return 0;
+}
+
+int usrl_durable_sync(UsrlDurableWriter *d)
+{
+    if (!d || !d->ext) return -1;
+    if (d->stage.claimed == 0) return 0;
+
+    uint64_t t0 = mono_ns();
+    if (usrl_journal_sync(&d->w) != 0) return -1;
+    uint64_t dt = mono_ns() - t0;
+
+    /* Only what the sync covered: every record up to the journal's last seq */
+    usrl_stage_commit(&d->stage);
+    atomic_store_explicit(&d->ext->durable_seq, d->w.last_seq, memory_order_release);
+
+    d->groups++;
+    if (d->pending > d->max_group) d->max_group = d->pending;
+    d->sync_ns_total += dt;
+    if (dt > d->sync_ns_max) d->sync_ns_max = dt;
+    d->pending = 0;
+    return 0;
+}
+
+int usrl_durable_poll(UsrlDurableWriter *d)
+{
+    if (USRL_UNLIKELY(!d || !d->ext)) return -1;
+
+    UsrlStageSlot slots[DURABLE_BATCH];
+    int n = usrl_stage_claim(&d->stage, slots, DURABLE_BATCH);
+    if (n < 0) return -1;
+
+    for (int i = 0; i < n; i++) {
+        const UsrlStageSlot *sl = &slots[i];
+        if (i + 1 < n) USRL_PREFETCH_R(slots[i + 1].data);
+        if (USRL_UNLIKELY(sl->seq <= d->w.last_seq)) continue; /* journaled before a restart */
+
+        /* Claimed slots cannot be overwritten until committed: no re-check */
+        UsrlJournalTrace trace;
+        int traced = usrl_jrec_trace_from_slot(sl->hdr, &trace);
+        if (usrl_journal_append_traced(&d->w, sl->seq, sl->timestamp_ns, sl->pub_id, sl->hdr->flags,
+                                       traced ? &trace : NULL, sl->data, sl->len) != 0)
+            return -1;
+    }
+
+    if (n > 0) {
+        if (d->pending == 0) d->pending_since_ns = mono_ns();
+        d->pending += (uint64_t)n;
+    }
+    if (d->stage.claimed == 0) return n;
+
+    /* Group full, oldest record due, or nothing more to wait for */
+    if (n == 0 || d->pending >= d->group_records ||
+        mono_ns() - d->pending_since_ns >= d->group_ns) {
+        if (usrl_durable_sync(d) != 0) return -1;
+    }
+    return n;
+}
+
+int usrl_durable_close(UsrlDurableWriter *d)
+{
+    if (!d) return -1;
+    int rc = usrl_durable_sync(d);
+    usrl_journal_writer_close(&d->w);
+    return rc;
+}
+
+/* ============================================================================
+ * PUBLISHER SIDE
+ * ============================================================================ */
+
+int usrl_durable_wait(const TopicExt *x, uint64_t seq, uint64_t timeout_ns)
+{
+    if (!x) return USRL_RING_ERROR;
+    if (usrl_durable_seq(x) >= seq) return USRL_RING_OK;
+    if (timeout_ns == 0) return USRL_RING_TIMEOUT;
+
+    /* A group commit takes one fdatasync: spin through the short ones */
+    uint64_t deadline = mono_ns() + timeout_ns;
+    for (int i = 0; i < WAIT_SPINS; i++) {
+        CPU_RELAX();
+        if (usrl_durable_seq(x) >= seq) return USRL_RING_OK;
+    }
+
+    struct timespec ts = { 0, WAIT_SLEEP_NS };
+    while (usrl_durable_seq(x) < seq) {
+        if (mono_ns() >= deadline) return USRL_RING_TIMEOUT;
+        nanosleep(&ts, NULL);
+    }
+    return USRL_RING_OK;
+}
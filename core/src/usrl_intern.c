@@ -0,0 +1,287 @@
+/**
+ * @file usrl_intern.c
+ * @brief Shared symbol interning table (string <-> dense id).
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+#include "usrl_intern.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define INDEX_EMPTY   0u
+#define INDEX_PENDING 0x80000000u /* | inserter pid; ids+1 never set this bit */
+#define PENDING_SPINS 4096        /* spins between owner liveness checks */
+
+static uint32_t next_power_of_two_u32(uint32_t v)
+{
+    if (v == 0) return 1;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return ++v;
+}
+
+/* FNV-1a; symbols are short so this beats anything fancier */
+static inline uint32_t symbol_hash(const char *s, uint32_t len)
+{
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static inline uint64_t entries_offset(void)
+{
+    return usrl_align_up(sizeof(UsrlInternHeader), USRL_ALIGNMENT);
+}
+
+static inline uint32_t index_slots_for(uint32_t capacity)
+{
+    return next_power_of_two_u32(capacity * 2);
+}
+
+/* ============================================================================
+ * LAYOUT
+ * ============================================================================ */
+
+uint64_t usrl_intern_required_size(uint32_t capacity)
+{
+    uint64_t idx_off = entries_offset() + (uint64_t)capacity * sizeof(UsrlSymbolEntry);
+    return usrl_align_up(idx_off + (uint64_t)index_slots_for(capacity) * sizeof(uint32_t),
+                         USRL_ALIGNMENT);
+}
+
+int usrl_intern_format(void *mem, uint64_t size, uint32_t capacity)
+{
+    if (!mem || capacity == 0 || capacity >= INDEX_PENDING) return -1;
+    if (size < usrl_intern_required_size(capacity)) return -1;
+
+    memset(mem, 0, size);
+
+    UsrlInternHeader *hdr = (UsrlInternHeader *)mem;
+    hdr->version = 1;
+    hdr->size = size;
+    hdr->capacity = capacity;
+    hdr->index_slots = index_slots_for(capacity);
+    atomic_store_explicit(&hdr->next_id, 0, memory_order_relaxed);
+
+    atomic_thread_fence(memory_order_release);
+    hdr->magic = USRL_INTERN_MAGIC;
+    return 0;
+}
+
+int usrl_intern_attach(UsrlIntern *t, void *mem)
+{
+    if (!t || !mem) return -1;
+
+    UsrlInternHeader *hdr = (UsrlInternHeader *)mem;
+    if (hdr->magic != USRL_INTERN_MAGIC) return -1;
+
+    t->hdr = hdr;
+    t->entries = (UsrlSymbolEntry *)((uint8_t *)mem + entries_offset());
+    t->index = (_Atomic uint32_t *)((uint8_t *)t->entries +
+                                    (uint64_t)hdr->capacity * sizeof(UsrlSymbolEntry));
+    t->mask = hdr->index_slots - 1;
+    t->map_size = 0;
+    return 0;
+}
+
+/* ============================================================================
+ * STANDALONE SHM OBJECT
+ * ============================================================================ */
+
+/**
+ * usrl_intern_create return codes (same as usrl_core_init)
+ *  0  : created and formatted
+ *  1  : already exists (not formatted by this call)
+ * -1  : invalid params or shm_open failed (not EEXIST)
+ * -2  : ftruncate failed
+ * -3  : mmap failed
+ */
+int usrl_intern_create(const char *path, uint32_t capacity)
+{
+    if (!path || capacity == 0) return -1;
+
+    uint64_t size = usrl_intern_required_size(capacity);
+
+    int fd = shm_open(path, O_CREAT | O_RDWR | O_EXCL, 0666);
+    if (fd < 0) return (errno == EEXIST) ? 1 : -1;
+
+    if (ftruncate(fd, (off_t)size) < 0) {
+        close(fd);
+        return -2;
+    }
+
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return -3;
+    }
+
+    usrl_intern_format(base, size, capacity);
+
+    munmap(base, size);
+    close(fd);
+    return 0;
+}
+
+int usrl_intern_open(UsrlIntern *t, const char *path)
+{
+    if (!t || !path) return -1;
+
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) return -1;
+    struct stat st;
+    int rc = fstat(fd, &st);
+    close(fd);
+    if (rc != 0 || st.st_size <= 0) return -1;
+
+    void *base = usrl_core_map(path, (uint64_t)st.st_size);
+    if (!base) return -1;
+
+    if (usrl_intern_attach(t, base) != 0) {
+        munmap(base, (size_t)st.st_size);
+        return -1;
+    }
+
+    t->map_size = (size_t)st.st_size;
+    return 0;
+}
+
+void usrl_intern_close(UsrlIntern *t)
+{
+    if (!t || !t->hdr) return;
+    if (t->map_size) munmap(t->hdr, t->map_size);
+    memset(t, 0, sizeof(*t));
+}
+
+/* ============================================================================
+ * OPERATIONS
+ * ============================================================================ */
+
+static inline int entry_matches(const UsrlSymbolEntry *e, uint32_t hash,
+                                const char *name, uint32_t len)
+{
+    return e->hash == hash && e->len == len && memcmp(e->name, name, len) == 0;
+}
+
+static inline uint32_t pending_mark(void)
+{
+    return INDEX_PENDING | ((uint32_t)getpid() & ~INDEX_PENDING);
+}
+
+/* Wait for an in-flight insert to publish its id (or give the slot back).
+ * An inserter that died mid-insert never will: its slot goes back to EMPTY
+ * and the id it may have taken is skipped (usrl_intern_name() is NULL). */
+static inline uint32_t index_load_settled(const UsrlIntern *t, uint32_t slot)
+{
+    uint32_t v;
+    uint32_t spins = 0;
+    while ((v = atomic_load_explicit(&t->index[slot], memory_order_acquire)) & INDEX_PENDING) {
+        CPU_RELAX();
+        if (++spins < PENDING_SPINS) continue;
+        spins = 0;
+
+        pid_t owner = (pid_t)(v & ~INDEX_PENDING);
+        if (kill(owner, 0) == 0 || errno != ESRCH) continue;
+        atomic_compare_exchange_strong_explicit(&t->index[slot], &v, INDEX_EMPTY,
+                                                memory_order_acq_rel, memory_order_acquire);
+    }
+    return v;
+}
+
+uint32_t usrl_intern_lookup(const UsrlIntern *t, const char *name, uint32_t len)
+{
+    if (USRL_UNLIKELY(!t || !t->hdr || !name || len == 0 || len >= USRL_SYMBOL_MAX))
+        return USRL_INTERN_INVALID;
+
+    uint32_t h = symbol_hash(name, len);
+
+    for (uint32_t probe = 0; probe <= t->mask; probe++) {
+        uint32_t slot = (h + probe) & t->mask;
+        uint32_t v = index_load_settled(t, slot);
+        if (v == INDEX_EMPTY) return USRL_INTERN_INVALID;
+
+        uint32_t id = v - 1;
+        if (entry_matches(&t->entries[id], h, name, len)) return id;
+    }
+    return USRL_INTERN_INVALID;
+}
+
+uint32_t usrl_intern_id(UsrlIntern *t, const char *name, uint32_t len)
+{
+    if (USRL_UNLIKELY(!t || !t->hdr || !name || len == 0 || len >= USRL_SYMBOL_MAX))
+        return USRL_INTERN_INVALID;
+
+    uint32_t h = symbol_hash(name, len);
+
+    for (uint32_t probe = 0; probe <= t->mask; probe++) {
+        uint32_t slot = (h + probe) & t->mask;
+        uint32_t v = index_load_settled(t, slot);
+
+        if (v == INDEX_EMPTY) {
+            uint32_t expected = INDEX_EMPTY;
+            if (!atomic_compare_exchange_strong_explicit(&t->index[slot], &expected, pending_mark(),
+                                                         memory_order_acq_rel,
+                                                         memory_order_acquire)) {
+                v = index_load_settled(t, slot); /* Lost the race: inspect the winner */
+            } else {
+                uint32_t id = (uint32_t)atomic_fetch_add_explicit(&t->hdr->next_id, 1,
+                                                                  memory_order_relaxed);
+                if (id >= t->hdr->capacity) {
+                    atomic_store_explicit(&t->hdr->next_id, t->hdr->capacity, memory_order_relaxed);
+                    atomic_store_explicit(&t->index[slot], INDEX_EMPTY, memory_order_release);
+                    return USRL_INTERN_INVALID; /* Table full */
+                }
+
+                UsrlSymbolEntry *e = &t->entries[id];
+                memcpy(e->name, name, len);
+                e->name[len] = '\0';
+                e->len = len;
+                e->hash = h;
+                atomic_store_explicit(&e->ready, 1, memory_order_release);
+                atomic_store_explicit(&t->index[slot], id + 1, memory_order_release);
+                return id;
+            }
+            if (v == INDEX_EMPTY) { probe--; continue; } /* Insert was abandoned; retry slot */
+        }
+
+        uint32_t id = v - 1;
+        if (entry_matches(&t->entries[id], h, name, len)) return id;
+    }
+    return USRL_INTERN_INVALID;
+}
+
+const char *usrl_intern_name(const UsrlIntern *t, uint32_t id)
+{
+    if (!t || !t->hdr || id >= t->hdr->capacity) return NULL;
+
+    const UsrlSymbolEntry *e = &t->entries[id];
+    if (!atomic_load_explicit(&e->ready, memory_order_acquire)) return NULL;
+    return e->name;
+}
+
+uint32_t usrl_intern_count(const UsrlIntern *t)
+{
+    if (!t || !t->hdr) return 0;
+    uint32_t n = (uint32_t)atomic_load_explicit(&t->hdr->next_id, memory_order_relaxed);
+    return (n > t->hdr->capacity) ? t->hdr->capacity : n;
+}
@@ -0,0 +1,907 @@
+/**
+ * @file usrl_journal.c
+ * @brief Topic journal: segment writer, recorder and mmap reader.
+ */
+
+#include "usrl_journal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+#define WRITE_BUF_BYTES (1u << 20)
+#define RECORD_BATCH 256
+
+/* ============================================================================
+ * FILE HELPERS
+ * ============================================================================ */
+
+static int mkdirs(const char *path)
+{
+    char tmp[USRL_JOURNAL_PATH_MAX];
+    size_t n = strlen(path);
+    if (n == 0 || n >= sizeof(tmp)) return -1;
+    memcpy(tmp, path, n + 1);
+
+    for (char *p = tmp + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(tmp, 0755) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    return (mkdir(tmp, 0755) != 0 && errno != EEXIST) ? -1 : 0;
+}
+
+static int seg_path(char *out, size_t n, const char *dir, uint64_t first_seq, const char *suffix)
+{
+    int len = snprintf(out, n, "%s/%020" PRIu64 USRL_JOURNAL_EXT "%s",
+                       dir, first_seq, suffix ? suffix : "");
+    return (len > 0 && (size_t)len < n) ? 0 : -1;
+}
+
+static int write_all(int fd, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int pwrite_all(int fd, const void *data, size_t len, off_t off)
+{
+    const uint8_t *p = data;
+    while (len) {
+        ssize_t n = pwrite(fd, p, len, off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        off += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int fsync_dir(const char *dir)
+{
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return -1;
+    int rc = fsync(fd);
+    close(fd);
+    return rc;
+}
+
+static uint64_t file_size(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+/* End of the last complete record at or after start (seqs must ascend) */
+static uint64_t scan_end(const uint8_t *base, uint64_t size, uint64_t start,
+                         uint64_t *count, uint64_t *last_seq)
+{
+    uint64_t off = start, prev = 0, n = 0;
+    while (off + sizeof(UsrlJournalRecord) <= size) {
+        const UsrlJournalRecord *r = (const UsrlJournalRecord *)(base + off);
+        if (r->seq == 0 || r->seq <= prev || r->len > size - off) break;
+        uint64_t next = off + usrl_jrec_size(r);
+        if (next > size) break;
+        prev = r->seq;
+        off = next;
+        n++;
+    }
+    if (count) *count = n;
+    if (last_seq) *last_seq = prev;
+    return off;
+}
+
+/* Write the index at data_end and the final header */
+static int seal_fd(int fd, UsrlJournalSegHeader *h, uint64_t data_end,
+                   const UsrlJournalIndexEntry *index, uint32_t index_count)
+{
+    h->flags |= USRL_JSEG_F_SEALED;
+    h->data_end = data_end;
+    h->index_offset = data_end;
+    h->index_count = index_count;
+
+    size_t bytes = (size_t)index_count * sizeof(UsrlJournalIndexEntry);
+    if (ftruncate(fd, (off_t)data_end) != 0) return -1;
+    if (bytes && pwrite_all(fd, index, bytes, (off_t)data_end) != 0) return -1;
+    if (pwrite_all(fd, h, sizeof(*h), 0) != 0) return -1;
+    return fdatasync(fd);
+}
+
+/* Seal a segment a crashed writer left open: cut the torn tail, rebuild the
+ * index. Returns 0 (sealed header in out), 1 if it held no records and was
+ * removed, -1 on error. */
+static int repair_segment(const char *path, UsrlJournalSegHeader *out)
+{
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= sizeof(UsrlJournalSegHeader))
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    const uint8_t *base = map;
+    UsrlJournalSegHeader h;
+    memcpy(&h, base, sizeof(h));
+
+    int rc = -1;
+    if (h.magic == USRL_JOURNAL_MAGIC && h.hdr_size >= sizeof(h)) {
+        uint64_t size = (uint64_t)st.st_size;
+        uint64_t end = scan_end(base, size, h.hdr_size, &h.count, &h.last_seq);
+
+        uint32_t cap = (uint32_t)(end / USRL_JOURNAL_INDEX_EVERY + 1), n = 0;
+        UsrlJournalIndexEntry *index = malloc(cap * sizeof(*index));
+        uint64_t next_index = h.hdr_size;
+
+        for (uint64_t off = h.hdr_size; index && off < end;) {
+            const UsrlJournalRecord *r = (const UsrlJournalRecord *)(base + off);
+            if (off == h.hdr_size) h.first_ns = r->timestamp_ns;
+            h.last_ns = r->timestamp_ns;
+            if (off >= next_index && n < cap) {
+                index[n++] = (UsrlJournalIndexEntry){ r->seq, r->timestamp_ns, off };
+                next_index = off + USRL_JOURNAL_INDEX_EVERY;
+            }
+            off += usrl_jrec_size(r);
+        }
+
+        munmap(map, (size_t)st.st_size);
+        map = MAP_FAILED;
+        if (h.count == 0) {
+            rc = unlink(path) == 0 ? 1 : -1;
+        } else if (index && seal_fd(fd, &h, end, index, n) == 0) {
+            *out = h;
+            rc = 0;
+        }
+        free(index);
+    }
+
+    if (map != MAP_FAILED) munmap(map, (size_t)st.st_size);
+    close(fd);
+    return rc;
+}
+
+/* ============================================================================
+ * WRITER
+ * ============================================================================ */
+
+static int writer_start_segment(UsrlJournalWriter *w, uint64_t seq)
+{
+    uint64_t first = w->cover_first ? w->cover_first : seq;
+    w->cover_first = 0;
+
+    char path[USRL_JOURNAL_PATH_MAX + 32];
+    if (seg_path(path, sizeof(path), w->dir, first, w->suffix) != 0) return -1;
+
+    w->fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (w->fd < 0) return -1;
+    w->dir_dirty = 1;
+
+    UsrlJournalSegHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = USRL_JOURNAL_MAGIC;
+    h.version = USRL_JOURNAL_VERSION;
+    h.flags = w->seg_flags;
+    h.hdr_size = sizeof(h);
+    h.first_seq = first;
+    memcpy(h.topic, w->topic, sizeof(h.topic));
+
+    memcpy(w->buf, &h, sizeof(h));
+    w->buf_len = sizeof(h);
+    w->file_off = 0;
+    w->seg_first_seq = first;
+    w->seg_count = 0;
+    w->index_count = 0;
+    w->next_index_off = sizeof(h);
+    return 0;
+}
+
+static int writer_init(UsrlJournalWriter *w, const char *dir, const char *topic,
+                       uint64_t segment_bytes)
+{
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    if (snprintf(w->dir, sizeof(w->dir), "%s/%s", dir, topic) >= (int)sizeof(w->dir)) return -1;
+    snprintf(w->topic, sizeof(w->topic), "%s", topic);
+    w->segment_bytes = segment_bytes ? segment_bytes : USRL_JOURNAL_SEGMENT_BYTES;
+
+    w->buf_cap = WRITE_BUF_BYTES;
+    w->buf = malloc(w->buf_cap);
+    w->index_cap = 1024;
+    w->index = malloc(w->index_cap * sizeof(UsrlJournalIndexEntry));
+    if (!w->buf || !w->index || mkdirs(w->dir) != 0) {
+        free(w->buf);
+        free(w->index);
+        w->buf = NULL;
+        w->index = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int usrl_journal_writer_open(UsrlJournalWriter *w, const char *dir, const char *topic,
+                             uint64_t segment_bytes)
+{
+    if (!w || !dir || !topic || strchr(topic, '/')) return -1;
+    if (writer_init(w, dir, topic, segment_bytes) != 0) return -1;
+
+    /* Resume after the last recorded seq; repair an unsealed tail segment */
+    int n = usrl_journal_list(dir, topic, NULL, 0);
+    UsrlJournalSegInfo *segs = malloc((n > 0 ? (size_t)n : 1) * sizeof(*segs));
+    int rc = (n < 0 || !segs) ? -1 : 0;
+    if (rc == 0) n = usrl_journal_list(dir, topic, segs, (uint32_t)n);
+
+    for (int i = n - 1; rc == 0 && i >= 0; i--) {
+        UsrlJournalSegment s;
+        if (usrl_jseg_open(&s, segs[i].path) != 0) {
+            /* Created, but the header never reached the file */
+            if (file_size(segs[i].path) >= sizeof(UsrlJournalSegHeader)) rc = -1;
+            else unlink(segs[i].path);
+            continue;
+        }
+        UsrlJournalSegHeader h = *s.hdr;
+        usrl_jseg_close(&s);
+
+        if (!(h.flags & USRL_JSEG_F_SEALED)) {
+            int r = repair_segment(segs[i].path, &h);
+            if (r < 0) rc = -1;
+            if (r != 0) continue;
+        }
+        w->last_seq = h.last_seq;
+        w->last_ns = h.last_ns;
+        break;
+    }
+    free(segs);
+
+    if (rc != 0) {
+        free(w->buf);
+        free(w->index);
+        w->buf = NULL;
+        w->index = NULL;
+    }
+    return rc;
+}
+
+static int writer_seal(UsrlJournalWriter *w, uint64_t last_seq)
+{
+    if (w->fd < 0) return 0;
+    if (usrl_journal_flush(w) != 0) return -1;
+
+    UsrlJournalSegHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = USRL_JOURNAL_MAGIC;
+    h.version = USRL_JOURNAL_VERSION;
+    h.flags = w->seg_flags;
+    h.hdr_size = sizeof(h);
+    h.first_seq = w->seg_first_seq;
+    h.last_seq = last_seq;
+    h.first_ns = w->seg_first_ns;
+    h.last_ns = w->last_ns;
+    h.count = w->seg_count;
+    memcpy(h.topic, w->topic, sizeof(h.topic));
+
+    int rc = seal_fd(w->fd, &h, w->file_off, w->index, w->index_count);
+    close(w->fd);
+    w->fd = -1;
+    w->segments++;
+    return rc;
+}
+
+int usrl_journal_roll(UsrlJournalWriter *w)
+{
+    if (!w) return -1;
+    return writer_seal(w, w->last_seq);
+}
+
+void usrl_journal_writer_close(UsrlJournalWriter *w)
+{
+    if (!w) return;
+    if (w->buf) writer_seal(w, (w->cover_last > w->last_seq) ? w->cover_last : w->last_seq);
+    free(w->buf);
+    free(w->index);
+    w->buf = NULL;
+    w->index = NULL;
+}
+
+int usrl_journal_flush(UsrlJournalWriter *w)
+{
+    if (!w) return -1;
+    if (w->fd < 0 || w->buf_len == 0) return 0;
+    if (write_all(w->fd, w->buf, w->buf_len) != 0) return -1;
+    w->file_off += w->buf_len;
+    w->buf_len = 0;
+    return 0;
+}
+
+int usrl_journal_sync(UsrlJournalWriter *w)
+{
+    if (usrl_journal_flush(w) != 0) return -1;
+    if (w->fd >= 0) {
+        w->syncs++;
+        if (fdatasync(w->fd) != 0) return -1;
+    }
+
+    /* A new segment is only durable once its directory entry is */
+    if (w->dir_dirty) {
+        if (fsync_dir(w->dir) != 0) return -1;
+        w->dir_dirty = 0;
+    }
+    return 0;
+}
+
+/* Room for one record in the buffer; returns where its header goes */
+static uint8_t *writer_reserve(UsrlJournalWriter *w, uint64_t seq, uint64_t size)
+{
+    if (w->fd >= 0 && w->seg_count > 0 &&
+        w->file_off + w->buf_len + size > w->segment_bytes) {
+        if (writer_seal(w, w->last_seq) != 0) return NULL;
+    }
+    if (w->fd < 0 && writer_start_segment(w, seq) != 0) return NULL;
+
+    if (w->buf_len + size > w->buf_cap) {
+        if (usrl_journal_flush(w) != 0) return NULL;
+        if (size > w->buf_cap) {
+            uint8_t *b = realloc(w->buf, size);
+            if (!b) return NULL;
+            w->buf = b;
+            w->buf_cap = (uint32_t)size;
+        }
+    }
+    return w->buf + w->buf_len;
+}
+
+static void writer_commit(UsrlJournalWriter *w, uint64_t seq, uint64_t ts, uint64_t size)
+{
+    uint64_t off = w->file_off + w->buf_len;
+    if (off >= w->next_index_off) {
+        if (w->index_count == w->index_cap) {
+            UsrlJournalIndexEntry *g = realloc(w->index, (size_t)w->index_cap * 2 * sizeof(*g));
+            if (g) {
+                w->index = g;
+                w->index_cap *= 2;
+            }
+        }
+        if (w->index_count < w->index_cap) {
+            w->index[w->index_count++] = (UsrlJournalIndexEntry){ seq, ts, off };
+            w->next_index_off = off + USRL_JOURNAL_INDEX_EVERY;
+        }
+    }
+    if (w->seg_count == 0) w->seg_first_ns = ts;
+
+    w->buf_len += (uint32_t)size;
+    w->seg_count++;
+    w->last_seq = seq;
+    w->last_ns = ts;
+    w->records++;
+    w->bytes += size;
+}
+
+/* Header and trace trailer; TRACED is only kept with a context to go with it */
+static inline void record_header(uint8_t *dst, uint64_t seq, uint64_t ts, uint16_t pub_id,
+                                 uint8_t flags, const UsrlJournalTrace *trace, uint32_t len)
+{
+    /* Zero the padding first so segments are byte-for-byte reproducible */
+    uint64_t size = usrl_journal_record_size(len);
+    memset(dst + size - 8, 0, 8);
+
+    UsrlJournalRecord r = { seq, ts, len, pub_id, flags & (uint8_t)~USRL_SLOT_F_TRACED, 0 };
+    if (trace) {
+        r.flags |= USRL_SLOT_F_TRACED;
+        r.rflags = USRL_JREC_F_TRACE;
+        memcpy(dst + size, trace, sizeof(*trace));
+    }
+    memcpy(dst, &r, sizeof(r));
+}
+
+static inline uint64_t record_bytes(uint32_t len, const UsrlJournalTrace *trace)
+{
+    return usrl_journal_record_size(len) + (trace ? sizeof(UsrlJournalTrace) : 0);
+}
+
+int usrl_journal_append_traced(UsrlJournalWriter *w, uint64_t seq, uint64_t timestamp_ns,
+                               uint16_t pub_id, uint8_t flags, const UsrlJournalTrace *trace,
+                               const void *data, uint32_t len)
+{
+    if (USRL_UNLIKELY(!w || !w->buf || (!data && len) || seq <= w->last_seq)) return -1;
+
+    uint64_t size = record_bytes(len, trace);
+    uint8_t *dst = writer_reserve(w, seq, size);
+    if (!dst) return -1;
+
+    record_header(dst, seq, timestamp_ns, pub_id, flags, trace, len);
+    if (len) memcpy(dst + sizeof(UsrlJournalRecord), data, len);
+    writer_commit(w, seq, timestamp_ns, size);
+    return 0;
+}
+
+int usrl_journal_append(UsrlJournalWriter *w, uint64_t seq, uint64_t timestamp_ns,
+                        uint16_t pub_id, uint8_t flags, const void *data, uint32_t len)
+{
+    return usrl_journal_append_traced(w, seq, timestamp_ns, pub_id, flags, NULL, data, len);
+}
+
+int usrl_journal_record(UsrlJournalWriter *w, UsrlSubscriber *sub, uint32_t max_batch)
+{
+    if (USRL_UNLIKELY(!w || !w->buf || !sub)) return -1;
+    if (max_batch == 0 || max_batch > RECORD_BATCH) max_batch = RECORD_BATCH;
+
+    UsrlSlotView views[RECORD_BATCH];
+    int n = usrl_sub_view_batch(sub, views, max_batch);
+    if (n <= 0) return n;
+
+    for (int i = 0; i < n; i++) {
+        const UsrlSlotView *v = &views[i];
+        if (i + 1 < n) USRL_PREFETCH_R(views[i + 1].data);
+        if (USRL_UNLIKELY(v->seq <= w->last_seq)) continue;
+
+        /* Copy straight into the write buffer, keep it only if still intact */
+        UsrlJournalTrace trace;
+        int traced = usrl_jrec_trace_from_slot(v->hdr, &trace);
+        uint64_t size = record_bytes(v->len, traced ? &trace : NULL);
+        uint8_t *dst = writer_reserve(w, v->seq, size);
+        if (!dst) return -1;
+
+        record_header(dst, v->seq, v->timestamp_ns, v->pub_id, v->hdr->flags, traced ? &trace : NULL,
+                      v->len);
+        memcpy(dst + sizeof(UsrlJournalRecord), v->data, v->len);
+        if (USRL_UNLIKELY(!usrl_view_valid(v))) {
+            w->lapped++;
+            continue;
+        }
+        writer_commit(w, v->seq, v->timestamp_ns, size);
+    }
+    return n;
+}
+
+/* ============================================================================
+ * READER
+ * ============================================================================ */
+
+int usrl_jseg_open(UsrlJournalSegment *s, const char *path)
+{
+    if (!s || !path) return -1;
+    memset(s, 0, sizeof(*s));
+    snprintf(s->path, sizeof(s->path), "%s", path);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(UsrlJournalSegHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    s->base = map;
+    s->size = (uint64_t)st.st_size;
+    s->hdr = (const UsrlJournalSegHeader *)s->base;
+
+    const UsrlJournalSegHeader *h = s->hdr;
+    if (h->magic != USRL_JOURNAL_MAGIC || h->version != USRL_JOURNAL_VERSION ||
+        h->hdr_size < sizeof(*h) || h->hdr_size > s->size) {
+        usrl_jseg_close(s);
+        return -1;
+    }
+
+    if ((h->flags & USRL_JSEG_F_SEALED) && h->data_end <= s->size &&
+        h->index_offset + (uint64_t)h->index_count * sizeof(UsrlJournalIndexEntry) <= s->size) {
+        s->data_end = h->data_end;
+        s->index = (const UsrlJournalIndexEntry *)(s->base + h->index_offset);
+        s->index_count = h->index_count;
+    } else {
+        s->data_end = scan_end(s->base, s->size, h->hdr_size, NULL, NULL);
+    }
+
+    madvise(map, (size_t)s->size, MADV_SEQUENTIAL);
+    return 0;
+}
+
+void usrl_jseg_close(UsrlJournalSegment *s)
+{
+    if (!s) return;
+    if (s->base) munmap((void *)s->base, (size_t)s->size);
+    s->base = NULL;
+    s->hdr = NULL;
+    s->size = 0;
+}
+
+/* Scan start: the last index entry whose key is below the target */
+static uint64_t index_floor(const UsrlJournalSegment *s, uint64_t target, int by_time)
+{
+    uint32_t lo = 0, hi = s->index_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint64_t k = by_time ? s->index[mid].timestamp_ns : s->index[mid].seq;
+        if (k < target) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo ? s->index[lo - 1].offset : usrl_jseg_begin(s);
+}
+
+uint64_t usrl_jseg_seek_seq(const UsrlJournalSegment *s, uint64_t seq)
+{
+    uint64_t off = index_floor(s, seq, 0);
+    const UsrlJournalRecord *r;
+    while ((r = usrl_jseg_record(s, off)) != NULL && r->seq < seq) off = usrl_jseg_next(r, off);
+    return off;
+}
+
+uint64_t usrl_jseg_seek_time(const UsrlJournalSegment *s, uint64_t ts)
+{
+    uint64_t off = index_floor(s, ts, 1);
+    const UsrlJournalRecord *r;
+    while ((r = usrl_jseg_record(s, off)) != NULL && r->timestamp_ns < ts) off = usrl_jseg_next(r, off);
+    return off;
+}
+
+static int cmp_seg(const void *a, const void *b)
+{
+    uint64_t x = ((const UsrlJournalSegInfo *)a)->first_seq;
+    uint64_t y = ((const UsrlJournalSegInfo *)b)->first_seq;
+    return (x > y) - (x < y);
+}
+
+int usrl_journal_list(const char *dir, const char *topic, UsrlJournalSegInfo *out, uint32_t max)
+{
+    if (!dir || !topic || (!out && max)) return -1;
+
+    char path[USRL_JOURNAL_PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", dir, topic) >= (int)sizeof(path)) return -1;
+
+    DIR *d = opendir(path);
+    if (!d) return (errno == ENOENT) ? 0 : -1;
+
+    /* Collect everything first: the newest segments must survive a small max */
+    uint32_t n = 0, cap = 64;
+    UsrlJournalSegInfo *all = malloc(cap * sizeof(*all));
+    size_t ext = strlen(USRL_JOURNAL_EXT);
+    struct dirent *e;
+    while (all && (e = readdir(d)) != NULL) {
+        size_t len = strlen(e->d_name);
+        if (len <= ext || strcmp(e->d_name + len - ext, USRL_JOURNAL_EXT) != 0) continue;
+
+        char *end;
+        uint64_t first = strtoull(e->d_name, &end, 10);
+        if (end != e->d_name + len - ext) continue;
+
+        if (n == cap) {
+            UsrlJournalSegInfo *g = realloc(all, (size_t)cap * 2 * sizeof(*g));
+            if (!g) {
+                free(all);
+                all = NULL;
+                break;
+            }
+            all = g;
+            cap *= 2;
+        }
+        all[n].first_seq = first;
+        if (snprintf(all[n].path, sizeof(all[n].path), "%s/%s", path, e->d_name) >=
+            (int)sizeof(all[n].path))
+            continue;
+        n++;
+    }
+    closedir(d);
+    if (!all) return -1;
+
+    qsort(all, n, sizeof(*all), cmp_seg);
+    if (max) memcpy(out, all, (n < max ? n : max) * sizeof(*out));
+    free(all);
+    return (int)n;
+}
+
+/* ============================================================================
+ * COMPACTION
+ * ============================================================================ */
+
+#define COMPACT_SUFFIX ".compact"
+
+typedef struct {
+    uint64_t hash;
+    uint64_t off;   /* 0 = empty (records never start at 0) */
+    uint32_t seg;
+    uint32_t _pad;
+} KeySlot;
+
+typedef struct {
+    KeySlot *slots;
+    uint32_t mask;
+    uint32_t count;
+} KeyTable;
+
+typedef struct {
+    const UsrlCompactSpec *spec;
+    UsrlJournalSegment *segs;
+    uint32_t seg_count;
+    KeyTable keys;
+} Compactor;
+
+static uint64_t fnv1a(const uint8_t *p, uint32_t n)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (uint32_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+/* Key bytes of a record, NULL when the payload is too short to hold one */
+static const uint8_t *record_key(const UsrlCompactSpec *spec, const UsrlJournalRecord *r,
+                                 uint32_t *len)
+{
+    if (spec->key_len == 0) {
+        *len = sizeof(r->pub_id);
+        return (const uint8_t *)&r->pub_id;
+    }
+    if ((uint64_t)spec->key_offset + spec->key_len > r->len) return NULL;
+    *len = spec->key_len;
+    return usrl_jseg_payload(r) + spec->key_offset;
+}
+
+static const UsrlJournalRecord *slot_record(const Compactor *c, const KeySlot *s)
+{
+    return (const UsrlJournalRecord *)(c->segs[s->seg].base + s->off);
+}
+
+/* Slot holding key, or the empty slot where it belongs */
+static KeySlot *key_find(Compactor *c, const uint8_t *key, uint32_t len, uint64_t hash)
+{
+    for (uint32_t i = (uint32_t)hash & c->keys.mask;; i = (i + 1) & c->keys.mask) {
+        KeySlot *s = &c->keys.slots[i];
+        if (s->off == 0) return s;
+        if (s->hash != hash) continue;
+
+        uint32_t klen = 0;
+        const uint8_t *k = record_key(c->spec, slot_record(c, s), &klen);
+        if (klen == len && memcmp(k, key, len) == 0) return s;
+    }
+}
+
+static int key_grow(KeyTable *t)
+{
+    uint32_t cap = (t->mask + 1) * 2;
+    KeySlot *slots = calloc(cap, sizeof(*slots));
+    if (!slots) return -1;
+
+    for (uint32_t i = 0; i <= t->mask; i++) {
+        if (t->slots[i].off == 0) continue;
+        uint32_t j = (uint32_t)t->slots[i].hash & (cap - 1);
+        while (slots[j].off) j = (j + 1) & (cap - 1);
+        slots[j] = t->slots[i];
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->mask = cap - 1;
+    return 0;
+}
+
+/* Pass 1: newest record per key, and the newest timestamp overall */
+static int compact_index(Compactor *c, uint64_t *max_ns, UsrlCompactStats *st)
+{
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < c->seg_count; i++) {
+        const UsrlJournalSegment *s = &c->segs[i];
+        const UsrlJournalRecord *r;
+        for (uint64_t off = usrl_jseg_begin(s); (r = usrl_jseg_record(s, off)) != NULL;
+             off = usrl_jseg_next(r, off)) {
+            if (r->seq <= seen) continue;
+            seen = r->seq;
+            st->records_in++;
+            if (r->timestamp_ns > *max_ns) *max_ns = r->timestamp_ns;
+
+            uint32_t len;
+            const uint8_t *key = record_key(c->spec, r, &len);
+            if (!key) continue;
+
+            uint64_t hash = fnv1a(key, len);
+            KeySlot *slot = key_find(c, key, len, hash);
+            if (slot->off == 0) {
+                if ((c->keys.count + 1) * 2 > c->keys.mask + 1) {
+                    if (key_grow(&c->keys) != 0) return -1;
+                    slot = key_find(c, key, len, hash);
+                }
+                c->keys.count++;
+            }
+            *slot = (KeySlot){ hash, off, i, 0 };
+        }
+    }
+    return 0;
+}
+
+/* Pass 2: copy survivors, in seq order, into new segments */
+static int compact_copy(Compactor *c, UsrlJournalWriter *w, uint64_t max_ns, UsrlCompactStats *st)
+{
+    uint64_t seen = 0;
+    uint64_t horizon = c->spec->horizon_ns;
+    for (uint32_t i = 0; i < c->seg_count; i++) {
+        const UsrlJournalSegment *s = &c->segs[i];
+        const UsrlJournalRecord *r;
+        for (uint64_t off = usrl_jseg_begin(s); (r = usrl_jseg_record(s, off)) != NULL;
+             off = usrl_jseg_next(r, off)) {
+            if (r->seq <= seen) continue;
+            seen = r->seq;
+
+            uint32_t len;
+            const uint8_t *key = record_key(c->spec, r, &len);
+            int keep = !key || (horizon && r->timestamp_ns + horizon >= max_ns);
+            if (!keep) {
+                const KeySlot *slot = key_find(c, key, len, fnv1a(key, len));
+                keep = slot->seg == i && slot->off == off;
+            }
+            if (!keep) continue;
+
+            if (usrl_journal_append_traced(w, r->seq, r->timestamp_ns, r->pub_id, r->flags,
+                                           usrl_jrec_trailer(r), usrl_jseg_payload(r), r->len) != 0)
+                return -1;
+            st->records_out++;
+        }
+        madvise((void *)s->base, (size_t)s->size, MADV_DONTNEED);
+    }
+    return 0;
+}
+
+/* Temporary outputs in dir, sorted; removes them instead when discard is set */
+static int compact_outputs(const char *dir, UsrlJournalSegInfo *out, uint32_t max, int discard)
+{
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+
+    const char *ext = USRL_JOURNAL_EXT COMPACT_SUFFIX;
+    size_t ext_len = strlen(ext);
+    uint32_t n = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        size_t len = strlen(e->d_name);
+        if (len <= ext_len || strcmp(e->d_name + len - ext_len, ext) != 0) continue;
+
+        char path[USRL_JOURNAL_PATH_MAX];
+        if (snprintf(path, sizeof(path), "%s/%s", dir, e->d_name) >= (int)sizeof(path)) continue;
+        if (discard) {
+            unlink(path);
+        } else if (n < max) {
+            out[n].first_seq = strtoull(e->d_name, NULL, 10);
+            memcpy(out[n].path, path, sizeof(path));
+            n++;
+        }
+    }
+    closedir(d);
+
+    qsort(out, n, sizeof(*out), cmp_seg);
+    return (int)n;
+}
+
+int usrl_journal_compact(const char *dir, const char *topic, const UsrlCompactSpec *spec,
+                         UsrlCompactStats *stats)
+{
+    if (!dir || !topic || !spec) return -1;
+
+    UsrlCompactStats st;
+    memset(&st, 0, sizeof(st));
+
+    char tdir[USRL_JOURNAL_PATH_MAX], lock[USRL_JOURNAL_PATH_MAX];
+    if (snprintf(tdir, sizeof(tdir), "%s/%s", dir, topic) >= (int)sizeof(tdir)) return -1;
+    if (snprintf(lock, sizeof(lock), "%s/.compact.lock", tdir) >= (int)sizeof(lock)) return -1;
+
+    /* One compactor per topic; leftovers of a crashed one are discarded */
+    int lock_fd = open(lock, O_CREAT | O_RDWR, 0644);
+    if (lock_fd < 0) return -1;
+    if (flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+        close(lock_fd);
+        return -1;
+    }
+    compact_outputs(tdir, NULL, 0, 1);
+
+    int rc = -1;
+    int n = usrl_journal_list(dir, topic, NULL, 0);
+    UsrlJournalSegInfo *list = malloc((n > 0 ? (size_t)n : 1) * sizeof(*list));
+    Compactor c = { spec, NULL, 0, { NULL, 0, 0 } };
+    UsrlJournalWriter w;
+    w.buf = NULL;
+    if (n < 0 || !list) goto out;
+
+    n = usrl_journal_list(dir, topic, list, (uint32_t)n);
+    c.segs = calloc(n > 0 ? (size_t)n : 1, sizeof(*c.segs));
+    c.keys.slots = calloc(1024, sizeof(KeySlot));
+    c.keys.mask = 1023;
+    if (n < 0 || !c.segs || !c.keys.slots) goto out;
+
+    /* Inputs: the sealed prefix; the active segment and anything after stay */
+    for (int i = 0; i < n; i++) {
+        UsrlJournalSegment *s = &c.segs[c.seg_count];
+        if (usrl_jseg_open(s, list[i].path) != 0) break;
+        if (!(s->hdr->flags & USRL_JSEG_F_SEALED)) {
+            usrl_jseg_close(s);
+            break;
+        }
+        c.seg_count++;
+        st.bytes_in += s->size;
+    }
+    st.segments_in = c.seg_count;
+    if (c.seg_count == 0 ||
+        (c.seg_count == 1 && (c.segs[0].hdr->flags & USRL_JSEG_F_COMPACTED))) {
+        memset(&st, 0, sizeof(st));
+        rc = 0;
+        goto out;
+    }
+
+    uint64_t max_ns = 0;
+    if (compact_index(&c, &max_ns, &st) != 0) goto out;
+    st.keys = c.keys.count;
+
+    if (writer_init(&w, dir, topic, spec->segment_bytes) != 0) goto out;
+    w.seg_flags = USRL_JSEG_F_COMPACTED;
+    w.suffix = COMPACT_SUFFIX;
+    w.cover_first = c.segs[0].hdr->first_seq;
+    w.cover_last = c.segs[c.seg_count - 1].hdr->last_seq;
+    if (compact_copy(&c, &w, max_ns, &st) != 0) goto out;
+
+    uint64_t segments = w.segments + (w.fd >= 0);
+    usrl_journal_writer_close(&w);
+    if (w.segments != segments || fsync_dir(tdir) != 0) goto out;
+
+    /* Swap in: outputs replace inputs by name in seq order, the rest go */
+    UsrlJournalSegInfo *outs = malloc((segments ? segments : 1) * sizeof(*outs));
+    int m = outs ? compact_outputs(tdir, outs, (uint32_t)segments, 0) : -1;
+    if (m != (int)segments) {
+        free(outs);
+        goto out;
+    }
+
+    for (int i = 0; i < m; i++) {
+        char final[USRL_JOURNAL_PATH_MAX + 32];
+        st.bytes_out += file_size(outs[i].path);
+        if (seg_path(final, sizeof(final), tdir, outs[i].first_seq, NULL) != 0 ||
+            rename(outs[i].path, final) != 0) {
+            free(outs);
+            goto out;
+        }
+    }
+    for (uint32_t i = 0; i < c.seg_count; i++) {
+        int replaced = 0;
+        for (int j = 0; j < m && !replaced; j++) replaced = outs[j].first_seq == list[i].first_seq;
+        if (!replaced) unlink(list[i].path);
+    }
+    free(outs);
+    st.segments_out = (uint64_t)m;
+    rc = fsync_dir(tdir);
+
+out:
+    if (rc != 0 && w.buf) usrl_journal_writer_close(&w);
+    if (rc != 0) compact_outputs(tdir, NULL, 0, 1);
+    for (uint32_t i = 0; i < c.seg_count; i++) usrl_jseg_close(&c.segs[i]);
+    free(c.segs);
+    free(c.keys.slots);
+    free(list);
+    if (stats) *stats = st;
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+    return rc;
+}
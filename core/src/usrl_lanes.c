@@ -0,0 +1,191 @@
+/**
+ * @file usrl_lanes.c
+ * @brief Priority lanes: one logical topic over several rings.
+ */
+
+#include "usrl_lanes.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LANE_FILL_EVERY 64 /* publishes between lane fill checks */
+
+static int lane_name(char *out, const char *topic, uint32_t lane)
+{
+    int n = snprintf(out, USRL_MAX_TOPIC_NAME, USRL_LANE_NAME_FMT, topic, lane);
+    return (n > 0 && n < USRL_MAX_TOPIC_NAME) ? 0 : -1;
+}
+
+int usrl_lanes_expand(const UsrlTopicConfig *topic, uint32_t lanes,
+                      UsrlTopicConfig *out, uint32_t max_out)
+{
+    if (!topic || !out || lanes == 0 || lanes > USRL_MAX_LANES || lanes > max_out)
+        return -1;
+
+    for (uint32_t i = 0; i < lanes; i++) {
+        out[i] = *topic;
+        if (lane_name(out[i].name, topic->name, i) != 0) return -1;
+    }
+    return (int)lanes;
+}
+
+/* ============================================================================
+ * PUBLISHER
+ * ============================================================================ */
+
+int usrl_lanes_pub_init(UsrlLanePublisher *p, void *core_base, const char *topic,
+                        uint16_t pub_id, uint64_t rate_limit_hz)
+{
+    if (!p || !core_base || !topic) return 0;
+    memset(p, 0, sizeof(*p));
+
+    char name[USRL_MAX_TOPIC_NAME];
+    for (uint32_t i = 0; i < USRL_MAX_LANES; i++) {
+        if (lane_name(name, topic, i) != 0) break;
+        TopicEntry *t = usrl_get_topic(core_base, name);
+        if (!t) break;
+
+        if (i == 0) p->is_mwmr = (t->type == USRL_RING_TYPE_MWMR);
+        if (p->is_mwmr) usrl_mwmr_pub_init(&p->mwmr[i], core_base, name, pub_id);
+        else            usrl_pub_init(&p->swmr[i], core_base, name, pub_id);
+        p->lane_count++;
+    }
+
+    usrl_quota_init(&p->quota, rate_limit_hz);
+    p->use_limiter = (rate_limit_hz > 0);
+    return (int)p->lane_count;
+}
+
+/*
+ * Recompute which lanes shed for ring fill. Fill is measured against the
+ * last stage of a gated lane; an ungated ring laps its readers and never
+ * fills. Lane k sheds while any more urgent lane is over (N - k) / N full.
+ */
+static void lanes_refresh_fill(UsrlLanePublisher *p)
+{
+    uint32_t n_lanes = p->lane_count;
+    uint32_t mask = 0;
+
+    for (uint32_t j = 0; j + 1 < n_lanes; j++) {
+        RingDesc *d = p->is_mwmr ? p->mwmr[j].desc : p->swmr[j].desc;
+        TopicExt *x = p->is_mwmr ? p->mwmr[j].ext : p->swmr[j].ext;
+        if (!d || !x) continue;
+
+        uint32_t n = (uint32_t)atomic_load_explicit(&x->stage_count, memory_order_relaxed);
+        if (n == 0) continue;
+        uint64_t head = atomic_load_explicit(&d->w_head, memory_order_relaxed);
+        uint64_t done = atomic_load_explicit(&x->stages[n - 1].seq, memory_order_acquire);
+        uint64_t fill = (head > done) ? head - done : 0;
+
+        for (uint32_t k = j + 1; k < n_lanes; k++)
+            if (fill * n_lanes > (uint64_t)d->slot_count * (n_lanes - k)) mask |= 1u << k;
+    }
+    p->shed_mask = mask;
+}
+
+int usrl_lanes_publish(UsrlLanePublisher *p, uint32_t lane, const void *data, uint32_t len)
+{
+    if (USRL_UNLIKELY(!p || !data)) return USRL_RING_ERROR;
+    if (USRL_UNLIKELY(lane >= p->lane_count)) return USRL_RING_ERROR;
+
+    if (USRL_UNLIKELY(p->fill_countdown-- == 0)) {
+        p->fill_countdown = LANE_FILL_EVERY;
+        lanes_refresh_fill(p);
+    }
+    if ((p->shed_mask >> lane) & 1) {
+        p->shed[lane]++;
+        return USRL_RING_FULL;
+    }
+
+    /* Lane k may only use (N - k) / N of the shared budget */
+    if (p->use_limiter &&
+        usrl_quota_check_share(&p->quota, p->lane_count - lane, p->lane_count)) {
+        p->shed[lane]++;
+        return USRL_RING_FULL;
+    }
+
+    if (!p->is_mwmr) return usrl_pub_publish(&p->swmr[lane], data, len);
+
+    /* A timed-out writer has already claimed (and abandoned) its seq;
+     * publishing again would claim another, so it is not retried here. */
+    int res = usrl_mwmr_pub_publish(&p->mwmr[lane], data, len);
+    if (res == USRL_RING_TIMEOUT) p->shed[lane]++;
+    return res;
+}
+
+/* ============================================================================
+ * SUBSCRIBER
+ * ============================================================================ */
+
+int usrl_lanes_sub_init(UsrlLaneSubscriber *s, void *core_base, const char *topic)
+{
+    if (!s || !core_base || !topic) return 0;
+    memset(s, 0, sizeof(*s));
+
+    char name[USRL_MAX_TOPIC_NAME];
+    for (uint32_t i = 0; i < USRL_MAX_LANES; i++) {
+        if (lane_name(name, topic, i) != 0) break;
+        if (!usrl_get_topic(core_base, name)) break;
+        usrl_sub_init(&s->lanes[i], core_base, name);
+        s->lane_count++;
+    }
+    return (int)s->lane_count;
+}
+
+int usrl_lanes_sub_next(UsrlLaneSubscriber *s, uint8_t *out_buf, uint32_t buf_len,
+                        uint16_t *out_pub_id, uint32_t *out_lane)
+{
+    if (USRL_UNLIKELY(!s || !out_buf || s->lane_count == 0)) return USRL_RING_ERROR;
+
+    for (uint32_t i = 0; i < s->lane_count; i++) {
+        int n = usrl_sub_next(&s->lanes[i], out_buf, buf_len, out_pub_id);
+        if (n == USRL_RING_NO_DATA) continue;
+        if (out_lane) *out_lane = i;
+        return n;
+    }
+    return USRL_RING_NO_DATA;
+}
+
+/*
+ * Fill up to max_msgs messages, strictly by priority. After every message
+ * the scan restarts at lane 0, so urgent traffic arriving mid-batch is
+ * still delivered ahead of the remaining bulk backlog. A lane is only read
+ * when the arena can hold its largest payload, so nothing is truncated; a
+ * lane that no longer fits is skipped for the rest of this batch while
+ * lanes with smaller slots keep filling it.
+ */
+int usrl_lanes_sub_next_batch(UsrlLaneSubscriber *s, UsrlLaneMsg *msgs, uint32_t max_msgs,
+                              uint8_t *arena, uint32_t arena_len)
+{
+    if (USRL_UNLIKELY(!s || !msgs || !arena || s->lane_count == 0)) return USRL_RING_ERROR;
+
+    uint32_t count = 0;
+    uint32_t used = 0;
+
+    while (count < max_msgs) {
+        int got = 0;
+
+        for (uint32_t i = 0; i < s->lane_count; i++) {
+            UsrlSubscriber *sub = &s->lanes[i];
+            uint32_t cap = sub->desc->slot_size - (uint32_t)sizeof(SlotHeader);
+            if (arena_len - used < cap) continue;
+
+            uint16_t pid = 0;
+            int n = usrl_sub_next(sub, arena + used, cap, &pid);
+            if (n == USRL_RING_NO_DATA) continue;
+            if (n < 0) return count ? (int)count : n;
+
+            msgs[count].data = arena + used;
+            msgs[count].len = (uint32_t)n;
+            msgs[count].pub_id = pid;
+            msgs[count].lane = (uint16_t)i;
+            count++;
+            used += (uint32_t)usrl_align_up((uint64_t)n, 8);
+            if (used > arena_len) used = arena_len;
+            got = 1;
+            break;
+        }
+
+        if (!got) break;
+    }
+    return (int)count;
+}
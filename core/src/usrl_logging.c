@@ -4,6 +4,7 @@
  */
 
 #include "usrl_logging.h"
+#include "usrl_metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
@@ -17,6 +18,20 @@ static UsrlLogLevel min_log_level = USRL_LOG_INFO;
 
 static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
 
+#define METRIC_FLUSH_MS   1000
+#define METRIC_CACHE_SIZE 64   /* per-thread (module, name) -> cell, power-of-two */
+
+typedef struct {
+    const UsrlMetrics *reg;
+    const char *module;
+    const char *name;
+    UsrlMetricCell *cell;
+} MetricCacheEntry;
+
+static _Thread_local MetricCacheEntry metric_cache[METRIC_CACHE_SIZE];
+static UsrlMetrics *metric_flusher = NULL;      /* under log_lock */
+static int metric_flusher_wanted = 0;           /* logging is up: start it on the first metric */
+
 static inline uint64_t usrl_now_ns(void)
 {
     struct timespec ts;
@@ -36,6 +51,20 @@ static const char *level_str(UsrlLogLevel level)
     }
 }
 
+/* Flusher sink: scrapes the current default registry, once it has metrics */
+static void metric_sink(const UsrlMetrics *m, void *arg)
+{
+    (void)m;
+    (void)arg;
+
+    UsrlMetrics *reg = usrl_metrics_default();
+    if (!reg || usrl_metrics_count(reg) == 0) return;
+
+    pthread_mutex_lock(&log_lock);
+    if (log_file) usrl_metrics_dump(reg, log_file);
+    pthread_mutex_unlock(&log_lock);
+}
+
 int usrl_logging_init(const char *log_file_path, UsrlLogLevel min_level)
 {
     min_log_level = min_level;
@@ -48,9 +77,22 @@ int usrl_logging_init(const char *log_file_path, UsrlLogLevel min_level)
         log_file = stderr;
     }
 
+    pthread_mutex_lock(&log_lock);
+    metric_flusher_wanted = 1;
+    pthread_mutex_unlock(&log_lock);
     return 0;
 }
 
+/* The metric flusher thread only runs once something has been recorded */
+static void metric_flusher_ensure(UsrlMetrics *reg)
+{
+    pthread_mutex_lock(&log_lock);
+    if (metric_flusher_wanted && !metric_flusher &&
+        usrl_metrics_flusher_start(reg, METRIC_FLUSH_MS, metric_sink, NULL) == 0)
+        metric_flusher = reg;
+    pthread_mutex_unlock(&log_lock);
+}
+
 void usrl_log(UsrlLogLevel level, const char *module, uint32_t line,
               const char *fmt, ...)
 {
@@ -82,22 +124,54 @@ void usrl_log(UsrlLogLevel level, const char *module, uint32_t line,
     pthread_mutex_unlock(&log_lock);
 }
 
+/* Does the cell's name read "<module>.<name>" (as truncated by snprintf)? */
+static int cell_named(const UsrlMetricCell *c, const char *module, const char *name)
+{
+    const char *f = c->name;
+    const char *end = c->name + USRL_METRIC_NAME_MAX - 1;
+
+    for (; *module; module++, f++) {
+        if (f == end) return 1;
+        if (*f != *module) return 0;
+    }
+    if (f == end) return 1;
+    if (*f++ != '.') return 0;
+    for (; *name; name++, f++) {
+        if (f == end) return 1;
+        if (*f != *name) return 0;
+    }
+    return *f == '\0';
+}
+
+/*
+ * Record a sample as the gauge "<module>.<metric>" in the default metrics
+ * registry; the flusher writes it to the log. The cell is cached per thread
+ * by the (module, metric) pointers and a hit is confirmed against the cell
+ * name, so a reused buffer with new contents looks up its own cell.
+ */
 void usrl_log_metric(const char *module, const char *metric_name, int64_t value)
 {
-    if (!log_file) return;
+    UsrlMetrics *reg = usrl_metrics_default();
+    if (USRL_UNLIKELY(!reg)) return;
 
-    uint64_t now = usrl_now_ns();
-    uint64_t sec = now / 1000000000ULL;
-    uint64_t ms  = (now % 1000000000ULL) / 1000000ULL;
+    if (!module) module = "unknown";
+    if (!metric_name) metric_name = "unknown";
 
-    pthread_mutex_lock(&log_lock);
-    fprintf(log_file,
-            "[%" PRIu64 ".%03" PRIu64 "] [METRIC] [%s] %s=%" PRId64 "\n",
-            sec, ms,
-            module ? module : "unknown",
-            metric_name ? metric_name : "unknown",
-            (int64_t)value);
-    pthread_mutex_unlock(&log_lock);
+    uintptr_t key = ((uintptr_t)module >> 3) ^ (((uintptr_t)metric_name >> 3) * 31);
+    MetricCacheEntry *e = &metric_cache[key & (METRIC_CACHE_SIZE - 1)];
+
+    if (USRL_UNLIKELY(e->reg != reg || e->module != module || e->name != metric_name ||
+                      (e->cell && !cell_named(e->cell, module, metric_name)))) {
+        char full[USRL_METRIC_NAME_MAX];
+        snprintf(full, sizeof(full), "%s.%s", module, metric_name);
+        e->cell = usrl_metric_gauge(reg, full);
+        e->reg = reg;
+        e->module = module;
+        e->name = metric_name;
+        if (e->cell) metric_flusher_ensure(reg);
+    }
+
+    if (USRL_LIKELY(e->cell != NULL)) usrl_metric_set(e->cell, value);
 }
 
 void usrl_log_lag(const char *topic, uint64_t lag_slots, uint64_t threshold)
@@ -125,6 +199,14 @@ void usrl_log_flush(void)
 
 void usrl_logging_shutdown(void)
 {
+    /* The sink takes log_lock: stop the flusher outside it */
+    pthread_mutex_lock(&log_lock);
+    UsrlMetrics *flusher = metric_flusher;
+    metric_flusher = NULL;
+    metric_flusher_wanted = 0;
+    pthread_mutex_unlock(&log_lock);
+    if (flusher) usrl_metrics_flusher_stop(flusher); /* Writes a final scrape */
+
     if (log_file && log_file != stderr) {
         fclose(log_file);
         log_file = NULL;
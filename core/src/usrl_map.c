@@ -0,0 +1,325 @@
+/**
+ * @file usrl_map.c
+ * @brief Fixed-capacity concurrent hash map in shared memory.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+#include "usrl_map.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define LOCK_SPINS 4096 /* spins between writer liveness checks */
+
+static uint32_t next_power_of_two_u32(uint32_t v)
+{
+    if (v == 0) return 1;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return ++v;
+}
+
+/* splitmix64 finalizer: cheap, and spreads sequential ids/CRCs well */
+static inline uint64_t map_hash(uint64_t k)
+{
+    k ^= k >> 30;
+    k *= 0xbf58476d1ce4e5b9ULL;
+    k ^= k >> 27;
+    k *= 0x94d049bb133111ebULL;
+    k ^= k >> 31;
+    return k;
+}
+
+static inline UsrlMapBucket *map_bucket(const UsrlMap *m, uint32_t idx)
+{
+    return (UsrlMapBucket *)(m->buckets + (uint64_t)idx * m->stride);
+}
+
+static inline uint32_t map_stride(uint32_t value_size)
+{
+    return (uint32_t)usrl_align_up(sizeof(UsrlMapBucket) + value_size, USRL_ALIGNMENT);
+}
+
+/* ============================================================================
+ * LAYOUT
+ * ============================================================================ */
+
+uint64_t usrl_map_required_size(uint32_t capacity, uint32_t value_size)
+{
+    uint32_t cap = next_power_of_two_u32(capacity);
+    return usrl_align_up(sizeof(UsrlMapHeader), USRL_ALIGNMENT) +
+           (uint64_t)cap * map_stride(value_size);
+}
+
+int usrl_map_format(void *mem, uint64_t size, uint32_t capacity, uint32_t value_size)
+{
+    if (!mem || capacity == 0 || value_size == 0 || value_size > UINT16_MAX) return USRL_MAP_ERROR;
+    if (size < usrl_map_required_size(capacity, value_size)) return USRL_MAP_FULL;
+
+    memset(mem, 0, size);
+
+    UsrlMapHeader *hdr = (UsrlMapHeader *)mem;
+    hdr->version = USRL_MAP_VERSION;
+    hdr->size = size;
+    hdr->capacity = next_power_of_two_u32(capacity);
+    hdr->value_size = value_size;
+    hdr->bucket_size = map_stride(value_size);
+    atomic_store_explicit(&hdr->count, 0, memory_order_relaxed);
+
+    /* Magic last: attach() refuses a half-formatted map */
+    atomic_thread_fence(memory_order_release);
+    hdr->magic = USRL_MAP_MAGIC;
+    return USRL_MAP_OK;
+}
+
+int usrl_map_attach(UsrlMap *m, void *mem)
+{
+    if (!m || !mem) return USRL_MAP_ERROR;
+
+    UsrlMapHeader *hdr = (UsrlMapHeader *)mem;
+    if (hdr->magic != USRL_MAP_MAGIC || hdr->version != USRL_MAP_VERSION) return USRL_MAP_ERROR;
+
+    m->hdr = hdr;
+    m->buckets = (uint8_t *)mem + usrl_align_up(sizeof(UsrlMapHeader), USRL_ALIGNMENT);
+    m->mask = hdr->capacity - 1;
+    m->stride = hdr->bucket_size;
+    m->map_size = 0;
+    return USRL_MAP_OK;
+}
+
+/* ============================================================================
+ * STANDALONE SHM OBJECT
+ * ============================================================================ */
+
+/**
+ * usrl_map_create return codes (same as usrl_core_init)
+ *  0  : created and formatted
+ *  1  : already exists (not formatted by this call)
+ * -1  : invalid params or shm_open failed (not EEXIST)
+ * -2  : ftruncate failed
+ * -3  : mmap failed
+ */
+int usrl_map_create(const char *path, uint32_t capacity, uint32_t value_size)
+{
+    if (!path || capacity == 0 || value_size == 0 || value_size > UINT16_MAX) return -1;
+
+    uint64_t size = usrl_map_required_size(capacity, value_size);
+
+    int fd = shm_open(path, O_CREAT | O_RDWR | O_EXCL, 0666);
+    if (fd < 0) return (errno == EEXIST) ? 1 : -1;
+
+    if (ftruncate(fd, (off_t)size) < 0) {
+        close(fd);
+        return -2;
+    }
+
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return -3;
+    }
+
+    usrl_map_format(base, size, capacity, value_size);
+
+    munmap(base, size);
+    close(fd);
+    return 0;
+}
+
+int usrl_map_open(UsrlMap *m, const char *path)
+{
+    if (!m || !path) return USRL_MAP_ERROR;
+
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) return USRL_MAP_ERROR;
+    struct stat st;
+    int rc = fstat(fd, &st);
+    close(fd);
+    if (rc != 0 || st.st_size <= 0) return USRL_MAP_ERROR;
+
+    void *base = usrl_core_map(path, (uint64_t)st.st_size);
+    if (!base) return USRL_MAP_ERROR;
+
+    if (usrl_map_attach(m, base) != USRL_MAP_OK) {
+        munmap(base, (size_t)st.st_size);
+        return USRL_MAP_ERROR;
+    }
+
+    m->map_size = (size_t)st.st_size;
+    return USRL_MAP_OK;
+}
+
+void usrl_map_close(UsrlMap *m)
+{
+    if (!m || !m->hdr) return;
+    if (m->map_size) munmap(m->hdr, m->map_size);
+    memset(m, 0, sizeof(*m));
+}
+
+/* ============================================================================
+ * OPERATIONS
+ * ============================================================================ */
+
+/* Find the bucket holding `key`; optionally claim an empty one for it. */
+static UsrlMapBucket *map_find(const UsrlMap *m, uint64_t key, int claim)
+{
+    uint32_t idx = (uint32_t)map_hash(key) & m->mask;
+
+    for (uint32_t probe = 0; probe <= m->mask; probe++) {
+        UsrlMapBucket *b = map_bucket(m, (idx + probe) & m->mask);
+        uint64_t k = atomic_load_explicit(&b->key, memory_order_acquire);
+
+        if (k == key) return b;
+        if (k != USRL_MAP_EMPTY_KEY) continue;
+        if (!claim) return NULL; /* Empty bucket ends the probe chain */
+
+        uint64_t expected = USRL_MAP_EMPTY_KEY;
+        if (atomic_compare_exchange_strong_explicit(&b->key, &expected, key,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire))
+            return b;
+        if (expected == key) return b; /* Another writer claimed it for us */
+    }
+    return NULL;
+}
+
+static inline uint64_t lock_word(uint32_t seq, pid_t owner)
+{
+    return (uint64_t)seq | ((uint64_t)(uint32_t)owner << 32);
+}
+
+/* A bucket locked by a process that no longer exists: take the lock over,
+ * drop the value it may have torn and release. Returns 1 if reclaimed. */
+static int bucket_reclaim(const UsrlMap *m, UsrlMapBucket *b, uint64_t w)
+{
+    pid_t owner = (pid_t)(w >> 32);
+    if (owner <= 0 || kill(owner, 0) == 0 || errno != ESRCH) return 0;
+
+    uint_fast64_t expected = w;
+    if (!atomic_compare_exchange_strong_explicit(&b->seq, &expected, lock_word((uint32_t)w, getpid()),
+                                                 memory_order_acquire, memory_order_relaxed))
+        return 0;
+    if (b->live) atomic_fetch_sub_explicit(&m->hdr->count, 1, memory_order_relaxed);
+    b->live = 0;
+    b->value_len = 0;
+    atomic_store_explicit(&b->seq, lock_word((uint32_t)w + 1, 0), memory_order_release);
+    return 1;
+}
+
+static inline uint64_t bucket_lock(const UsrlMap *m, UsrlMapBucket *b)
+{
+    uint32_t spins = 0;
+    for (;;) {
+        uint64_t w = atomic_load_explicit(&b->seq, memory_order_relaxed);
+        if (!(w & 1)) {
+            uint_fast64_t expected = w;
+            uint64_t locked = lock_word((uint32_t)w + 1, getpid());
+            if (atomic_compare_exchange_weak_explicit(&b->seq, &expected, locked,
+                                                      memory_order_acquire,
+                                                      memory_order_relaxed))
+                return locked;
+        } else if (USRL_UNLIKELY(++spins >= LOCK_SPINS)) {
+            spins = 0;
+            bucket_reclaim(m, b, w);
+        }
+        CPU_RELAX();
+    }
+}
+
+static inline void bucket_unlock(UsrlMapBucket *b, uint64_t w)
+{
+    atomic_store_explicit(&b->seq, lock_word((uint32_t)w + 1, 0), memory_order_release);
+}
+
+int usrl_map_put(UsrlMap *m, uint64_t key, const void *value, uint32_t len)
+{
+    if (USRL_UNLIKELY(!m || !m->hdr || !value || key == USRL_MAP_EMPTY_KEY)) return USRL_MAP_ERROR;
+    if (USRL_UNLIKELY(len > m->hdr->value_size)) return USRL_MAP_FULL;
+
+    UsrlMapBucket *b = map_find(m, key, 1);
+    if (!b) return USRL_MAP_FULL;
+
+    /* count changes under the lock, before live: a writer dying in between
+     * leaves it one high, never below the live keys */
+    uint64_t s = bucket_lock(m, b);
+    memcpy((uint8_t *)(b + 1), value, len);
+    b->value_len = (uint16_t)len;
+    if (!b->live) {
+        atomic_fetch_add_explicit(&m->hdr->count, 1, memory_order_relaxed);
+        b->live = 1;
+    }
+    bucket_unlock(b, s);
+    return USRL_MAP_OK;
+}
+
+int usrl_map_get(const UsrlMap *m, uint64_t key, void *out, uint32_t max_len)
+{
+    if (USRL_UNLIKELY(!m || !m->hdr || !out || key == USRL_MAP_EMPTY_KEY)) return USRL_MAP_ERROR;
+
+    UsrlMapBucket *b = map_find(m, key, 0);
+    if (!b) return USRL_MAP_NOT_FOUND;
+
+    uint32_t spins = 0;
+    for (;;) {
+        uint64_t s1 = atomic_load_explicit(&b->seq, memory_order_acquire);
+        if (USRL_UNLIKELY(s1 & 1)) {
+            if (++spins >= LOCK_SPINS) {
+                spins = 0;
+                bucket_reclaim(m, b, s1);
+            }
+            CPU_RELAX();
+            continue;
+        }
+
+        uint32_t len = b->value_len;
+        int live = b->live;
+        if (len > max_len) len = max_len + 1; /* Report TRUNC after validation */
+        else if (live) memcpy(out, (const uint8_t *)(b + 1), len);
+
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t s2 = atomic_load_explicit(&b->seq, memory_order_relaxed);
+        if (USRL_UNLIKELY(s1 != s2)) continue;
+
+        if (!live) return USRL_MAP_NOT_FOUND;
+        if (len > max_len) return USRL_MAP_TRUNC;
+        return (int)len;
+    }
+}
+
+int usrl_map_erase(UsrlMap *m, uint64_t key)
+{
+    if (USRL_UNLIKELY(!m || !m->hdr || key == USRL_MAP_EMPTY_KEY)) return USRL_MAP_ERROR;
+
+    UsrlMapBucket *b = map_find(m, key, 0);
+    if (!b) return USRL_MAP_NOT_FOUND;
+
+    uint64_t s = bucket_lock(m, b);
+    int was_live = b->live;
+    b->live = 0;
+    b->value_len = 0;
+    if (was_live) atomic_fetch_sub_explicit(&m->hdr->count, 1, memory_order_relaxed);
+    bucket_unlock(b, s);
+    return was_live ? USRL_MAP_OK : USRL_MAP_NOT_FOUND;
+}
+
+uint32_t usrl_map_count(const UsrlMap *m)
+{
+    if (!m || !m->hdr) return 0;
+    return (uint32_t)atomic_load_explicit(&m->hdr->count, memory_order_relaxed);
+}
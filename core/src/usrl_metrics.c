@@ -0,0 +1,443 @@
+/**
+ * @file usrl_metrics.c
+ * @brief Lock-free metrics registry (heap or shared memory).
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+#include "usrl_metrics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CELL_FREE     0u
+#define CELL_READY    2u
+#define CELL_CLAIMING USRL_METRIC_CLAIMING /* | registrant pid */
+#define CLAIM_SPINS   4096                 /* spins between owner liveness checks */
+
+#define DEFAULT_CAPACITY 1024
+#define FLUSH_TICK_MS    10
+
+static uint32_t next_power_of_two_u32(uint32_t v)
+{
+    if (v == 0) return 1;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return ++v;
+}
+
+static inline uint64_t usrl_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* FNV-1a, same as the symbol table */
+static inline uint32_t name_hash(const char *s, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static inline uint64_t cells_offset(void)
+{
+    return usrl_align_up(sizeof(UsrlMetricsHeader), USRL_ALIGNMENT);
+}
+
+/* ============================================================================
+ * LAYOUT
+ * ============================================================================ */
+
+uint64_t usrl_metrics_required_size(uint32_t capacity)
+{
+    return cells_offset() + (uint64_t)next_power_of_two_u32(capacity) * sizeof(UsrlMetricCell);
+}
+
+int usrl_metrics_format(void *mem, uint64_t size, uint32_t capacity)
+{
+    if (!mem || capacity == 0) return -1;
+    if (size < usrl_metrics_required_size(capacity)) return -1;
+
+    memset(mem, 0, size);
+
+    UsrlMetricsHeader *hdr = (UsrlMetricsHeader *)mem;
+    hdr->version = 1;
+    hdr->size = size;
+    hdr->capacity = next_power_of_two_u32(capacity);
+    atomic_store_explicit(&hdr->count, 0, memory_order_relaxed);
+
+    atomic_thread_fence(memory_order_release);
+    hdr->magic = USRL_METRICS_MAGIC;
+    return 0;
+}
+
+int usrl_metrics_attach(UsrlMetrics *m, void *mem)
+{
+    if (!m || !mem) return -1;
+
+    UsrlMetricsHeader *hdr = (UsrlMetricsHeader *)mem;
+    if (hdr->magic != USRL_METRICS_MAGIC) return -1;
+
+    memset(m, 0, sizeof(*m));
+    m->hdr = hdr;
+    m->cells = (UsrlMetricCell *)((uint8_t *)mem + cells_offset());
+    m->mask = hdr->capacity - 1;
+    return 0;
+}
+
+int usrl_metrics_init(UsrlMetrics *m, uint32_t capacity)
+{
+    if (!m || capacity == 0) return -1;
+
+    uint64_t size = usrl_metrics_required_size(capacity);
+    void *mem = NULL;
+    if (posix_memalign(&mem, USRL_ALIGNMENT, (size_t)size) != 0) return -1;
+
+    if (usrl_metrics_format(mem, size, capacity) != 0 || usrl_metrics_attach(m, mem) != 0) {
+        free(mem);
+        return -1;
+    }
+    m->owned = 1;
+    return 0;
+}
+
+void usrl_metrics_free(UsrlMetrics *m)
+{
+    if (!m || !m->hdr) return;
+    usrl_metrics_flusher_stop(m);
+    if (m->owned) free(m->hdr);
+    memset(m, 0, sizeof(*m));
+}
+
+/* ============================================================================
+ * STANDALONE SHM OBJECT
+ * ============================================================================ */
+
+/**
+ * usrl_metrics_create return codes (same as usrl_core_init)
+ *  0  : created and formatted
+ *  1  : already exists (not formatted by this call)
+ * -1  : invalid params or shm_open failed (not EEXIST)
+ * -2  : ftruncate failed
+ * -3  : mmap failed
+ */
+int usrl_metrics_create(const char *path, uint32_t capacity)
+{
+    if (!path || capacity == 0) return -1;
+
+    uint64_t size = usrl_metrics_required_size(capacity);
+
+    int fd = shm_open(path, O_CREAT | O_RDWR | O_EXCL, 0666);
+    if (fd < 0) return (errno == EEXIST) ? 1 : -1;
+
+    if (ftruncate(fd, (off_t)size) < 0) {
+        close(fd);
+        return -2;
+    }
+
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return -3;
+    }
+
+    usrl_metrics_format(base, size, capacity);
+
+    munmap(base, size);
+    close(fd);
+    return 0;
+}
+
+int usrl_metrics_open(UsrlMetrics *m, const char *path)
+{
+    if (!m || !path) return -1;
+
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) return -1;
+    struct stat st;
+    int rc = fstat(fd, &st);
+    close(fd);
+    if (rc != 0 || st.st_size <= 0) return -1;
+
+    void *base = usrl_core_map(path, (uint64_t)st.st_size);
+    if (!base) return -1;
+
+    if (usrl_metrics_attach(m, base) != 0) {
+        munmap(base, (size_t)st.st_size);
+        return -1;
+    }
+
+    m->map_size = (size_t)st.st_size;
+    return 0;
+}
+
+void usrl_metrics_close(UsrlMetrics *m)
+{
+    if (!m || !m->hdr) return;
+    usrl_metrics_flusher_stop(m);
+    if (m->map_size) munmap(m->hdr, m->map_size);
+    memset(m, 0, sizeof(*m));
+}
+
+/* ============================================================================
+ * REGISTRATION
+ * ============================================================================ */
+
+static inline uint32_t claim_mark(void)
+{
+    return CELL_CLAIMING | ((uint32_t)getpid() & ~CELL_CLAIMING);
+}
+
+/* Wait for a registrant to finish naming a cell. One that died mid-claim
+ * never will: the cell goes back to FREE for the next registrant. */
+static uint_fast32_t claim_settled(UsrlMetricCell *c, uint_fast32_t st)
+{
+    uint32_t spins = 0;
+    while (st & CELL_CLAIMING) {
+        CPU_RELAX();
+        st = atomic_load_explicit(&c->state, memory_order_acquire);
+        if (!(st & CELL_CLAIMING) || ++spins < CLAIM_SPINS) continue;
+        spins = 0;
+
+        pid_t owner = (pid_t)(st & ~CELL_CLAIMING);
+        if (kill(owner, 0) == 0 || errno != ESRCH) continue;
+        atomic_compare_exchange_strong_explicit(&c->state, &st, CELL_FREE,
+                                                memory_order_acq_rel, memory_order_acquire);
+        st = atomic_load_explicit(&c->state, memory_order_acquire);
+    }
+    return st;
+}
+
+static UsrlMetricCell *metric_register(UsrlMetrics *m, const char *name, uint32_t kind)
+{
+    if (USRL_UNLIKELY(!m || !m->hdr || !name)) return NULL;
+
+    size_t len = strnlen(name, USRL_METRIC_NAME_MAX);
+    if (len == 0 || len >= USRL_METRIC_NAME_MAX) return NULL;
+
+    uint32_t h = name_hash(name, len);
+
+    for (uint32_t probe = 0; probe <= m->mask; probe++) {
+        UsrlMetricCell *c = &m->cells[(h + probe) & m->mask];
+        uint_fast32_t st = atomic_load_explicit(&c->state, memory_order_acquire);
+
+        while (st != CELL_READY) {
+            if (st == CELL_FREE) {
+                uint_fast32_t expected = CELL_FREE;
+                if (atomic_compare_exchange_strong_explicit(&c->state, &expected, claim_mark(),
+                                                            memory_order_acq_rel,
+                                                            memory_order_acquire)) {
+                    c->kind = kind;
+                    memcpy(c->name, name, len);
+                    c->name[len] = '\0';
+                    atomic_store_explicit(&c->state, CELL_READY, memory_order_release);
+                    atomic_fetch_add_explicit(&m->hdr->count, 1, memory_order_relaxed);
+                    return c;
+                }
+                st = expected;
+            }
+            st = claim_settled(c, st); /* Another registrant is writing the name */
+        }
+
+        if (strncmp(c->name, name, USRL_METRIC_NAME_MAX) == 0)
+            return (c->kind == kind) ? c : NULL;
+    }
+    return NULL;
+}
+
+UsrlMetricCell *usrl_metric_counter(UsrlMetrics *m, const char *name)
+{
+    return metric_register(m, name, USRL_METRIC_COUNTER);
+}
+
+UsrlMetricCell *usrl_metric_gauge(UsrlMetrics *m, const char *name)
+{
+    return metric_register(m, name, USRL_METRIC_GAUGE);
+}
+
+UsrlMetricCell *usrl_metric_hist(UsrlMetrics *m, const char *name)
+{
+    return metric_register(m, name, USRL_METRIC_HIST);
+}
+
+/* ============================================================================
+ * SCRAPE
+ * ============================================================================ */
+
+int64_t usrl_metric_read(const UsrlMetricCell *c)
+{
+    if (!c) return 0;
+    return atomic_load_explicit(&((UsrlMetricCell *)c)->value, memory_order_relaxed);
+}
+
+uint64_t usrl_metric_hist_count(const UsrlMetricCell *c)
+{
+    if (!c) return 0;
+    uint64_t n = 0;
+    for (uint32_t i = 0; i < USRL_METRIC_HIST_BUCKETS; i++)
+        n += atomic_load_explicit(&((UsrlMetricCell *)c)->buckets[i], memory_order_relaxed);
+    return n;
+}
+
+/* Upper bound of the bucket holding quantile q */
+uint64_t usrl_metric_hist_quantile(const UsrlMetricCell *c, double q)
+{
+    if (!c) return 0;
+
+    uint64_t b[USRL_METRIC_HIST_BUCKETS];
+    uint64_t n = 0;
+    for (uint32_t i = 0; i < USRL_METRIC_HIST_BUCKETS; i++) {
+        b[i] = atomic_load_explicit(&((UsrlMetricCell *)c)->buckets[i], memory_order_relaxed);
+        n += b[i];
+    }
+    if (n == 0) return 0;
+
+    uint64_t target = (uint64_t)(q * (double)n);
+    if (target >= n) target = n - 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < USRL_METRIC_HIST_BUCKETS; i++) {
+        seen += b[i];
+        if (seen > target) return 1ULL << (i + 1);
+    }
+    return 1ULL << USRL_METRIC_HIST_BUCKETS;
+}
+
+uint32_t usrl_metrics_count(const UsrlMetrics *m)
+{
+    if (!m || !m->hdr) return 0;
+    return (uint32_t)atomic_load_explicit(&m->hdr->count, memory_order_relaxed);
+}
+
+int usrl_metrics_dump(const UsrlMetrics *m, FILE *out)
+{
+    if (!m || !m->hdr || !out) return -1;
+
+    uint64_t now = usrl_now_ns();
+    uint64_t sec = now / 1000000000ULL;
+    uint64_t ms  = (now % 1000000000ULL) / 1000000ULL;
+    int lines = 0;
+
+    for (uint32_t i = 0; i <= m->mask; i++) {
+        const UsrlMetricCell *c = &m->cells[i];
+        if (atomic_load_explicit(&((UsrlMetricCell *)c)->state, memory_order_acquire) != CELL_READY)
+            continue;
+
+        if (c->kind == USRL_METRIC_HIST) {
+            uint64_t n = usrl_metric_hist_count(c);
+            fprintf(out,
+                    "[%" PRIu64 ".%03" PRIu64 "] [METRIC] %s count=%" PRIu64 " sum=%" PRId64
+                    " p50<=%" PRIu64 " p99<=%" PRIu64 "\n",
+                    sec, ms, c->name, n, (int64_t)usrl_metric_read(c),
+                    usrl_metric_hist_quantile(c, 0.50), usrl_metric_hist_quantile(c, 0.99));
+        } else {
+            fprintf(out, "[%" PRIu64 ".%03" PRIu64 "] [METRIC] %s=%" PRId64 "\n",
+                    sec, ms, c->name, (int64_t)usrl_metric_read(c));
+        }
+        lines++;
+    }
+    return lines;
+}
+
+/* ============================================================================
+ * FLUSHER
+ * ============================================================================ */
+
+static void dump_stderr(const UsrlMetrics *m, void *arg)
+{
+    (void)arg;
+    usrl_metrics_dump(m, stderr);
+}
+
+static void *flusher_main(void *arg)
+{
+    UsrlMetrics *m = (UsrlMetrics *)arg;
+    uint32_t waited = 0;
+
+    while (atomic_load_explicit(&m->flusher_run, memory_order_acquire)) {
+        struct timespec ts = {0, FLUSH_TICK_MS * 1000000L};
+        nanosleep(&ts, NULL);
+        waited += FLUSH_TICK_MS;
+        if (waited < m->flush_interval_ms) continue;
+        waited = 0;
+        m->sink(m, m->sink_arg);
+    }
+    m->sink(m, m->sink_arg); /* Final scrape on stop */
+    return NULL;
+}
+
+int usrl_metrics_flusher_start(UsrlMetrics *m, uint32_t interval_ms,
+                               void (*sink)(const UsrlMetrics *m, void *arg), void *arg)
+{
+    if (!m || !m->hdr || atomic_load(&m->flusher_run)) return -1;
+
+    m->flush_interval_ms = interval_ms ? interval_ms : 1000;
+    m->sink = sink ? sink : dump_stderr;
+    m->sink_arg = arg;
+    atomic_store(&m->flusher_run, 1);
+
+    if (pthread_create(&m->flusher, NULL, flusher_main, m) != 0) {
+        atomic_store(&m->flusher_run, 0);
+        return -1;
+    }
+    return 0;
+}
+
+void usrl_metrics_flusher_stop(UsrlMetrics *m)
+{
+    if (!m || !atomic_load(&m->flusher_run)) return;
+    atomic_store(&m->flusher_run, 0);
+    pthread_join(m->flusher, NULL);
+}
+
+/* ============================================================================
+ * DEFAULT REGISTRY
+ * ============================================================================ */
+
+static UsrlMetrics default_local;
+static _Atomic(UsrlMetrics *) default_reg = NULL;
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+
+static void default_init(void)
+{
+    if (usrl_metrics_init(&default_local, DEFAULT_CAPACITY) == 0) {
+        UsrlMetrics *expected = NULL;
+        atomic_compare_exchange_strong(&default_reg, &expected, &default_local);
+    }
+}
+
+UsrlMetrics *usrl_metrics_default(void)
+{
+    UsrlMetrics *m = atomic_load_explicit(&default_reg, memory_order_acquire);
+    if (USRL_LIKELY(m != NULL)) return m;
+    pthread_once(&default_once, default_init);
+    return atomic_load_explicit(&default_reg, memory_order_acquire);
+}
+
+void usrl_metrics_set_default(UsrlMetrics *m)
+{
+    atomic_store_explicit(&default_reg, m, memory_order_release);
+}
@@ -0,0 +1,333 @@
+/**
+ * @file usrl_replay.c
+ * @brief Historical-then-live subscription over a topic journal and its ring.
+ */
+
+#include "usrl_replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SRC_NONE    -1
+#define SRC_RING     0
+#define SRC_JOURNAL  1
+
+static inline uint64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * HISTORY
+ * ============================================================================ */
+
+static void hist_close(UsrlReplaySubscriber *s)
+{
+    s->last_rec = NULL;
+    if (!s->seg_open) return;
+    usrl_jseg_close(&s->seg);
+    s->seg_open = 0;
+}
+
+/* Open the segment holding the first record past last_seq (and at or after
+ * from_ns). Returns 1 if positioned on one, 0 if the journal has nothing
+ * newer, -1 on error. */
+static int hist_seek(UsrlReplaySubscriber *s)
+{
+    hist_close(s);
+
+    int n = usrl_journal_list(s->dir, s->topic, NULL, 0);
+    if (n <= 0) return n;
+    UsrlJournalSegInfo *segs = malloc((size_t)n * sizeof(*segs));
+    if (!segs) return -1;
+    n = usrl_journal_list(s->dir, s->topic, segs, (uint32_t)n);
+
+    /* Start at the last segment beginning at or before the wanted seq */
+    uint64_t want = s->sub.last_seq + 1;
+    int i = 0;
+    for (int k = 0; k < n; k++)
+        if (segs[k].first_seq <= want) i = k;
+
+    for (; i < n && !s->seg_open; i++) {
+        if (usrl_jseg_open(&s->seg, segs[i].path) != 0) continue; /* compacted away */
+
+        const UsrlJournalSegHeader *h = s->seg.hdr;
+        if ((h->flags & USRL_JSEG_F_SEALED) && (h->last_seq < want || h->last_ns < s->from_ns)) {
+            usrl_jseg_close(&s->seg);
+            continue;
+        }
+        uint64_t off = usrl_jseg_seek_seq(&s->seg, want);
+        if (s->from_ns) {
+            uint64_t t = usrl_jseg_seek_time(&s->seg, s->from_ns);
+            if (t > off) off = t;
+        }
+        if (usrl_jseg_record(&s->seg, off)) {
+            s->off = off;
+            s->seg_open = 1;
+        } else {
+            usrl_jseg_close(&s->seg);
+        }
+    }
+    free(segs);
+    return s->seg_open;
+}
+
+/* Move last_seq to a journal seq, counting the seqs the journal skipped.
+ * Before the first record of an open-ended replay nothing is missing yet. */
+static inline void hist_resolve(UsrlReplaySubscriber *s, uint64_t seq)
+{
+    if (s->sub.last_seq && seq > s->sub.last_seq + 1) s->gap_count += seq - s->sub.last_seq - 1;
+    s->sub.last_seq = seq;
+}
+
+/* Next deliverable journal record, or NULL once the journal is exhausted.
+ * Caught up, the segment list is re-read at most every USRL_REPLAY_RESCAN_NS. */
+static const UsrlJournalRecord *hist_peek(UsrlReplaySubscriber *s)
+{
+    for (;;) {
+        if (s->seg_open) {
+            const UsrlJournalRecord *r;
+            while ((r = usrl_jseg_record(&s->seg, s->off)) != NULL) {
+                if (r->seq > s->sub.last_seq) {
+                    if (!(r->flags & USRL_SLOT_F_PROBE) && r->timestamp_ns >= s->from_ns) return r;
+                    hist_resolve(s, r->seq); /* resolved, not delivered */
+                }
+                s->off = usrl_jseg_next(r, s->off);
+            }
+        }
+        /* End of this segment: a newer one, or more of the active one */
+        if (s->rescan_at_ns) {
+            uint64_t now = mono_ns();
+            if (now < s->rescan_at_ns) return NULL;
+        }
+        if (hist_seek(s) <= 0) {
+            s->rescan_at_ns = mono_ns() + USRL_REPLAY_RESCAN_NS;
+            return NULL;
+        }
+        s->rescan_at_ns = 0;
+    }
+}
+
+static inline void hist_consume(UsrlReplaySubscriber *s, const UsrlJournalRecord *r)
+{
+    hist_resolve(s, r->seq);
+    s->off = usrl_jseg_next(r, s->off);
+    s->from_ns = 0;
+    s->replayed++;
+}
+
+/* ============================================================================
+ * SOURCE SELECTION
+ * ============================================================================ */
+
+/* The ring still holds seq last_seq + 1 */
+static inline int ring_retains(const UsrlReplaySubscriber *s)
+{
+    uint64_t head = atomic_load_explicit(&s->sub.desc->w_head, memory_order_acquire);
+    return head <= s->sub.last_seq + s->sub.desc->slot_count;
+}
+
+/* Leave the ring for the journal; the journal is listed again right away */
+static inline void live_fallback(UsrlReplaySubscriber *s)
+{
+    s->live = 0;
+    s->fallbacks++;
+    s->rescan_at_ns = 0;
+}
+
+/* The ring holds seq last_seq + 1 now (not just once it is published) */
+static inline int ring_holds_next(const UsrlReplaySubscriber *s)
+{
+    uint64_t head = atomic_load_explicit(&s->sub.desc->w_head, memory_order_acquire);
+    return head > s->sub.last_seq && ring_retains(s);
+}
+
+static int replay_source(UsrlReplaySubscriber *s, const UsrlJournalRecord **rec)
+{
+    if (s->live) {
+        if (USRL_LIKELY(ring_retains(s))) return SRC_RING;
+        live_fallback(s); /* lapped: fetch the missed seqs from the journal */
+    }
+
+    /* A journal gap the ring still covers is read from the ring instead */
+    const UsrlJournalRecord *r = hist_peek(s);
+    if (r && !(s->sub.last_seq && r->seq > s->sub.last_seq + 1 && ring_holds_next(s))) {
+        s->stall_since_ns = 0;
+        *rec = r;
+        return SRC_JOURNAL;
+    }
+
+    /* Journal exhausted: hand over once the ring holds the next seq */
+    if (ring_retains(s)) {
+        hist_close(s);
+        s->live = 1;
+        s->handovers++;
+        s->stall_since_ns = 0;
+        return SRC_RING;
+    }
+
+    /* The ring has moved on: give the recorder time to catch up first */
+    uint64_t now = mono_ns();
+    if (s->stall_since_ns == 0) {
+        s->stall_since_ns = now;
+        return SRC_NONE;
+    }
+    if (now - s->stall_since_ns < s->stall_timeout_ns) return SRC_NONE;
+
+    uint64_t head = atomic_load_explicit(&s->sub.desc->w_head, memory_order_acquire);
+    uint64_t oldest = head - s->sub.desc->slot_count + 1;
+    s->gap_count += oldest - 1 - s->sub.last_seq;
+    s->sub.last_seq = oldest - 1;
+    hist_close(s);
+    s->live = 1;
+    s->handovers++;
+    s->stall_since_ns = 0;
+    return SRC_RING;
+}
+
+/* Ring read; a lap inside usrl_sub_view_batch() is undone and sends the
+ * reader back to the journal instead of skipping. */
+static int live_batch(UsrlReplaySubscriber *s, UsrlSlotView *views, uint32_t max_views)
+{
+    uint64_t last = s->sub.last_seq, skipped = s->sub.skipped_count;
+    int n = usrl_sub_view_batch(&s->sub, views, max_views);
+    if (USRL_UNLIKELY(s->sub.skipped_count != skipped)) {
+        s->sub.skipped_count = skipped;
+        s->sub.last_seq = last;
+        live_fallback(s);
+        return 0;
+    }
+    return n;
+}
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+int usrl_replay_init(UsrlReplaySubscriber *s, void *core_base, const char *topic,
+                     const char *journal_dir, uint64_t from_seq, uint64_t from_ns)
+{
+    if (!s || !core_base || !topic || !journal_dir) return -1;
+    memset(s, 0, sizeof(*s));
+
+    usrl_sub_init(&s->sub, core_base, topic);
+    if (!s->sub.desc) return -1;
+    snprintf(s->dir, sizeof(s->dir), "%s", journal_dir);
+    snprintf(s->topic, sizeof(s->topic), "%s", topic);
+
+    s->sub.last_seq = from_seq ? from_seq - 1 : 0;
+    s->from_ns = from_ns;
+    s->stall_timeout_ns = USRL_REPLAY_STALL_NS;
+    return 0;
+}
+
+void usrl_replay_close(UsrlReplaySubscriber *s)
+{
+    if (!s) return;
+    hist_close(s);
+}
+
+void usrl_replay_rewind(UsrlReplaySubscriber *s, uint64_t seq)
+{
+    if (!s || seq == 0 || seq > s->sub.last_seq + 1) return;
+    s->sub.last_seq = seq - 1;
+    hist_close(s);
+    live_fallback(s);
+}
+
+int usrl_replay_next(UsrlReplaySubscriber *s, uint8_t *out_buf, uint32_t buf_len,
+                     uint16_t *out_pub_id, uint64_t *out_seq)
+{
+    if (USRL_UNLIKELY(!s || !s->sub.desc || !out_buf)) return USRL_RING_ERROR;
+
+    for (;;) {
+        const UsrlJournalRecord *r = NULL;
+        int src = replay_source(s, &r);
+        if (src == SRC_NONE) return USRL_RING_NO_DATA;
+
+        if (src == SRC_JOURNAL) {
+            hist_consume(s, r);
+            s->last_rec = r;
+            if (USRL_UNLIKELY(r->len > buf_len)) return USRL_RING_TRUNC;
+            memcpy(out_buf, usrl_jseg_payload(r), r->len);
+            if (out_pub_id) *out_pub_id = r->pub_id;
+            if (out_seq) *out_seq = r->seq;
+            return (int)r->len;
+        }
+
+        UsrlSlotView v;
+        int n = live_batch(s, &v, 1);
+        if (n < 0) return n;
+        if (n == 0) {
+            if (s->live) return USRL_RING_NO_DATA;
+            continue; /* fell back to the journal */
+        }
+        if (USRL_UNLIKELY(v.timestamp_ns < s->from_ns)) continue;
+        if (USRL_UNLIKELY(v.len > buf_len)) return USRL_RING_TRUNC;
+
+        memcpy(out_buf, v.data, v.len);
+        if (USRL_UNLIKELY(!usrl_view_valid(&v))) {
+            usrl_replay_rewind(s, v.seq);
+            continue;
+        }
+        s->from_ns = 0;
+        s->last_rec = NULL;
+        if (out_pub_id) *out_pub_id = v.pub_id;
+        if (out_seq) *out_seq = v.seq;
+        return (int)v.len;
+    }
+}
+
+int usrl_replay_last_trace(const UsrlReplaySubscriber *s, UsrlTraceContext *out)
+{
+    if (!s || !out) return -1;
+    if (s->last_rec) return usrl_jrec_trace(s->last_rec, out);
+    return usrl_sub_last_trace(&s->sub, out);
+}
+
+int usrl_replay_batch(UsrlReplaySubscriber *s, UsrlSlotView *views, uint32_t max_views)
+{
+    if (USRL_UNLIKELY(!s || !s->sub.desc || !views)) return USRL_RING_ERROR;
+    if (max_views == 0) return 0;
+
+    const UsrlJournalRecord *r = NULL;
+    int src = replay_source(s, &r);
+    if (src == SRC_NONE) return 0;
+
+    if (src == SRC_RING) {
+        int n = live_batch(s, views, max_views);
+        if (n <= 0 || !s->from_ns) return n;
+
+        /* Still looking for from_ns: drop older views */
+        int k = 0;
+        for (int i = 0; i < n; i++)
+            if (views[i].timestamp_ns >= s->from_ns) views[k++] = views[i];
+        if (k) s->from_ns = 0;
+        return k;
+    }
+
+    /* Journal: consecutive records of the current segment, in place */
+    uint32_t n = 0;
+    while (r && n < max_views) {
+        UsrlSlotView *v = &views[n++];
+        v->data = usrl_jseg_payload(r);
+        v->len = r->len;
+        v->pub_id = r->pub_id;
+        v->seq = r->seq;
+        v->timestamp_ns = r->timestamp_ns;
+        v->hdr = NULL;
+        v->desc = NULL;
+        hist_consume(s, r);
+
+        /* Stay in this mapping: the next call may move to another segment.
+         * Probes, duplicates and gaps end the batch and go through
+         * replay_source(), which resolves them. */
+        r = usrl_jseg_record(&s->seg, s->off);
+        if (r) USRL_PREFETCH_R(r);
+        if (r && (r->seq != s->sub.last_seq + 1 || (r->flags & USRL_SLOT_F_PROBE))) r = NULL;
+    }
+    return (int)n;
+}
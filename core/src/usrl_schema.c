@@ -56,6 +56,18 @@ int usrl_schema_add_field(UsrlSchema *schema, const char *field_name,
     return 0;
 }
 
+const UsrlField *usrl_schema_field(const UsrlSchema *schema, const char *field_name)
+{
+    if (!schema || !field_name)
+        return NULL;
+
+    for (uint32_t i = 0; i < schema->field_count; i++) {
+        if (strcmp(schema->fields[i].name, field_name) == 0)
+            return &schema->fields[i];
+    }
+    return NULL;
+}
+
 int usrl_schema_finalize(UsrlSchema *schema)
 {
     if (!schema || schema->field_count == 0)
@@ -0,0 +1,155 @@
+/**
+ * @file usrl_stage.c
+ * @brief Dependent pipeline stages over a single ring.
+ */
+
+#include "usrl_stage.h"
+#include <string.h>
+
+int usrl_stage_init(UsrlStage *s, void *core_base, const char *topic, uint32_t stage)
+{
+    if (!s || !core_base || !topic || stage >= USRL_MAX_STAGES) return -1;
+    memset(s, 0, sizeof(*s));
+
+    TopicEntry *t = usrl_get_topic(core_base, topic);
+    if (!t) return -1;
+    TopicExt *x = usrl_topic_ext(core_base, t);
+    if (!x) return -1; /* v1 region: no stage cursors */
+
+    s->desc = (RingDesc *)((uint8_t *)core_base + t->ring_desc_offset);
+    s->ext = x;
+    s->base_ptr = (uint8_t *)core_base + s->desc->base_offset;
+    s->mask = s->desc->slot_count - 1;
+    s->stage = stage;
+    s->upstream = (stage == 0) ? &s->desc->w_head : &x->stages[stage - 1].seq;
+
+    /* First registration starts at the upstream position; a restarted stage
+     * resumes from its own cursor. */
+    uint_fast32_t n = atomic_load_explicit(&x->stage_count, memory_order_acquire);
+    if (stage >= n) {
+        uint64_t start = atomic_load_explicit(s->upstream, memory_order_acquire);
+        atomic_store_explicit(&x->stages[stage].seq, start, memory_order_release);
+        while (n < stage + 1 &&
+               !atomic_compare_exchange_weak_explicit(&x->stage_count, &n, stage + 1,
+                                                      memory_order_acq_rel,
+                                                      memory_order_acquire)) {}
+    }
+
+    uint64_t cur = atomic_load_explicit(&x->stages[stage].seq, memory_order_acquire);
+    s->next = cur + 1;
+    s->avail = cur;
+    return 0;
+}
+
+int usrl_stage_claim(UsrlStage *s, UsrlStageSlot *slots, uint32_t max_slots)
+{
+    if (USRL_UNLIKELY(!s || !s->desc || !slots)) return USRL_RING_ERROR;
+
+    uint64_t next = s->next;
+    if (next > s->avail) {
+        s->avail = atomic_load_explicit(s->upstream, memory_order_acquire);
+        if (next > s->avail) return 0;
+    }
+
+    uint64_t end = s->avail;
+    if (end - next >= max_slots) end = next + max_slots - 1;
+
+    RingDesc *d = s->desc;
+    uint32_t cap = d->slot_size - (uint32_t)sizeof(SlotHeader);
+    uint32_t n = 0;
+
+    for (uint64_t seq = next; seq <= end; seq++) {
+        uint32_t idx = (uint32_t)((seq - 1) & s->mask);
+        SlotHeader *hdr = (SlotHeader *)(s->base_ptr + ((uint64_t)idx * d->slot_size));
+
+        /* w_head runs ahead of commits; later stages only see committed seqs */
+        if (s->stage == 0 && atomic_load_explicit(&hdr->seq, memory_order_acquire) != seq) break;
+
+        UsrlStageSlot *sl = &slots[n++];
+        sl->data = (uint8_t *)hdr + sizeof(SlotHeader);
+        sl->len = hdr->payload_len;
+        sl->cap = cap;
+        sl->pub_id = hdr->pub_id;
+        sl->seq = seq;
+        sl->timestamp_ns = hdr->timestamp_ns;
+        sl->hdr = hdr;
+    }
+
+    s->next = next + n;
+    s->claimed += n;
+    return (int)n;
+}
+
+int usrl_stage_resize(UsrlStageSlot *slot, uint32_t len)
+{
+    if (!slot || !slot->hdr) return USRL_RING_ERROR;
+    if (len > slot->cap) return USRL_RING_FULL;
+    slot->hdr->payload_len = len;
+    slot->len = len;
+    return USRL_RING_OK;
+}
+
+void usrl_stage_commit(UsrlStage *s)
+{
+    if (!s || !s->ext || s->claimed == 0) return;
+    atomic_store_explicit(&s->ext->stages[s->stage].seq, s->next - 1, memory_order_release);
+    s->claimed = 0;
+}
+
+uint64_t usrl_stage_cursor(const UsrlStage *s)
+{
+    if (!s || !s->ext) return 0;
+    return atomic_load_explicit(&s->ext->stages[s->stage].seq, memory_order_acquire);
+}
+
+/* ============================================================================
+ * RECOVERY
+ * ============================================================================ */
+
+static TopicExt *stage_ext(void *core_base, const char *topic, RingDesc **desc)
+{
+    if (!core_base || !topic) return NULL;
+    TopicEntry *t = usrl_get_topic(core_base, topic);
+    if (!t) return NULL;
+    *desc = (RingDesc *)((uint8_t *)core_base + t->ring_desc_offset);
+    return usrl_topic_ext(core_base, t);
+}
+
+int usrl_stage_count(void *core_base, const char *topic)
+{
+    RingDesc *d;
+    TopicExt *x = stage_ext(core_base, topic, &d);
+    if (!x) return -1;
+    return (int)atomic_load_explicit(&x->stage_count, memory_order_acquire);
+}
+
+int64_t usrl_stage_skip(void *core_base, const char *topic, uint32_t stage)
+{
+    RingDesc *d;
+    TopicExt *x = stage_ext(core_base, topic, &d);
+    if (!x || stage >= atomic_load_explicit(&x->stage_count, memory_order_acquire)) return -1;
+
+    atomic_uint_fast64_t *up = (stage == 0) ? &d->w_head : &x->stages[stage - 1].seq;
+    uint64_t target = atomic_load_explicit(up, memory_order_acquire);
+    uint64_t cur = atomic_load_explicit(&x->stages[stage].seq, memory_order_acquire);
+
+    /* Never move backwards if the stage is alive after all */
+    while (cur < target &&
+           !atomic_compare_exchange_weak_explicit(&x->stages[stage].seq, &cur, target,
+                                                  memory_order_acq_rel, memory_order_acquire)) {}
+    return (cur < target) ? (int64_t)(target - cur) : 0;
+}
+
+int usrl_stage_detach(void *core_base, const char *topic, uint32_t stage)
+{
+    RingDesc *d;
+    TopicExt *x = stage_ext(core_base, topic, &d);
+    if (!x) return -1;
+
+    /* Later stages read stages[k]: only the tail of the chain can go */
+    uint_fast32_t n = stage + 1;
+    if (!atomic_compare_exchange_strong_explicit(&x->stage_count, &n, stage,
+                                                 memory_order_acq_rel, memory_order_acquire))
+        return -1;
+    return 0;
+}
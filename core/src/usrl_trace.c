@@ -0,0 +1,226 @@
+/**
+ * @file usrl_trace.c
+ * @brief Sampled trace context, hop stamps and per-path latency collector.
+ */
+
+#include "usrl_trace.h"
+#include <string.h>
+
+/* ============================================================================
+ * CONTEXT
+ * ============================================================================ */
+
+void usrl_trace_begin(UsrlTraceContext *ctx, uint16_t origin_id, uint64_t counter)
+{
+    if (!ctx) return;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->trace_id = ((uint64_t)origin_id << 48) | (counter & 0xFFFFFFFFFFFFULL);
+    ctx->origin_ns = usrl_trace_clock_ns();
+    ctx->flags = USRL_SLOT_F_TRACED;
+}
+
+void usrl_trace_hop(UsrlTraceContext *ctx, uint16_t hop_id)
+{
+    if (!ctx || !(ctx->flags & USRL_SLOT_F_TRACED)) return;
+
+    uint64_t now = usrl_trace_clock_ns();
+    uint64_t delta = (now > ctx->origin_ns) ? now - ctx->origin_ns : 0;
+    if (delta > UINT32_MAX) delta = UINT32_MAX;
+
+    if (ctx->hop_count < USRL_TRACE_MAX_HOPS) {
+        ctx->hop_id[ctx->hop_count] = hop_id;
+        ctx->hop_ns[ctx->hop_count] = (uint32_t)delta;
+    }
+    if (ctx->hop_count < UINT8_MAX) ctx->hop_count++;
+}
+
+void usrl_trace_stamp(SlotHeader *hdr, const UsrlTraceContext *ctx)
+{
+    hdr->trace_id = ctx->trace_id;
+    hdr->origin_ns = ctx->origin_ns;
+    hdr->hop_count = ctx->hop_count;
+    memcpy(hdr->hop_id, ctx->hop_id, sizeof(hdr->hop_id));
+    memcpy(hdr->hop_ns, ctx->hop_ns, sizeof(hdr->hop_ns));
+    hdr->flags = ctx->flags & USRL_SLOT_F_TRACED;
+}
+
+/* Copy the slot's trace context, then confirm the slot still holds `seq`. */
+static int trace_read(const SlotHeader *hdr, uint64_t seq, UsrlTraceContext *out)
+{
+    int traced = (hdr->flags & USRL_SLOT_F_TRACED) != 0;
+
+    memset(out, 0, sizeof(*out));
+    if (traced) {
+        out->trace_id = hdr->trace_id;
+        out->origin_ns = hdr->origin_ns;
+        out->flags = USRL_SLOT_F_TRACED;
+        out->hop_count = hdr->hop_count;
+        memcpy(out->hop_id, hdr->hop_id, sizeof(out->hop_id));
+        memcpy(out->hop_ns, hdr->hop_ns, sizeof(out->hop_ns));
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&((SlotHeader *)hdr)->seq, memory_order_relaxed) != seq) {
+        memset(out, 0, sizeof(*out));
+        return -1;
+    }
+    return traced;
+}
+
+int usrl_sub_last_trace(const UsrlSubscriber *s, UsrlTraceContext *out)
+{
+    if (!s || !s->desc || !out || s->last_seq == 0) return -1;
+
+    uint32_t idx = (uint32_t)((s->last_seq - 1) & s->mask);
+    const SlotHeader *hdr = (const SlotHeader *)(s->base_ptr + ((uint64_t)idx * s->desc->slot_size));
+    return trace_read(hdr, s->last_seq, out);
+}
+
+int usrl_jrec_trace(const UsrlJournalRecord *r, UsrlTraceContext *out)
+{
+    if (!r || !out) return -1;
+
+    memset(out, 0, sizeof(*out));
+    const UsrlJournalTrace *t = usrl_jrec_trailer(r);
+    if (!t || !(r->flags & USRL_SLOT_F_TRACED)) return 0;
+
+    out->trace_id = t->trace_id;
+    out->origin_ns = t->origin_ns;
+    out->flags = USRL_SLOT_F_TRACED;
+    out->hop_count = t->hop_count;
+    memcpy(out->hop_id, t->hop_id, sizeof(out->hop_id));
+    memcpy(out->hop_ns, t->hop_ns, sizeof(out->hop_ns));
+    return 1;
+}
+
+int usrl_view_trace(const UsrlSlotView *v, UsrlTraceContext *out)
+{
+    if (!v || !out || !v->data) return -1;
+
+    /* Journal view (usrl_replay_batch()): the record header sits in front of the payload */
+    if (!v->hdr) return usrl_jrec_trace((const UsrlJournalRecord *)(v->data - sizeof(UsrlJournalRecord)), out);
+    return trace_read(v->hdr, v->seq, out);
+}
+
+/* ============================================================================
+ * COLLECTOR
+ * ============================================================================ */
+
+static inline void hist_add(UsrlTraceHist *h, uint64_t ns)
+{
+    uint32_t b = (ns == 0) ? 0 : (uint32_t)(63 - __builtin_clzll(ns));
+    if (b >= USRL_TRACE_HIST_BUCKETS) b = USRL_TRACE_HIST_BUCKETS - 1;
+    h->buckets[b]++;
+    h->count++;
+    h->sum_ns += ns;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+/* Upper bound of the bucket holding quantile q */
+uint64_t usrl_trace_hist_quantile(const UsrlTraceHist *h, double q)
+{
+    if (!h || h->count == 0) return 0;
+
+    uint64_t target = (uint64_t)(q * (double)h->count);
+    if (target >= h->count) target = h->count - 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < USRL_TRACE_HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen > target) {
+            uint64_t hi = (i + 1 < 64) ? (1ULL << (i + 1)) : UINT64_MAX;
+            return (hi < h->max_ns) ? hi : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
+void usrl_trace_collector_init(UsrlTraceCollector *c)
+{
+    if (c) memset(c, 0, sizeof(*c));
+}
+
+static UsrlTracePath *path_find(UsrlTraceCollector *c, uint16_t origin, uint8_t hops,
+                                const uint16_t *hop_id)
+{
+    for (uint32_t i = 0; i < c->path_count; i++) {
+        UsrlTracePath *p = &c->paths[i];
+        if (p->origin == origin && p->hops == hops &&
+            memcmp(p->hop_id, hop_id, hops * sizeof(uint16_t)) == 0)
+            return p;
+    }
+    if (c->path_count == USRL_TRACE_MAX_PATHS) return NULL;
+
+    UsrlTracePath *p = &c->paths[c->path_count++];
+    p->origin = origin;
+    p->hops = hops;
+    memcpy(p->hop_id, hop_id, hops * sizeof(uint16_t));
+    return p;
+}
+
+int usrl_trace_collect(UsrlTraceCollector *c, const UsrlTraceContext *ctx)
+{
+    if (!c || !ctx || !(ctx->flags & USRL_SLOT_F_TRACED)) return -1;
+
+    uint8_t hops = ctx->hop_count;
+    if (hops > USRL_TRACE_MAX_HOPS) {
+        hops = USRL_TRACE_MAX_HOPS;
+        c->truncated++;
+    }
+
+    uint16_t hop_id[USRL_TRACE_MAX_HOPS];
+    memcpy(hop_id, ctx->hop_id, sizeof(hop_id));
+
+    UsrlTracePath *p = path_find(c, usrl_trace_origin(ctx), hops, hop_id);
+    if (!p) {
+        c->overflow++;
+        return -1;
+    }
+
+    uint32_t prev = 0;
+    for (uint8_t i = 0; i < hops; i++) {
+        uint32_t t = ctx->hop_ns[i];
+        hist_add(&p->seg[i], (t > prev) ? t - prev : 0);
+        prev = t;
+    }
+    hist_add(&p->total, prev);
+    c->collected++;
+    return 0;
+}
+
+static void report_hist(FILE *out, const char *label, const UsrlTraceHist *h)
+{
+    fprintf(out, "  %-16s n=%-8lu avg=%-8lu p50<=%-8lu p99<=%-8lu max=%lu ns\n",
+            label,
+            (unsigned long)h->count,
+            (unsigned long)(h->count ? h->sum_ns / h->count : 0),
+            (unsigned long)usrl_trace_hist_quantile(h, 0.50),
+            (unsigned long)usrl_trace_hist_quantile(h, 0.99),
+            (unsigned long)h->max_ns);
+}
+
+void usrl_trace_report(const UsrlTraceCollector *c, FILE *out)
+{
+    if (!c || !out) return;
+
+    fprintf(out, "Traces: %lu collected, %u paths, %lu overflow, %lu truncated\n",
+            (unsigned long)c->collected, c->path_count,
+            (unsigned long)c->overflow, (unsigned long)c->truncated);
+
+    for (uint32_t i = 0; i < c->path_count; i++) {
+        const UsrlTracePath *p = &c->paths[i];
+        char label[32];
+
+        fprintf(out, "\nPath: %u", p->origin);
+        for (uint8_t h = 0; h < p->hops; h++) fprintf(out, " -> %u", p->hop_id[h]);
+        fprintf(out, "\n");
+
+        uint16_t from = p->origin;
+        for (uint8_t h = 0; h < p->hops; h++) {
+            snprintf(label, sizeof(label), "%u -> %u", from, p->hop_id[h]);
+            report_hist(out, label, &p->seg[h]);
+            from = p->hop_id[h];
+        }
+        report_hist(out, "total", &p->total);
+    }
+}
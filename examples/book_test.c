@@ -0,0 +1,227 @@
+/**
+ * @file book_test.c
+ * @brief Order book builder: window anchoring, overflow and top-level deletes.
+ *
+ * VALIDATES:
+ * 1. The window is anchored at the touch: depth behind a new touch stays in
+ *    the window.
+ * 2. Levels deeper than the window become the touch once every level above
+ *    them is deleted.
+ * 3. Levels pushed off by a re-anchor on a better price come back when that
+ *    price is deleted.
+ * 4. Random sets and deletes on both sides match a brute-force book: top of
+ *    book, every level's quantity and the "touch changed" result.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_book.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define WINDOW 16
+#define PRICES 512      /* reference book covers ticks [0, PRICES) */
+#define FUZZ_OPS 200000
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static uint64_t g_ref[2][PRICES];
+
+static uint64_t lcg(uint64_t *s) {
+    *s = *s * 6364136223846793005ull + 1442695040888963407ull;
+    return *s >> 33;
+}
+
+static void ref_top(UsrlTopOfBook *t) {
+    memset(t, 0, sizeof(*t));
+    for (int64_t p = PRICES - 1; p >= 0; p--)
+        if (g_ref[USRL_BOOK_BID][p]) {
+            t->bid_ticks = p;
+            t->bid_qty = g_ref[USRL_BOOK_BID][p];
+            break;
+        }
+    for (int64_t p = 0; p < PRICES; p++)
+        if (g_ref[USRL_BOOK_ASK][p]) {
+            t->ask_ticks = p;
+            t->ask_qty = g_ref[USRL_BOOK_ASK][p];
+            break;
+        }
+}
+
+static int same_top(const UsrlTopOfBook *a, const UsrlTopOfBook *b) {
+    return a->bid_ticks == b->bid_ticks && a->bid_qty == b->bid_qty &&
+           a->ask_ticks == b->ask_ticks && a->ask_qty == b->ask_qty;
+}
+
+static int set(UsrlBookBuilder *b, int side, int64_t price, uint64_t qty) {
+    UsrlBookUpdate u = { .symbol_id = 0, .side = (uint8_t)side, .action = USRL_BOOK_SET,
+                         .price_ticks = price, .qty = qty };
+    g_ref[side][price] = qty;
+    return usrl_book_apply(b, &u);
+}
+
+static void clear(UsrlBookBuilder *b) {
+    UsrlBookUpdate u = { .symbol_id = 0, .action = USRL_BOOK_CLEAR };
+    usrl_book_apply(b, &u);
+    memset(g_ref, 0, sizeof(g_ref));
+}
+
+/* Top of book and every level against the reference; returns 0 on mismatch */
+static int matches(const UsrlBookBuilder *b, const char *what) {
+    UsrlTopOfBook got, want;
+    usrl_book_top(b, 0, &got);
+    ref_top(&want);
+    if (!same_top(&got, &want)) {
+        CHECK(0, "%s: top %ld x %lu / %ld x %lu, expected %ld x %lu / %ld x %lu", what,
+              (long)got.bid_ticks, (unsigned long)got.bid_qty, (long)got.ask_ticks, (unsigned long)got.ask_qty,
+              (long)want.bid_ticks, (unsigned long)want.bid_qty, (long)want.ask_ticks,
+              (unsigned long)want.ask_qty);
+        return 0;
+    }
+    for (int side = 0; side < 2; side++)
+        for (int64_t p = 0; p < PRICES; p++)
+            if (usrl_book_qty_at(b, 0, side, p) != g_ref[side][p]) {
+                CHECK(0, "%s: side %d tick %ld qty %lu, expected %lu", what, side, (long)p,
+                      (unsigned long)usrl_book_qty_at(b, 0, side, p), (unsigned long)g_ref[side][p]);
+                return 0;
+            }
+    return 1;
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL ORDER BOOK CORRECTNESS TEST                      \n");
+    printf("========================================================\n");
+
+    UsrlBookBuilder b;
+    if (usrl_book_init(&b, 1, WINDOW) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create a book\n" COLOR_RESET);
+        return 2;
+    }
+
+    /* =========================================================================
+     * PHASE 1: ANCHORED AT THE TOUCH
+     * ========================================================================= */
+    printf("\n[PHASE 1] Touch plus %d ticks of depth, window %d...\n", WINDOW - 3, WINDOW);
+
+    set(&b, USRL_BOOK_BID, 300, 5);
+    set(&b, USRL_BOOK_ASK, 310, 5);
+    for (int64_t i = 1; i <= WINDOW - 3; i++) {
+        set(&b, USRL_BOOK_BID, 300 - i, 10 + (uint64_t)i);
+        set(&b, USRL_BOOK_ASK, 310 + i, 10 + (uint64_t)i);
+    }
+    matches(&b, "depth");
+    CHECK(b.out_of_window == 0, "%lu depth updates fell outside the window", (unsigned long)b.out_of_window);
+    CHECK(b.books[0].side[USRL_BOOK_BID].levels == WINDOW - 2 && b.books[0].side[USRL_BOOK_ASK].levels == WINDOW - 2,
+          "window holds %u / %u levels", b.books[0].side[USRL_BOOK_BID].levels,
+          b.books[0].side[USRL_BOOK_ASK].levels);
+    CHECK(set(&b, USRL_BOOK_BID, 301, 1) == 1 && set(&b, USRL_BOOK_ASK, 309, 1) == 1 && b.out_of_window == 0,
+          "improving by a tick left the window");
+    matches(&b, "improve");
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Depth behind the touch kept in the window.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: DELETE THE TOP LEVELS
+     * ========================================================================= */
+    printf("\n[PHASE 2] Deep levels become the touch as the top is deleted...\n");
+    int fail_before = g_fail;
+
+    clear(&b);
+    set(&b, USRL_BOOK_BID, 400, 1);
+    set(&b, USRL_BOOK_ASK, 410, 1);
+    for (int64_t p = 100; p < 400; p += 7) set(&b, USRL_BOOK_BID, p, (uint64_t)p);
+    for (int64_t p = 411; p < PRICES; p += 5) set(&b, USRL_BOOK_ASK, p, (uint64_t)p);
+    CHECK(b.out_of_window > 0, "nothing landed beyond the window");
+    matches(&b, "deep");
+
+    int steps = 0;
+    UsrlTopOfBook t;
+    for (usrl_book_top(&b, 0, &t); t.bid_qty; usrl_book_top(&b, 0, &t), steps++) {
+        CHECK(set(&b, USRL_BOOK_BID, t.bid_ticks, 0) == 1, "deleting bid %ld not reported", (long)t.bid_ticks);
+        if (!matches(&b, "bid delete")) break;
+    }
+    for (usrl_book_top(&b, 0, &t); t.ask_qty; usrl_book_top(&b, 0, &t), steps++) {
+        CHECK(set(&b, USRL_BOOK_ASK, t.ask_ticks, 0) == 1, "deleting ask %ld not reported", (long)t.ask_ticks);
+        if (!matches(&b, "ask delete")) break;
+    }
+    CHECK(b.books[0].side[0].deep_count == 0 && b.books[0].side[1].deep_count == 0, "overflow not drained");
+    printf("    %d top-level deletes walked both sides empty\n", steps);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Every deep level surfaced in order.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: RE-ANCHOR ON A BETTER PRICE
+     * ========================================================================= */
+    printf("\n[PHASE 3] A far better price, then deleted again...\n");
+    fail_before = g_fail;
+
+    clear(&b);
+    for (int64_t p = 200; p > 190; p--) set(&b, USRL_BOOK_BID, p, 1000 + (uint64_t)p);
+    for (int64_t p = 260; p < 270; p++) set(&b, USRL_BOOK_ASK, p, 1000 + (uint64_t)p);
+    CHECK(set(&b, USRL_BOOK_BID, 250, 9) == 1, "bid jump not reported");
+    CHECK(set(&b, USRL_BOOK_ASK, 251, 9) == 1, "ask jump not reported");
+    matches(&b, "jump");
+    CHECK(set(&b, USRL_BOOK_BID, 250, 0) == 1 && set(&b, USRL_BOOK_ASK, 251, 0) == 1, "delete not reported");
+    matches(&b, "fall back");
+    usrl_book_top(&b, 0, &t);
+    CHECK(t.bid_ticks == 200 && t.bid_qty == 1200 && t.ask_ticks == 260 && t.ask_qty == 1260,
+          "touch %ld / %ld after the jump was deleted", (long)t.bid_ticks, (long)t.ask_ticks);
+    CHECK(b.dropped_levels == 0, "%lu levels lost", (unsigned long)b.dropped_levels);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Pushed-off levels came back.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 4: RANDOM UPDATES AGAINST A REFERENCE BOOK
+     * ========================================================================= */
+    printf("\n[PHASE 4] %d random updates against a brute-force book...\n", FUZZ_OPS);
+    fail_before = g_fail;
+
+    clear(&b);
+    uint64_t rng = 42;
+    int reported = 0;
+    for (int op = 0; op < FUZZ_OPS; op++) {
+        int side = (int)(lcg(&rng) & 1);
+        /* Bids below 256, asks above, clustered near the spread with a long tail */
+        int64_t off = (int64_t)(lcg(&rng) % 4 ? lcg(&rng) % 24 : lcg(&rng) % 200);
+        int64_t price = side == USRL_BOOK_BID ? 255 - off : 256 + off;
+        uint64_t qty = lcg(&rng) % 3 ? 0 : 1 + lcg(&rng) % 100; /* mostly deletes: the book keeps thinning */
+
+        UsrlTopOfBook before, after;
+        ref_top(&before);
+        int changed = set(&b, side, price, qty);
+        ref_top(&after);
+        if (!same_top(&before, &after)) reported++;
+
+        CHECK(changed == !same_top(&before, &after), "op %d: apply returned %d", op, changed);
+        if (op % 64 == 0 || changed) {
+            if (!matches(&b, "fuzz")) break;
+        }
+        if (g_fail != fail_before) break;
+    }
+    matches(&b, "fuzz end");
+    printf("    %d touch changes, %lu deep updates\n", reported, (unsigned long)b.out_of_window);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Builder matches the reference book.\n" COLOR_RESET);
+
+    usrl_book_free(&b);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
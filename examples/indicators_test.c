@@ -0,0 +1,283 @@
+/**
+ * @file indicators_test.c
+ * @brief Streaming indicators against brute-force references.
+ *
+ * VALIDATES:
+ * 1. EMA, windowed and cumulative VWAP, rolling mean / variance and
+ *    rolling min / max match a recomputation over the raw history after
+ *    every sample, for several interleaved keys given ids in arrival
+ *    order; warm flags flip exactly
+ *    when a key has seen a full period.
+ * 2. Bad specs are refused at init; unknown keys past max_keys and short
+ *    records are rejected without touching state.
+ * 3. Polling a topic publishes one conflated record per touched key per
+ *    batch, carrying the key name, sample count and current values.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_indicators.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_indicators_test"
+#define SHM_SIZE (8u << 20)
+#define KEYS 3
+#define SAMPLES 20000
+#define N_IND 7
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static const UsrlIndSpec g_specs[N_IND] = {
+    { USRL_IND_EMA,  "price", NULL,  10 },
+    { USRL_IND_VWAP, "price", "qty", 20 },
+    { USRL_IND_VWAP, "price", "qty", 0 },
+    { USRL_IND_MEAN, "price", NULL,  50 },
+    { USRL_IND_VAR,  "price", NULL,  50 },
+    { USRL_IND_MIN,  "price", NULL,  30 },
+    { USRL_IND_MAX,  "price", NULL,  30 },
+};
+
+static const char *const g_syms[KEYS] = { "AAPL", "MSFT", "ES.H27" };
+
+/* Raw history per key */
+static double g_price[KEYS][SAMPLES];
+static double g_qty[KEYS][SAMPLES];
+static uint32_t g_n[KEYS];
+static double g_ema[KEYS];
+static int32_t g_id[KEYS] = { -1, -1, -1 };
+static int32_t g_next_id;
+
+static const UsrlField *f_sym, *f_price, *f_qty;
+
+static uint64_t lcg(uint64_t *s) {
+    *s = *s * 6364136223846793005ull + 1442695040888963407ull;
+    return *s >> 33;
+}
+
+static void make_record(uint8_t *rec, const char *sym, double price, uint32_t qty) {
+    memset(rec + f_sym->offset, 0, f_sym->size);
+    memcpy(rec + f_sym->offset, sym, strlen(sym));
+    memcpy(rec + f_price->offset, &price, sizeof(price));
+    memcpy(rec + f_qty->offset, &qty, sizeof(qty));
+}
+
+static double reference(uint32_t k, uint32_t ind) {
+    const UsrlIndSpec *s = &g_specs[ind];
+    uint32_t n = g_n[k];
+    uint32_t from = (s->period && n > s->period) ? n - s->period : 0;
+    double a = 0.0, b = 0.0, best = g_price[k][from];
+
+    switch (s->kind) {
+    case USRL_IND_EMA:
+        return g_ema[k];
+    case USRL_IND_VWAP:
+        for (uint32_t i = from; i < n; i++) {
+            a += g_price[k][i] * g_qty[k][i];
+            b += g_qty[k][i];
+        }
+        return a / b;
+    case USRL_IND_MEAN:
+    case USRL_IND_VAR:
+        for (uint32_t i = from; i < n; i++) a += g_price[k][i];
+        a /= (double)(n - from);
+        if (s->kind == USRL_IND_MEAN) return a;
+        for (uint32_t i = from; i < n; i++) b += (g_price[k][i] - a) * (g_price[k][i] - a);
+        return b / (double)(n - from);
+    case USRL_IND_MIN:
+    case USRL_IND_MAX:
+        for (uint32_t i = from; i < n; i++)
+            if (s->kind == USRL_IND_MIN ? g_price[k][i] < best : g_price[k][i] > best) best = g_price[k][i];
+        return best;
+    default:
+        return NAN;
+    }
+}
+
+static int close_enough(double got, double want) {
+    return fabs(got - want) <= 1e-7 * (fabs(want) > 1.0 ? fabs(want) : 1.0);
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL STREAMING INDICATORS TEST                        \n");
+    printf("========================================================\n");
+
+    UsrlSchema *schema = usrl_schema_create(1, "tick");
+    usrl_schema_add_field(schema, "sym", USRL_FIELD_STRING, 8);
+    usrl_schema_add_field(schema, "price", USRL_FIELD_F64, 8);
+    usrl_schema_add_field(schema, "qty", USRL_FIELD_U32, 4);
+    usrl_schema_finalize(schema);
+    f_sym = usrl_schema_field(schema, "sym");
+    f_price = usrl_schema_field(schema, "price");
+    f_qty = usrl_schema_field(schema, "qty");
+
+    UsrlIndicators x;
+    if (!f_sym || !f_price || !f_qty || usrl_ind_init(&x, schema, "sym", KEYS, g_specs, N_IND) != 0) {
+        printf(COLOR_RED "[FAIL] cannot set up indicators\n" COLOR_RESET);
+        return 2;
+    }
+    uint8_t rec[64];
+
+    /* =========================================================================
+     * PHASE 1: AGAINST THE REFERENCE
+     * ========================================================================= */
+    printf("\n[PHASE 1] %d samples over %d keys, %d indicators each...\n", SAMPLES, KEYS, N_IND);
+
+    uint64_t rng = 7;
+    double mid[KEYS] = { 100.0, 250.0, 5000.0 };
+    for (uint32_t s = 0; s < SAMPLES && !g_fail; s++) {
+        uint32_t k = (uint32_t)(lcg(&rng) % KEYS);
+        if (g_n[k] == SAMPLES) continue;
+        mid[k] += ((double)(lcg(&rng) % 2001) - 1000.0) / 1000.0;
+        double price = mid[k];
+        uint32_t qty = 1 + (uint32_t)(lcg(&rng) % 500);
+
+        make_record(rec, g_syms[k], price, qty);
+        int32_t id = usrl_ind_apply(&x, rec, s);
+        if (g_id[k] < 0) g_id[k] = g_next_id++;
+        CHECK(id == g_id[k], "%s mapped to key %d, expected %d", g_syms[k], id, g_id[k]);
+
+        g_price[k][g_n[k]] = price;
+        g_qty[k][g_n[k]] = qty;
+        g_ema[k] = g_n[k] == 0 ? price : g_ema[k] + 2.0 / 11.0 * (price - g_ema[k]);
+        g_n[k]++;
+
+        for (uint32_t i = 0; i < N_IND; i++) {
+            double got = usrl_ind_value(&x, (uint32_t)id, i), want = reference(k, i);
+            CHECK(close_enough(got, want), "sample %u key %u indicator %u: %.10f, expected %.10f", g_n[k], k, i,
+                  got, want);
+            CHECK(usrl_ind_warm(&x, (uint32_t)id, i) == (g_n[k] >= g_specs[i].period), "sample %u indicator %u warm flag",
+                  g_n[k], i);
+        }
+    }
+    for (uint32_t k = 0; k < KEYS; k++) printf("    %-6s %u samples\n", g_syms[k], g_n[k]);
+    CHECK(x.updates == g_n[0] + g_n[1] + g_n[2], "%lu updates", (unsigned long)x.updates);
+    usrl_ind_flush(&x);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Every indicator matched after every sample.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: REJECTIONS
+     * ========================================================================= */
+    printf("\n[PHASE 2] Bad specs, unknown keys...\n");
+    int fail_before = g_fail;
+
+    UsrlIndicators bad;
+    UsrlIndSpec spec = { USRL_IND_MEAN, "sym", NULL, 5 };
+    CHECK(usrl_ind_init(&bad, schema, "sym", 4, &spec, 1) != 0, "string input accepted");
+    spec = (UsrlIndSpec){ USRL_IND_EMA, "price", NULL, 0 };
+    CHECK(usrl_ind_init(&bad, schema, "sym", 4, &spec, 1) != 0, "EMA period 0 accepted");
+    spec = (UsrlIndSpec){ USRL_IND_VWAP, "price", NULL, 5 };
+    CHECK(usrl_ind_init(&bad, schema, "sym", 4, &spec, 1) != 0, "VWAP without weight accepted");
+    spec = (UsrlIndSpec){ USRL_IND_MIN, "price", NULL, 5 };
+    CHECK(usrl_ind_init(&bad, schema, "nope", 4, &spec, 1) != 0, "unknown key field accepted");
+
+    uint64_t before = x.updates;
+    make_record(rec, "TSLA", 1.0, 1);
+    CHECK(usrl_ind_apply(&x, rec, 0) == -1 && x.rejected == 1 && x.updates == before,
+          "fourth key accepted into a 3-key operator");
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Bad specs and keys rejected.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: TOPIC IN, CONFLATED RECORDS OUT
+     * ========================================================================= */
+    printf("\n[PHASE 3] Poll a topic, one output record per touched key...\n");
+    fail_before = g_fail;
+
+    shm_unlink(SHM_PATH);
+    UsrlTopicConfig cfg[2] = {
+        { .name = "ticks", .slot_count = 1024, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+        { .name = "ind", .slot_count = 1024, .slot_size = 256, .type = USRL_RING_TYPE_SWMR },
+    };
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, cfg, 2) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    void *core = usrl_core_map(SHM_PATH, SHM_SIZE);
+    UsrlIndicators live;
+    if (!core || usrl_ind_init(&live, schema, "sym", KEYS, g_specs, N_IND) != 0 ||
+        usrl_ind_attach(&live, core, "ticks", "ind", 9) != 0) {
+        printf(COLOR_RED "[FAIL] cannot attach\n" COLOR_RESET);
+        return 2;
+    }
+    UsrlPublisher in;
+    UsrlSubscriber out;
+    usrl_pub_init(&in, core, "ticks", 1);
+    usrl_sub_init(&out, core, "ind");
+
+    /* 40 ticks for AAPL, 5 for ES.H27, one short record */
+    for (int i = 0; i < 40; i++) {
+        make_record(rec, "AAPL", 100.0 + i, 10);
+        usrl_pub_publish(&in, rec, schema->total_size);
+    }
+    for (int i = 0; i < 5; i++) {
+        make_record(rec, "ES.H27", 5000.0 - i, 2);
+        usrl_pub_publish(&in, rec, schema->total_size);
+    }
+    usrl_pub_publish(&in, rec, schema->total_size - 1);
+
+    int polled = usrl_ind_poll(&live, 0);
+    CHECK(polled == 46, "poll consumed %d", polled);
+    CHECK(live.rejected == 1 && live.published == 2, "rejected %lu, published %lu", (unsigned long)live.rejected,
+          (unsigned long)live.published);
+
+    uint8_t buf[256];
+    int records = 0;
+    int n;
+    while ((n = usrl_sub_next(&out, buf, sizeof(buf), NULL)) > 0) {
+        const UsrlIndRecord *r = (const UsrlIndRecord *)buf;
+        records++;
+        CHECK(n == (int)usrl_ind_record_size(N_IND) && r->count == N_IND, "record size %d", n);
+        int aapl = strcmp(r->key, "AAPL") == 0;
+        CHECK(aapl || strcmp(r->key, "ES.H27") == 0, "record for key '%.16s'", r->key);
+        CHECK(r->samples == (aapl ? 40u : 5u), "%s: %lu samples", r->key, (unsigned long)r->samples);
+        /* AAPL has 40 samples: warm for EMA(10), VWAP(20), VWAP(0), MIN/MAX(30), not MEAN/VAR(50) */
+        CHECK(r->warm == (aapl ? 0x67 : 0x04), "%s: warm bits %#x", r->key, r->warm);
+        for (uint32_t i = 0; i < N_IND; i++) {
+            double v;
+            memcpy(&v, (const uint8_t *)r->value + i * sizeof(double), sizeof(v));
+            CHECK(v == usrl_ind_value(&live, r->key_id, i), "%s indicator %u: %f in the record", r->key, i, v);
+        }
+        if (aapl) {
+            double mn, mx;
+            memcpy(&mn, (const uint8_t *)r->value + 5 * sizeof(double), sizeof(mn));
+            memcpy(&mx, (const uint8_t *)r->value + 6 * sizeof(double), sizeof(mx));
+            CHECK(mn == 110.0 && mx == 139.0, "AAPL min / max %f / %f over the last 30", mn, mx);
+        }
+    }
+    CHECK(records == 2, "%d records for 2 touched keys", records);
+    CHECK(usrl_ind_poll(&live, 0) == 0 && usrl_sub_next(&out, buf, sizeof(buf), NULL) == USRL_RING_NO_DATA,
+          "idle poll published");
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] One conflated record per key per batch.\n" COLOR_RESET);
+
+    usrl_ind_free(&live);
+    usrl_ind_free(&x);
+    usrl_schema_free(schema);
+    usrl_core_unmap(core, SHM_SIZE);
+    shm_unlink(SHM_PATH);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file intern_test.c
+ * @brief Symbol interning: dense ids, multi-process agreement, dead inserters.
+ *
+ * VALIDATES:
+ * 1. Ids are dense from 0, stable per name, and map back to the name;
+ *    bad lengths, unknown names and a full table return INVALID.
+ * 2. Processes interning the same symbols in different orders all get the
+ *    same id for each name, and no id is handed out twice.
+ * 3. Index slots left mid-insert by a dead process are reclaimed by both
+ *    lookups and inserts instead of blocking them; an id the dead process
+ *    took is skipped, not reused.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_intern_test"
+#define CAPACITY 1024
+#define WORKERS 4
+#define SYMBOLS 600
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static void on_alarm(int sig) {
+    (void)sig;
+    static const char msg[] = "\x1b[31m[FAIL] blocked on a dead inserter's slot\x1b[0m\n";
+    write(1, msg, sizeof(msg) - 1);
+    _exit(1);
+}
+
+static uint32_t sym_name(char *out, size_t cap, uint32_t i) {
+    return (uint32_t)snprintf(out, cap, "SYM%04u.X", i);
+}
+
+static uint32_t intern(UsrlIntern *t, const char *s) {
+    return usrl_intern_id(t, s, (uint32_t)strlen(s));
+}
+
+static uint32_t lookup(const UsrlIntern *t, const char *s) {
+    return usrl_intern_lookup(t, s, (uint32_t)strlen(s));
+}
+
+/* Interns every symbol in a worker-specific order; ids[w][i] = id of symbol i */
+static void worker(int w, uint32_t (*ids)[SYMBOLS]) {
+    UsrlIntern t;
+    if (usrl_intern_open(&t, SHM_PATH) != 0) _exit(100);
+    for (uint32_t k = 0; k < SYMBOLS; k++) {
+        uint32_t i = (w & 1) ? SYMBOLS - 1 - k : (k * 7 + (uint32_t)w * 131) % SYMBOLS;
+        char name[32];
+        uint32_t len = sym_name(name, sizeof(name), i);
+        ids[w][i] = usrl_intern_id(&t, name, len);
+    }
+    usrl_intern_close(&t);
+    _exit(0);
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL SYMBOL INTERNING TEST                            \n");
+    printf("========================================================\n");
+
+    /* =========================================================================
+     * PHASE 1: SEMANTICS
+     * ========================================================================= */
+    printf("\n[PHASE 1] Ids, names and limits on a private table...\n");
+
+    uint64_t small_size = usrl_intern_required_size(4);
+    void *small = aligned_alloc(USRL_ALIGNMENT, small_size);
+    UsrlIntern s;
+    if (!small || usrl_intern_format(small, small_size, 4) != 0 || usrl_intern_attach(&s, small) != 0) {
+        printf(COLOR_RED "[FAIL] cannot format a table\n" COLOR_RESET);
+        return 2;
+    }
+    CHECK(intern(&s, "AAPL") == 0 && intern(&s, "MSFT") == 1 && intern(&s, "AAPL") == 0,
+          "ids not dense / stable");
+    CHECK(lookup(&s, "MSFT") == 1 && lookup(&s, "GOOG") == USRL_INTERN_INVALID, "lookup");
+    CHECK(usrl_intern_name(&s, 1) && strcmp(usrl_intern_name(&s, 1), "MSFT") == 0, "name of id 1");
+    CHECK(usrl_intern_name(&s, 2) == NULL && usrl_intern_name(&s, 99) == NULL, "name of an unassigned id");
+    CHECK(usrl_intern_id(&s, "AAPL", 0) == USRL_INTERN_INVALID, "empty name accepted");
+    char long_name[USRL_SYMBOL_MAX + 1];
+    memset(long_name, 'L', USRL_SYMBOL_MAX);
+    long_name[USRL_SYMBOL_MAX] = '\0';
+    CHECK(intern(&s, long_name) == USRL_INTERN_INVALID, "over-long name accepted");
+    CHECK(usrl_intern_id(&s, "AAPLX", 4) == 0, "length not honoured");
+
+    CHECK(intern(&s, "GOOG") == 2 && intern(&s, "AMZN") == 3, "filling the table");
+    CHECK(intern(&s, "TSLA") == USRL_INTERN_INVALID, "insert into a full table");
+    CHECK(usrl_intern_count(&s) == 4, "count %u after overflow", usrl_intern_count(&s));
+    CHECK(intern(&s, "AMZN") == 3 && lookup(&s, "TSLA") == USRL_INTERN_INVALID, "full table lookups");
+    free(small);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Dense, stable ids; limits enforced.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: MULTI-PROCESS
+     * ========================================================================= */
+    printf("\n[PHASE 2] %d processes interning %d symbols in different orders...\n", WORKERS, SYMBOLS);
+    int fail_before = g_fail;
+
+    shm_unlink(SHM_PATH);
+    if (usrl_intern_create(SHM_PATH, CAPACITY) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    uint32_t (*ids)[SYMBOLS] = mmap(NULL, sizeof(uint32_t) * WORKERS * SYMBOLS, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (ids == MAP_FAILED) return 2;
+
+    for (int w = 0; w < WORKERS; w++)
+        if (fork() == 0) worker(w, ids);
+    for (int w = 0; w < WORKERS; w++) {
+        int status = 0;
+        wait(&status);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "worker failed (%d)", status);
+    }
+
+    UsrlIntern t;
+    CHECK(usrl_intern_open(&t, SHM_PATH) == 0, "open failed");
+    CHECK(usrl_intern_count(&t) == SYMBOLS, "count %u", usrl_intern_count(&t));
+    static uint8_t seen[SYMBOLS];
+    for (uint32_t i = 0; i < SYMBOLS && g_fail == fail_before; i++) {
+        char name[32];
+        sym_name(name, sizeof(name), i);
+        uint32_t id = ids[0][i];
+        for (int w = 1; w < WORKERS; w++)
+            CHECK(ids[w][i] == id, "%s: worker 0 got %u, worker %d got %u", name, id, w, ids[w][i]);
+        CHECK(id < SYMBOLS && !seen[id], "%s: id %u out of range or shared", name, id);
+        if (id < SYMBOLS) seen[id] = 1;
+        const char *back = usrl_intern_name(&t, id);
+        CHECK(back && strcmp(back, name) == 0 && lookup(&t, name) == id, "%s: id %u maps back to %s", name, id,
+              back ? back : "NULL");
+    }
+    munmap(ids, sizeof(uint32_t) * WORKERS * SYMBOLS);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] All processes agree on %d dense ids.\n" COLOR_RESET, SYMBOLS);
+
+    /* =========================================================================
+     * PHASE 3: DEAD INSERTER
+     * ========================================================================= */
+    printf("\n[PHASE 3] Every free index slot left mid-insert by a dead process...\n");
+    fail_before = g_fail;
+
+    pid_t dead = fork();
+    if (dead == 0) _exit(0);
+    waitpid(dead, NULL, 0);
+
+    /* The inserter died after claiming slots (and one id) but before publishing */
+    uint32_t mark = 0x80000000u | (uint32_t)dead;
+    uint32_t marked = 0;
+    for (uint32_t i = 0; i <= t.mask; i++) {
+        uint32_t expected = 0;
+        if (atomic_compare_exchange_strong(&t.index[i], &expected, mark)) marked++;
+    }
+    uint32_t taken = (uint32_t)atomic_fetch_add(&t.hdr->next_id, 1);
+
+    signal(SIGALRM, on_alarm);
+    alarm(10);
+    uint32_t absent = lookup(&t, "NEW.SYM");
+    uint32_t fresh = intern(&t, "NEW.SYM");
+    uint32_t known = lookup(&t, "SYM0007.X");
+    alarm(0);
+
+    CHECK(marked > 0, "no free slots to mark");
+    CHECK(absent == USRL_INTERN_INVALID, "lookup of an absent name returned %u", absent);
+    CHECK(fresh == taken + 1, "new symbol got id %u, expected %u", fresh, taken + 1);
+    CHECK(usrl_intern_name(&t, taken) == NULL, "dead inserter's id %u has a name", taken);
+    CHECK(fresh != USRL_INTERN_INVALID && lookup(&t, "NEW.SYM") == fresh &&
+          strcmp(usrl_intern_name(&t, fresh), "NEW.SYM") == 0, "new symbol not found again");
+    CHECK(known != USRL_INTERN_INVALID && strcmp(usrl_intern_name(&t, known), "SYM0007.X") == 0,
+          "existing symbol lost");
+    usrl_intern_close(&t);
+    shm_unlink(SHM_PATH);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Dead inserter's slots reclaimed, its id skipped.\n" COLOR_RESET);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,324 @@
+/**
+ * @file join_test.c
+ * @brief As-of join against a brute-force reference.
+ *
+ * VALIDATES:
+ * 1. Every left record joins the newest right record of its key at or
+ *    before its time, within the tolerance and the per-key depth; the
+ *    output carries both records byte for byte, or a zeroed right side.
+ *    Trades that lag the quote stream, quotes pushed out of the ring,
+ *    stale quotes and unquoted keys all occur.
+ * 2. Mismatched key kinds and zero depth are refused; depth rounds up to
+ *    a power of two.
+ * 3. Polling topics on publish time drains quotes first, so a trade joins
+ *    the quote before it, not the one after; inner joins drop unmatched
+ *    trades, left joins publish them; short records are rejected.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_join.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_join_test"
+#define SHM_SIZE (4u << 20)
+#define KEYS 4
+#define QUOTED 3            /* the last key never quotes */
+#define EVENTS 20000
+#define DEPTH 4
+#define TOLERANCE 100
+#define MAX_LAG 300
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static const char *const g_syms[KEYS] = { "AAPL", "MSFT", "ES.H27", "NOQUOTE" };
+
+static const UsrlField *t_sym, *t_px, *t_ts;
+static const UsrlField *q_sym, *q_bid, *q_ask, *q_ts;
+static uint32_t g_tsize, g_qsize;
+
+/* Quotes per key in arrival order */
+static uint8_t g_quotes[KEYS][EVENTS][64];
+static uint32_t g_nquotes[KEYS];
+
+static uint64_t lcg(uint64_t *s) {
+    *s = *s * 6364136223846793005ull + 1442695040888963407ull;
+    return *s >> 33;
+}
+
+static void put_sym(uint8_t *rec, const UsrlField *f, const char *sym) {
+    memset(rec + f->offset, 0, f->size);
+    memcpy(rec + f->offset, sym, strlen(sym));
+}
+
+static void make_trade(uint8_t *rec, const char *sym, double px, int64_t ts) {
+    put_sym(rec, t_sym, sym);
+    memcpy(rec + t_px->offset, &px, sizeof(px));
+    memcpy(rec + t_ts->offset, &ts, sizeof(ts));
+}
+
+static void make_quote(uint8_t *rec, const char *sym, double bid, double ask, int64_t ts) {
+    put_sym(rec, q_sym, sym);
+    memcpy(rec + q_bid->offset, &bid, sizeof(bid));
+    memcpy(rec + q_ask->offset, &ask, sizeof(ask));
+    memcpy(rec + q_ts->offset, &ts, sizeof(ts));
+}
+
+static int64_t quote_ts(const uint8_t *q) {
+    int64_t ts;
+    memcpy(&ts, q + q_ts->offset, sizeof(ts));
+    return ts;
+}
+
+/* Newest of the last DEPTH quotes of key k at or before ts; NULL if none or too old */
+static const uint8_t *reference(uint32_t k, int64_t ts) {
+    uint32_t n = g_nquotes[k];
+    uint32_t stop = n > DEPTH ? n - DEPTH : 0;
+    while (n > stop) {
+        const uint8_t *q = g_quotes[k][--n];
+        if (quote_ts(q) <= ts) return ts - quote_ts(q) <= TOLERANCE ? q : NULL;
+    }
+    return NULL;
+}
+
+static int is_zero(const uint8_t *p, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++)
+        if (p[i]) return 0;
+    return 1;
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL AS-OF JOIN TEST                                  \n");
+    printf("========================================================\n");
+
+    UsrlSchema *trade = usrl_schema_create(1, "trade");
+    usrl_schema_add_field(trade, "sym", USRL_FIELD_STRING, 8);
+    usrl_schema_add_field(trade, "px", USRL_FIELD_F64, 8);
+    usrl_schema_add_field(trade, "ts", USRL_FIELD_I64, 8);
+    usrl_schema_finalize(trade);
+    UsrlSchema *quote = usrl_schema_create(2, "quote");
+    usrl_schema_add_field(quote, "sym", USRL_FIELD_STRING, 8);
+    usrl_schema_add_field(quote, "bid", USRL_FIELD_F64, 8);
+    usrl_schema_add_field(quote, "ask", USRL_FIELD_F64, 8);
+    usrl_schema_add_field(quote, "ts", USRL_FIELD_I64, 8);
+    usrl_schema_finalize(quote);
+    t_sym = usrl_schema_field(trade, "sym");
+    t_px = usrl_schema_field(trade, "px");
+    t_ts = usrl_schema_field(trade, "ts");
+    q_sym = usrl_schema_field(quote, "sym");
+    q_bid = usrl_schema_field(quote, "bid");
+    q_ask = usrl_schema_field(quote, "ask");
+    q_ts = usrl_schema_field(quote, "ts");
+    g_tsize = trade->total_size;
+    g_qsize = quote->total_size;
+
+    UsrlJoinSpec spec = { .left_key = "sym", .right_key = "sym", .left_time = "ts", .right_time = "ts",
+                          .tolerance_ns = TOLERANCE, .depth = DEPTH, .mode = USRL_JOIN_LEFT };
+    UsrlJoin j;
+    if (!t_sym || !t_px || !t_ts || !q_sym || !q_bid || !q_ask || !q_ts || g_qsize > sizeof(g_quotes[0][0]) ||
+        usrl_join_init(&j, trade, quote, &spec, KEYS) != 0) {
+        printf(COLOR_RED "[FAIL] cannot set up the join\n" COLOR_RESET);
+        return 2;
+    }
+    uint8_t rec[64];
+    uint8_t out[256];
+    uint32_t out_size = usrl_join_record_size(&j);
+    if (out_size > sizeof(out)) return 2;
+
+    /* =========================================================================
+     * PHASE 1: AGAINST THE REFERENCE
+     * ========================================================================= */
+    printf("\n[PHASE 1] %d events, trades lagging quotes by up to %d ns, depth %d, tolerance %d...\n", EVENTS,
+           MAX_LAG, DEPTH, TOLERANCE);
+
+    /* Quotes arrive in time order; trades are stamped up to MAX_LAG behind */
+    uint64_t rng = 3;
+    int64_t now = 1000;
+    uint32_t hits = 0, stale = 0, evicted = 0, unknown = 0, trades = 0;
+    for (int e = 0; e < EVENTS && !g_fail; e++) {
+        now += (int64_t)(lcg(&rng) % 20);
+        if (lcg(&rng) % 2) {
+            uint32_t k = (uint32_t)(lcg(&rng) % QUOTED);
+            double bid = 100.0 + (double)(lcg(&rng) % 1000) / 100.0;
+            uint8_t *q = g_quotes[k][g_nquotes[k]++];
+            make_quote(q, g_syms[k], bid, bid + 0.01, now);
+            CHECK(usrl_join_right(&j, q, 0) == 0, "quote %d rejected", e);
+            continue;
+        }
+
+        uint32_t k = (uint32_t)(lcg(&rng) % KEYS);
+        int64_t ts = now - (int64_t)(lcg(&rng) % (MAX_LAG + 1));
+        make_trade(rec, g_syms[k], 100.0 + e, ts);
+        int hit = usrl_join_left(&j, rec, 0, out);
+        trades++;
+
+        const uint8_t *want = k < QUOTED ? reference(k, ts) : NULL;
+        UsrlJoinHeader h;
+        memcpy(&h, out, sizeof(h));
+        const uint8_t *left = out + sizeof(UsrlJoinHeader);
+        const uint8_t *right = left + g_tsize;
+
+        CHECK(hit == (want != NULL), "trade %d (%s at %ld): matched %d, expected %d", e, g_syms[k], (long)ts,
+              hit, want != NULL);
+        CHECK(h.left_ns == (uint64_t)ts && memcmp(left, rec, g_tsize) == 0, "trade %d: left side", e);
+        if (want) {
+            hits++;
+            CHECK(h.flags == USRL_JOIN_F_MATCHED && h.right_ns == (uint64_t)quote_ts(want) &&
+                  memcmp(right, want, g_qsize) == 0,
+                  "trade %d: joined quote at %lu, expected %ld", e, (unsigned long)h.right_ns,
+                  (long)quote_ts(want));
+        } else {
+            CHECK(h.flags == 0 && h.right_ns == 0 && is_zero(right, g_qsize), "trade %d: right side not zeroed", e);
+            if (k >= QUOTED) {
+                unknown++;
+            } else {
+                /* Classify the miss: is there any quote at or before ts at all? */
+                uint32_t n = g_nquotes[k];
+                while (n > 0 && quote_ts(g_quotes[k][n - 1]) > ts) n--;
+                if (n > 0 && g_nquotes[k] - n >= DEPTH) evicted++;
+                else if (n > 0) stale++;
+            }
+        }
+    }
+    printf("    %u trades: %u matched, %u stale, %u pushed out, %u unquoted\n", trades, hits, stale, evicted,
+           unknown);
+    CHECK(hits && stale && evicted && unknown, "not every outcome exercised");
+    CHECK(j.matched == hits && j.unmatched == trades - hits && j.left_in == trades, "stats %lu / %lu / %lu",
+          (unsigned long)j.matched, (unsigned long)j.unmatched, (unsigned long)j.left_in);
+    usrl_join_free(&j);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Every trade joined its prevailing quote.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: SPECS
+     * ========================================================================= */
+    printf("\n[PHASE 2] Key kinds and depth...\n");
+    int fail_before = g_fail;
+
+    UsrlJoinSpec bad = spec;
+    bad.left_key = "px";
+    CHECK(usrl_join_init(&j, trade, quote, &bad, KEYS) != 0, "numeric key joined to a text key");
+    bad = spec;
+    bad.depth = 0;
+    CHECK(usrl_join_init(&j, trade, quote, &bad, KEYS) != 0, "depth 0 accepted");
+    bad = spec;
+    bad.right_time = "nope";
+    CHECK(usrl_join_init(&j, trade, quote, &bad, KEYS) != 0, "unknown time field accepted");
+    bad = spec;
+    bad.depth = 5;
+    CHECK(usrl_join_init(&j, trade, quote, &bad, KEYS) == 0 && j.depth == 8, "depth 5 became %u", j.depth);
+    CHECK(usrl_join_record_size(&j) == sizeof(UsrlJoinHeader) + g_tsize + g_qsize, "record size %u",
+          usrl_join_record_size(&j));
+    usrl_join_free(&j);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Bad specs refused, depth rounded.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: TOPICS, INNER AND LEFT
+     * ========================================================================= */
+    printf("\n[PHASE 3] Quote, trade, quote, unquoted trade, short trade; inner and left joins...\n");
+    fail_before = g_fail;
+
+    shm_unlink(SHM_PATH);
+    UsrlTopicConfig cfg[4] = {
+        { .name = "trades", .slot_count = 64, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+        { .name = "quotes", .slot_count = 64, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+        { .name = "inner", .slot_count = 64, .slot_size = 256, .type = USRL_RING_TYPE_SWMR },
+        { .name = "outer", .slot_count = 64, .slot_size = 256, .type = USRL_RING_TYPE_SWMR },
+    };
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, cfg, 4) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    void *core = usrl_core_map(SHM_PATH, SHM_SIZE);
+    UsrlJoin inner, outer;
+    UsrlJoinSpec live = { .left_key = "sym", .right_key = "sym", .depth = 4, .mode = USRL_JOIN_INNER };
+    if (!core || usrl_join_init(&inner, trade, quote, &live, KEYS) != 0 ||
+        usrl_join_attach(&inner, core, "trades", "quotes", "inner", 8) != 0) {
+        printf(COLOR_RED "[FAIL] cannot attach\n" COLOR_RESET);
+        return 2;
+    }
+    live.mode = USRL_JOIN_LEFT;
+    if (usrl_join_init(&outer, trade, quote, &live, KEYS) != 0 ||
+        usrl_join_attach(&outer, core, "trades", "quotes", "outer", 9) != 0) {
+        printf(COLOR_RED "[FAIL] cannot attach\n" COLOR_RESET);
+        return 2;
+    }
+    UsrlPublisher tp, qp;
+    usrl_pub_init(&tp, core, "trades", 1);
+    usrl_pub_init(&qp, core, "quotes", 2);
+
+    /* Publish time orders these; the ts fields are unused here */
+    uint8_t q1[64], q2[64], t1[64], t2[64];
+    make_quote(q1, "AAPL", 1.0, 1.5, 0);
+    make_trade(t1, "AAPL", 1.25, 0);
+    make_quote(q2, "AAPL", 2.0, 2.5, 0);
+    make_trade(t2, "NOQUOTE", 9.0, 0);
+    usrl_pub_publish(&qp, q1, g_qsize);
+    usleep(100);
+    usrl_pub_publish(&tp, t1, g_tsize);
+    usleep(100);
+    usrl_pub_publish(&qp, q2, g_qsize);
+    usrl_pub_publish(&tp, t2, g_tsize);
+    usrl_pub_publish(&tp, t2, g_tsize - 1);
+
+    CHECK(usrl_join_poll(&inner, 0) == 3 && usrl_join_poll(&outer, 0) == 3, "poll did not see 3 trades");
+    CHECK(inner.right_in == 2 && inner.rejected == 1 && inner.published == 1, "inner: right %lu rejected %lu published %lu",
+          (unsigned long)inner.right_in, (unsigned long)inner.rejected, (unsigned long)inner.published);
+    CHECK(outer.matched == 1 && outer.unmatched == 1 && outer.published == 2, "outer: matched %lu unmatched %lu published %lu",
+          (unsigned long)outer.matched, (unsigned long)outer.unmatched, (unsigned long)outer.published);
+
+    UsrlSubscriber si, so;
+    usrl_sub_init(&si, core, "inner");
+    usrl_sub_init(&so, core, "outer");
+    UsrlJoinHeader h;
+    int n = usrl_sub_next(&si, out, sizeof(out), NULL);
+    memcpy(&h, out, sizeof(h));
+    CHECK(n == (int)out_size && h.flags == USRL_JOIN_F_MATCHED &&
+          memcmp(out + sizeof(h), t1, g_tsize) == 0 && memcmp(out + sizeof(h) + g_tsize, q1, g_qsize) == 0,
+          "inner: trade did not join the quote before it");
+    CHECK(h.right_ns != 0 && h.right_ns < h.left_ns, "inner: quote time %lu, trade time %lu",
+          (unsigned long)h.right_ns, (unsigned long)h.left_ns);
+    CHECK(usrl_sub_next(&si, out, sizeof(out), NULL) == USRL_RING_NO_DATA, "inner join published a miss");
+
+    CHECK(usrl_sub_next(&so, out, sizeof(out), NULL) == (int)out_size &&
+          memcmp(out + sizeof(h) + g_tsize, q1, g_qsize) == 0, "outer: first trade");
+    n = usrl_sub_next(&so, out, sizeof(out), NULL);
+    memcpy(&h, out, sizeof(h));
+    CHECK(n == (int)out_size && h.flags == 0 && memcmp(out + sizeof(h), t2, g_tsize) == 0 &&
+          is_zero(out + sizeof(h) + g_tsize, g_qsize), "outer: unquoted trade");
+
+    usrl_join_free(&inner);
+    usrl_join_free(&outer);
+    usrl_core_unmap(core, SHM_SIZE);
+    shm_unlink(SHM_PATH);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Quotes drained first; inner drops, left keeps misses.\n" COLOR_RESET);
+
+    usrl_schema_free(trade);
+    usrl_schema_free(quote);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
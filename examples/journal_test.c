@@ -0,0 +1,252 @@
+/**
+ * @file journal_test.c
+ * @brief Journal crash recovery: torn-tail repair and interrupted compaction.
+ *
+ * VALIDATES:
+ * 1. A segment cut mid-record is repaired on open: torn tail dropped, sealed,
+ *    appends resume after the last complete record.
+ * 2. Leftover "*.usj.compact" outputs of a crashed compactor are invisible to
+ *    readers and discarded by the next compaction.
+ * 3. A compaction that crashed between renames (a seq range covered twice)
+ *    still reads as one ascending, duplicate-free stream, and compacts again.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define TOPIC "jtest"
+#define KEYS 8
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+typedef struct {
+    uint32_t key;
+    uint32_t value;
+} Rec;
+
+typedef struct {
+    uint64_t count;
+    uint64_t first;
+    uint64_t last;
+    uint64_t out_of_order;
+    uint32_t newest[KEYS];   /* value of the newest record per key */
+} Scan;
+
+/* Read a topic the way readers do: segments by first_seq, seqs already seen skipped */
+static int scan_journal(const char *dir, Scan *out) {
+    memset(out, 0, sizeof(*out));
+    UsrlJournalSegInfo segs[64];
+    int n = usrl_journal_list(dir, TOPIC, segs, 64);
+    if (n < 0 || n > 64) return -1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < n; i++) {
+        UsrlJournalSegment s;
+        if (usrl_jseg_open(&s, segs[i].path) != 0) return -1;
+        const UsrlJournalRecord *r;
+        for (uint64_t off = usrl_jseg_begin(&s); (r = usrl_jseg_record(&s, off)) != NULL;
+             off = usrl_jseg_next(r, off)) {
+            if (r->seq <= seen) continue;
+            if (out->count && r->seq <= out->last) out->out_of_order++;
+            if (!out->count) out->first = r->seq;
+            out->last = seen = r->seq;
+            out->count++;
+
+            Rec rec;
+            memcpy(&rec, usrl_jseg_payload(r), sizeof(rec));
+            if (rec.key < KEYS) out->newest[rec.key] = rec.value;
+        }
+        usrl_jseg_close(&s);
+    }
+    return n;
+}
+
+static void append_range(UsrlJournalWriter *w, uint64_t from, uint64_t to) {
+    for (uint64_t seq = from; seq <= to; seq++) {
+        Rec rec = { (uint32_t)(seq % KEYS), (uint32_t)seq };
+        usrl_journal_append(w, seq, seq * 1000, 1, 0, &rec, sizeof(rec));
+    }
+}
+
+/* Abandon a writer as a crash would: data flushed, segment never sealed */
+static void crash_writer(UsrlJournalWriter *w) {
+    usrl_journal_flush(w);
+    if (w->fd >= 0) close(w->fd);
+    free(w->buf);
+    free(w->index);
+    memset(w, 0, sizeof(*w));
+}
+
+static void copy_file(const char *from, const char *to) {
+    FILE *in = fopen(from, "rb");
+    FILE *out = fopen(to, "wb");
+    char buf[65536];
+    size_t n;
+    while (in && out && (n = fread(buf, 1, sizeof(buf), in)) > 0) fwrite(buf, 1, n, out);
+    if (in) fclose(in);
+    if (out) fclose(out);
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL JOURNAL CRASH RECOVERY TEST                      \n");
+    printf("========================================================\n");
+
+    char base[] = "/tmp/usrl_journal_test.XXXXXX";
+    if (!mkdtemp(base)) {
+        perror("mkdtemp");
+        return 2;
+    }
+    char dir_a[256], dir_b[256], cmd[600];
+    snprintf(dir_a, sizeof(dir_a), "%s/a", base);
+    snprintf(dir_b, sizeof(dir_b), "%s/b", base);
+
+    /* =========================================================================
+     * PHASE 1: TORN TAIL
+     * ========================================================================= */
+    printf("\n[PHASE 1] Writer crash with a torn last record...\n");
+
+    UsrlJournalWriter w;
+    if (usrl_journal_writer_open(&w, dir_a, TOPIC, 0) != 0) {
+        perror("usrl_journal_writer_open");
+        return 2;
+    }
+    append_range(&w, 1, 100);
+    crash_writer(&w);
+
+    UsrlJournalSegInfo seg;
+    CHECK(usrl_journal_list(dir_a, TOPIC, &seg, 1) == 1, "expected one segment");
+    struct stat st;
+    stat(seg.path, &st);
+    truncate(seg.path, st.st_size - 5); /* cut into record 100 */
+
+    CHECK(usrl_journal_writer_open(&w, dir_a, TOPIC, 0) == 0, "reopen after crash failed");
+    CHECK(w.last_seq == 99, "resume seq %lu, expected 99", (unsigned long)w.last_seq);
+
+    UsrlJournalSegment s;
+    CHECK(usrl_jseg_open(&s, seg.path) == 0, "repaired segment does not open");
+    CHECK(s.hdr->flags & USRL_JSEG_F_SEALED, "repaired segment is not sealed");
+    CHECK(s.hdr->count == 99 && s.hdr->last_seq == 99, "repaired segment holds %lu records up to %lu",
+          (unsigned long)s.hdr->count, (unsigned long)s.hdr->last_seq);
+    usrl_jseg_close(&s);
+
+    append_range(&w, 100, 120);
+    usrl_journal_writer_close(&w);
+
+    Scan sc;
+    scan_journal(dir_a, &sc);
+    CHECK(sc.count == 120 && sc.first == 1 && sc.last == 120 && !sc.out_of_order,
+          "after repair: %lu records %lu..%lu", (unsigned long)sc.count,
+          (unsigned long)sc.first, (unsigned long)sc.last);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Torn tail cut, 99 kept, appends resumed at 100.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: STRAY COMPACTION OUTPUT
+     * ========================================================================= */
+    printf("\n[PHASE 2] Compactor crash before the rename...\n");
+    int fail_before = g_fail;
+
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir_a);
+    system(cmd);
+    CHECK(usrl_journal_writer_open(&w, dir_a, TOPIC, 4096) == 0, "writer open failed");
+    append_range(&w, 1, 1000);              /* ~10 sealed segments */
+    usrl_journal_roll(&w);
+    append_range(&w, 1001, 1010);           /* active segment */
+    usrl_journal_flush(&w);
+
+    char stray[512];
+    snprintf(stray, sizeof(stray), "%s/%s/%020llu%s.compact", dir_a, TOPIC, 1ull, USRL_JOURNAL_EXT);
+    FILE *f = fopen(stray, "wb");
+    if (f) {
+        fputs("half-written compaction output", f);
+        fclose(f);
+    }
+
+    scan_journal(dir_a, &sc);
+    CHECK(sc.count == 1010 && sc.last == 1010 && !sc.out_of_order,
+          "stray output visible to readers: %lu records", (unsigned long)sc.count);
+
+    /* Keep an uncompacted copy for phase 3 */
+    snprintf(cmd, sizeof(cmd), "cp -r %s %s", dir_a, dir_b);
+    system(cmd);
+
+    UsrlCompactSpec spec = { .key_offset = 0, .key_len = sizeof(uint32_t) };
+    UsrlCompactStats cs;
+    CHECK(usrl_journal_compact(dir_a, TOPIC, &spec, &cs) == 0, "compaction failed");
+    CHECK(access(stray, F_OK) != 0, "stray output survived compaction");
+    CHECK(cs.records_in == 1000, "compacted %lu records, expected 1000", (unsigned long)cs.records_in);
+
+    Scan compacted;
+    scan_journal(dir_a, &compacted);
+    CHECK(compacted.last == 1010 && !compacted.out_of_order, "compacted journal out of order");
+    for (int k = 0; k < KEYS; k++)
+        CHECK(compacted.newest[k] == sc.newest[k], "key %d: newest %u, expected %u", k,
+              compacted.newest[k], sc.newest[k]);
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] Stray output ignored, then discarded; %lu -> %lu records.\n" COLOR_RESET,
+               (unsigned long)sc.count, (unsigned long)compacted.count);
+
+    /* =========================================================================
+     * PHASE 3: CRASH BETWEEN RENAMES
+     * ========================================================================= */
+    printf("\n[PHASE 3] Compactor crash after the first rename...\n");
+    fail_before = g_fail;
+
+    /* The compacted first segment replaces the first input of the copy; the
+     * other inputs are still there, so their seqs are covered twice */
+    UsrlJournalSegInfo outs[64], ins[64];
+    int n_out = usrl_journal_list(dir_a, TOPIC, outs, 64);
+    int n_in = usrl_journal_list(dir_b, TOPIC, ins, 64);
+    CHECK(n_out > 0 && n_in > 2, "unexpected segment counts %d / %d", n_out, n_in);
+    copy_file(outs[0].path, ins[0].path);
+
+    Scan torn;
+    scan_journal(dir_b, &torn);
+    CHECK(!torn.out_of_order, "%lu seqs delivered out of order", (unsigned long)torn.out_of_order);
+    CHECK(torn.last == 1010, "last seq %lu, expected 1010", (unsigned long)torn.last);
+    for (int k = 0; k < KEYS; k++)
+        CHECK(torn.newest[k] == sc.newest[k], "key %d: newest %u, expected %u", k,
+              torn.newest[k], sc.newest[k]);
+
+    CHECK(usrl_journal_compact(dir_b, TOPIC, &spec, &cs) == 0, "re-compaction failed");
+    Scan again;
+    scan_journal(dir_b, &again);
+    CHECK(again.count == compacted.count && again.last == 1010 && !again.out_of_order,
+          "re-compacted: %lu records, expected %lu", (unsigned long)again.count,
+          (unsigned long)compacted.count);
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] Doubly covered seqs read once, in order; compaction converges.\n" COLOR_RESET);
+
+    crash_writer(&w);
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", base);
+    system(cmd);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
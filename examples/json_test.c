@@ -0,0 +1,259 @@
+/**
+ * @file json_test.c
+ * @brief JSON transcoder: values, escapes and malformed input on both scanners.
+ *
+ * VALIDATES:
+ * 1. Well-formed objects fill the right fields on the vector scanner and on
+ *    the scalar one (USRL_JSON_F_SCALAR): escaped quotes, backslash runs,
+ *    escapes straddling a 64-byte block, nested values skipped, INT64_MIN.
+ * 2. Malformed input is rejected by both: trailing bytes after the object,
+ *    junk after a closing quote or bracket, unterminated strings, bad
+ *    numbers and escapes.
+ * 3. Randomly generated and randomly corrupted payloads give byte-identical
+ *    results on both scanners.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_json.h"
+#include "usrl_schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define REC_MAX 128
+#define DOC_MAX 512
+#define FUZZ_DOCS 20000
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static UsrlJsonMap g_simd, g_scalar;
+static const UsrlSchema *g_schema;
+
+typedef struct {
+    int rc;
+    uint32_t present;
+    uint8_t rec[REC_MAX];
+} Result;
+
+/* Transcode on both scanners; returns 1 if they agree */
+static int both(const char *doc, uint32_t len, Result *out) {
+    Result a, b;
+    memset(&a, 0xEE, sizeof(a));
+    memset(&b, 0xEE, sizeof(b));
+    a.present = b.present = 0;
+    a.rc = usrl_json_transcode(&g_simd, (const uint8_t *)doc, len, a.rec, REC_MAX, &a.present);
+    b.rc = usrl_json_transcode(&g_scalar, (const uint8_t *)doc, len, b.rec, REC_MAX, &b.present);
+    if (out) *out = a;
+    if (a.rc != b.rc) return 0;
+    if (a.rc < 0) return 1;
+    return a.present == b.present && memcmp(a.rec, b.rec, (size_t)a.rc) == 0;
+}
+
+static const uint8_t *field(const Result *r, const char *name) {
+    return r->rec + usrl_schema_field(g_schema, name)->offset;
+}
+
+static int64_t i64(const Result *r, const char *name) {
+    int64_t v;
+    memcpy(&v, field(r, name), 8);
+    return v;
+}
+
+static double f64(const Result *r, const char *name) {
+    double v;
+    memcpy(&v, field(r, name), 8);
+    return v;
+}
+
+static uint32_t u32(const Result *r, const char *name) {
+    uint32_t v;
+    memcpy(&v, field(r, name), 4);
+    return v;
+}
+
+static int text_is(const Result *r, const char *name, const char *want) {
+    const UsrlField *f = usrl_schema_field(g_schema, name);
+    char buf[64] = { 0 };
+    memcpy(buf, r->rec + f->offset, f->size);
+    return strcmp(buf, want) == 0;
+}
+
+static int parse(const char *doc, Result *r) {
+    int agree = both(doc, (uint32_t)strlen(doc), r);
+    CHECK(agree, "scanners disagree on %s", doc);
+    return agree && r->rc > 0;
+}
+
+static uint64_t lcg(uint64_t *s) {
+    *s = *s * 6364136223846793005ull + 1442695040888963407ull;
+    return *s >> 33;
+}
+
+/* A random flat object, with escapes, nesting and whitespace the schema does not need */
+static uint32_t random_doc(uint64_t *rng, char *doc) {
+    static const char *keys[] = { "sym", "price", "qty", "ok", "meta", "x" };
+    static const char *strs[] = { "AB", "a\\\"b", "\\\\", "\\\\\\\"", "q\\u00e9", "}{", "[,]", "" };
+    static const char *nums[] = { "0", "-1", "3.25", "1e3", "-9223372036854775808", "true", "null", "\"7\"" };
+    uint32_t n = 0;
+    doc[n++] = '{';
+    uint32_t fields = 1 + (uint32_t)(lcg(rng) % 6);
+    for (uint32_t i = 0; i < fields; i++) {
+        if (i) doc[n++] = ',';
+        if (lcg(rng) % 4 == 0) doc[n++] = ' ';
+        /* Variable padding moves escapes across block boundaries */
+        if (lcg(rng) % 3 == 0) {
+            uint32_t pad = (uint32_t)(lcg(rng) % 70);
+            n += (uint32_t)sprintf(doc + n, "\"pad\":\"");
+            for (uint32_t k = 0; k < pad; k++) doc[n++] = 'p';
+            n += (uint32_t)sprintf(doc + n, "%s\",", strs[lcg(rng) % 8]);
+        }
+        const char *key = keys[lcg(rng) % 6];
+        switch (lcg(rng) % 3) {
+        case 0: n += (uint32_t)sprintf(doc + n, "\"%s\" : \"%s\"", key, strs[lcg(rng) % 8]); break;
+        case 1: n += (uint32_t)sprintf(doc + n, "\"%s\":%s", key, nums[lcg(rng) % 8]); break;
+        default: n += (uint32_t)sprintf(doc + n, "\"%s\":{\"a\":[1,\"]\",{\"b\":\"\\\"\"}]}", key); break;
+        }
+    }
+    doc[n++] = '}';
+    if (lcg(rng) % 4 == 0) doc[n++] = '\n';
+    doc[n] = '\0';
+    return n;
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL JSON TRANSCODER TEST (backend: %-6s)          \n", usrl_json_backend());
+    printf("========================================================\n");
+
+    UsrlSchema *s = usrl_schema_create(1, "tick");
+    usrl_schema_add_field(s, "sym", USRL_FIELD_STRING, 16);
+    usrl_schema_add_field(s, "price", USRL_FIELD_F64, 8);
+    usrl_schema_add_field(s, "qty", USRL_FIELD_I64, 8);
+    usrl_schema_add_field(s, "ok", USRL_FIELD_U32, 4);
+    usrl_schema_finalize(s);
+    g_schema = s;
+    if (usrl_json_map_init(&g_simd, s) != 0 || usrl_json_map_init(&g_scalar, s) != 0 || s->total_size > REC_MAX) {
+        printf(COLOR_RED "[FAIL] cannot build the key maps\n" COLOR_RESET);
+        return 2;
+    }
+    g_scalar.flags |= USRL_JSON_F_SCALAR;
+
+    /* =========================================================================
+     * PHASE 1: VALUES
+     * ========================================================================= */
+    printf("\n[PHASE 1] Well-formed objects on both scanners...\n");
+
+    Result r;
+    if (parse("{\"sym\":\"BTC\",\"price\":1.5,\"qty\":-42,\"ok\":true}", &r))
+        CHECK(text_is(&r, "sym", "BTC") && f64(&r, "price") == 1.5 && i64(&r, "qty") == -42 &&
+              u32(&r, "ok") == 1 && r.present == 0xF, "plain object");
+    if (parse(" { \"sym\" : \"A\\\"B\" , \"price\" : \"2.25\" }\r\n", &r))
+        CHECK(text_is(&r, "sym", "A\"B") && f64(&r, "price") == 2.25 && r.present == 0x3,
+              "escaped quote / number as string");
+    if (parse("{\"sym\":\"x\\\\\\\\\",\"qty\":1}", &r))
+        CHECK(text_is(&r, "sym", "x\\\\") && i64(&r, "qty") == 1, "backslash run before the closing quote");
+    if (parse("{\"meta\":{\"a\":[1,2,{\"b\":\"}\"}]},\"qty\":7,\"x\":[]}", &r))
+        CHECK(i64(&r, "qty") == 7 && r.present == 0x4, "nested values not skipped");
+    if (parse("{\"qty\":-9223372036854775808,\"ok\":null,\"sym\":\"\\u00e9\"}", &r))
+        CHECK(i64(&r, "qty") == INT64_MIN && text_is(&r, "sym", "\xc3\xa9") && r.present == 0x5,
+              "INT64_MIN / null / \\u escape");
+    if (parse("{}", &r)) CHECK(r.present == 0, "empty object");
+
+    /* Escaped quote (\") at every offset around the first block boundary */
+    int straddle_ok = 1;
+    for (int pad = 40; pad < 80; pad++) {
+        char doc[DOC_MAX];
+        int n = snprintf(doc, sizeof(doc), "{\"x\":\"%.*s\\\"\",\"sym\":\"Z\",\"qty\":%d}", pad,
+                         "pppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppp", pad);
+        if (!both(doc, (uint32_t)n, &r) || r.rc < 0 || !text_is(&r, "sym", "Z") || i64(&r, "qty") != pad) {
+            CHECK(0, "escape at offset %d: rc %d", pad + 6, r.rc);
+            straddle_ok = 0;
+            break;
+        }
+    }
+    if (!g_fail && straddle_ok) printf(COLOR_GREEN "[PASS] Fields match on both scanners.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: MALFORMED
+     * ========================================================================= */
+    printf("\n[PHASE 2] Malformed payloads...\n");
+    int fail_before = g_fail;
+
+    static const char *bad[] = {
+        "{\"sym\":\"A\"}x",                 /* trailing bytes */
+        "{\"sym\":\"A\"} {}",               /* second object */
+        "{\"qty\":1}}",                     /* extra bracket */
+        "{\"sym\":\"A\"x,\"qty\":1}",       /* junk after a string value */
+        "{\"sym\":\"A\" \"qty\":1}",        /* missing comma */
+        "{\"meta\":[1]x,\"qty\":1}",        /* junk after a nested value */
+        "{\"sym\":\"A\\\"}",                /* closing quote escaped */
+        "{\"sym\" \"A\"}",                  /* missing colon */
+        "x{\"qty\":1}",                     /* leading junk */
+        "{x\"qty\":1}",                     /* junk before a key */
+        "{\"qty\":1,x\"ok\":1}",            /* junk before a later key */
+        "{\"qty\":1,}",                     /* trailing comma */
+        "{\"qty\":1.}",                     /* bad number */
+        "{\"qty\":}",                       /* missing value */
+        "{\"ok\":tru}",                     /* bad literal */
+        "{\"sym\":\"a\\q\"}",               /* bad escape */
+        "{\"meta\":{\"a\":1}",              /* unclosed object */
+        "[1,2]",                            /* not an object */
+        "{",
+        "",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        int agree = both(bad[i], (uint32_t)strlen(bad[i]), &r);
+        CHECK(agree && r.rc < 0, "accepted (or scanners disagree): %s", bad[i]);
+    }
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] %zu malformed payloads rejected by both.\n" COLOR_RESET,
+               sizeof(bad) / sizeof(bad[0]));
+
+    /* =========================================================================
+     * PHASE 3: DIFFERENTIAL
+     * ========================================================================= */
+    printf("\n[PHASE 3] %d random payloads, each also corrupted...\n", FUZZ_DOCS);
+    fail_before = g_fail;
+
+    static const char junk[] = "\"\\{}[]:, x0";
+    uint64_t rng = 7, accepted = 0, corrupt_accepted = 0;
+    for (int i = 0; i < FUZZ_DOCS && g_fail == fail_before; i++) {
+        char doc[DOC_MAX];
+        uint32_t n = random_doc(&rng, doc);
+        CHECK(both(doc, n, &r) && r.rc > 0, "rejected or disagree: %s", doc);
+        accepted += r.rc > 0;
+
+        uint32_t at = (uint32_t)(lcg(&rng) % n);
+        doc[at] = junk[lcg(&rng) % (sizeof(junk) - 1)];
+        CHECK(both(doc, n, &r), "scanners disagree on corrupted: %s", doc);
+        corrupt_accepted += r.rc > 0;
+    }
+    printf("    %lu accepted, %lu corrupted copies still well-formed\n", (unsigned long)accepted,
+           (unsigned long)corrupt_accepted);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Scanners agree byte for byte.\n" COLOR_RESET);
+
+    usrl_schema_free(s);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
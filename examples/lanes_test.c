@@ -0,0 +1,225 @@
+/**
+ * @file lanes_test.c
+ * @brief Priority lanes: delivery order, rate-budget and ring-fill shedding.
+ *
+ * VALIDATES:
+ * 1. Subscribers drain lane 0 before lane 1 and so on, FIFO within a lane,
+ *    through both usrl_lanes_sub_next() and usrl_lanes_sub_next_batch().
+ * 2. A batch whose arena cannot hold a lane's largest payload skips that
+ *    lane and keeps filling from lanes with smaller slots.
+ * 3. Under a shared rate budget lane k gets only (N - k) / N of a window,
+ *    so bulk lanes are shed while lane 0 still publishes.
+ * 4. While a gated lane 0 backs up, lane k sheds once lane 0 is over
+ *    (N - k) / N full, and stops shedding after the stage catches up.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_lanes.h"
+#include "usrl_stage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_lanes_test"
+#define SHM_SIZE (8u << 20)
+#define LANES 4
+#define SLOTS 64
+#define PER_LANE 10
+#define RATE_HZ 400000ull   /* 400 per 1 ms window: lane 3 gets 100, lane 0 all 400 */
+#define ATTEMPTS 200
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+/* Payload: lane in the high half, per-lane sequence in the low half */
+static int publish(UsrlLanePublisher *p, uint32_t lane, uint32_t n) {
+    uint32_t v = (lane << 16) | n;
+    return usrl_lanes_publish(p, lane, &v, sizeof(v));
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void drain(UsrlLaneSubscriber *s) {
+    uint8_t buf[4096];
+    while (usrl_lanes_sub_next(s, buf, sizeof(buf), NULL, NULL) > 0) {}
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL PRIORITY LANES TEST                              \n");
+    printf("========================================================\n");
+
+    /* "bulk": lane 0 has 2 KB slots, the others 64 B. "gated": lane 0 gets a stage. */
+    UsrlTopicConfig base[2] = {
+        { .name = "bulk", .slot_count = SLOTS, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+        { .name = "gated", .slot_count = SLOTS, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+    };
+    UsrlTopicConfig cfg[2 * LANES];
+    if (usrl_lanes_expand(&base[0], LANES, cfg, LANES) != LANES ||
+        usrl_lanes_expand(&base[1], LANES, cfg + LANES, LANES) != LANES) {
+        printf(COLOR_RED "[FAIL] cannot expand lane configs\n" COLOR_RESET);
+        return 2;
+    }
+    cfg[0].slot_size = 2048;
+
+    shm_unlink(SHM_PATH);
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, cfg, 2 * LANES) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    void *core = usrl_core_map(SHM_PATH, SHM_SIZE);
+    UsrlStage stage;
+    if (!core || usrl_stage_init(&stage, core, "gated#p0", 0) != 0) {
+        printf(COLOR_RED "[FAIL] cannot map %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+
+    /* =========================================================================
+     * PHASE 1: PRIORITY ORDER
+     * ========================================================================= */
+    printf("\n[PHASE 1] %d messages per lane, published bulk-first...\n", PER_LANE);
+
+    UsrlLanePublisher pub;
+    UsrlLaneSubscriber sub;
+    CHECK(usrl_lanes_pub_init(&pub, core, "bulk", 1, 0) == LANES, "publisher found %u lanes", pub.lane_count);
+    CHECK(usrl_lanes_sub_init(&sub, core, "bulk") == LANES, "subscriber found %u lanes", sub.lane_count);
+    CHECK(usrl_lanes_pub_init(&pub, core, "nope", 1, 0) == 0, "lanes found on an unknown topic");
+    usrl_lanes_pub_init(&pub, core, "bulk", 1, 0);
+
+    for (uint32_t n = 0; n < PER_LANE; n++)
+        for (int lane = LANES - 1; lane >= 0; lane--)
+            CHECK(publish(&pub, (uint32_t)lane, n) == USRL_RING_OK, "publish lane %d", lane);
+
+    uint32_t expect = 0, got = 0;
+    uint8_t buf[4096];
+    uint16_t pid = 0;
+    uint32_t lane = 0;
+    int n;
+    while ((n = usrl_lanes_sub_next(&sub, buf, sizeof(buf), &pid, &lane)) > 0) {
+        uint32_t v;
+        memcpy(&v, buf, sizeof(v));
+        uint32_t want = ((expect / PER_LANE) << 16) | (expect % PER_LANE);
+        CHECK(n == (int)sizeof(v) && v == want && lane == (v >> 16) && pid == 1,
+              "message %u: lane %u value %08x, expected %08x", got, lane, v, want);
+        expect++;
+        got++;
+    }
+    CHECK(got == LANES * PER_LANE, "read %u of %u", got, LANES * PER_LANE);
+
+    for (uint32_t i = 0; i < PER_LANE; i++)
+        for (int l = LANES - 1; l >= 0; l--) publish(&pub, (uint32_t)l, i);
+    UsrlLaneMsg msgs[LANES * PER_LANE];
+    static uint8_t arena[64 * 1024];
+    int batch = usrl_lanes_sub_next_batch(&sub, msgs, LANES * PER_LANE, arena, sizeof(arena));
+    CHECK(batch == LANES * PER_LANE, "batch returned %d", batch);
+    for (int i = 0; i < batch; i++) {
+        uint32_t v;
+        memcpy(&v, msgs[i].data, sizeof(v));
+        CHECK(msgs[i].lane == (uint32_t)i / PER_LANE && v == (((uint32_t)i / PER_LANE) << 16 | (uint32_t)i % PER_LANE),
+              "batch message %d: lane %u value %08x", i, msgs[i].lane, v);
+    }
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Lanes delivered strictly by priority.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: ARENA TOO SMALL FOR ONE LANE
+     * ========================================================================= */
+    printf("\n[PHASE 2] 1 KB arena; lane 0 slots are 2 KB...\n");
+    int fail_before = g_fail;
+
+    for (int l = 0; l < LANES; l++) publish(&pub, (uint32_t)l, 7);
+    batch = usrl_lanes_sub_next_batch(&sub, msgs, LANES, arena, 1024);
+    CHECK(batch == LANES - 1, "small arena returned %d messages", batch);
+    for (int i = 0; i < batch; i++)
+        CHECK(msgs[i].lane == (uint32_t)i + 1, "small arena message %d from lane %u", i, msgs[i].lane);
+    batch = usrl_lanes_sub_next_batch(&sub, msgs, LANES, arena, sizeof(arena));
+    CHECK(batch == 1 && msgs[0].lane == 0, "lane 0 message lost (%d messages)", batch);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Oversized lane skipped, others filled.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: RATE BUDGET
+     * ========================================================================= */
+    printf("\n[PHASE 3] %llu msg/s shared by %d lanes...\n", RATE_HZ, LANES);
+    fail_before = g_fail;
+
+    /* Everything must land in one 1 ms window; retry if the scheduler intervenes */
+    int ok3 = 0, ok2 = 0, ok0 = 0;
+    uint64_t shed3 = 0;
+    for (int attempt = 0; attempt < 5; attempt++) {
+        usrl_lanes_pub_init(&pub, core, "bulk", 1, RATE_HZ);
+        ok3 = ok2 = ok0 = 0;
+        uint64_t t0 = now_ns();
+        for (uint32_t i = 0; i < ATTEMPTS; i++) ok3 += publish(&pub, 3, i) == USRL_RING_OK;
+        for (uint32_t i = 0; i < ATTEMPTS; i++) ok2 += publish(&pub, 2, i) == USRL_RING_OK;
+        for (uint32_t i = 0; i < ATTEMPTS; i++) ok0 += publish(&pub, 0, i) == USRL_RING_OK;
+        shed3 = pub.shed[3];
+        if (now_ns() - t0 < 500000) break;
+    }
+    printf("    accepted: lane 3 %d, lane 2 %d, lane 0 %d of %d each\n", ok3, ok2, ok0, ATTEMPTS);
+    CHECK(ok3 == 100 && shed3 == ATTEMPTS - 100, "lane 3 accepted %d, shed %lu", ok3, (unsigned long)shed3);
+    CHECK(ok2 == 100, "lane 2 accepted %d on top of lane 3", ok2);
+    CHECK(ok0 == 200, "lane 0 accepted %d of the remaining budget", ok0);
+    CHECK(pub.shed[0] == 0, "lane 0 shed %lu", (unsigned long)pub.shed[0]);
+    drain(&sub);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Bulk lanes shed first; lane 0 kept headroom.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 4: RING FILL
+     * ========================================================================= */
+    printf("\n[PHASE 4] Gated lane 0 backs up to 40 of %d slots...\n", SLOTS);
+    fail_before = g_fail;
+
+    CHECK(usrl_lanes_pub_init(&pub, core, "gated", 2, 0) == LANES, "gated lanes not found");
+    for (uint32_t i = 0; i < 40; i++)
+        CHECK(publish(&pub, 0, i) == USRL_RING_OK, "lane 0 publish %u", i);
+    for (uint32_t i = 0; i < 65; i++) publish(&pub, 1, i); /* forces a fill check */
+
+    /* 40 / 64 full: lanes 2 (> 1/2) and 3 (> 1/4) shed, lane 1 (> 3/4) does not */
+    CHECK(publish(&pub, 1, 0) == USRL_RING_OK, "lane 1 shed at 40/64");
+    CHECK(publish(&pub, 2, 0) == USRL_RING_FULL, "lane 2 not shed at 40/64");
+    CHECK(publish(&pub, 3, 0) == USRL_RING_FULL, "lane 3 not shed at 40/64");
+    CHECK(pub.shed[1] == 0 && pub.shed[2] == 1 && pub.shed[3] == 1, "shed counts %lu/%lu/%lu",
+          (unsigned long)pub.shed[1], (unsigned long)pub.shed[2], (unsigned long)pub.shed[3]);
+
+    for (uint32_t i = 40; i < SLOTS; i++) publish(&pub, 0, i);
+    CHECK(publish(&pub, 0, 0) == USRL_RING_FULL, "lane 0 lapped its stage");
+
+    UsrlStageSlot slots[SLOTS];
+    int claimed = usrl_stage_claim(&stage, slots, SLOTS);
+    usrl_stage_commit(&stage);
+    CHECK(claimed == SLOTS, "stage claimed %d", claimed);
+    for (uint32_t i = 0; i < 65; i++) publish(&pub, 1, i);
+    CHECK(publish(&pub, 3, 1) == USRL_RING_OK, "lane 3 still shed after the stage caught up");
+    CHECK(publish(&pub, 0, 0) == USRL_RING_OK, "lane 0 still full after the stage caught up");
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Lanes shed by fill and recovered.\n" COLOR_RESET);
+
+    munmap(core, SHM_SIZE);
+    shm_unlink(SHM_PATH);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * @file map_test.c
+ * @brief Shared map: multi-process put / get / erase and dead writers.
+ *
+ * VALIDATES:
+ * 1. put / get / erase / count semantics, TRUNC and FULL.
+ * 2. Processes hammering the same keys never read a torn value, and the
+ *    final count matches the keys that are actually live.
+ * 3. A bucket left locked by a dead writer is reclaimed by the next reader
+ *    and writer instead of blocking them forever.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_map.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_map_test"
+#define CAPACITY 1024
+#define WORKERS 4
+#define HOT_KEYS 32
+#define OPS 200000
+#define OWN_KEYS 100
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+/* Every word derives from (key, ver): a mix of two writes is detectable */
+typedef struct {
+    uint64_t key;
+    uint64_t ver;
+    uint64_t words[4];
+} Value;
+
+static void make_value(Value *v, uint64_t key, uint64_t ver) {
+    v->key = key;
+    v->ver = ver;
+    for (int i = 0; i < 4; i++) v->words[i] = key * 0x9E3779B97F4A7C15ull + ver + (uint64_t)i;
+}
+
+static int value_ok(const Value *v, uint64_t key) {
+    if (v->key != key) return 0;
+    for (int i = 0; i < 4; i++)
+        if (v->words[i] != key * 0x9E3779B97F4A7C15ull + v->ver + (uint64_t)i) return 0;
+    return 1;
+}
+
+static uint64_t lcg(uint64_t *s) {
+    *s = *s * 6364136223846793005ull + 1442695040888963407ull;
+    return *s >> 33;
+}
+
+static UsrlMapBucket *find_bucket(const UsrlMap *m, uint64_t key) {
+    for (uint32_t i = 0; i <= m->mask; i++) {
+        UsrlMapBucket *b = (UsrlMapBucket *)(m->buckets + (uint64_t)i * m->stride);
+        if (atomic_load(&b->key) == key) return b;
+    }
+    return NULL;
+}
+
+static void on_alarm(int sig) {
+    (void)sig;
+    static const char msg[] = "\x1b[31m[FAIL] blocked on a dead writer's bucket\x1b[0m\n";
+    write(1, msg, sizeof(msg) - 1);
+    _exit(1);
+}
+
+/* Mixed put / get / erase on the hot keys; own keys put once. Exit code = torn reads (capped). */
+static void worker(int w) {
+    UsrlMap m;
+    if (usrl_map_open(&m, SHM_PATH) != USRL_MAP_OK) _exit(100);
+
+    for (uint64_t i = 0; i < OWN_KEYS; i++) {
+        Value v;
+        uint64_t key = 1000 + (uint64_t)w * OWN_KEYS + i;
+        make_value(&v, key, 1);
+        if (usrl_map_put(&m, key, &v, sizeof(v)) != USRL_MAP_OK) _exit(101);
+    }
+
+    uint64_t rng = 0x1234 + (uint64_t)w, torn = 0;
+    for (uint64_t op = 0; op < OPS; op++) {
+        uint64_t key = 1 + lcg(&rng) % HOT_KEYS;
+        uint64_t dice = lcg(&rng) % 8;
+        Value v;
+        if (dice < 3) {
+            make_value(&v, key, ((uint64_t)w << 32) | op);
+            usrl_map_put(&m, key, &v, sizeof(v));
+        } else if (dice == 3) {
+            usrl_map_erase(&m, key);
+        } else {
+            int n = usrl_map_get(&m, key, &v, sizeof(v));
+            if (n == (int)sizeof(v) && !value_ok(&v, key)) torn++;
+            else if (n >= 0 && n != (int)sizeof(v)) torn++;
+        }
+    }
+    usrl_map_close(&m);
+    _exit(torn > 99 ? 99 : (int)torn);
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL SHARED MAP CONCURRENCY TEST                      \n");
+    printf("========================================================\n");
+
+    shm_unlink(SHM_PATH);
+    if (usrl_map_create(SHM_PATH, CAPACITY, sizeof(Value)) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    UsrlMap m;
+    if (usrl_map_open(&m, SHM_PATH) != USRL_MAP_OK) {
+        printf(COLOR_RED "[FAIL] cannot open %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+
+    /* =========================================================================
+     * PHASE 1: SEMANTICS
+     * ========================================================================= */
+    printf("\n[PHASE 1] put / get / erase on one process...\n");
+
+    Value v, out;
+    make_value(&v, 7, 1);
+    CHECK(usrl_map_put(&m, 7, &v, sizeof(v)) == USRL_MAP_OK, "put failed");
+    CHECK(usrl_map_get(&m, 7, &out, sizeof(out)) == (int)sizeof(out) && value_ok(&out, 7) && out.ver == 1,
+          "get after put");
+    make_value(&v, 7, 2);
+    usrl_map_put(&m, 7, &v, sizeof(v));
+    CHECK(usrl_map_count(&m) == 1, "overwrite changed the count to %u", usrl_map_count(&m));
+    CHECK(usrl_map_get(&m, 7, &out, 8) == USRL_MAP_TRUNC, "short buffer not reported");
+    CHECK(usrl_map_get(&m, 8, &out, sizeof(out)) == USRL_MAP_NOT_FOUND, "absent key found");
+    CHECK(usrl_map_put(&m, 9, &v, sizeof(v) + 1) == USRL_MAP_FULL, "oversized value accepted");
+    CHECK(usrl_map_put(&m, USRL_MAP_EMPTY_KEY, &v, sizeof(v)) == USRL_MAP_ERROR, "key 0 accepted");
+    CHECK(usrl_map_erase(&m, 7) == USRL_MAP_OK && usrl_map_erase(&m, 7) == USRL_MAP_NOT_FOUND,
+          "erase twice");
+    CHECK(usrl_map_get(&m, 7, &out, sizeof(out)) == USRL_MAP_NOT_FOUND && usrl_map_count(&m) == 0,
+          "erased key still visible");
+    CHECK(usrl_map_put(&m, 7, &v, sizeof(v)) == USRL_MAP_OK && usrl_map_count(&m) == 1, "re-put after erase");
+    usrl_map_erase(&m, 7);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Map semantics hold.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: MULTI-PROCESS
+     * ========================================================================= */
+    printf("\n[PHASE 2] %d processes x %d ops on %d hot keys...\n", WORKERS, OPS, HOT_KEYS);
+    int fail_before = g_fail;
+
+    for (int w = 0; w < WORKERS; w++)
+        if (fork() == 0) worker(w);
+    for (int w = 0; w < WORKERS; w++) {
+        int status = 0;
+        wait(&status);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "worker: %d torn reads / error (status %d)",
+              WIFEXITED(status) ? WEXITSTATUS(status) : -1, status);
+    }
+
+    uint32_t live = 0;
+    for (uint64_t key = 1; key <= HOT_KEYS; key++) {
+        int n = usrl_map_get(&m, key, &out, sizeof(out));
+        if (n == USRL_MAP_NOT_FOUND) continue;
+        CHECK(n == (int)sizeof(out) && value_ok(&out, key), "hot key %lu corrupt", (unsigned long)key);
+        live++;
+    }
+    for (uint64_t key = 1000; key < 1000 + WORKERS * OWN_KEYS; key++) {
+        int n = usrl_map_get(&m, key, &out, sizeof(out));
+        CHECK(n == (int)sizeof(out) && value_ok(&out, key) && out.ver == 1, "own key %lu lost",
+              (unsigned long)key);
+        live++;
+    }
+    CHECK(usrl_map_count(&m) == live, "count %u, %u keys live", usrl_map_count(&m), live);
+    printf("    %u keys live, count %u\n", live, usrl_map_count(&m));
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] No torn reads; count matches.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: DEAD WRITER
+     * ========================================================================= */
+    printf("\n[PHASE 3] Writer killed while holding a bucket...\n");
+    fail_before = g_fail;
+
+    const uint64_t key_a = 1000, key_b = 1001;
+    uint32_t before = usrl_map_count(&m);
+    pid_t dead = fork();
+    if (dead == 0) _exit(0);
+    waitpid(dead, NULL, 0);
+
+    /* As a writer dying between bucket_lock() and bucket_unlock() leaves them */
+    UsrlMapBucket *ba = find_bucket(&m, key_a), *bb = find_bucket(&m, key_b);
+    CHECK(ba && bb, "buckets not found");
+    if (ba && bb) {
+        uint64_t sa = atomic_load(&ba->seq), sb = atomic_load(&bb->seq);
+        atomic_store(&ba->seq, ((sa + 1) & 0xffffffffull) | ((uint64_t)dead << 32));
+        atomic_store(&bb->seq, ((sb + 1) & 0xffffffffull) | ((uint64_t)dead << 32));
+        memset(ba + 1, 0xAB, 16); /* half-written value */
+
+        signal(SIGALRM, on_alarm);
+        alarm(10);
+        int ra = usrl_map_get(&m, key_a, &out, sizeof(out));
+        make_value(&v, key_b, 5);
+        int rb = usrl_map_put(&m, key_b, &v, sizeof(v));
+        alarm(0);
+
+        CHECK(ra == USRL_MAP_NOT_FOUND, "reader got %d from a torn bucket", ra);
+        CHECK(rb == USRL_MAP_OK, "writer got %d", rb);
+        CHECK(usrl_map_get(&m, key_b, &out, sizeof(out)) == (int)sizeof(out) && value_ok(&out, key_b) &&
+              out.ver == 5, "write after reclaim lost");
+        CHECK(!(atomic_load(&ba->seq) & 1) && !(atomic_load(&bb->seq) & 1), "buckets still locked");
+        CHECK(usrl_map_count(&m) == before - 1, "count %u, expected %u", usrl_map_count(&m), before - 1);
+
+        make_value(&v, key_a, 6);
+        CHECK(usrl_map_put(&m, key_a, &v, sizeof(v)) == USRL_MAP_OK && usrl_map_count(&m) == before,
+              "reclaimed key not writable");
+    }
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] Dead writer's buckets reclaimed by a reader and a writer.\n" COLOR_RESET);
+
+    usrl_map_close(&m);
+    shm_unlink(SHM_PATH);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
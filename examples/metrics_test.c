@@ -0,0 +1,231 @@
+/**
+ * @file metrics_test.c
+ * @brief Metrics registry: registration, updates, dump and dead registrants.
+ *
+ * VALIDATES:
+ * 1. Registration is get-or-create by name; a kind mismatch, an over-long
+ *    name or a full table returns NULL.
+ * 2. Counter / gauge / histogram updates read back exactly, and the dump
+ *    prints one line per registered metric.
+ * 3. Processes sharing an SHM table update the same cell.
+ * 4. A cell left claimed by a dead registrant is taken back instead of
+ *    stalling every later registrant.
+ * 5. Logging starts its flusher thread on the first metric, not at init.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_metrics.h"
+#include "usrl_logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_metrics_test"
+#define WORKERS 4
+#define ADDS 100000
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static void on_alarm(int sig) {
+    (void)sig;
+    static const char msg[] = "\x1b[31m[FAIL] registration stalled on a dead registrant\x1b[0m\n";
+    write(1, msg, sizeof(msg) - 1);
+    _exit(1);
+}
+
+static int thread_count(void) {
+    DIR *d = opendir("/proc/self/task");
+    if (!d) return -1;
+    int n = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL)
+        if (e->d_name[0] != '.') n++;
+    closedir(d);
+    return n;
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL METRICS REGISTRY TEST                            \n");
+    printf("========================================================\n");
+
+    /* =========================================================================
+     * PHASE 1: REGISTRATION
+     * ========================================================================= */
+    printf("\n[PHASE 1] Get-or-create by name...\n");
+
+    UsrlMetrics m;
+    if (usrl_metrics_init(&m, 8) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create a table\n" COLOR_RESET);
+        return 2;
+    }
+    UsrlMetricCell *sent = usrl_metric_counter(&m, "gw.sent");
+    UsrlMetricCell *depth = usrl_metric_gauge(&m, "gw.depth");
+    UsrlMetricCell *lat = usrl_metric_hist(&m, "gw.latency_ns");
+    CHECK(sent && depth && lat, "registration failed");
+    CHECK(usrl_metric_counter(&m, "gw.sent") == sent, "same name, different cell");
+    CHECK(usrl_metric_gauge(&m, "gw.sent") == NULL, "kind mismatch accepted");
+
+    char long_name[USRL_METRIC_NAME_MAX + 8];
+    memset(long_name, 'x', sizeof(long_name) - 1);
+    long_name[sizeof(long_name) - 1] = '\0';
+    CHECK(usrl_metric_counter(&m, long_name) == NULL, "over-long name accepted");
+    CHECK(usrl_metrics_count(&m) == 3, "%u cells registered", usrl_metrics_count(&m));
+
+    char name[32];
+    int added = 0;
+    for (int i = 0; i < 16; i++) {
+        snprintf(name, sizeof(name), "fill.%d", i);
+        if (usrl_metric_counter(&m, name)) added++;
+    }
+    CHECK(added == 5 && usrl_metrics_count(&m) == 8, "full table took %d more", added);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] One cell per name; mismatches and overflow rejected.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: UPDATES AND DUMP
+     * ========================================================================= */
+    printf("\n[PHASE 2] Counter, gauge and histogram values...\n");
+    int fail_before = g_fail;
+
+    for (int i = 0; i < 5; i++) usrl_metric_add(sent, 1);
+    usrl_metric_set(depth, 42);
+    usrl_metric_set(depth, -7);
+    for (int i = 0; i < 99; i++) usrl_metric_observe(lat, 100);  /* bucket [64, 128) */
+    usrl_metric_observe(lat, 5000);                              /* bucket [4096, 8192) */
+
+    CHECK(usrl_metric_read(sent) == 5, "counter %ld", (long)usrl_metric_read(sent));
+    CHECK(usrl_metric_read(depth) == -7, "gauge %ld", (long)usrl_metric_read(depth));
+    CHECK(usrl_metric_hist_count(lat) == 100 && usrl_metric_read(lat) == 99 * 100 + 5000,
+          "hist count %lu sum %ld", (unsigned long)usrl_metric_hist_count(lat), (long)usrl_metric_read(lat));
+    CHECK(usrl_metric_hist_quantile(lat, 0.50) == 128, "p50 bound %lu",
+          (unsigned long)usrl_metric_hist_quantile(lat, 0.50));
+    CHECK(usrl_metric_hist_quantile(lat, 0.999) == 8192, "p99.9 bound %lu",
+          (unsigned long)usrl_metric_hist_quantile(lat, 0.999));
+
+    char *text = NULL;
+    size_t text_len = 0;
+    FILE *out = open_memstream(&text, &text_len);
+    int lines = usrl_metrics_dump(&m, out);
+    fclose(out);
+    CHECK(lines == 8, "dump wrote %d lines", lines);
+    CHECK(text && strstr(text, "gw.sent=5\n") && strstr(text, "gw.depth=-7\n") &&
+          strstr(text, "gw.latency_ns count=100 sum=14900 p50<=128 p99<=8192\n"),
+          "dump text:\n%s", text ? text : "");
+    free(text);
+    usrl_metrics_free(&m);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Values and dump lines match.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: SHARED TABLE
+     * ========================================================================= */
+    printf("\n[PHASE 3] %d processes adding to one SHM counter...\n", WORKERS);
+    fail_before = g_fail;
+
+    shm_unlink(SHM_PATH);
+    if (usrl_metrics_create(SHM_PATH, 16) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    for (int w = 0; w < WORKERS; w++) {
+        if (fork() == 0) {
+            UsrlMetrics wm;
+            if (usrl_metrics_open(&wm, SHM_PATH) != 0) _exit(3);
+            UsrlMetricCell *c = usrl_metric_counter(&wm, "shared.adds");
+            if (!c) _exit(4);
+            for (int i = 0; i < ADDS; i++) usrl_metric_add(c, 1);
+            usrl_metrics_close(&wm);
+            _exit(0);
+        }
+    }
+    for (int w = 0; w < WORKERS; w++) {
+        int status = 0;
+        wait(&status);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "worker failed (%d)", status);
+    }
+
+    UsrlMetrics shm;
+    CHECK(usrl_metrics_open(&shm, SHM_PATH) == 0, "open failed");
+    UsrlMetricCell *adds = usrl_metric_counter(&shm, "shared.adds");
+    CHECK(adds && usrl_metric_read(adds) == (int64_t)WORKERS * ADDS, "shared counter %ld",
+          (long)usrl_metric_read(adds));
+    CHECK(usrl_metrics_count(&shm) == 1, "%u cells for one name", usrl_metrics_count(&shm));
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] %d adds aggregated in one cell.\n" COLOR_RESET, WORKERS * ADDS);
+
+    /* =========================================================================
+     * PHASE 4: DEAD REGISTRANT
+     * ========================================================================= */
+    printf("\n[PHASE 4] Every free cell left claimed by a dead process...\n");
+    fail_before = g_fail;
+
+    pid_t dead = fork();
+    if (dead == 0) _exit(0);
+    waitpid(dead, NULL, 0);
+
+    /* The registrant died between claiming and naming, in every free cell */
+    for (uint32_t i = 0; i <= shm.mask; i++) {
+        uint_fast32_t expected = 0;
+        atomic_compare_exchange_strong(&shm.cells[i].state, &expected, USRL_METRIC_CLAIMING | (uint32_t)dead);
+    }
+
+    signal(SIGALRM, on_alarm);
+    alarm(10);
+    UsrlMetricCell *late = usrl_metric_gauge(&shm, "late.gauge");
+    UsrlMetricCell *again = usrl_metric_counter(&shm, "shared.adds");
+    alarm(0);
+    CHECK(late != NULL, "cell not reclaimed");
+    CHECK(again == adds, "existing cell not found past claimed cells");
+    if (late) {
+        usrl_metric_set(late, 9);
+        CHECK(usrl_metric_read(late) == 9 && strcmp(late->name, "late.gauge") == 0, "reclaimed cell unusable");
+    }
+    CHECK(usrl_metrics_count(&shm) == 2, "%u cells registered", usrl_metrics_count(&shm));
+    usrl_metrics_close(&shm);
+    shm_unlink(SHM_PATH);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Dead claims reclaimed, no stall.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 5: LAZY FLUSHER
+     * ========================================================================= */
+    printf("\n[PHASE 5] Logging flusher thread...\n");
+    fail_before = g_fail;
+
+    int base = thread_count();
+    usrl_logging_init("/dev/null", USRL_LOG_INFO);
+    CHECK(thread_count() == base, "flusher started with no metrics (%d threads)", thread_count());
+    usrl_log_metric("test", "value", 1);
+    CHECK(thread_count() == base + 1, "no flusher after the first metric (%d threads)", thread_count());
+    usrl_log_metric("test", "other", 2);
+    CHECK(thread_count() == base + 1, "second flusher started");
+    usrl_logging_shutdown();
+    CHECK(thread_count() == base, "flusher still running after shutdown");
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Flusher starts with the first metric.\n" COLOR_RESET);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,251 @@
+/**
+ * @file pipeline_test.c
+ * @brief Pipeline compiler and executor: fusion, routing and join output.
+ *
+ * VALIDATES:
+ * 1. Same-thread single-consumer edges are fused: no ring is created for
+ *    them and the consumer reports its input as fused.
+ * 2. The router sends each key to its route's topic and drops keys with no
+ *    route; stage in / out / dropped counts match.
+ * 3. A fused json -> router -> join chain publishes as-of joined records
+ *    carrying the prevailing quote.
+ * 4. A ring-fed join reads a bounded number of right batches per poll, so
+ *    a right-side backlog does not hold back the left side.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_pipeline.h"
+#include "usrl_join.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_pipeline_test"
+#define BACKLOG 5000 /* right-side quotes queued before one left trade */
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+typedef struct __attribute__((packed)) {
+    char symbol[8];
+    double price;
+    uint64_t qty;
+} Trade;
+
+typedef struct __attribute__((packed)) {
+    char symbol[8];
+    double bid;
+    double ask;
+} Quote;
+
+typedef struct __attribute__((packed)) {
+    UsrlJoinHeader h;
+    Trade t;
+    Quote q;
+} Joined;
+
+static const char *g_config =
+    "{ \"core\": \"" SHM_PATH "\", \"memory_size_mb\": 8,"
+    "  \"topics\": ["
+    "    { \"name\": \"p_json\",    \"slots\": 1024, \"payload_size\": 256 },"
+    "    { \"name\": \"p_quotes\",  \"slots\": 1024, \"payload_size\": 64 },"
+    "    { \"name\": \"p_out_b\",   \"slots\": 1024, \"payload_size\": 64 },"
+    "    { \"name\": \"p_joined\",  \"slots\": 1024, \"payload_size\": 128 },"
+    "    { \"name\": \"p_trades\",  \"slots\": 1024, \"payload_size\": 64 },"
+    "    { \"name\": \"p_quotes2\", \"slots\": 8192, \"payload_size\": 64 },"
+    "    { \"name\": \"p_joined2\", \"slots\": 1024, \"payload_size\": 128 } ],"
+    "  \"schemas\": ["
+    "    { \"name\": \"trade\", \"fields\": [ { \"name\": \"symbol\", \"type\": \"string\", \"size\": 8 },"
+    "        { \"name\": \"price\", \"type\": \"f64\" }, { \"name\": \"qty\", \"type\": \"u64\" } ] },"
+    "    { \"name\": \"quote\", \"fields\": [ { \"name\": \"symbol\", \"type\": \"string\", \"size\": 8 },"
+    "        { \"name\": \"bid\", \"type\": \"f64\" }, { \"name\": \"ask\", \"type\": \"f64\" } ] } ],"
+    "  \"threads\": [ { \"name\": \"main\" } ],"
+    "  \"stages\": ["
+    "    { \"name\": \"parse\", \"op\": \"json\", \"in\": \"p_json\", \"out\": \"trades\", \"schema\": \"trade\" },"
+    "    { \"name\": \"route\", \"op\": \"router\", \"in\": \"trades\", \"schema\": \"trade\", \"key\": \"symbol\","
+    "      \"routes\": { \"AAA\": \"trades_a\", \"BBB\": \"p_out_b\" } },"
+    "    { \"name\": \"join\", \"op\": \"join\", \"left\": \"trades_a\", \"right\": \"p_quotes\","
+    "      \"left_schema\": \"trade\", \"right_schema\": \"quote\", \"key\": \"symbol\", \"out\": \"p_joined\" },"
+    "    { \"name\": \"join2\", \"op\": \"join\", \"left\": \"p_trades\", \"right\": \"p_quotes2\","
+    "      \"left_schema\": \"trade\", \"right_schema\": \"quote\", \"key\": \"symbol\", \"out\": \"p_joined2\" } ] }";
+
+static int find_stage(const UsrlPipeStageStats *st, int n, const char *name) {
+    for (int i = 0; i < n; i++)
+        if (strcmp(st[i].name, name) == 0) return i;
+    return 0;
+}
+
+static void publish_quote(UsrlPublisher *pub, const char *sym, double bid, double ask) {
+    Quote q = { .bid = bid, .ask = ask };
+    strncpy(q.symbol, sym, sizeof(q.symbol));
+    usrl_pub_publish(pub, &q, sizeof(q));
+}
+
+static void publish_json(UsrlPublisher *pub, const char *sym, double price, uint64_t qty) {
+    char buf[128];
+    int n = snprintf(buf, sizeof(buf), "{\"symbol\":\"%s\",\"price\":%.2f,\"qty\":%lu}", sym, price,
+                     (unsigned long)qty);
+    usrl_pub_publish(pub, buf, (uint32_t)n);
+}
+
+static void poll_idle(UsrlPipeline *p) {
+    while (usrl_pipeline_poll(p, 0) > 0) {}
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL PIPELINE EXECUTOR TEST                           \n");
+    printf("========================================================\n");
+
+    shm_unlink(SHM_PATH);
+    char err[256] = "";
+    UsrlPipeline *p = usrl_pipeline_load(g_config, err, sizeof(err));
+    if (!p || usrl_pipeline_open(p, err, sizeof(err)) != 0) {
+        printf(COLOR_RED "[FAIL] pipeline setup: %s\n" COLOR_RESET, err);
+        return 2;
+    }
+    void *core = usrl_core_map(SHM_PATH, 0);
+
+    /* =========================================================================
+     * PHASE 1: FUSION
+     * ========================================================================= */
+    printf("\n[PHASE 1] Compiling json -> router -> join on one thread...\n");
+
+    UsrlTopicConfig topics[USRL_PIPE_MAX_TOPICS];
+    int nt = usrl_pipeline_topics(p, topics, USRL_PIPE_MAX_TOPICS);
+    CHECK(nt == 7, "%d topics, expected the 7 declared ones only", nt);
+    for (int i = 0; i < nt && i < USRL_PIPE_MAX_TOPICS; i++)
+        CHECK(strcmp(topics[i].name, "trades") != 0 && strcmp(topics[i].name, "trades_a") != 0,
+              "fused edge %s got a ring", topics[i].name);
+
+    UsrlPipeStageStats st[8];
+    int ns = usrl_pipeline_stats(p, st, 8);
+    CHECK(ns == 4, "%d stages", ns);
+    CHECK(st[find_stage(st, ns, "parse")].fused == 0, "parse input fused");
+    CHECK(st[find_stage(st, ns, "route")].fused == 1, "router input not fused");
+    CHECK(st[find_stage(st, ns, "join")].fused == 1, "join left input not fused");
+    CHECK(st[find_stage(st, ns, "join2")].fused == 0, "join2 inputs fused");
+    if (!g_fail) printf(COLOR_GREEN "[PASS] trades / trades_a fused, no rings created.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: ROUTER AND JOIN
+     * ========================================================================= */
+    printf("\n[PHASE 2] Quotes, then AAA / BBB / CCC trades...\n");
+    int fail_before = g_fail;
+
+    UsrlPublisher pj, pq;
+    usrl_pub_init(&pj, core, "p_json", 1);
+    usrl_pub_init(&pq, core, "p_quotes", 2);
+    publish_quote(&pq, "AAA", 9.5, 10.5);
+    publish_quote(&pq, "AAA", 10.0, 11.0); /* prevailing */
+    poll_idle(p);
+
+    publish_json(&pj, "AAA", 10.25, 3);
+    publish_json(&pj, "BBB", 20.5, 7);
+    publish_json(&pj, "CCC", 30.0, 1); /* no route */
+    publish_json(&pj, "AAA", 10.75, 4);
+    poll_idle(p);
+
+    UsrlSubscriber sb, sj;
+    usrl_sub_init(&sb, core, "p_out_b");
+    usrl_sub_init(&sj, core, "p_joined");
+    uint8_t buf[256];
+    int n;
+
+    int b_count = 0;
+    while ((n = usrl_sub_next(&sb, buf, sizeof(buf), NULL)) > 0) {
+        Trade t;
+        memcpy(&t, buf, sizeof(t));
+        CHECK(n == (int)sizeof(Trade) && strcmp(t.symbol, "BBB") == 0 && t.price == 20.5 && t.qty == 7,
+              "p_out_b: %.8s %.2f x %lu (%d bytes)", t.symbol, t.price, (unsigned long)t.qty, n);
+        b_count++;
+    }
+    CHECK(b_count == 1, "%d records routed to p_out_b", b_count);
+
+    int j_count = 0;
+    static const double prices[] = { 10.25, 10.75 };
+    while ((n = usrl_sub_next(&sj, buf, sizeof(buf), NULL)) > 0) {
+        Joined j;
+        memcpy(&j, buf, sizeof(j));
+        CHECK(n == (int)sizeof(Joined), "joined record is %d bytes", n);
+        CHECK(j.h.flags & USRL_JOIN_F_MATCHED, "trade %d unmatched", j_count);
+        CHECK(strcmp(j.t.symbol, "AAA") == 0 && strcmp(j.q.symbol, "AAA") == 0, "joined %.8s / %.8s",
+              j.t.symbol, j.q.symbol);
+        CHECK(j_count < 2 && j.t.price == prices[j_count], "trade %d price %.2f", j_count, j.t.price);
+        CHECK(j.q.bid == 10.0 && j.q.ask == 11.0 && j.h.right_ns <= j.h.left_ns,
+              "trade %d joined quote %.2f/%.2f, not the prevailing one", j_count, j.q.bid, j.q.ask);
+        j_count++;
+    }
+    CHECK(j_count == 2, "%d joined records", j_count);
+
+    ns = usrl_pipeline_stats(p, st, 8);
+    const UsrlPipeStageStats *r = &st[find_stage(st, ns, "route")];
+    CHECK(r->in == 4 && r->out == 3 && r->dropped == 1, "router in %lu out %lu dropped %lu",
+          (unsigned long)r->in, (unsigned long)r->out, (unsigned long)r->dropped);
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] BBB routed, CCC dropped, AAA joined with the prevailing quote.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: BOUNDED RIGHT DRAIN
+     * ========================================================================= */
+    printf("\n[PHASE 3] %d queued quotes ahead of one trade on ring inputs...\n", BACKLOG);
+    fail_before = g_fail;
+
+    UsrlPublisher pt, pq2;
+    usrl_pub_init(&pt, core, "p_trades", 3);
+    usrl_pub_init(&pq2, core, "p_quotes2", 4);
+    for (int i = 1; i <= BACKLOG; i++) publish_quote(&pq2, "AAA", (double)i, (double)i + 1);
+    Trade t = { .price = 5.0, .qty = 1 };
+    strncpy(t.symbol, "AAA", sizeof(t.symbol));
+    usrl_pub_publish(&pt, &t, sizeof(t));
+
+    usrl_pipeline_poll(p, 0);
+
+    UsrlSubscriber sj2;
+    usrl_sub_init(&sj2, core, "p_joined2");
+    Joined j;
+    n = usrl_sub_next(&sj2, buf, sizeof(buf), NULL);
+    memcpy(&j, buf, sizeof(j));
+    CHECK(n == (int)sizeof(Joined), "trade not joined in the first poll (%d)", n);
+    CHECK(j.q.bid >= 1 && j.q.bid < BACKLOG, "first poll drained %.0f of %d quotes", j.q.bid, BACKLOG);
+
+    ns = usrl_pipeline_stats(p, st, 8);
+    uint64_t lag = st[find_stage(st, ns, "join2")].lag;
+    CHECK(lag > 0 && lag < BACKLOG, "lag after one poll %lu", (unsigned long)lag);
+    printf("    first poll joined against quote %.0f, %lu quotes still queued\n", j.q.bid, (unsigned long)lag);
+
+    poll_idle(p);
+    ns = usrl_pipeline_stats(p, st, 8);
+    CHECK(st[find_stage(st, ns, "join2")].lag == 0, "right side not drained on later polls");
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] Left record served before the right backlog was drained.\n" COLOR_RESET);
+
+    usrl_pipeline_free(p);
+    usrl_core_unmap(core, ((CoreHeader *)core)->mmap_size);
+    shm_unlink(SHM_PATH);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file policy_test.c
+ * @brief Live topic policy: seqlock updates, torn reads, dead writers.
+ *
+ * VALIDATES:
+ * 1. Updates set only the flagged fields, clear flags on request, and move
+ *    the version by 2 each time.
+ * 2. With writer and reader processes racing, readers never see a policy
+ *    mixed from two updates, versions only move forward, and no update is
+ *    lost between writers.
+ * 3. A lock left odd by a dead writer makes reads and updates fail instead
+ *    of hanging; usrl_policy_reset() drops the half-written policy and
+ *    updates work again.
+ * 4. A facade publisher picks up a live rate limit within one check
+ *    interval and drops back to unlimited when it is cleared.
+ */
+
+#define _GNU_SOURCE
+#include "usrl.h"
+#include "usrl_core.h"
+#include "usrl_backpressure.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_policy_test"
+#define SHM_SIZE (4u << 20)
+#define TOPIC "pol"
+#define WRITERS 2
+#define READERS 2
+#define UPDATES 100000
+#define FACADE_TOPIC "policy_test"
+#define FACADE_SHM_MB 8
+#define SENDS 6400
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+typedef struct {
+    atomic_int writers_done;
+    uint64_t reads[READERS];
+    uint64_t busy[READERS];
+    uint64_t torn[READERS];
+    uint64_t backwards[READERS];
+} Shared;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Every update writes a self-consistent triple derived from one value */
+static void writer(UsrlTopicCtl *ctl, int w) {
+    for (uint64_t i = 1; i <= UPDATES; i++) {
+        uint64_t x = ((uint64_t)(w + 1) << 32) | i;
+        UsrlPolicy set = { .flags = USRL_POLICY_RATE | USRL_POLICY_BP | USRL_POLICY_LAG,
+                           .bp_mode = (x & 1) ? USRL_BP_BLOCK : USRL_BP_DROP,
+                           .rate_limit_hz = x,
+                           .lag_threshold = x * 3 + 1 };
+        if (usrl_policy_update(ctl, &set, 0) != 0) _exit(1);
+    }
+    _exit(0);
+}
+
+static void reader(UsrlTopicCtl *ctl, Shared *sh, int r) {
+    uint64_t last = 0;
+    while (!atomic_load(&sh->writers_done)) {
+        UsrlPolicy pol;
+        uint64_t v;
+        if (usrl_policy_read(ctl, &pol, &v) != 0) {
+            sh->busy[r]++;
+            continue;
+        }
+        sh->reads[r]++;
+        if ((v & 1) || v < last) sh->backwards[r]++;
+        last = v;
+        if (pol.flags == 0) continue;
+        UsrlBackpressureMode bp = (pol.rate_limit_hz & 1) ? USRL_BP_BLOCK : USRL_BP_DROP;
+        if (pol.lag_threshold != pol.rate_limit_hz * 3 + 1 || pol.bp_mode != bp) sh->torn[r]++;
+    }
+    _exit(0);
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL LIVE POLICY TEST                                 \n");
+    printf("========================================================\n");
+
+    shm_unlink(SHM_PATH);
+    UsrlTopicConfig cfg = { .name = TOPIC, .slot_count = 64, .slot_size = 64, .type = USRL_RING_TYPE_SWMR };
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, &cfg, 1) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    void *base = usrl_core_map(SHM_PATH, SHM_SIZE);
+    UsrlTopicCtl *ctl = base ? usrl_topic_ctl(base, usrl_get_topic(base, TOPIC)) : NULL;
+    if (!ctl) {
+        printf(COLOR_RED "[FAIL] no control block in %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+
+    /* =========================================================================
+     * PHASE 1: SEMANTICS
+     * ========================================================================= */
+    printf("\n[PHASE 1] Set, merge and clear fields...\n");
+
+    UsrlPolicy pol;
+    uint64_t v = 99;
+    CHECK(usrl_policy_read(ctl, &pol, &v) == 0 && v == 0 && pol.flags == 0, "fresh policy: v%lu flags %#x",
+          (unsigned long)v, pol.flags);
+
+    UsrlPolicy set = { .flags = USRL_POLICY_RATE, .rate_limit_hz = 5000 };
+    CHECK(usrl_policy_update(ctl, &set, 0) == 0 && usrl_policy_version(ctl) == 2, "rate update");
+    set = (UsrlPolicy){ .flags = USRL_POLICY_BP, .bp_mode = USRL_BP_DROP, .rate_limit_hz = 1 };
+    CHECK(usrl_policy_update(ctl, &set, 0) == 0 && usrl_policy_version(ctl) == 4, "bp update");
+    CHECK(usrl_policy_read(ctl, &pol, &v) == 0 && v == 4 && pol.flags == (USRL_POLICY_RATE | USRL_POLICY_BP) &&
+          pol.rate_limit_hz == 5000 && pol.bp_mode == USRL_BP_DROP,
+          "merged: flags %#x rate %lu bp %d", pol.flags, (unsigned long)pol.rate_limit_hz, (int)pol.bp_mode);
+
+    CHECK(usrl_policy_update(ctl, NULL, USRL_POLICY_RATE) == 0, "clear rate");
+    CHECK(usrl_policy_read(ctl, &pol, &v) == 0 && v == 6 && pol.flags == USRL_POLICY_BP, "cleared: v%lu flags %#x",
+          (unsigned long)v, pol.flags);
+    CHECK(usrl_policy_reset(ctl) == 0 && usrl_policy_read(ctl, &pol, &v) == 0 && v == 8 && pol.flags == 0,
+          "reset: v%lu flags %#x", (unsigned long)v, pol.flags);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Flagged fields only, version +2 per update.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: RACING WRITERS AND READERS
+     * ========================================================================= */
+    printf("\n[PHASE 2] %d writers x %d updates against %d readers...\n", WRITERS, UPDATES, READERS);
+    int fail_before = g_fail;
+
+    Shared *sh = mmap(NULL, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sh == MAP_FAILED) return 2;
+    memset(sh, 0, sizeof(*sh));
+    uint64_t v0 = usrl_policy_version(ctl);
+
+    pid_t readers[READERS];
+    for (int r = 0; r < READERS; r++)
+        if ((readers[r] = fork()) == 0) reader(ctl, sh, r);
+    pid_t writers[WRITERS];
+    for (int w = 0; w < WRITERS; w++)
+        if ((writers[w] = fork()) == 0) writer(ctl, w);
+
+    for (int w = 0; w < WRITERS; w++) {
+        int status = 0;
+        waitpid(writers[w], &status, 0);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "writer failed (%d)", status);
+    }
+    atomic_store(&sh->writers_done, 1);
+    for (int r = 0; r < READERS; r++) waitpid(readers[r], NULL, 0);
+
+    uint64_t reads = 0, busy = 0, torn = 0, backwards = 0;
+    for (int r = 0; r < READERS; r++) {
+        reads += sh->reads[r];
+        busy += sh->busy[r];
+        torn += sh->torn[r];
+        backwards += sh->backwards[r];
+    }
+    printf("    %lu reads, %lu found the writer busy\n", (unsigned long)reads, (unsigned long)busy);
+    CHECK(reads > 0, "no successful reads");
+    CHECK(torn == 0, "%lu torn reads", (unsigned long)torn);
+    CHECK(backwards == 0, "%lu reads saw an odd or older version", (unsigned long)backwards);
+    CHECK(usrl_policy_version(ctl) == v0 + 2ull * WRITERS * UPDATES, "version %lu, expected %lu",
+          (unsigned long)usrl_policy_version(ctl), (unsigned long)(v0 + 2ull * WRITERS * UPDATES));
+    munmap(sh, sizeof(Shared));
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] No torn reads, no lost updates.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: DEAD WRITER
+     * ========================================================================= */
+    printf("\n[PHASE 3] Lock left odd with a half-written policy...\n");
+    fail_before = g_fail;
+
+    uint64_t held = atomic_fetch_add(&ctl->version, 1) + 1;
+    ctl->rate_limit_hz = 7;
+
+    uint64_t t0 = now_ns();
+    CHECK(usrl_policy_read(ctl, &pol, &v) == -1, "read succeeded under a held lock");
+    set = (UsrlPolicy){ .flags = USRL_POLICY_LAG, .lag_threshold = 10 };
+    CHECK(usrl_policy_update(ctl, &set, 0) == -1, "update succeeded under a held lock");
+    uint64_t waited_ms = (now_ns() - t0) / 1000000ull;
+    CHECK(waited_ms < 5000, "gave up after %lu ms", (unsigned long)waited_ms);
+
+    CHECK(usrl_policy_reset(ctl) == 0, "reset failed");
+    CHECK(usrl_policy_read(ctl, &pol, &v) == 0 && v == held + 1 && pol.flags == 0, "after reset: v%lu flags %#x",
+          (unsigned long)v, pol.flags);
+    CHECK(usrl_policy_update(ctl, &set, 0) == 0 && usrl_policy_read(ctl, &pol, &v) == 0 &&
+          pol.flags == USRL_POLICY_LAG && pol.lag_threshold == 10, "update after reset");
+    usrl_core_unmap(base, SHM_SIZE);
+    shm_unlink(SHM_PATH);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Dead writer's lock broken, policy dropped.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 4: FACADE PUBLISHER
+     * ========================================================================= */
+    printf("\n[PHASE 4] Unlimited publisher, live 1 kHz limit, then cleared...\n");
+    fail_before = g_fail;
+
+    usrl_set_default_shm_size_mb(FACADE_SHM_MB);
+    shm_unlink("/usrl-" FACADE_TOPIC);
+    usrl_sys_config_t sys = { .app_name = "policy_test", .log_level = USRL_LOG_ERROR };
+    usrl_ctx_t *ctx = usrl_init(&sys);
+    usrl_pub_config_t pc = { .topic = FACADE_TOPIC, .slot_count = 4096, .slot_size = 64, .block_on_full = false };
+    usrl_pub_t *fp = ctx ? usrl_pub_create(ctx, &pc) : NULL;
+    void *fbase = usrl_core_map("/usrl-" FACADE_TOPIC, 0);
+    UsrlTopicCtl *fctl = fbase ? usrl_topic_ctl(fbase, usrl_get_topic(fbase, FACADE_TOPIC)) : NULL;
+    if (!fp || !fctl) {
+        printf(COLOR_RED "[FAIL] cannot create the facade publisher\n" COLOR_RESET);
+        return 2;
+    }
+
+    uint64_t msg = 0;
+    int sent = 0;
+    for (int i = 0; i < SENDS; i++) sent += usrl_pub_send(fp, &msg, sizeof(msg)) == 0;
+    CHECK(sent == SENDS, "unlimited: %d of %d sent", sent, SENDS);
+
+    /* 1 kHz = one message per 1 ms window once the next check applies it */
+    set = (UsrlPolicy){ .flags = USRL_POLICY_RATE, .rate_limit_hz = 1000 };
+    usrl_policy_update(fctl, &set, 0);
+    t0 = now_ns();
+    sent = 0;
+    for (int i = 0; i < SENDS; i++) sent += usrl_pub_send(fp, &msg, sizeof(msg)) == 0;
+    uint64_t elapsed_ms = (now_ns() - t0) / 1000000ull;
+    CHECK(sent <= 64 + (int)elapsed_ms + 2, "limited: %d of %d sent in %lu ms", sent, SENDS,
+          (unsigned long)elapsed_ms);
+    printf("    limited: %d of %d sent in %lu ms\n", sent, SENDS, (unsigned long)elapsed_ms);
+
+    usrl_policy_update(fctl, NULL, USRL_POLICY_RATE);
+    sent = 0;
+    for (int i = 0; i < SENDS; i++) sent += usrl_pub_send(fp, &msg, sizeof(msg)) == 0;
+    CHECK(sent >= SENDS - 64, "cleared: %d of %d sent", sent, SENDS);
+
+    usrl_pub_destroy(fp);
+    usrl_shutdown(ctx);
+    usrl_core_unmap(fbase, (size_t)FACADE_SHM_MB << 20);
+    shm_unlink("/usrl-" FACADE_TOPIC);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Live rate limit applied and lifted.\n" COLOR_RESET);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file reorder_test.c
+ * @brief MWMR reorder subscriber: reading past holes and the hole timeout.
+ *
+ * VALIDATES:
+ * 1. Committed slots behind an uncommitted claim are delivered without
+ *    waiting for it, and counted in reordered_count.
+ * 2. A hole open past hole_timeout_ns is reported exactly once as
+ *    USRL_RING_SKIPPED; a commit arriving after that is not delivered.
+ * 3. A hole committed before the timeout is delivered in place.
+ * 4. Nothing further than `window` seqs past the oldest hole is delivered
+ *    until the hole resolves.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_reorder_test"
+#define SHM_SIZE (1u << 20)
+#define TOPIC "otest"
+#define WINDOW 16
+#define HOLE_TIMEOUT_NS 20000000ull /* 20 ms */
+#define MAX_SEQ 64
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static uint32_t g_delivered[MAX_SEQ + 1]; /* deliveries per seq */
+static uint32_t g_skipped[MAX_SEQ + 1];   /* USRL_RING_SKIPPED reports per seq */
+
+static void sleep_ns(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    nanosleep(&ts, NULL);
+}
+
+/* A writer that claimed a seq and has not committed it yet */
+static uint64_t claim(RingDesc *d) {
+    return atomic_fetch_add_explicit(&d->w_head, 1, memory_order_acq_rel) + 1;
+}
+
+/* That writer finally committing, as mwmr_publish() does */
+static void commit(UsrlReorderSubscriber *r, uint64_t seq) {
+    RingDesc *d = r->sub.desc;
+    uint8_t *slot = r->sub.base_ptr + ((seq - 1) & r->sub.mask) * d->slot_size;
+    SlotHeader *hdr = (SlotHeader *)slot;
+    memcpy(slot + sizeof(SlotHeader), &seq, sizeof(seq));
+    hdr->payload_len = sizeof(seq);
+    hdr->pub_id = 2;
+    hdr->flags = 0;
+    hdr->timestamp_ns = 0;
+    atomic_store_explicit(&hdr->seq, seq, memory_order_release);
+}
+
+static void publish(UsrlMwmrPublisher *pub, uint64_t from, uint64_t to) {
+    for (uint64_t i = from; i <= to; i++) usrl_mwmr_pub_publish(pub, &i, sizeof(i));
+}
+
+/* Read until NO_DATA; returns the number of results handled */
+static int drain(UsrlReorderSubscriber *r) {
+    uint8_t buf[64];
+    int handled = 0;
+    for (;;) {
+        uint64_t seq = 0;
+        int n = usrl_reorder_sub_next(r, buf, sizeof(buf), NULL, &seq);
+        if (n == USRL_RING_NO_DATA) return handled;
+        handled++;
+        if (seq == 0 || seq > MAX_SEQ) {
+            CHECK(0, "result %d for seq %lu", n, (unsigned long)seq);
+            return handled;
+        }
+        if (n == USRL_RING_SKIPPED) {
+            g_skipped[seq]++;
+            continue;
+        }
+        uint64_t v = 0;
+        if (n == sizeof(v)) memcpy(&v, buf, sizeof(v));
+        CHECK(n == sizeof(v) && v == seq, "seq %lu: result %d, payload %lu", (unsigned long)seq, n,
+              (unsigned long)v);
+        g_delivered[seq]++;
+    }
+}
+
+/* Every seq in [from, to] delivered once and never skipped, except `hole` (0 = none) */
+static void expect_range(uint64_t from, uint64_t to, uint64_t hole) {
+    for (uint64_t s = from; s <= to; s++) {
+        if (s == hole) continue;
+        CHECK(g_delivered[s] == 1 && g_skipped[s] == 0, "seq %lu delivered %u times, skipped %u times",
+              (unsigned long)s, g_delivered[s], g_skipped[s]);
+    }
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL REORDER HOLE TIMEOUT TEST                        \n");
+    printf("========================================================\n");
+
+    shm_unlink(SHM_PATH);
+    UsrlTopicConfig cfg = { .slot_count = 128, .slot_size = 64, .type = USRL_RING_TYPE_MWMR };
+    snprintf(cfg.name, sizeof(cfg.name), "%s", TOPIC);
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, &cfg, 1) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    void *core = usrl_core_map(SHM_PATH, SHM_SIZE);
+
+    UsrlMwmrPublisher pub;
+    UsrlReorderSubscriber r;
+    usrl_mwmr_pub_init(&pub, core, TOPIC, 1);
+    usrl_reorder_sub_init(&r, core, TOPIC, WINDOW, HOLE_TIMEOUT_NS);
+    if (!pub.desc || !r.sub.desc) {
+        printf(COLOR_RED "[FAIL] topic %s not mapped\n" COLOR_RESET, TOPIC);
+        return 2;
+    }
+    RingDesc *d = pub.desc;
+
+    /* =========================================================================
+     * PHASE 1: READ PAST A HOLE
+     * ========================================================================= */
+    printf("\n[PHASE 1] Seq 6 claimed but not committed, 7..10 committed...\n");
+
+    publish(&pub, 1, 5);
+    uint64_t hole = claim(d);
+    publish(&pub, 7, 10);
+    CHECK(hole == 6, "claimed seq %lu, expected 6", (unsigned long)hole);
+
+    drain(&r);
+    expect_range(1, 10, 6);
+    CHECK(g_delivered[6] == 0 && g_skipped[6] == 0, "hole reported before its timeout");
+    CHECK(r.reordered_count == 4 && r.sub.last_seq == 5, "reordered %lu, base %lu (expected 4, 5)",
+          (unsigned long)r.reordered_count, (unsigned long)r.sub.last_seq);
+    CHECK(drain(&r) == 0, "results before the hole timed out");
+    if (!g_fail) printf(COLOR_GREEN "[PASS] 7..10 delivered ahead of the hole.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: HOLE TIMEOUT
+     * ========================================================================= */
+    printf("\n[PHASE 2] Waiting out the hole timeout...\n");
+    int fail_before = g_fail;
+
+    sleep_ns(HOLE_TIMEOUT_NS + HOLE_TIMEOUT_NS / 2);
+    CHECK(drain(&r) == 1 && g_skipped[6] == 1, "hole reported %u times", g_skipped[6]);
+    CHECK(r.sub.last_seq == 10 && r.sub.skipped_count == 1, "base %lu, skipped %lu (expected 10, 1)",
+          (unsigned long)r.sub.last_seq, (unsigned long)r.sub.skipped_count);
+
+    commit(&r, 6); /* the stalled writer wakes up */
+    drain(&r);
+    CHECK(g_delivered[6] == 0 && g_skipped[6] == 1, "late commit of a skipped seq was delivered");
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] Hole skipped once; its late commit ignored.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: COMMIT BEFORE THE TIMEOUT
+     * ========================================================================= */
+    printf("\n[PHASE 3] Seq 11 committed late, within the timeout...\n");
+    fail_before = g_fail;
+
+    hole = claim(d);
+    publish(&pub, 12, 13);
+    drain(&r);
+    CHECK(g_delivered[12] == 1 && g_delivered[13] == 1 && !g_delivered[11], "12..13 not read past 11");
+
+    commit(&r, hole);
+    drain(&r);
+    expect_range(11, 13, 0);
+    CHECK(r.sub.last_seq == 13 && r.sub.skipped_count == 1, "base %lu, skipped %lu (expected 13, 1)",
+          (unsigned long)r.sub.last_seq, (unsigned long)r.sub.skipped_count);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Late commit delivered in place.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 4: WINDOW BOUND
+     * ========================================================================= */
+    printf("\n[PHASE 4] Seq 14 open with 15..40 committed behind it, window %d...\n", WINDOW);
+    fail_before = g_fail;
+
+    hole = claim(d);
+    publish(&pub, 15, 40);
+    drain(&r);
+    expect_range(15, 14 + WINDOW - 1, 0);
+    for (uint64_t s = 14 + WINDOW; s <= 40; s++)
+        CHECK(!g_delivered[s], "seq %lu delivered beyond the window", (unsigned long)s);
+
+    sleep_ns(HOLE_TIMEOUT_NS + HOLE_TIMEOUT_NS / 2);
+    drain(&r);
+    CHECK(g_skipped[14] == 1 && !g_delivered[14], "hole 14 reported %u times", g_skipped[14]);
+    expect_range(15, 40, 0);
+    CHECK(r.sub.last_seq == 40 && r.sub.skipped_count == 2, "base %lu, skipped %lu (expected 40, 2)",
+          (unsigned long)r.sub.last_seq, (unsigned long)r.sub.skipped_count);
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] Reads held at the window until the hole timed out.\n" COLOR_RESET);
+
+    printf("\n    reordered %lu, skipped %lu\n", (unsigned long)r.reordered_count,
+           (unsigned long)r.sub.skipped_count);
+    shm_unlink(SHM_PATH);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,344 @@
+/**
+ * @file replay_test.c
+ * @brief Replay subscriber: journal -> ring handover and lapped fallback.
+ *
+ * VALIDATES:
+ * 1. Replaying from seq 1 reads the journal, hands over to the ring once it
+ *    holds the next seq, and delivers every seq exactly once.
+ * 2. A live reader lapped by the ring falls back to the journal for the
+ *    missed seqs and returns to the ring, with no gaps or duplicates.
+ * 3. A journal gap the ring still covers is read from the ring; one it no
+ *    longer covers is counted in gap_count.
+ * 4. A ring that has not reached a journal gap yet (recreated region) does
+ *    not take over from the journal.
+ * 5. Traced messages keep their trace context through the journal, on
+ *    journal and ring views alike; an untraced append clears the flag.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_replay_test"
+#define SHM_SIZE (4u << 20)
+#define SLOTS 64
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+typedef struct {
+    uint64_t count;
+    uint64_t last;
+    uint64_t dups;
+    uint64_t holes;          /* missing seqs, outside the expected ones */
+    uint64_t bad_payload;
+} Seen;
+
+/* One delivery: seqs ascend by one except across the allowed gap [lo, hi] */
+static void see(Seen *s, uint64_t seq, const void *data, uint32_t len, uint64_t lo, uint64_t hi) {
+    uint64_t v = 0;
+    if (len == sizeof(v)) memcpy(&v, data, sizeof(v));
+    if (v != seq) s->bad_payload++;
+
+    if (s->count && seq <= s->last) s->dups++;
+    else if (s->count && seq != s->last + 1 && !(s->last + 1 == lo && seq == hi + 1)) s->holes++;
+    if (seq > s->last) s->last = seq;
+    s->count++;
+}
+
+/* Drain with usrl_replay_next() until nothing is pending */
+static void drain_next(UsrlReplaySubscriber *r, Seen *s, uint64_t lo, uint64_t hi) {
+    uint8_t buf[64];
+    uint64_t seq;
+    int n;
+    while ((n = usrl_replay_next(r, buf, sizeof(buf), NULL, &seq)) >= 0) see(s, seq, buf, (uint32_t)n, lo, hi);
+    CHECK(n == USRL_RING_NO_DATA, "replay_next returned %d", n);
+}
+
+/* Drain with usrl_replay_batch(), rejecting overwritten ring views */
+static void drain_batch(UsrlReplaySubscriber *r, Seen *s) {
+    UsrlSlotView v[16];
+    int n;
+    while ((n = usrl_replay_batch(r, v, 16)) > 0) {
+        for (int i = 0; i < n; i++) {
+            CHECK(usrl_replay_view_valid(&v[i]), "seq %lu overwritten while held", (unsigned long)v[i].seq);
+            see(s, v[i].seq, v[i].data, v[i].len, 0, 0);
+        }
+    }
+    CHECK(n == 0, "replay_batch returned %d", n);
+}
+
+/* Publish [from, to], recording every few messages so the recorder is never lapped */
+static void publish(UsrlPublisher *pub, UsrlJournalWriter *w, UsrlSubscriber *rec, uint64_t from, uint64_t to) {
+    for (uint64_t i = from; i <= to; i++) {
+        usrl_pub_publish(pub, &i, sizeof(i));
+        if (w && (i % 16 == 0 || i == to))
+            while (usrl_journal_record(w, rec, 64) > 0) {}
+    }
+    if (w) usrl_journal_flush(w);
+}
+
+static void append_range(UsrlJournalWriter *w, uint64_t from, uint64_t to) {
+    for (uint64_t seq = from; seq <= to; seq++) usrl_journal_append(w, seq, seq * 1000, 1, 0, &seq, sizeof(seq));
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL REPLAY HANDOVER TEST                             \n");
+    printf("========================================================\n");
+
+    char base[] = "/tmp/usrl_replay_test.XXXXXX";
+    if (!mkdtemp(base)) {
+        perror("mkdtemp");
+        return 2;
+    }
+
+    shm_unlink(SHM_PATH);
+    UsrlTopicConfig cfg[4] = {
+        { .name = "rtest", .slot_count = SLOTS, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+        { .name = "rgap",  .slot_count = SLOTS, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+        { .name = "rback", .slot_count = SLOTS, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+        { .name = "rtrace", .slot_count = SLOTS, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+    };
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, cfg, 4) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    void *core = usrl_core_map(SHM_PATH, SHM_SIZE);
+
+    /* =========================================================================
+     * PHASE 1: HANDOVER
+     * ========================================================================= */
+    printf("\n[PHASE 1] Journal 1..200, ring up to 240, replay from 1...\n");
+
+    UsrlPublisher pub;
+    UsrlSubscriber rec;
+    UsrlJournalWriter w;
+    usrl_pub_init(&pub, core, "rtest", 1);
+    usrl_sub_init(&rec, core, "rtest");
+    if (usrl_journal_writer_open(&w, base, "rtest", 4096) != 0) {
+        perror("usrl_journal_writer_open");
+        return 2;
+    }
+    publish(&pub, &w, &rec, 1, 200);    /* several segments */
+    publish(&pub, NULL, NULL, 201, 240); /* ring only: 177..240 */
+
+    UsrlReplaySubscriber r;
+    CHECK(usrl_replay_init(&r, core, "rtest", base, 1, 0) == 0, "replay_init failed");
+    Seen s = { 0 };
+    drain_next(&r, &s, 0, 0);
+    publish(&pub, NULL, NULL, 241, 250);
+    drain_next(&r, &s, 0, 0);
+
+    printf("    %lu delivered, %lu from the journal, %lu handovers\n", (unsigned long)s.count,
+           (unsigned long)r.replayed, (unsigned long)r.handovers);
+    CHECK(s.count == 250 && s.last == 250 && !s.dups && !s.holes && !s.bad_payload,
+          "%lu delivered up to %lu, %lu dups, %lu holes, %lu bad payloads", (unsigned long)s.count,
+          (unsigned long)s.last, (unsigned long)s.dups, (unsigned long)s.holes, (unsigned long)s.bad_payload);
+    CHECK(r.replayed == 200 && r.handovers == 1 && r.gap_count == 0 && usrl_replay_is_live(&r),
+          "replayed %lu, handovers %lu, gaps %lu", (unsigned long)r.replayed,
+          (unsigned long)r.handovers, (unsigned long)r.gap_count);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] 250 seqs once each, one handover at 201.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: LAPPED FALLBACK
+     * ========================================================================= */
+    printf("\n[PHASE 2] Live reader lapped by 150 publishes...\n");
+    int fail_before = g_fail;
+
+    publish(&pub, &w, &rec, 251, 400);
+    drain_batch(&r, &s);
+    publish(&pub, &w, &rec, 401, 410);
+    drain_batch(&r, &s);
+
+    printf("    %lu fallbacks, %lu handovers, %lu from the journal\n", (unsigned long)r.fallbacks,
+           (unsigned long)r.handovers, (unsigned long)r.replayed);
+    CHECK(s.count == 410 && s.last == 410 && !s.dups && !s.holes && !s.bad_payload,
+          "%lu delivered up to %lu, %lu dups, %lu holes", (unsigned long)s.count, (unsigned long)s.last,
+          (unsigned long)s.dups, (unsigned long)s.holes);
+    CHECK(r.fallbacks == 1 && r.handovers == 2 && r.gap_count == 0 && usrl_replay_is_live(&r),
+          "fallbacks %lu, handovers %lu, gaps %lu", (unsigned long)r.fallbacks,
+          (unsigned long)r.handovers, (unsigned long)r.gap_count);
+    CHECK(r.replayed > 200 && w.lapped == 0, "missed seqs not read from the journal");
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] Lap recovered from the journal, back on the ring.\n" COLOR_RESET);
+
+    usrl_replay_close(&r);
+    usrl_journal_writer_close(&w);
+
+    /* =========================================================================
+     * PHASE 3: JOURNAL GAPS
+     * ========================================================================= */
+    printf("\n[PHASE 3] Journal 1..10, 20..40, 50..60; ring 37..100...\n");
+    fail_before = g_fail;
+
+    char gap_dir[256];
+    snprintf(gap_dir, sizeof(gap_dir), "%s/gap", base);
+    CHECK(usrl_journal_writer_open(&w, gap_dir, "rgap", 0) == 0, "writer open failed");
+    append_range(&w, 1, 10);
+    append_range(&w, 20, 40);
+    append_range(&w, 50, 60);
+    usrl_journal_writer_close(&w);
+
+    usrl_pub_init(&pub, core, "rgap", 1);
+    publish(&pub, NULL, NULL, 1, 100);
+
+    CHECK(usrl_replay_init(&r, core, "rgap", gap_dir, 0, 0) == 0, "replay_init failed");
+    memset(&s, 0, sizeof(s));
+    drain_next(&r, &s, 11, 19);
+
+    CHECK(s.count == 91 && s.last == 100 && !s.dups && !s.holes && !s.bad_payload,
+          "%lu delivered up to %lu, %lu dups, %lu holes", (unsigned long)s.count, (unsigned long)s.last,
+          (unsigned long)s.dups, (unsigned long)s.holes);
+    CHECK(r.gap_count == 9 && r.replayed == 31 && r.handovers == 1,
+          "gaps %lu, replayed %lu, handovers %lu (expected 9, 31, 1)", (unsigned long)r.gap_count,
+          (unsigned long)r.replayed, (unsigned long)r.handovers);
+    usrl_replay_close(&r);
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] 41..49 read from the ring, 11..19 counted as a gap.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 4: RING BEHIND THE JOURNAL
+     * ========================================================================= */
+    printf("\n[PHASE 4] Journal 1..10, 20..30; recreated ring at 5...\n");
+    fail_before = g_fail;
+
+    char back_dir[256];
+    snprintf(back_dir, sizeof(back_dir), "%s/back", base);
+    CHECK(usrl_journal_writer_open(&w, back_dir, "rback", 0) == 0, "writer open failed");
+    append_range(&w, 1, 10);
+    append_range(&w, 20, 30);
+    usrl_journal_writer_close(&w);
+
+    usrl_pub_init(&pub, core, "rback", 1);
+    publish(&pub, NULL, NULL, 1, 5);
+
+    CHECK(usrl_replay_init(&r, core, "rback", back_dir, 0, 0) == 0, "replay_init failed");
+    memset(&s, 0, sizeof(s));
+    drain_next(&r, &s, 11, 19);
+    publish(&pub, NULL, NULL, 6, 35);
+    drain_next(&r, &s, 11, 19);
+
+    CHECK(r.replayed == 21 && r.gap_count == 9, "replayed %lu, gaps %lu (expected 21, 9)",
+          (unsigned long)r.replayed, (unsigned long)r.gap_count);
+    CHECK(s.count == 26 && s.last == 35 && !s.dups && !s.holes && !s.bad_payload,
+          "%lu delivered up to %lu, %lu dups, %lu holes", (unsigned long)s.count, (unsigned long)s.last,
+          (unsigned long)s.dups, (unsigned long)s.holes);
+    usrl_replay_close(&r);
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] Journal kept until the ring caught up.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 5: TRACE CONTEXT
+     * ========================================================================= */
+    printf("\n[PHASE 5] Every 3rd message traced, replayed from the journal...\n");
+    fail_before = g_fail;
+
+    char trace_dir[256];
+    snprintf(trace_dir, sizeof(trace_dir), "%s/trace", base);
+    CHECK(usrl_journal_writer_open(&w, trace_dir, "rtrace", 0) == 0, "writer open failed");
+    usrl_pub_init(&pub, core, "rtrace", 9);
+    usrl_pub_set_trace_sampling(&pub, 3);
+    usrl_sub_init(&rec, core, "rtrace");
+
+    /* What each seq carried on the ring */
+    enum { TRACE_MSGS = 100 };
+    UsrlTraceContext sent[TRACE_MSGS + 1];
+    UsrlSubscriber probe;
+    usrl_sub_init(&probe, core, "rtrace");
+    for (uint64_t i = 1; i <= TRACE_MSGS; i++) {
+        uint8_t buf[64];
+        publish(&pub, &w, &rec, i, i);
+        usrl_sub_next(&probe, buf, sizeof(buf), NULL);
+        usrl_sub_last_trace(&probe, &sent[i]);
+    }
+
+    uint64_t traced = 0, from_journal = 0;
+    CHECK(usrl_replay_init(&r, core, "rtrace", trace_dir, 0, 0) == 0, "replay_init failed");
+    UsrlSlotView v[16];
+    int n;
+    while ((n = usrl_replay_batch(&r, v, 16)) > 0) {
+        for (int i = 0; i < n; i++) {
+            UsrlTraceContext got;
+            uint64_t seq = v[i].seq;
+            int t = usrl_view_trace(&v[i], &got);
+            if (seq > TRACE_MSGS) continue;
+            from_journal += (v[i].hdr == NULL);
+            traced += (t == 1);
+            CHECK(t == (sent[seq].flags ? 1 : 0) && got.trace_id == sent[seq].trace_id &&
+                  got.origin_ns == sent[seq].origin_ns && got.hop_count == sent[seq].hop_count,
+                  "seq %lu (%s): trace %d id %lx, sent id %lx", (unsigned long)seq,
+                  v[i].hdr ? "ring" : "journal", t, (unsigned long)got.trace_id,
+                  (unsigned long)sent[seq].trace_id);
+        }
+    }
+    usrl_replay_close(&r);
+    CHECK(from_journal >= TRACE_MSGS - SLOTS && traced == TRACE_MSGS / 3, "%lu traced, %lu from the journal",
+          (unsigned long)traced, (unsigned long)from_journal);
+
+    /* Copy API: the context of the message just returned */
+    CHECK(usrl_replay_init(&r, core, "rtrace", trace_dir, 0, 0) == 0, "replay_init failed");
+    uint8_t buf[64];
+    uint64_t seq, copied = 0;
+    while (usrl_replay_next(&r, buf, sizeof(buf), NULL, &seq) >= 0 && seq <= TRACE_MSGS) {
+        UsrlTraceContext got;
+        int t = usrl_replay_last_trace(&r, &got);
+        CHECK(t == (sent[seq].flags ? 1 : 0) && got.trace_id == sent[seq].trace_id,
+              "replay_next seq %lu: trace %d", (unsigned long)seq, t);
+        copied++;
+    }
+    usrl_replay_close(&r);
+    usrl_journal_writer_close(&w);
+    CHECK(copied == TRACE_MSGS, "%lu copied", (unsigned long)copied);
+
+    /* No context to write: the flag must not survive on its own */
+    char bare_dir[256];
+    snprintf(bare_dir, sizeof(bare_dir), "%s/bare", base);
+    CHECK(usrl_journal_writer_open(&w, bare_dir, "rtrace", 0) == 0, "writer open failed");
+    seq = 1;
+    usrl_journal_append(&w, 1, 1000, 1, USRL_SLOT_F_TRACED, &seq, sizeof(seq));
+    usrl_journal_writer_close(&w);
+    UsrlJournalSegInfo info;
+    UsrlJournalSegment seg;
+    CHECK(usrl_journal_list(bare_dir, "rtrace", &info, 1) == 1 && usrl_jseg_open(&seg, info.path) == 0,
+          "journal not readable");
+    const UsrlJournalRecord *jr = usrl_jseg_record(&seg, usrl_jseg_begin(&seg));
+    CHECK(jr && !(jr->flags & USRL_SLOT_F_TRACED) && !(jr->rflags & USRL_JREC_F_TRACE),
+          "untraced append kept the TRACED flag");
+    usrl_jseg_close(&seg);
+    if (g_fail == fail_before)
+        printf(COLOR_GREEN "[PASS] %lu traced messages replayed with their context.\n" COLOR_RESET,
+               (unsigned long)traced);
+
+    shm_unlink(SHM_PATH);
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", base);
+    system(cmd);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file stage_test.c
+ * @brief Pipeline stages: cursors, gating, in-place annotation and recovery.
+ *
+ * VALIDATES:
+ * 1. Stage k only sees seqs stage k-1 has committed; stage 0 stops at a
+ *    slot that is claimed but not committed; annotations made in place by
+ *    one stage are what the next one reads.
+ * 2. The publisher never laps the last stage: a full ring returns
+ *    USRL_RING_FULL until that stage commits, whatever earlier stages do.
+ * 3. A publisher and two stages in separate processes move every message
+ *    through the chain exactly once, in order, annotated.
+ * 4. Recovery: a restarted stage resumes from its cursor; skip releases a
+ *    dead stage's seqs; only the last stage can be detached.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_stage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_stage_test"
+#define SHM_SIZE (8u << 20)
+#define SLOTS 64
+#define MSGS 200000
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+/* Published as {n}; stage 0 appends n * 3; stage 1 checks both */
+typedef struct {
+    uint64_t n;
+    uint64_t tripled;
+} Msg;
+
+static int publish(UsrlPublisher *p, uint64_t n) {
+    Msg m = { n, 0 };
+    return usrl_pub_publish(p, &m, sizeof(m.n));
+}
+
+/* Claim and commit everything available; returns the count */
+static int drain(UsrlStage *s) {
+    UsrlStageSlot slots[SLOTS];
+    int total = 0, n;
+    while ((n = usrl_stage_claim(s, slots, SLOTS)) > 0) {
+        total += n;
+        usrl_stage_commit(s);
+    }
+    return total;
+}
+
+static void proc_publisher(void *core) {
+    UsrlPublisher p;
+    usrl_pub_init(&p, core, "flow", 1);
+    for (uint64_t n = 1; n <= MSGS; n++)
+        while (publish(&p, n) == USRL_RING_FULL) sched_yield();
+    _exit(0);
+}
+
+static void proc_annotate(void *core) {
+    UsrlStage s;
+    if (usrl_stage_init(&s, core, "flow", 0) != 0) _exit(100);
+    UsrlStageSlot slots[16];
+    uint64_t seen = 0;
+    while (seen < MSGS) {
+        int n = usrl_stage_claim(&s, slots, 16);
+        if (n <= 0) {
+            sched_yield();
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            Msg *m = (Msg *)slots[i].data;
+            if (slots[i].len != sizeof(m->n) || m->n != ++seen) _exit(1);
+            m->tripled = m->n * 3;
+            if (usrl_stage_resize(&slots[i], sizeof(Msg)) != USRL_RING_OK) _exit(2);
+        }
+        usrl_stage_commit(&s);
+    }
+    _exit(0);
+}
+
+static void proc_verify(void *core) {
+    UsrlStage s;
+    if (usrl_stage_init(&s, core, "flow", 1) != 0) _exit(100);
+    UsrlStageSlot slots[16];
+    uint64_t seen = 0;
+    while (seen < MSGS) {
+        int n = usrl_stage_claim(&s, slots, 16);
+        if (n <= 0) {
+            sched_yield();
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            const Msg *m = (const Msg *)slots[i].data;
+            if (slots[i].len != sizeof(Msg) || m->n != ++seen || m->tripled != m->n * 3) _exit(1);
+        }
+        usrl_stage_commit(&s);
+    }
+    _exit(0);
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL PIPELINE STAGE TEST                              \n");
+    printf("========================================================\n");
+
+    shm_unlink(SHM_PATH);
+    UsrlTopicConfig cfg[2] = {
+        { .name = "chain", .slot_count = SLOTS, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+        { .name = "flow", .slot_count = SLOTS, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+    };
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, cfg, 2) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    void *core = usrl_core_map(SHM_PATH, SHM_SIZE);
+    UsrlStage s0, s1;
+    if (!core || usrl_stage_init(&s0, core, "chain", 0) != 0 || usrl_stage_init(&s1, core, "chain", 1) != 0) {
+        printf(COLOR_RED "[FAIL] cannot register stages\n" COLOR_RESET);
+        return 2;
+    }
+    UsrlPublisher pub;
+    usrl_pub_init(&pub, core, "chain", 1);
+
+    /* =========================================================================
+     * PHASE 1: CURSORS
+     * ========================================================================= */
+    printf("\n[PHASE 1] Two stages on one ring...\n");
+
+    CHECK(usrl_stage_count(core, "chain") == 2, "%d stages registered", usrl_stage_count(core, "chain"));
+    UsrlStageSlot slots[SLOTS];
+    for (uint64_t n = 1; n <= 10; n++) publish(&pub, n);
+    CHECK(usrl_stage_claim(&s1, slots, SLOTS) == 0, "stage 1 ran ahead of stage 0");
+
+    /* Seq 10 claimed by a writer but not committed yet */
+    SlotHeader *h10 = (SlotHeader *)(s0.base_ptr + 9 * s0.desc->slot_size);
+    atomic_store(&h10->seq, 0);
+    int n = usrl_stage_claim(&s0, slots, 4);
+    CHECK(n == 4 && slots[0].seq == 1 && slots[3].seq == 4, "first claim %d from seq %lu", n,
+          n > 0 ? (unsigned long)slots[0].seq : 0ul);
+    n = usrl_stage_claim(&s0, slots + 4, SLOTS);
+    CHECK(n == 5 && slots[8].seq == 9, "stage 0 claimed %d past an uncommitted slot", n);
+    for (int i = 0; i < 9; i++) {
+        Msg *m = (Msg *)slots[i].data;
+        m->tripled = m->n * 3;
+        usrl_stage_resize(&slots[i], sizeof(Msg));
+    }
+    CHECK(usrl_stage_resize(&slots[0], slots[0].cap + 1) == USRL_RING_FULL, "resize past the slot accepted");
+    CHECK(usrl_stage_claim(&s1, slots, SLOTS) == 0, "stage 1 saw uncommitted claims");
+    usrl_stage_commit(&s0);
+    CHECK(usrl_stage_cursor(&s0) == 9, "stage 0 cursor %lu", (unsigned long)usrl_stage_cursor(&s0));
+
+    n = usrl_stage_claim(&s1, slots, SLOTS);
+    CHECK(n == 9, "stage 1 claimed %d", n);
+    for (int i = 0; i < n; i++) {
+        const Msg *m = (const Msg *)slots[i].data;
+        CHECK(slots[i].len == sizeof(Msg) && m->n == (uint64_t)i + 1 && m->tripled == m->n * 3,
+              "stage 1 slot %d: len %u n %lu tripled %lu", i, slots[i].len, (unsigned long)m->n,
+              (unsigned long)m->tripled);
+    }
+    usrl_stage_commit(&s1);
+
+    atomic_store(&h10->seq, 10);
+    CHECK(drain(&s0) == 1 && drain(&s1) == 1, "seq 10 not delivered once committed");
+    CHECK(usrl_stage_cursor(&s1) == 10, "stage 1 cursor %lu", (unsigned long)usrl_stage_cursor(&s1));
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Stages follow committed seqs in order.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: GATING
+     * ========================================================================= */
+    printf("\n[PHASE 2] Filling the ring behind the last stage...\n");
+    int fail_before = g_fail;
+
+    int accepted = 0;
+    for (uint64_t k = 0; k < SLOTS + 5; k++) accepted += publish(&pub, 100 + k) == USRL_RING_OK;
+    CHECK(accepted == SLOTS, "%d of %d accepted into a %d-slot ring", accepted, SLOTS + 5, SLOTS);
+    CHECK(drain(&s0) == SLOTS, "stage 0 drained a different count");
+    CHECK(publish(&pub, 1) == USRL_RING_FULL, "stage 0 alone unblocked the publisher");
+    n = usrl_stage_claim(&s1, slots, 8);
+    usrl_stage_commit(&s1);
+    accepted = 0;
+    for (int k = 0; k < 10; k++) accepted += publish(&pub, 200 + (uint64_t)k) == USRL_RING_OK;
+    CHECK(n == 8 && accepted == 8, "stage 1 freed %d slots, publisher used %d", n, accepted);
+    drain(&s0);
+    drain(&s1);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Publisher gated on the last stage only.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: PROCESSES
+     * ========================================================================= */
+    printf("\n[PHASE 3] Publisher -> annotate -> verify, %d messages, 3 processes...\n", MSGS);
+    fail_before = g_fail;
+
+    /* Stages register before the publisher starts */
+    pid_t stages[2];
+    if ((stages[0] = fork()) == 0) proc_annotate(core);
+    if ((stages[1] = fork()) == 0) proc_verify(core);
+    while (usrl_stage_count(core, "flow") < 2) usleep(1000);
+    pid_t writer = fork();
+    if (writer == 0) proc_publisher(core);
+
+    for (int i = 0; i < 3; i++) {
+        int status = 0;
+        pid_t pid = wait(&status);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "%s exited with %d",
+              pid == writer ? "publisher" : pid == stages[0] ? "annotate" : "verify",
+              WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    }
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Every message annotated and verified in order.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 4: RECOVERY
+     * ========================================================================= */
+    printf("\n[PHASE 4] Restart, skip and detach...\n");
+    fail_before = g_fail;
+
+    for (uint64_t k = 0; k < 20; k++) publish(&pub, k);
+    n = usrl_stage_claim(&s0, slots, 5);
+    usrl_stage_commit(&s0);
+    usrl_stage_claim(&s0, slots, 5); /* claimed, then the process dies */
+
+    UsrlStage again;
+    usrl_stage_init(&again, core, "chain", 0);
+    n = usrl_stage_claim(&again, slots, SLOTS);
+    CHECK(n == 15 && slots[0].seq == usrl_stage_cursor(&again) + 1, "restart claimed %d from seq %lu", n,
+          n > 0 ? (unsigned long)slots[0].seq : 0ul);
+    usrl_stage_commit(&again);
+
+    /* Stage 1 is dead: fill the ring, then release its seqs */
+    while (publish(&pub, 7) == USRL_RING_OK) {}
+    drain(&again);
+    int64_t skipped = usrl_stage_skip(core, "chain", 1);
+    CHECK(skipped == SLOTS, "skip released %ld seqs", (long)skipped);
+    CHECK(publish(&pub, 8) == USRL_RING_OK, "publisher still gated after skip");
+    CHECK(usrl_stage_skip(core, "chain", 1) == 0, "second skip moved the cursor");
+    CHECK(usrl_stage_skip(core, "chain", 2) == -1, "skip of an unregistered stage");
+
+    CHECK(usrl_stage_detach(core, "chain", 0) == -1, "detached a stage with a successor");
+    CHECK(usrl_stage_detach(core, "chain", 1) == 0 && usrl_stage_count(core, "chain") == 1, "detach stage 1");
+    while (publish(&pub, 9) == USRL_RING_OK) {}
+    CHECK(drain(&again) == SLOTS, "stage 0 is now the gate");
+    CHECK(usrl_stage_detach(core, "chain", 0) == 0 && usrl_stage_count(core, "chain") == 0, "detach stage 0");
+    accepted = 0;
+    for (int k = 0; k < 2 * SLOTS; k++) accepted += publish(&pub, 10) == USRL_RING_OK;
+    CHECK(accepted == 2 * SLOTS, "ungated ring refused %d publishes", 2 * SLOTS - accepted);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Stages resume, skip and detach.\n" COLOR_RESET);
+
+    usrl_core_unmap(core, SHM_SIZE);
+    shm_unlink(SHM_PATH);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file ttl_test.c
+ * @brief Subscriber message TTL: stale slots skipped by binary search.
+ *
+ * VALIDATES:
+ * 1. For every split of a backlog into stale then fresh slots, the first
+ *    message read is the first fresh one and expired_count is exactly the
+ *    stale prefix; the rest follows in order.
+ * 2. usrl_sub_view_batch() skips the same prefix.
+ * 3. A lapped reader first jumps the lap, then the stale part of what is
+ *    left, and counts each separately.
+ * 4. With real publish times, a backlog older than the TTL is dropped and
+ *    everything newer is delivered; with the TTL off nothing is dropped.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_ttl_test"
+#define SHM_SIZE (4u << 20)
+#define TOPIC "ttl"
+#define SLOTS 1024
+#define BACKLOG 600
+#define SEC 1000000000ull
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * SEC + (uint64_t)ts.tv_nsec;
+}
+
+static SlotHeader *slot_hdr(const UsrlSubscriber *s, uint64_t seq) {
+    return (SlotHeader *)(s->base_ptr + ((seq - 1) & s->mask) * s->desc->slot_size);
+}
+
+/* Backdate seqs [first, stale_end] by 10 s, the rest up to head to now */
+static void stamp(const UsrlSubscriber *s, uint64_t first, uint64_t stale_end, uint64_t head) {
+    uint64_t now = now_ns();
+    for (uint64_t seq = first; seq <= head; seq++)
+        slot_hdr(s, seq)->timestamp_ns = seq <= stale_end ? now - 10 * SEC : now;
+}
+
+/* Payloads carry their own seq */
+static void publish_n(UsrlPublisher *p, uint64_t *seq, uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        ++*seq;
+        usrl_pub_publish(p, seq, sizeof(*seq));
+    }
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL SUBSCRIBER TTL TEST                              \n");
+    printf("========================================================\n");
+
+    shm_unlink(SHM_PATH);
+    UsrlTopicConfig cfg = { .slot_count = SLOTS, .slot_size = 64, .type = USRL_RING_TYPE_SWMR };
+    snprintf(cfg.name, sizeof(cfg.name), "%s", TOPIC);
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, &cfg, 1) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    void *base = usrl_core_map(SHM_PATH, SHM_SIZE);
+    if (!base) {
+        printf(COLOR_RED "[FAIL] cannot map %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+
+    UsrlPublisher pub;
+    usrl_pub_init(&pub, base, TOPIC, 1);
+    uint64_t head = 0;
+    publish_n(&pub, &head, BACKLOG);
+
+    /* =========================================================================
+     * PHASE 1: EVERY STALE / FRESH SPLIT
+     * ========================================================================= */
+    printf("\n[PHASE 1] %d-slot backlog, stale prefix of 0..%d...\n", BACKLOG, BACKLOG);
+
+    UsrlSubscriber sub;
+    uint64_t v = 0;
+    for (uint64_t k = 0; k <= BACKLOG; k++) {
+        usrl_sub_init(&sub, base, TOPIC);
+        stamp(&sub, 1, k, head);
+        usrl_sub_set_max_age(&sub, SEC);
+
+        int n = usrl_sub_next(&sub, (uint8_t *)&v, sizeof(v), NULL);
+        if (k == BACKLOG) {
+            CHECK(n == USRL_RING_NO_DATA, "all stale: read %d (value %lu)", n, (unsigned long)v);
+        } else {
+            CHECK(n == (int)sizeof(v) && v == k + 1, "prefix %lu: first read %d value %lu", (unsigned long)k,
+                  n, (unsigned long)v);
+        }
+        CHECK(sub.expired_count == k, "prefix %lu: expired %lu", (unsigned long)k,
+              (unsigned long)sub.expired_count);
+
+        uint64_t want = k + 2;
+        while (usrl_sub_next(&sub, (uint8_t *)&v, sizeof(v), NULL) > 0) {
+            if (v != want) break;
+            want++;
+        }
+        CHECK(want == BACKLOG + 1 || k == BACKLOG, "prefix %lu: stopped at %lu, expected %d",
+              (unsigned long)k, (unsigned long)want, BACKLOG + 1);
+        CHECK(sub.expired_count == k && sub.skipped_count == 0, "prefix %lu: expired %lu skipped %lu later",
+              (unsigned long)k, (unsigned long)sub.expired_count, (unsigned long)sub.skipped_count);
+        if (g_fail) break;
+    }
+
+    usrl_sub_init(&sub, base, TOPIC);
+    CHECK(usrl_sub_next(&sub, (uint8_t *)&v, sizeof(v), NULL) == (int)sizeof(v) && v == 1 &&
+          sub.expired_count == 0, "TTL off: first read %lu", (unsigned long)v);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Every split skipped exactly the stale prefix.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: BATCH VIEWS
+     * ========================================================================= */
+    printf("\n[PHASE 2] usrl_sub_view_batch() over the same splits...\n");
+    int fail_before = g_fail;
+
+    static const uint64_t splits[] = { 0, 1, 2, 63, 64, 299, 300, 598, 599 };
+    for (size_t i = 0; i < sizeof(splits) / sizeof(splits[0]); i++) {
+        uint64_t k = splits[i];
+        usrl_sub_init(&sub, base, TOPIC);
+        stamp(&sub, 1, k, head);
+        usrl_sub_set_max_age(&sub, SEC);
+
+        UsrlSlotView views[8];
+        int n = usrl_sub_view_batch(&sub, views, 8);
+        uint64_t first = 0;
+        if (n > 0) memcpy(&first, views[0].data, sizeof(first));
+        CHECK(n > 0 && views[0].seq == k + 1 && first == k + 1 && sub.expired_count == k,
+              "prefix %lu: %d views, first seq %lu, expired %lu", (unsigned long)k, n,
+              n > 0 ? (unsigned long)views[0].seq : 0ul, (unsigned long)sub.expired_count);
+    }
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Batch views skip the same prefix.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: LAPPED AND STALE
+     * ========================================================================= */
+    printf("\n[PHASE 3] Reader lapped, then all but the last 100 stale...\n");
+    fail_before = g_fail;
+
+    publish_n(&pub, &head, 3000);
+    uint64_t oldest = head - SLOTS + 1;
+    usrl_sub_init(&sub, base, TOPIC);
+    stamp(&sub, oldest, head - 100, head);
+    usrl_sub_set_max_age(&sub, SEC);
+
+    CHECK(usrl_sub_next(&sub, (uint8_t *)&v, sizeof(v), NULL) == (int)sizeof(v) && v == head - 99,
+          "first read %lu, expected %lu", (unsigned long)v, (unsigned long)(head - 99));
+    CHECK(sub.skipped_count == oldest - 1, "lapped %lu, expected %lu", (unsigned long)sub.skipped_count,
+          (unsigned long)(oldest - 1));
+    CHECK(sub.expired_count == SLOTS - 100, "expired %lu, expected %d", (unsigned long)sub.expired_count,
+          SLOTS - 100);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Lap and TTL skips counted apart.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 4: REAL PUBLISH TIMES
+     * ========================================================================= */
+    printf("\n[PHASE 4] 50 messages, 60 ms pause, 50 more; TTL 20 ms...\n");
+    fail_before = g_fail;
+
+    UsrlSubscriber off;
+    usrl_sub_init(&sub, base, TOPIC);
+    sub.last_seq = head;
+    off = sub;
+    uint64_t old_first = head + 1;
+    publish_n(&pub, &head, 50);
+    usleep(60000);
+    uint64_t new_first = head + 1;
+    publish_n(&pub, &head, 50);
+    usrl_sub_set_max_age(&sub, 20000000ull);
+
+    int got = 0;
+    uint64_t first_v = 0;
+    while (usrl_sub_next(&sub, (uint8_t *)&v, sizeof(v), NULL) > 0)
+        if (got++ == 0) first_v = v;
+    CHECK(got == 50 && first_v == new_first && sub.expired_count == 50,
+          "read %d from %lu, expired %lu", got, (unsigned long)first_v, (unsigned long)sub.expired_count);
+
+    got = 0;
+    while (usrl_sub_next(&off, (uint8_t *)&v, sizeof(v), NULL) > 0)
+        if (got++ == 0) first_v = v;
+    CHECK(got == 100 && first_v == old_first && off.expired_count == 0,
+          "TTL off: read %d from %lu", got, (unsigned long)first_v);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Only the backlog older than the TTL dropped.\n" COLOR_RESET);
+
+    usrl_core_unmap(base, SHM_SIZE);
+    shm_unlink(SHM_PATH);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
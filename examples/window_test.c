@@ -0,0 +1,337 @@
+/**
+ * @file window_test.c
+ * @brief Event-time window aggregator against brute-force bars.
+ *
+ * VALIDATES:
+ * 1. Sliding windows built from panes produce, for every key and every
+ *    window that saw a record, exactly the OHLCV / VWAP bar recomputed from
+ *    the raw records, with out-of-order input inside the lateness bound.
+ * 2. Keys that go quiet are retired from the active set once their last
+ *    window closes, while busy keys stay.
+ * 3. A record whose windows have all closed is dropped as late; one that
+ *    still belongs to an open window lands only in the open ones.
+ * 4. Polling a topic publishes one UsrlBar per closed tumbling window.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_window.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>
+
+#define COLOR_RED     "\x1b[31m"
+#define COLOR_GREEN   "\x1b[32m"
+#define COLOR_RESET   "\x1b[0m"
+
+#define SHM_PATH "/usrl_window_test"
+#define SHM_SIZE (4u << 20)
+#define KEYS 3
+#define RECORDS 4000
+#define SLIDE 10
+#define SIZE 40
+#define LATENESS 25
+#define MAX_BARS 8192
+
+static int g_fail = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            g_fail = 1; \
+            printf(COLOR_RED "[FAIL] " COLOR_RESET __VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+typedef struct {
+    uint32_t key;
+    int64_t ts;
+    double price;
+    double qty;
+} Tick;
+
+static const char *const g_syms[KEYS] = { "AAPL", "MSFT", "QUIET" };
+static Tick g_ticks[RECORDS];
+
+static UsrlBar g_bars[MAX_BARS];
+static int g_nbars;
+
+static const UsrlField *f_sym, *f_price, *f_qty, *f_ts;
+
+static uint64_t lcg(uint64_t *s) {
+    *s = *s * 6364136223846793005ull + 1442695040888963407ull;
+    return *s >> 33;
+}
+
+static void make_record(uint8_t *rec, const char *sym, double price, double qty, int64_t ts) {
+    memset(rec + f_sym->offset, 0, f_sym->size);
+    memcpy(rec + f_sym->offset, sym, strlen(sym));
+    memcpy(rec + f_price->offset, &price, sizeof(price));
+    memcpy(rec + f_qty->offset, &qty, sizeof(qty));
+    memcpy(rec + f_ts->offset, &ts, sizeof(ts));
+}
+
+static void collect(const UsrlBar *bar, void *arg) {
+    (void)arg;
+    if (g_nbars < MAX_BARS) g_bars[g_nbars] = *bar;
+    g_nbars++;
+}
+
+static const UsrlBar *find_bar(const char *sym, uint64_t end) {
+    for (int i = 0; i < g_nbars && i < MAX_BARS; i++)
+        if (g_bars[i].end_ns == end && strncmp(g_bars[i].key, sym, USRL_KEY_MAX) == 0) return &g_bars[i];
+    return NULL;
+}
+
+static int close_enough(double got, double want) {
+    return fabs(got - want) <= 1e-9 * (fabs(want) > 1.0 ? fabs(want) : 1.0);
+}
+
+/* Recompute the bar of key k over [end - SIZE, end); returns its record count */
+static uint32_t reference(uint32_t k, int64_t end, UsrlBar *bar) {
+    const Tick *open = NULL, *close = NULL;
+    double notional = 0.0;
+
+    memset(bar, 0, sizeof(*bar));
+    for (int i = 0; i < RECORDS; i++) {
+        const Tick *t = &g_ticks[i];
+        if (t->key != k || t->ts < end - SIZE || t->ts >= end) continue;
+        /* open: earliest event time, first arrival; close: latest, last arrival */
+        if (!open || t->ts < open->ts) open = t;
+        if (!close || t->ts >= close->ts) close = t;
+        if (!bar->count || t->price > bar->high) bar->high = t->price;
+        if (!bar->count || t->price < bar->low) bar->low = t->price;
+        bar->volume += t->qty;
+        notional += t->price * t->qty;
+        bar->count++;
+    }
+    if (bar->count) {
+        bar->open = open->price;
+        bar->close = close->price;
+        bar->vwap = notional / bar->volume;
+    }
+    return bar->count;
+}
+
+int main(void) {
+    printf("========================================================\n");
+    printf("  USRL WINDOW AGGREGATOR TEST                           \n");
+    printf("========================================================\n");
+
+    UsrlSchema *schema = usrl_schema_create(1, "tick");
+    usrl_schema_add_field(schema, "sym", USRL_FIELD_STRING, 8);
+    usrl_schema_add_field(schema, "price", USRL_FIELD_F64, 8);
+    usrl_schema_add_field(schema, "qty", USRL_FIELD_F64, 8);
+    usrl_schema_add_field(schema, "ts", USRL_FIELD_I64, 8);
+    usrl_schema_finalize(schema);
+    f_sym = usrl_schema_field(schema, "sym");
+    f_price = usrl_schema_field(schema, "price");
+    f_qty = usrl_schema_field(schema, "qty");
+    f_ts = usrl_schema_field(schema, "ts");
+
+    UsrlWindowSpec spec = { .size_ns = SIZE, .slide_ns = SLIDE, .lateness_ns = LATENESS,
+                            .key = "sym", .price = "price", .qty = "qty", .time = "ts" };
+    UsrlWindowAgg w;
+    if (!f_sym || !f_price || !f_qty || !f_ts || usrl_window_init(&w, schema, &spec, KEYS) != 0) {
+        printf(COLOR_RED "[FAIL] cannot set up the aggregator\n" COLOR_RESET);
+        return 2;
+    }
+    usrl_window_on_bar(&w, collect, NULL);
+    uint8_t rec[64];
+
+    /* =========================================================================
+     * PHASE 1: SLIDING BARS AGAINST THE REFERENCE
+     * ========================================================================= */
+    printf("\n[PHASE 1] %d out-of-order records, %d/%d ns windows, lateness %d...\n", RECORDS, SIZE, SLIDE,
+           LATENESS);
+
+    /* Event times trail a rising base by up to LATENESS, so none is late.
+     * QUIET only trades in the first quarter. */
+    uint64_t rng = 11;
+    int64_t base = 1000;
+    int32_t ids[KEYS] = { -1, -1, -1 };
+    int32_t quiet_id = -1;
+    int quiet_retired_early = 0;
+    for (int i = 0; i < RECORDS; i++) {
+        base += (int64_t)(lcg(&rng) % 5);
+        uint32_t k = (uint32_t)(lcg(&rng) % (i < RECORDS / 4 ? KEYS : KEYS - 1));
+        Tick *t = &g_ticks[i];
+        t->key = k;
+        t->ts = base - (int64_t)(lcg(&rng) % (LATENESS + 1));
+        t->price = 100.0 + (double)(lcg(&rng) % 1000) / 100.0;
+        t->qty = (double)(1 + lcg(&rng) % 300);
+
+        make_record(rec, g_syms[k], t->price, t->qty, t->ts);
+        int32_t id = usrl_window_apply(&w, rec, 0);
+        CHECK(id >= 0, "record %d (%s at %ld) rejected", i, g_syms[k], (long)t->ts);
+        if (ids[k] < 0) ids[k] = id;
+        if (k == 2) quiet_id = id;
+        if (i == RECORDS / 2 && quiet_id >= 0) quiet_retired_early = w.active_pos[quiet_id] < 0;
+    }
+    CHECK(w.late == 0 && w.rejected == 0 && w.records == RECORDS, "late %lu, rejected %lu, records %lu",
+          (unsigned long)w.late, (unsigned long)w.rejected, (unsigned long)w.records);
+
+    /* Sampled for phase 2 before the final flush */
+    int retire_ok = quiet_retired_early && w.active_count == KEYS - 1;
+    uint32_t active_before_flush = w.active_count;
+
+    int flushed = usrl_window_advance(&w, UINT64_MAX);
+    CHECK(flushed > 0, "final advance emitted %d bars", flushed);
+    CHECK(g_nbars <= MAX_BARS && (uint64_t)g_nbars == w.bars, "%d bars collected, %lu counted", g_nbars,
+          (unsigned long)w.bars);
+
+    int expected = 0;
+    for (uint32_t k = 0; k < KEYS; k++) {
+        int64_t lo = INT64_MAX, hi = 0;
+        for (int i = 0; i < RECORDS; i++) {
+            if (g_ticks[i].key != k) continue;
+            if (g_ticks[i].ts < lo) lo = g_ticks[i].ts;
+            if (g_ticks[i].ts > hi) hi = g_ticks[i].ts;
+        }
+        for (int64_t end = (lo / SLIDE + 1) * SLIDE; end <= (hi / SLIDE) * SLIDE + SIZE; end += SLIDE) {
+            UsrlBar want;
+            if (!reference(k, end, &want)) continue;
+            expected++;
+            const UsrlBar *got = find_bar(g_syms[k], (uint64_t)end);
+            CHECK(got != NULL, "%s: no bar ending at %ld", g_syms[k], (long)end);
+            if (!got) continue;
+            CHECK(got->start_ns == (uint64_t)(end - SIZE) && got->key_id == (uint32_t)ids[k],
+                  "%s@%ld: start %lu, key id %u", g_syms[k], (long)end, (unsigned long)got->start_ns,
+                  got->key_id);
+            CHECK(got->count == want.count && got->open == want.open && got->close == want.close &&
+                  got->high == want.high && got->low == want.low,
+                  "%s@%ld: n=%u O=%.2f H=%.2f L=%.2f C=%.2f, expected n=%u O=%.2f H=%.2f L=%.2f C=%.2f",
+                  g_syms[k], (long)end, got->count, got->open, got->high, got->low, got->close, want.count,
+                  want.open, want.high, want.low, want.close);
+            CHECK(close_enough(got->volume, want.volume) && close_enough(got->vwap, want.vwap),
+                  "%s@%ld: volume %.2f vwap %.6f, expected %.2f / %.6f", g_syms[k], (long)end, got->volume,
+                  got->vwap, want.volume, want.vwap);
+            if (g_fail) break;
+        }
+    }
+    printf("    %d bars, %d expected\n", g_nbars, expected);
+    CHECK(g_nbars == expected, "%d bars emitted, %d windows had records", g_nbars, expected);
+    if (!g_fail) printf(COLOR_GREEN "[PASS] Every bar matched its recomputation.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 2: RETIRING QUIET KEYS
+     * ========================================================================= */
+    printf("\n[PHASE 2] Active set while QUIET is idle, and after the flush...\n");
+    int fail_before = g_fail;
+
+    CHECK(retire_ok, "QUIET retired mid-run: %d, active keys %u", quiet_retired_early, active_before_flush);
+    CHECK(w.active_count == 0, "%u keys still active after flushing", w.active_count);
+    CHECK(usrl_window_advance(&w, UINT64_MAX) == 0 && w.bars == (uint64_t)g_nbars, "second flush emitted");
+    usrl_window_free(&w);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Idle keys retired, busy keys kept.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 3: LATE RECORDS
+     * ========================================================================= */
+    printf("\n[PHASE 3] One key, no lateness: records at 100, 200, then 165 and 175...\n");
+    fail_before = g_fail;
+
+    spec = (UsrlWindowSpec){ .size_ns = SIZE, .slide_ns = SLIDE, .price = "price", .time = "ts" };
+    if (usrl_window_init(&w, schema, &spec, 1) != 0) return 2;
+    usrl_window_on_bar(&w, collect, NULL);
+    g_nbars = 0;
+
+    make_record(rec, "X", 1.0, 1.0, 100);
+    usrl_window_apply(&w, rec, 0);
+    make_record(rec, "X", 2.0, 1.0, 200);
+    usrl_window_apply(&w, rec, 0);
+    CHECK(g_nbars == 4 && usrl_window_watermark(&w) == 200, "%d bars, watermark %lu after 200", g_nbars,
+          (unsigned long)usrl_window_watermark(&w));
+
+    /* 165 only fits windows ending by 200, all closed; 175 still fits [170, 210) */
+    make_record(rec, "X", 3.0, 1.0, 165);
+    CHECK(usrl_window_apply(&w, rec, 0) == -1 && w.late == 1, "record at 165 not dropped");
+    make_record(rec, "X", 4.0, 1.0, 175);
+    CHECK(usrl_window_apply(&w, rec, 0) == 0 && w.late == 1, "record at 175 dropped");
+
+    CHECK(usrl_window_advance(&w, UINT64_MAX) == 4 && g_nbars == 8, "%d bars in total", g_nbars);
+    for (int i = 0; i < g_nbars && i < MAX_BARS; i++) {
+        const UsrlBar *b = &g_bars[i];
+        if (b->end_ns <= 140) {
+            CHECK(b->count == 1 && b->open == 1.0 && b->end_ns >= 110, "bar %lu: n=%u O=%.1f",
+                  (unsigned long)b->end_ns, b->count, b->open);
+        } else if (b->end_ns == 210) {
+            CHECK(b->count == 2 && b->open == 4.0 && b->close == 2.0 && b->low == 2.0 && b->high == 4.0,
+                  "bar 210: n=%u O=%.1f C=%.1f", b->count, b->open, b->close);
+        } else {
+            CHECK(b->count == 1 && b->open == 2.0 && b->end_ns >= 220 && b->end_ns <= 240, "bar %lu: n=%u O=%.1f",
+                  (unsigned long)b->end_ns, b->count, b->open);
+        }
+    }
+    usrl_window_free(&w);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] Late record dropped, partly-late record kept.\n" COLOR_RESET);
+
+    /* =========================================================================
+     * PHASE 4: TOPIC IN, BARS OUT
+     * ========================================================================= */
+    printf("\n[PHASE 4] 1000 ticks polled from a topic into 100 ns tumbling bars...\n");
+    fail_before = g_fail;
+
+    shm_unlink(SHM_PATH);
+    UsrlTopicConfig cfg[2] = {
+        { .name = "ticks", .slot_count = 2048, .slot_size = 64, .type = USRL_RING_TYPE_SWMR },
+        { .name = "bars", .slot_count = 64, .slot_size = 128, .type = USRL_RING_TYPE_SWMR },
+    };
+    if (usrl_core_init(SHM_PATH, SHM_SIZE, cfg, 2) != 0) {
+        printf(COLOR_RED "[FAIL] cannot create %s\n" COLOR_RESET, SHM_PATH);
+        return 2;
+    }
+    void *core = usrl_core_map(SHM_PATH, SHM_SIZE);
+    spec = (UsrlWindowSpec){ .size_ns = 100, .key = "sym", .price = "price", .qty = "qty", .time = "ts" };
+    if (!core || usrl_window_init(&w, schema, &spec, 4) != 0 || usrl_window_attach(&w, core, "ticks", "bars", 9) != 0) {
+        printf(COLOR_RED "[FAIL] cannot attach\n" COLOR_RESET);
+        return 2;
+    }
+    UsrlPublisher in;
+    UsrlSubscriber out;
+    usrl_pub_init(&in, core, "ticks", 1);
+    usrl_sub_init(&out, core, "bars");
+
+    /* price = event time, so bar [s, s+100) is O=s H=s+99 L=s C=s+99, vwap s+49.5 */
+    for (int64_t ts = 0; ts < 1000; ts++) {
+        make_record(rec, "ES", (double)ts, 1.0, ts);
+        usrl_pub_publish(&in, rec, schema->total_size);
+    }
+    int consumed = 0, n;
+    while ((n = usrl_window_poll(&w, 0)) > 0) consumed += n;
+    CHECK(consumed == 1000 && w.records == 1000, "polled %d, applied %lu", consumed, (unsigned long)w.records);
+    usrl_window_advance(&w, UINT64_MAX);
+    CHECK(w.published == 10, "published %lu", (unsigned long)w.published);
+
+    UsrlBar bar;
+    int bars = 0;
+    while (usrl_sub_next(&out, (uint8_t *)&bar, sizeof(bar), NULL) == (int)sizeof(bar)) {
+        double s = (double)bar.start_ns;
+        CHECK(bar.end_ns == bar.start_ns + 100 && bar.start_ns == (uint64_t)bars * 100 && strcmp(bar.key, "ES") == 0,
+              "bar %d: [%lu, %lu) key %.16s", bars, (unsigned long)bar.start_ns, (unsigned long)bar.end_ns, bar.key);
+        CHECK(bar.count == 100 && bar.open == s && bar.high == s + 99 && bar.low == s && bar.close == s + 99 &&
+              bar.volume == 100.0 && bar.vwap == s + 49.5,
+              "bar %d: n=%u O=%.1f H=%.1f L=%.1f C=%.1f V=%.1f vwap %.2f", bars, bar.count, bar.open, bar.high,
+              bar.low, bar.close, bar.volume, bar.vwap);
+        bars++;
+    }
+    CHECK(bars == 10, "read %d bars", bars);
+    usrl_window_free(&w);
+    usrl_core_unmap(core, SHM_SIZE);
+    shm_unlink(SHM_PATH);
+    if (g_fail == fail_before) printf(COLOR_GREEN "[PASS] One bar per closed window on the output topic.\n" COLOR_RESET);
+
+    usrl_schema_free(schema);
+
+    printf("\n========================================================\n");
+    if (g_fail) {
+        printf(COLOR_RED "  RESULT: FAIL" COLOR_RESET "\n");
+        printf("========================================================\n");
+        return 1;
+    }
+    printf(COLOR_GREEN "  RESULT: PASS" COLOR_RESET "\n");
+    printf("========================================================\n");
+    return 0;
+}
@@ -0,0 +1,129 @@
+#ifndef USRL_BOOK_H
+#define USRL_BOOK_H
+
+/* --------------------------------------------------------------------------
+ * USRL Book Builder — per-symbol L2 books from incremental update topics
+ *
+ * Consumes UsrlBookUpdate records, keeps one price-level book per symbol
+ * and publishes UsrlTopOfBook records when the touch changes.
+ *
+ *   - Symbols are dense ids (see usrl_intern.h), so books are a flat array.
+ *   - Each side is a tick-indexed window of quantities: a level update is a
+ *     single array store, and finding the next best level after a delete is
+ *     a short linear scan over adjacent cache lines.
+ *   - The window is anchored at the touch, leaving most of it for depth and
+ *     a little headroom for the touch to improve. A better price outside it
+ *     re-anchors the window on that price.
+ *   - Levels beyond the window's far end (deep updates, or levels pushed off
+ *     by a re-anchor) are kept in a per-side overflow sorted best-last.
+ *     Once the window empties, it re-anchors on the best overflow level and
+ *     pulls back what fits, so deleting the top levels never loses the
+ *     real touch.
+ *   - Input is consumed in batches of zero-copy views straight out of the
+ *     ring. Each record is validated against its slot seq before it is
+ *     applied, so a lapped slot is never half-applied.
+ *   - Output is conflated per batch: a symbol whose touch changed several
+ *     times in one batch publishes only its final state.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include "usrl_ring.h"
+
+#define USRL_BOOK_BID 0
+#define USRL_BOOK_ASK 1
+
+#define USRL_BOOK_SET   0   /* Set level quantity (qty 0 removes the level) */
+#define USRL_BOOK_CLEAR 1   /* Drop the whole book for this symbol */
+
+#define USRL_BOOK_MAX_BATCH 256
+#define USRL_BOOK_EMPTY -1
+
+/* Input record (wire format) */
+typedef struct __attribute__((packed)) {
+    uint64_t timestamp_ns;
+    uint32_t symbol_id;
+    uint8_t side;
+    uint8_t action;
+    uint16_t _pad;
+    int64_t price_ticks;
+    uint64_t qty;
+} UsrlBookUpdate;
+
+/* Output record (wire format); qty 0 means that side is empty */
+typedef struct __attribute__((packed)) {
+    uint64_t timestamp_ns;
+    uint32_t symbol_id;
+    uint32_t _pad;
+    int64_t bid_ticks;
+    uint64_t bid_qty;
+    int64_t ask_ticks;
+    uint64_t ask_qty;
+} UsrlTopOfBook;
+
+typedef struct {
+    int64_t price_ticks;
+    uint64_t qty;
+} UsrlBookLevel;
+
+typedef struct {
+    int64_t base_tick;      /* price of qty[0] */
+    int32_t best;           /* index of best level, USRL_BOOK_EMPTY if none */
+    uint32_t levels;        /* non-empty levels in the window */
+    uint64_t *qty;          /* window_ticks entries */
+    UsrlBookLevel *deep;    /* overflow beyond the far end, best last */
+    uint32_t deep_count;
+    uint32_t deep_cap;
+} UsrlBookSide;
+
+typedef struct {
+    UsrlBookSide side[2];
+    uint64_t timestamp_ns;  /* last applied update */
+    uint32_t dirty;         /* touch changed since last publish */
+    uint32_t _pad;
+} UsrlBook;
+
+typedef struct {
+    UsrlBook *books;
+    uint64_t *levels;       /* one allocation backing every side */
+    uint32_t max_symbols;
+    uint32_t window_ticks;  /* power of two */
+
+    uint32_t *dirty;        /* symbols with a pending top-of-book change */
+    uint32_t dirty_count;
+
+    UsrlSubscriber in;
+    UsrlPublisher out;
+    int has_in;
+    int has_out;
+
+    /* Stats */
+    uint64_t updates;       /* applied */
+    uint64_t rejected;      /* malformed / unknown symbol */
+    uint64_t out_of_window; /* deeper than the window (kept in the overflow) */
+    uint64_t dropped_levels;/* lost: overflow could not grow */
+    uint64_t lapped;        /* views overwritten before they were applied */
+    uint64_t tob_published;
+} UsrlBookBuilder;
+
+/* Lifecycle */
+int usrl_book_init(UsrlBookBuilder *b, uint32_t max_symbols, uint32_t window_ticks);
+void usrl_book_free(UsrlBookBuilder *b);
+
+/* Wire up input/output topics (out_topic may be NULL) */
+int usrl_book_attach(UsrlBookBuilder *b, void *core_base, const char *in_topic,
+                     const char *out_topic, uint16_t pub_id);
+
+/* Apply one update; returns 1 if the top of book changed, 0 if not, -1 if rejected */
+int usrl_book_apply(UsrlBookBuilder *b, const UsrlBookUpdate *u);
+
+/* Consume up to max_batch input records and publish conflated changes */
+int usrl_book_poll(UsrlBookBuilder *b, uint32_t max_batch);
+
+/* Publish pending top-of-book changes; returns records published */
+int usrl_book_flush(UsrlBookBuilder *b);
+
+/* Queries */
+int usrl_book_top(const UsrlBookBuilder *b, uint32_t symbol_id, UsrlTopOfBook *out);
+uint64_t usrl_book_qty_at(const UsrlBookBuilder *b, uint32_t symbol_id, int side, int64_t price_ticks);
+
+#endif /* USRL_BOOK_H */
@@ -0,0 +1,129 @@
+#ifndef USRL_COLUMNAR_H
+#define USRL_COLUMNAR_H
+
+/* --------------------------------------------------------------------------
+ * USRL Columnar — journal segments transposed into per-column files
+ *
+ * An export directory holds one "<column>.col" file per schema field plus
+ * the record metadata columns "_seq", "_ts" and "_pub_id":
+ *
+ *   [UsrlColHeader][block][block]...[UsrlColBlock index]
+ *
+ *   - A block holds block_rows fixed-width values (the last may be short).
+ *     Blocks start on 64-byte boundaries, so an uncompressed block is
+ *     scanned in place from the mapping with aligned vector loads.
+ *   - USRL_COL_DELTA stores integer columns as zigzag varint deltas
+ *     (seqs and timestamps shrink to ~1-2 bytes a row); float, string and
+ *     bytes columns always stay raw.
+ *   - The index keeps each block's offset, rows and min / max, so range
+ *     scans skip blocks without touching them.
+ *   - Files are written under a temporary name and renamed when complete.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include "usrl_schema.h"
+
+#define USRL_COL_MAGIC 0x4C435355      /* 'USCL' */
+#define USRL_COL_VERSION 1
+#define USRL_COL_EXT ".col"
+#define USRL_COL_ALIGN 64
+#define USRL_COL_BLOCK_ROWS 65536      /* default */
+#define USRL_COL_MAX_COLUMNS (USRL_MAX_FIELDS + 3)
+
+#define USRL_COL_RAW   0
+#define USRL_COL_DELTA 1
+
+typedef union {
+    int64_t i;
+    uint64_t u;
+    double f;
+} UsrlColValue;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t codec;             /* USRL_COL_RAW / USRL_COL_DELTA */
+    uint32_t type;              /* UsrlFieldType */
+    uint32_t width;             /* bytes per value */
+    uint64_t rows;
+    uint32_t block_rows;
+    uint32_t block_count;
+    uint64_t index_offset;
+    uint64_t first_seq;         /* journal range exported */
+    uint64_t last_seq;
+    char name[64];
+    char topic[64];
+    uint8_t _reserved[72];
+} UsrlColHeader;
+
+typedef struct
+{
+    uint64_t offset;            /* from the file start, USRL_COL_ALIGN aligned */
+    uint64_t first_row;
+    uint32_t rows;
+    uint32_t bytes;             /* stored size */
+    UsrlColValue min;           /* numeric columns only */
+    UsrlColValue max;
+} UsrlColBlock;
+
+#ifndef __cplusplus
+_Static_assert(sizeof(UsrlColHeader) == 256, "column header size");
+_Static_assert(sizeof(UsrlColBlock) == 40, "column block entry size");
+#endif
+
+/* --------------------------------------------------------------------------
+ * Export
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    const UsrlSchema *schema;   /* NULL = metadata columns only */
+    const char *fields;         /* comma separated subset, NULL = all */
+    uint32_t block_rows;        /* 0 = USRL_COL_BLOCK_ROWS */
+    uint16_t codec;             /* for integer columns */
+    uint64_t from_seq;          /* 0 = from the start */
+    uint64_t to_seq;            /* 0 = to the end */
+} UsrlColSpec;
+
+typedef struct {
+    uint64_t segments;
+    uint64_t rows;
+    uint64_t short_records;     /* shorter than the schema, not exported */
+    uint32_t columns;
+    uint64_t bytes_in;          /* journal payload bytes read */
+    uint64_t bytes_raw;         /* column values before encoding */
+    uint64_t bytes_out;
+} UsrlColStats;
+
+/* Export a topic journal (usrl_journal.h) into out_dir. Returns 0 or -1. */
+int usrl_col_export(const char *journal_dir, const char *topic, const char *out_dir,
+                    const UsrlColSpec *spec, UsrlColStats *stats);
+
+/* --------------------------------------------------------------------------
+ * Reader (mmap)
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    const uint8_t *base;
+    uint64_t size;
+    const UsrlColHeader *hdr;
+    const UsrlColBlock *blocks;
+} UsrlColumn;
+
+int usrl_col_open(UsrlColumn *c, const char *dir, const char *name);
+void usrl_col_close(UsrlColumn *c);
+
+/* Scratch for decoding one block: block_rows * width, USRL_COL_ALIGN aligned */
+void *usrl_col_scratch(const UsrlColumn *c);
+
+/*
+ * Values of block b: a pointer into the mapping for raw blocks, else
+ * decoded into scratch. NULL if the block is corrupt.
+ */
+const void *usrl_col_block(const UsrlColumn *c, uint32_t b, void *scratch);
+
+/* First block whose max is >= v (integer columns sorted by value: _seq, _ts) */
+uint32_t usrl_col_seek(const UsrlColumn *c, int64_t v);
+
+/* Column names in dir, up to max; returns the total count or -1 */
+int usrl_col_list(const char *dir, char (*names)[64], uint32_t max);
+
+#endif /* USRL_COLUMNAR_H */
@@ -0,0 +1,123 @@
+#ifndef USRL_INDICATORS_H
+#define USRL_INDICATORS_H
+
+/* --------------------------------------------------------------------------
+ * USRL Indicators — incremental per-key streaming statistics
+ *
+ * Consumes schema records from a topic and keeps a set of indicators per
+ * key (e.g. per symbol), each fed by a numeric schema field:
+ *
+ *   EMA      alpha = 2 / (period + 1), seeded by the first sample
+ *   VWAP     sum(value * weight) / sum(weight), over the last `period`
+ *            samples (0 = since start)
+ *   MEAN/VAR rolling mean / population variance over the last `period`
+ *            samples (Welford add/remove, no re-summing)
+ *   MIN/MAX  rolling extremes over the last `period` samples with a
+ *            monotonic deque (amortised O(1) per sample)
+ *
+ *   - All per-key state (scalars, then the window rings) lives in one
+ *     contiguous block per key, allocated up front: steady state never
+ *     allocates and one key's update touches only its own cache lines.
+ *   - Output is conflated per batch, like the book builder: each key that
+ *     received input publishes one UsrlIndRecord with its latest values.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include "usrl_ring.h"
+#include "usrl_schema.h"
+#include "usrl_keys.h"
+
+#define USRL_MAX_INDICATORS 16      /* indicators per operator */
+#define USRL_IND_MAX_BATCH 256
+
+typedef enum {
+    USRL_IND_EMA  = 1,
+    USRL_IND_VWAP = 2,
+    USRL_IND_MEAN = 3,
+    USRL_IND_VAR  = 4,
+    USRL_IND_MIN  = 5,
+    USRL_IND_MAX  = 6,
+} UsrlIndKind;
+
+typedef struct {
+    UsrlIndKind kind;
+    const char *field;      /* numeric input field */
+    const char *weight;     /* VWAP volume field (ignored otherwise) */
+    uint32_t period;        /* EMA period / window length in samples */
+} UsrlIndSpec;
+
+/* Output record (wire format), followed by `count` doubles in spec order */
+typedef struct __attribute__((packed)) {
+    uint64_t timestamp_ns;  /* SlotHeader time of the last input */
+    uint64_t samples;       /* inputs seen for this key */
+    uint32_t key_id;
+    uint16_t count;
+    uint16_t warm;          /* bit i: indicator i has seen a full period */
+    char key[USRL_KEY_MAX]; /* string keys, NUL padded */
+    double value[];
+} UsrlIndRecord;
+
+/* Resolved spec */
+typedef struct {
+    uint32_t kind;
+    uint32_t period;
+    const UsrlField *value;
+    const UsrlField *weight;
+    double alpha;           /* EMA */
+    uint32_t ring_offset;   /* window ring within the key block, 0 = none */
+    uint32_t _pad;
+} UsrlIndDef;
+
+typedef struct {
+    const UsrlSchema *schema;
+    UsrlKeyIndex keys;
+    UsrlIndDef defs[USRL_MAX_INDICATORS];
+    uint32_t count;
+
+    uint8_t *state;         /* max_keys blocks of `stride` bytes */
+    uint32_t stride;
+    uint32_t max_keys;
+
+    uint32_t *dirty;        /* keys updated since last flush */
+    uint32_t dirty_count;
+    uint8_t *scratch;       /* input record copy */
+    uint8_t *out_buf;       /* output record */
+    uint32_t out_size;
+
+    UsrlSubscriber in;
+    UsrlPublisher out;
+    int has_in;
+    int has_out;
+
+    /* Stats */
+    uint64_t updates;
+    uint64_t rejected;      /* short record / unknown key */
+    uint64_t lapped;
+    uint64_t published;
+} UsrlIndicators;
+
+/* Lifecycle (key_field may be NULL: one key) */
+int usrl_ind_init(UsrlIndicators *x, const UsrlSchema *schema, const char *key_field,
+                  uint32_t max_keys, const UsrlIndSpec *specs, uint32_t count);
+void usrl_ind_free(UsrlIndicators *x);
+
+int usrl_ind_attach(UsrlIndicators *x, void *core_base, const char *in_topic,
+                    const char *out_topic, uint16_t pub_id);
+
+/* Feed one record; returns its key id or -1 if rejected */
+int32_t usrl_ind_apply(UsrlIndicators *x, const uint8_t *record, uint64_t timestamp_ns);
+
+/* Consume up to max_batch input records and publish one result per touched key */
+int usrl_ind_poll(UsrlIndicators *x, uint32_t max_batch);
+int usrl_ind_flush(UsrlIndicators *x);
+
+/* Queries */
+double usrl_ind_value(const UsrlIndicators *x, uint32_t key_id, uint32_t ind);
+int usrl_ind_warm(const UsrlIndicators *x, uint32_t key_id, uint32_t ind);
+int usrl_ind_record(const UsrlIndicators *x, uint32_t key_id, UsrlIndRecord *out, uint32_t out_size);
+
+static inline uint32_t usrl_ind_record_size(uint32_t count) {
+    return (uint32_t)(sizeof(UsrlIndRecord) + count * sizeof(double));
+}
+
+#endif /* USRL_INDICATORS_H */
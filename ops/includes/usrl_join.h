@@ -0,0 +1,116 @@
+#ifndef USRL_JOIN_H
+#define USRL_JOIN_H
+
+/* --------------------------------------------------------------------------
+ * USRL As-Of Join — match each left record with the prevailing right record
+ *
+ * Consumes two topics of schema records (e.g. trades = left, quotes =
+ * right) and, for every left record, finds the newest right record with
+ * the same key whose time is <= the left time and no older than
+ * tolerance_ns. The joined record goes to an output topic.
+ *
+ *   - Right records are kept per key in a bounded ring of the last `depth`
+ *     records (preallocated), so a left record that is a little behind the
+ *     right stream still joins against the quote that was current then.
+ *   - Each poll drains the right topic before the left one: a quote that was
+ *     committed before the trade is visible to it. The drain stops after
+ *     USRL_JOIN_RIGHT_BATCHES batches, so a right stream faster than that
+ *     can leave left records joining slightly stale quotes, but never stalls
+ *     the left side.
+ *   - Left records are read in place from zero-copy views and copied
+ *     straight into the output record, then validated against lapping.
+ *   - Time is SlotHeader.timestamp_ns unless a time field is named per side.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include "usrl_ring.h"
+#include "usrl_schema.h"
+#include "usrl_keys.h"
+
+#define USRL_JOIN_MAX_BATCH 256
+#define USRL_JOIN_RIGHT_BATCHES 16  /* right-side batches per poll */
+
+#define USRL_JOIN_INNER 0   /* Publish matched left records only */
+#define USRL_JOIN_LEFT  1   /* Publish every left record; unmatched ones carry a zeroed right side */
+
+#define USRL_JOIN_F_MATCHED 0x01
+
+typedef struct {
+    const char *left_key;       /* key fields (integer or text, same kind on both sides) */
+    const char *right_key;
+    const char *left_time;      /* event time fields (ns), NULL = SlotHeader.timestamp_ns */
+    const char *right_time;
+    uint64_t tolerance_ns;      /* max left - right time, 0 = unbounded */
+    uint32_t depth;             /* right records kept per key (rounded up to a power of two) */
+    uint32_t mode;              /* USRL_JOIN_INNER / USRL_JOIN_LEFT */
+} UsrlJoinSpec;
+
+/* Output record (wire format): header, left record, right record */
+typedef struct __attribute__((packed)) {
+    uint64_t left_ns;
+    uint64_t right_ns;          /* 0 when unmatched */
+    uint32_t key_id;
+    uint32_t flags;             /* USRL_JOIN_F_MATCHED */
+} UsrlJoinHeader;
+
+typedef struct {
+    const UsrlSchema *left;
+    const UsrlSchema *right;
+    const UsrlField *left_key;
+    const UsrlField *right_key;
+    const UsrlField *left_time;
+    const UsrlField *right_time;
+    UsrlKeyIndex keys;
+    uint64_t tolerance_ns;
+    uint32_t depth;
+    uint32_t mode;
+    uint32_t max_keys;
+
+    uint8_t *buf;               /* max_keys * depth entries: uint64 time + right record */
+    uint32_t entry_size;
+    uint64_t *count;            /* per key: right records ever stored */
+
+    uint8_t *scratch;           /* right record copy */
+    uint8_t *out_buf;
+    uint32_t out_size;
+
+    UsrlSubscriber in_left;
+    UsrlSubscriber in_right;
+    UsrlPublisher out;
+    int has_in;
+    int has_out;
+
+    /* Stats */
+    uint64_t left_in;
+    uint64_t right_in;
+    uint64_t matched;
+    uint64_t unmatched;         /* no right record for the key, or too old */
+    uint64_t rejected;          /* short record / unknown key */
+    uint64_t lapped;
+    uint64_t published;
+} UsrlJoin;
+
+int usrl_join_init(UsrlJoin *j, const UsrlSchema *left, const UsrlSchema *right,
+                   const UsrlJoinSpec *spec, uint32_t max_keys);
+void usrl_join_free(UsrlJoin *j);
+
+int usrl_join_attach(UsrlJoin *j, void *core_base, const char *left_topic,
+                     const char *right_topic, const char *out_topic, uint16_t pub_id);
+
+/* Feed a right record */
+int usrl_join_right(UsrlJoin *j, const uint8_t *record, uint64_t timestamp_ns);
+
+/*
+ * Join a left record into out (usrl_join_record_size() bytes).
+ * Returns 1 if matched, 0 if not (out then carries a zeroed right side).
+ */
+int usrl_join_left(UsrlJoin *j, const uint8_t *record, uint64_t timestamp_ns, uint8_t *out);
+
+/* Drain the right topic (bounded), then consume up to max_batch left records */
+int usrl_join_poll(UsrlJoin *j, uint32_t max_batch);
+
+static inline uint32_t usrl_join_record_size(const UsrlJoin *j) {
+    return j->out_size;
+}
+
+#endif /* USRL_JOIN_H */
@@ -0,0 +1,94 @@
+#ifndef USRL_JSON_H
+#define USRL_JSON_H
+
+/* --------------------------------------------------------------------------
+ * USRL JSON Transcoder — parse JSON payloads once, publish schema records
+ *
+ * Turns flat JSON objects (e.g. crypto.py's embed_ts_json: 8-byte LE
+ * timestamp + JSON text) into fixed-layout UsrlSchema records, so consumers
+ * read binary fields instead of re-parsing text.
+ *
+ *   - Stage 1 classifies 64 input bytes at a time into bitmasks (quotes,
+ *     backslashes, structural characters) with AVX2 / SSE2 compares, or a
+ *     scalar loop elsewhere. Escaped quotes and in-string ranges are
+ *     resolved with carry/prefix-xor bit tricks, simdjson style.
+ *   - Stage 2 walks the structural positions of the top-level object and
+ *     stores each recognised key's value at its schema offset. Unknown keys
+ *     and nested objects/arrays are skipped without being parsed.
+ *   - Fields missing from the text are left zero; the `present` mask says
+ *     which fields were filled.
+ *   - Anything but whitespace outside the tokens (after a closing quote or
+ *     bracket, or after the top-level object) rejects the payload.
+ *   - The transcoder stage reads input as zero-copy views, forwards trace
+ *     context, and drops records whose slot was lapped mid-parse.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include "usrl_ring.h"
+#include "usrl_schema.h"
+
+#define USRL_JSON_MAX_BATCH 256
+#define USRL_JSON_KEY_SLOTS 64      /* key hash table, 2 * USRL_MAX_FIELDS */
+
+#define USRL_JSON_F_SCALAR 0x01     /* Force the scalar stage-1 scanner */
+
+/* Key -> field binding */
+typedef struct {
+    const char *key;                /* JSON key (points into the schema or alias) */
+    uint32_t key_len;
+    int32_t field;                  /* schema field index, -1 = empty slot */
+} UsrlJsonKey;
+
+typedef struct {
+    const UsrlSchema *schema;
+    UsrlJsonKey keys[USRL_JSON_KEY_SLOTS];
+    uint32_t prefix_len;            /* bytes before the JSON text */
+    int32_t prefix_field;           /* U64 field receiving an 8-byte LE prefix, -1 = none */
+    uint32_t flags;
+} UsrlJsonMap;
+
+typedef struct {
+    UsrlJsonMap map;
+    UsrlSubscriber in;
+    UsrlPublisher out;
+    int has_in;
+    int has_out;
+    uint8_t *record;        /* schema->total_size scratch record */
+
+    /* Stats */
+    uint64_t records;       /* transcoded */
+    uint64_t rejected;      /* malformed JSON / not an object */
+    uint64_t lapped;        /* views overwritten while parsing */
+    uint64_t published;
+} UsrlJsonTranscoder;
+
+/* Map: every schema field is bound to the JSON key of the same name */
+int usrl_json_map_init(UsrlJsonMap *m, const UsrlSchema *schema);
+
+/* Bind an additional JSON key to a field (key must outlive the map) */
+int usrl_json_map_alias(UsrlJsonMap *m, const char *key, const char *field);
+
+/* Skip prefix_len bytes before the text; an 8-byte prefix may fill ts_field (or NULL) */
+int usrl_json_map_prefix(UsrlJsonMap *m, uint32_t prefix_len, const char *ts_field);
+
+/*
+ * Transcode one payload into out (schema->total_size bytes).
+ * Returns bytes written, or -1 if the text is not a well-formed flat object.
+ * present (optional) gets bit i set for each schema field i that was filled.
+ */
+int usrl_json_transcode(const UsrlJsonMap *m, const uint8_t *in, uint32_t len,
+                        uint8_t *out, uint32_t out_cap, uint32_t *present);
+
+/* Stage-1 backend compiled in: "avx2", "sse2" or "scalar" */
+const char *usrl_json_backend(void);
+
+/* Transcoder stage */
+int usrl_json_tc_init(UsrlJsonTranscoder *t, const UsrlSchema *schema);
+void usrl_json_tc_free(UsrlJsonTranscoder *t);
+int usrl_json_tc_attach(UsrlJsonTranscoder *t, void *core_base, const char *in_topic,
+                        const char *out_topic, uint16_t pub_id);
+
+/* Consume up to max_batch input records; returns views consumed */
+int usrl_json_tc_poll(UsrlJsonTranscoder *t, uint32_t max_batch);
+
+#endif /* USRL_JSON_H */
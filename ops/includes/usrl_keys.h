@@ -0,0 +1,47 @@
+#ifndef USRL_KEYS_H
+#define USRL_KEYS_H
+
+/* --------------------------------------------------------------------------
+ * USRL Key Index — map a record's key field to a dense per-key slot
+ *
+ * Keyed operators keep their state in flat arrays indexed by key id.
+ *
+ *   - Integer key fields are used as the id directly (dense ids, see
+ *     usrl_intern.h); values >= max_keys are rejected.
+ *   - String / bytes key fields are assigned ids in arrival order through
+ *     an open-addressing table. Only the first USRL_KEY_MAX bytes count.
+ *   - A NULL key field puts every record under key 0.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include "usrl_schema.h"
+
+#define USRL_KEY_MAX 16
+
+typedef struct {
+    const UsrlField *field;
+    uint32_t max_keys;
+    uint32_t count;         /* ids handed out (string keys) */
+    uint32_t mask;          /* table slots - 1 */
+    int32_t *table;         /* key id per slot, -1 = empty */
+    char (*names)[USRL_KEY_MAX + 1]; /* NUL terminated */
+} UsrlKeyIndex;
+
+int usrl_keys_init(UsrlKeyIndex *k, const UsrlField *field, uint32_t max_keys);
+void usrl_keys_free(UsrlKeyIndex *k);
+
+/* Key id of a record (assigned on first sight), -1 if out of range or full */
+int32_t usrl_keys_lookup(UsrlKeyIndex *k, const uint8_t *record);
+
+/*
+ * Same, reading the key from `field` of another schema (e.g. the other side
+ * of a join). It must be of the same kind, integer or text, as the index
+ * field. With assign = 0, unseen string keys return -1.
+ */
+int32_t usrl_keys_lookup_field(UsrlKeyIndex *k, const UsrlField *field,
+                               const uint8_t *record, int assign);
+
+/* Name of a string key id; "" for integer keys or unknown ids */
+const char *usrl_keys_name(const UsrlKeyIndex *k, uint32_t id);
+
+#endif /* USRL_KEYS_H */
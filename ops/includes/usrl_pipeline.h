@@ -0,0 +1,87 @@
+#ifndef USRL_PIPELINE_H
+#define USRL_PIPELINE_H
+
+/* --------------------------------------------------------------------------
+ * USRL Pipeline — declarative operator graphs from a JSON description
+ *
+ * A pipeline file is a config.json (memory_size_mb, topics) extended with
+ * schemas, executor threads and stages:
+ *
+ *   {
+ *     "memory_size_mb": 256,
+ *     "topics":  [ { "name": "md_json", "slots": 8192, "payload_size": 512 } ],
+ *     "schemas": [ { "name": "tick", "fields": [
+ *                    { "name": "symbol", "type": "string", "size": 16 },
+ *                    { "name": "price",  "type": "f64" } ] } ],
+ *     "threads": [ { "name": "md", "cpu": 2 } ],
+ *     "stages":  [
+ *       { "name": "parse", "op": "json",   "in": "md_json", "out": "ticks",
+ *         "schema": "tick", "thread": "md" },
+ *       { "name": "bars",  "op": "window", "in": "ticks", "out": "bars_1s",
+ *         "schema": "tick", "key": "symbol", "price": "price", "size_ms": 1000,
+ *         "thread": "md" } ]
+ *   }
+ *
+ *   - Operators: json, indicators, window, join, book, router, bridge.
+ *   - Stage outputs that are not declared under "topics" are intermediate:
+ *     the runner creates them, sized to the producing operator's record.
+ *   - An intermediate topic with one producer and one consumer on the same
+ *     thread is fused: the producer hands each record straight to the
+ *     consumer and the ring is never created ("fuse": false opts out).
+ *   - Each thread polls its stages' ring inputs in batches and is pinned to
+ *     "cpu" when given. Per-stage in / out / dropped counts and ring lag
+ *     are kept in a metrics registry (usrl_metrics.h) as "pipe.<stage>.*".
+ * -------------------------------------------------------------------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "usrl_core.h"
+
+#define USRL_PIPE_MAX_STAGES 64
+#define USRL_PIPE_MAX_THREADS 16
+#define USRL_PIPE_MAX_TOPICS 64
+#define USRL_PIPE_MAX_PORTS 16      /* router outputs */
+#define USRL_PIPE_NAME_MAX 32
+
+typedef struct UsrlPipeline UsrlPipeline;
+
+typedef struct {
+    char name[USRL_PIPE_NAME_MAX];
+    char op[16];
+    char thread[USRL_PIPE_NAME_MAX];
+    uint32_t fused;         /* inputs fed in-process by an upstream stage */
+    uint64_t in;            /* records consumed */
+    uint64_t out;           /* records emitted (ring or fused) */
+    uint64_t dropped;       /* rejected / late / lapped / send failures */
+    uint64_t lag;           /* committed but unread records on ring inputs */
+} UsrlPipeStageStats;
+
+/*
+ * Parse a pipeline and initialise every operator (no shared memory yet).
+ * Returns NULL on error with a message in err.
+ */
+UsrlPipeline *usrl_pipeline_load(const char *json, char *err, size_t err_len);
+void usrl_pipeline_free(UsrlPipeline *p);
+
+/* Topics the core must hold: declared ones, then intermediate ring topics */
+int usrl_pipeline_topics(const UsrlPipeline *p, UsrlTopicConfig *out, uint32_t max);
+
+/* Create ("create": true, the default) or map the core, then attach */
+int usrl_pipeline_open(UsrlPipeline *p, char *err, size_t err_len);
+
+/* Attach every stage to an already mapped core */
+int usrl_pipeline_attach(UsrlPipeline *p, void *core_base, char *err, size_t err_len);
+
+/* One executor round for a thread; returns records consumed */
+int usrl_pipeline_poll(UsrlPipeline *p, uint32_t thread);
+
+/* Executor threads (usrl_pipeline_stop also closes open windows) */
+int usrl_pipeline_start(UsrlPipeline *p);
+void usrl_pipeline_stop(UsrlPipeline *p);
+
+/* Introspection */
+uint32_t usrl_pipeline_stage_count(const UsrlPipeline *p);
+uint32_t usrl_pipeline_thread_count(const UsrlPipeline *p);
+int usrl_pipeline_stats(const UsrlPipeline *p, UsrlPipeStageStats *out, uint32_t max);
+
+#endif /* USRL_PIPELINE_H */
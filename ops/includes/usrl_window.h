@@ -0,0 +1,134 @@
+#ifndef USRL_WINDOW_H
+#define USRL_WINDOW_H
+
+/* --------------------------------------------------------------------------
+ * USRL Window Aggregator — event-time OHLCV bars from tick topics
+ *
+ * Groups schema records by key into tumbling or sliding event-time windows
+ * and publishes one UsrlBar per (key, window) when the window closes.
+ *
+ *   - Event time is SlotHeader.timestamp_ns, or a schema field.
+ *   - The watermark is the highest event time seen minus lateness_ns. A
+ *     window [start, end) closes once the watermark reaches `end`; records
+ *     that only belong to closed windows are dropped and counted as late.
+ *   - Windows are built from panes of slide_ns: a tumbling window is one
+ *     pane, a sliding window combines size/slide panes. Each record
+ *     updates exactly one pane whatever the overlap.
+ *   - Pane rings for every key are one array allocated at init: the steady
+ *     state never allocates.
+ * -------------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include "usrl_ring.h"
+#include "usrl_schema.h"
+#include "usrl_keys.h"
+
+#define USRL_WINDOW_MAX_BATCH 256
+
+typedef struct {
+    uint64_t size_ns;       /* window length */
+    uint64_t slide_ns;      /* 0 = tumbling; else size_ns must be a multiple */
+    uint64_t lateness_ns;   /* allowed out-of-orderness */
+    const char *key;        /* key field, NULL = one key */
+    const char *price;      /* numeric field */
+    const char *qty;        /* numeric field, NULL = every record counts 1 */
+    const char *time;       /* event time field (ns), NULL = SlotHeader.timestamp_ns */
+} UsrlWindowSpec;
+
+/* Output record (wire format) */
+typedef struct __attribute__((packed)) {
+    uint64_t start_ns;      /* window [start_ns, end_ns) */
+    uint64_t end_ns;
+    uint32_t key_id;
+    uint32_t count;         /* records in the window */
+    char key[USRL_KEY_MAX]; /* string keys, NUL padded */
+    double open;
+    double high;
+    double low;
+    double close;
+    double volume;
+    double vwap;
+} UsrlBar;
+
+typedef void (*UsrlBarFn)(const UsrlBar *bar, void *arg);
+
+/* One slide_ns slice of one key */
+typedef struct {
+    uint64_t pane;          /* pane index (event time / slide_ns) + 1, 0 = empty */
+    uint64_t first_ns;      /* event times of open / close */
+    uint64_t last_ns;
+    double open;
+    double high;
+    double low;
+    double close;
+    double volume;
+    double notional;        /* sum(price * qty) */
+    uint32_t count;
+    uint32_t _pad;
+} UsrlPane;
+
+typedef struct {
+    const UsrlSchema *schema;
+    UsrlKeyIndex keys;
+    const UsrlField *price;
+    const UsrlField *qty;
+    const UsrlField *time;
+
+    uint64_t slide_ns;
+    uint64_t lateness_ns;
+    uint32_t panes_per_window;
+    uint32_t ring_mask;     /* pane ring per key */
+    uint32_t max_keys;
+
+    UsrlPane *panes;        /* max_keys * (ring_mask + 1) */
+    uint64_t *newest;       /* per key: newest pane + 1, 0 = none */
+    uint32_t *active;       /* keys with live panes */
+    int32_t *active_pos;    /* per key: index in active, -1 = inactive */
+    uint32_t active_count;
+
+    uint64_t max_event_ns;
+    uint64_t closed_pane;   /* windows ending at or before pane boundary * slide_ns are closed */
+    int started;
+
+    UsrlBarFn on_bar;
+    void *on_bar_arg;
+
+    uint8_t *scratch;
+    UsrlSubscriber in;
+    UsrlPublisher out;
+    int has_in;
+    int has_out;
+
+    /* Stats */
+    uint64_t records;
+    uint64_t late;          /* dropped: all its windows had closed */
+    uint64_t rejected;      /* short record / unknown key */
+    uint64_t lapped;
+    uint64_t bars;          /* emitted */
+    uint64_t published;
+} UsrlWindowAgg;
+
+int usrl_window_init(UsrlWindowAgg *w, const UsrlSchema *schema, const UsrlWindowSpec *spec,
+                     uint32_t max_keys);
+void usrl_window_free(UsrlWindowAgg *w);
+
+int usrl_window_attach(UsrlWindowAgg *w, void *core_base, const char *in_topic,
+                       const char *out_topic, uint16_t pub_id);
+
+/* Optional callback for every emitted bar (called before publishing) */
+void usrl_window_on_bar(UsrlWindowAgg *w, UsrlBarFn fn, void *arg);
+
+/* Feed one record; returns its key id, -1 if rejected or late */
+int32_t usrl_window_apply(UsrlWindowAgg *w, const uint8_t *record, uint64_t timestamp_ns);
+
+/* Consume up to max_batch input records; returns views consumed */
+int usrl_window_poll(UsrlWindowAgg *w, uint32_t max_batch);
+
+/* Close windows ending at or before watermark_ns (idle input; UINT64_MAX flushes all).
+ * Returns bars emitted. */
+int usrl_window_advance(UsrlWindowAgg *w, uint64_t watermark_ns);
+
+/* End of the newest closed window */
+uint64_t usrl_window_watermark(const UsrlWindowAgg *w);
+
+#endif /* USRL_WINDOW_H */
@@ -0,0 +1,448 @@
+/**
+ * @file usrl_book.c
+ * @brief Per-symbol L2 book builder over tick-indexed level windows.
+ */
+
+#include "usrl_book.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t next_power_of_two_u32(uint32_t v)
+{
+    if (v == 0) return 1;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return ++v;
+}
+
+/* ============================================================================
+ * LIFECYCLE
+ * ============================================================================ */
+
+int usrl_book_init(UsrlBookBuilder *b, uint32_t max_symbols, uint32_t window_ticks)
+{
+    if (!b || max_symbols == 0 || window_ticks < 2) return -1;
+    memset(b, 0, sizeof(*b));
+
+    uint32_t w = next_power_of_two_u32(window_ticks);
+    uint64_t per_side = (uint64_t)w * sizeof(uint64_t);
+
+    b->books = calloc(max_symbols, sizeof(UsrlBook));
+    b->dirty = calloc(max_symbols, sizeof(uint32_t));
+    if (posix_memalign((void **)&b->levels, USRL_ALIGNMENT, per_side * 2 * max_symbols) != 0)
+        b->levels = NULL;
+
+    if (!b->books || !b->dirty || !b->levels) {
+        usrl_book_free(b);
+        return -1;
+    }
+    memset(b->levels, 0, per_side * 2 * max_symbols);
+
+    b->max_symbols = max_symbols;
+    b->window_ticks = w;
+
+    for (uint32_t i = 0; i < max_symbols; i++) {
+        for (int s = 0; s < 2; s++) {
+            UsrlBookSide *side = &b->books[i].side[s];
+            side->qty = b->levels + ((uint64_t)i * 2 + (uint64_t)s) * w;
+            side->best = USRL_BOOK_EMPTY;
+        }
+    }
+    return 0;
+}
+
+void usrl_book_free(UsrlBookBuilder *b)
+{
+    if (!b) return;
+    if (b->books) {
+        for (uint32_t i = 0; i < b->max_symbols; i++) {
+            free(b->books[i].side[0].deep);
+            free(b->books[i].side[1].deep);
+        }
+    }
+    free(b->books);
+    free(b->dirty);
+    free(b->levels);
+    memset(b, 0, sizeof(*b));
+}
+
+int usrl_book_attach(UsrlBookBuilder *b, void *core_base, const char *in_topic,
+                     const char *out_topic, uint16_t pub_id)
+{
+    if (!b || !core_base || !in_topic) return -1;
+
+    usrl_sub_init(&b->in, core_base, in_topic);
+    b->has_in = (b->in.desc != NULL);
+    if (!b->has_in) return -1;
+
+    if (out_topic) {
+        usrl_pub_init(&b->out, core_base, out_topic, pub_id);
+        b->has_out = (b->out.desc != NULL);
+        if (!b->has_out) return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * LEVEL WINDOW
+ * ============================================================================ */
+
+/* Touch offset from the better end of the window, left for it to improve into */
+#define BOOK_HEADROOM(w) ((w) / 8)
+
+static inline int64_t side_best_price(const UsrlBookSide *s)
+{
+    return (s->best == USRL_BOOK_EMPTY) ? INT64_MIN : s->base_tick + s->best;
+}
+
+static inline uint64_t side_best_qty(const UsrlBookSide *s)
+{
+    return (s->best == USRL_BOOK_EMPTY) ? 0 : s->qty[s->best];
+}
+
+/* base_tick that puts `touch` BOOK_HEADROOM ticks inside the better end */
+static inline int64_t side_anchor(uint32_t w, int is_bid, int64_t touch)
+{
+    return is_bid ? touch - (int64_t)(w - 1 - BOOK_HEADROOM(w)) : touch - (int64_t)BOOK_HEADROOM(w);
+}
+
+static int32_t scan_best(const UsrlBookSide *s, int is_bid, int32_t from, uint32_t w)
+{
+    if (s->levels == 0) return USRL_BOOK_EMPTY;
+    if (is_bid) {
+        for (int32_t i = from; i >= 0; i--)
+            if (s->qty[i]) return i;
+    } else {
+        for (int32_t i = from; i < (int32_t)w; i++)
+            if (s->qty[i]) return i;
+    }
+    return USRL_BOOK_EMPTY;
+}
+
+/* ============================================================================
+ * OVERFLOW
+ * ============================================================================ */
+
+/* Overflow order: worst first, best last (ascending bids, descending asks) */
+static inline int deep_before(int is_bid, int64_t a, int64_t b)
+{
+    return is_bid ? a < b : a > b;
+}
+
+/* Index of price, or of where it would be inserted */
+static uint32_t deep_find(const UsrlBookSide *s, int is_bid, int64_t price)
+{
+    uint32_t lo = 0, hi = s->deep_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (deep_before(is_bid, s->deep[mid].price_ticks, price)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static int deep_reserve(UsrlBookBuilder *b, UsrlBookSide *s)
+{
+    if (s->deep_count < s->deep_cap) return 0;
+    uint32_t cap = s->deep_cap ? s->deep_cap * 2 : 16;
+    UsrlBookLevel *d = realloc(s->deep, (size_t)cap * sizeof(*d));
+    if (!d) {
+        b->dropped_levels++;
+        return -1;
+    }
+    s->deep = d;
+    s->deep_cap = cap;
+    return 0;
+}
+
+static void deep_set(UsrlBookBuilder *b, UsrlBookSide *s, int is_bid, int64_t price, uint64_t qty)
+{
+    uint32_t i = deep_find(s, is_bid, price);
+    int found = (i < s->deep_count && s->deep[i].price_ticks == price);
+
+    if (found) {
+        if (qty) {
+            s->deep[i].qty = qty;
+        } else {
+            memmove(s->deep + i, s->deep + i + 1, (size_t)(s->deep_count - i - 1) * sizeof(UsrlBookLevel));
+            s->deep_count--;
+        }
+    } else if (qty && deep_reserve(b, s) == 0) {
+        memmove(s->deep + i + 1, s->deep + i, (size_t)(s->deep_count - i) * sizeof(UsrlBookLevel));
+        s->deep[i].price_ticks = price;
+        s->deep[i].qty = qty;
+        s->deep_count++;
+    }
+}
+
+/* Append a level better than everything already in the overflow */
+static inline void deep_push(UsrlBookBuilder *b, UsrlBookSide *s, int64_t price, uint64_t qty)
+{
+    if (deep_reserve(b, s) != 0) return;
+    s->deep[s->deep_count].price_ticks = price;
+    s->deep[s->deep_count].qty = qty;
+    s->deep_count++;
+}
+
+/* ============================================================================
+ * LEVEL WINDOW
+ * ============================================================================ */
+
+/*
+ * Slide the window toward better prices so that it starts at new_base.
+ * Levels pushed off the far end are all better than the overflow, so they
+ * are appended to it worst first.
+ */
+static void side_recentre(UsrlBookBuilder *b, UsrlBookSide *s, int is_bid, int64_t new_base)
+{
+    uint32_t w = b->window_ticks;
+    int64_t delta = new_base - s->base_tick;
+    int64_t mag = delta < 0 ? -delta : delta;
+    uint32_t d = mag >= (int64_t)w ? w : (uint32_t)mag;
+    uint32_t spilled = 0;
+
+    if (is_bid) {
+        for (uint32_t i = 0; i < d; i++)
+            if (s->qty[i]) {
+                deep_push(b, s, s->base_tick + i, s->qty[i]);
+                spilled++;
+            }
+        memmove(s->qty, s->qty + d, (size_t)(w - d) * sizeof(uint64_t));
+        memset(s->qty + (w - d), 0, (size_t)d * sizeof(uint64_t));
+    } else {
+        for (uint32_t i = w; i-- > w - d;)
+            if (s->qty[i]) {
+                deep_push(b, s, s->base_tick + i, s->qty[i]);
+                spilled++;
+            }
+        memmove(s->qty + d, s->qty, (size_t)(w - d) * sizeof(uint64_t));
+        memset(s->qty, 0, (size_t)d * sizeof(uint64_t));
+    }
+
+    s->levels -= spilled;
+    s->base_tick = new_base;
+
+    if (s->best != USRL_BOOK_EMPTY) {
+        int64_t nb = (int64_t)s->best - delta;
+        if (nb >= 0 && nb < (int64_t)w) s->best = (int32_t)nb;
+        else s->best = scan_best(s, is_bid, is_bid ? (int32_t)w - 1 : 0, w);
+    }
+}
+
+/* The window emptied: re-anchor it on the best overflow level and pull back what fits */
+static void side_refill(UsrlBookBuilder *b, UsrlBookSide *s, int is_bid)
+{
+    uint32_t w = b->window_ticks;
+    int64_t touch = s->deep[s->deep_count - 1].price_ticks;
+
+    s->base_tick = side_anchor(w, is_bid, touch);
+    s->best = (int32_t)(touch - s->base_tick);
+
+    while (s->deep_count) {
+        const UsrlBookLevel *l = &s->deep[s->deep_count - 1];
+        int64_t idx = l->price_ticks - s->base_tick;
+        if (idx < 0 || idx >= (int64_t)w) break;
+        s->qty[idx] = l->qty;
+        s->levels++;
+        s->deep_count--;
+    }
+}
+
+static int side_set(UsrlBookBuilder *b, UsrlBookSide *s, int is_bid, int64_t price, uint64_t qty)
+{
+    uint32_t w = b->window_ticks;
+    int64_t before = side_best_price(s);
+    uint64_t before_qty = side_best_qty(s);
+
+    /* An empty window means an empty overflow: side_refill() keeps it that way */
+    if (s->levels == 0) {
+        if (qty == 0) return 0;
+        s->base_tick = side_anchor(w, is_bid, price);
+    }
+
+    int64_t idx = price - s->base_tick;
+    if (USRL_UNLIKELY(idx < 0 || idx >= (int64_t)w)) {
+        int improves = is_bid ? (idx >= (int64_t)w) : (idx < 0);
+        if (!improves) {
+            /* Behind a non-empty window: cannot be the touch */
+            b->out_of_window++;
+            deep_set(b, s, is_bid, price, qty);
+            return 0;
+        }
+        if (qty == 0) return 0; /* Deleting a level we never had */
+        side_recentre(b, s, is_bid, side_anchor(w, is_bid, price));
+        idx = price - s->base_tick;
+    }
+
+    uint32_t i = (uint32_t)idx;
+    uint64_t old = s->qty[i];
+    s->qty[i] = qty;
+
+    if (qty) {
+        if (!old) s->levels++;
+        if (s->best == USRL_BOOK_EMPTY ||
+            (is_bid ? ((int32_t)i > s->best) : ((int32_t)i < s->best)))
+            s->best = (int32_t)i;
+    } else if (old) {
+        s->levels--;
+        if ((int32_t)i == s->best) {
+            if (s->levels == 0 && s->deep_count) side_refill(b, s, is_bid);
+            else s->best = scan_best(s, is_bid, is_bid ? (int32_t)i - 1 : (int32_t)i + 1, w);
+        }
+    }
+
+    return side_best_price(s) != before || side_best_qty(s) != before_qty;
+}
+
+static void side_clear(UsrlBookSide *s, uint32_t w)
+{
+    if (s->levels) memset(s->qty, 0, (size_t)w * sizeof(uint64_t));
+    s->levels = 0;
+    s->deep_count = 0;
+    s->best = USRL_BOOK_EMPTY;
+}
+
+/* ============================================================================
+ * UPDATES
+ * ============================================================================ */
+
+static inline void mark_dirty(UsrlBookBuilder *b, uint32_t symbol_id)
+{
+    UsrlBook *bk = &b->books[symbol_id];
+    if (!bk->dirty) {
+        bk->dirty = 1;
+        b->dirty[b->dirty_count++] = symbol_id;
+    }
+}
+
+int usrl_book_apply(UsrlBookBuilder *b, const UsrlBookUpdate *u)
+{
+    if (USRL_UNLIKELY(!b || !u || u->symbol_id >= b->max_symbols || u->side > USRL_BOOK_ASK)) {
+        if (b) b->rejected++;
+        return -1;
+    }
+
+    UsrlBook *bk = &b->books[u->symbol_id];
+    int changed;
+
+    switch (u->action) {
+    case USRL_BOOK_SET:
+        changed = side_set(b, &bk->side[u->side], u->side == USRL_BOOK_BID,
+                           u->price_ticks, u->qty);
+        break;
+    case USRL_BOOK_CLEAR:
+        changed = (bk->side[0].levels || bk->side[1].levels);
+        side_clear(&bk->side[0], b->window_ticks);
+        side_clear(&bk->side[1], b->window_ticks);
+        break;
+    default:
+        b->rejected++;
+        return -1;
+    }
+
+    bk->timestamp_ns = u->timestamp_ns;
+    b->updates++;
+    if (changed) mark_dirty(b, u->symbol_id);
+    return changed;
+}
+
+int usrl_book_poll(UsrlBookBuilder *b, uint32_t max_batch)
+{
+    if (USRL_UNLIKELY(!b || !b->has_in)) return USRL_RING_ERROR;
+    if (max_batch == 0 || max_batch > USRL_BOOK_MAX_BATCH) max_batch = USRL_BOOK_MAX_BATCH;
+
+    UsrlSlotView views[USRL_BOOK_MAX_BATCH];
+    int n = usrl_sub_view_batch(&b->in, views, max_batch);
+    if (n <= 0) return n;
+
+    for (int i = 0; i < n; i++) {
+        if (i + 1 < n) USRL_PREFETCH_R(views[i + 1].data);
+
+        if (USRL_UNLIKELY(views[i].len < sizeof(UsrlBookUpdate))) {
+            b->rejected++;
+            continue;
+        }
+
+        /* Read straight from the slot, then make sure it was not lapped */
+        UsrlBookUpdate u;
+        memcpy(&u, views[i].data, sizeof(u));
+        if (USRL_UNLIKELY(!usrl_view_valid(&views[i]))) {
+            b->lapped++;
+            continue;
+        }
+        usrl_book_apply(b, &u);
+    }
+
+    usrl_book_flush(b);
+    return n;
+}
+
+/* ============================================================================
+ * OUTPUT / QUERIES
+ * ============================================================================ */
+
+static void book_top(const UsrlBook *bk, uint32_t symbol_id, UsrlTopOfBook *out)
+{
+    const UsrlBookSide *bid = &bk->side[USRL_BOOK_BID];
+    const UsrlBookSide *ask = &bk->side[USRL_BOOK_ASK];
+
+    memset(out, 0, sizeof(*out));
+    out->timestamp_ns = bk->timestamp_ns;
+    out->symbol_id = symbol_id;
+    if (bid->best != USRL_BOOK_EMPTY) {
+        out->bid_ticks = bid->base_tick + bid->best;
+        out->bid_qty = bid->qty[bid->best];
+    }
+    if (ask->best != USRL_BOOK_EMPTY) {
+        out->ask_ticks = ask->base_tick + ask->best;
+        out->ask_qty = ask->qty[ask->best];
+    }
+}
+
+int usrl_book_flush(UsrlBookBuilder *b)
+{
+    if (!b) return 0;
+
+    int published = 0;
+    for (uint32_t i = 0; i < b->dirty_count; i++) {
+        uint32_t sym = b->dirty[i];
+        UsrlBook *bk = &b->books[sym];
+        bk->dirty = 0;
+
+        if (!b->has_out) continue;
+
+        UsrlTopOfBook tob;
+        book_top(bk, sym, &tob);
+        if (usrl_pub_publish(&b->out, &tob, sizeof(tob)) == USRL_RING_OK) published++;
+    }
+    b->dirty_count = 0;
+    b->tob_published += (uint64_t)published;
+    return published;
+}
+
+int usrl_book_top(const UsrlBookBuilder *b, uint32_t symbol_id, UsrlTopOfBook *out)
+{
+    if (!b || !out || symbol_id >= b->max_symbols) return -1;
+    book_top(&b->books[symbol_id], symbol_id, out);
+    return 0;
+}
+
+uint64_t usrl_book_qty_at(const UsrlBookBuilder *b, uint32_t symbol_id, int side, int64_t price_ticks)
+{
+    if (!b || symbol_id >= b->max_symbols || side < USRL_BOOK_BID || side > USRL_BOOK_ASK) return 0;
+
+    const UsrlBookSide *s = &b->books[symbol_id].side[side];
+    if (s->levels == 0) return 0;
+
+    int64_t idx = price_ticks - s->base_tick;
+    if (idx >= 0 && idx < (int64_t)b->window_ticks) return s->qty[idx];
+
+    int is_bid = (side == USRL_BOOK_BID);
+    uint32_t i = deep_find(s, is_bid, price_ticks);
+    return (i < s->deep_count && s->deep[i].price_ticks == price_ticks) ? s->deep[i].qty : 0;
+}
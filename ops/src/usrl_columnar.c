@@ -0,0 +1,502 @@
+/**
+ * @file usrl_columnar.c
+ * @brief Journal-to-columnar export and the mmap column reader.
+ */
+
+#include "usrl_columnar.h"
+#include "usrl_journal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define COL_TMP_SUFFIX ".tmp"
+#define COL_PATH_MAX (USRL_JOURNAL_PATH_MAX + 80)
+#define VARINT_MAX 10
+
+/* Pseudo field types of the metadata columns (after the schema's) */
+#define COL_SRC_SEQ    (-1)
+#define COL_SRC_TS     (-2)
+#define COL_SRC_PUB_ID (-3)
+
+/* ============================================================================
+ * ENCODING
+ * ============================================================================ */
+
+static inline int col_integer(uint32_t type)
+{
+    return type == USRL_FIELD_U64 || type == USRL_FIELD_I64 ||
+           type == USRL_FIELD_U32 || type == USRL_FIELD_I32;
+}
+
+static inline int64_t col_load_i64(uint32_t type, const uint8_t *p)
+{
+    switch (type) {
+    case USRL_FIELD_U32: { uint32_t v; memcpy(&v, p, 4); return (int64_t)v; }
+    case USRL_FIELD_I32: { int32_t v; memcpy(&v, p, 4); return v; }
+    default: { int64_t v; memcpy(&v, p, 8); return v; }
+    }
+}
+
+static inline void col_store_i64(uint32_t type, uint8_t *p, int64_t v)
+{
+    if (type == USRL_FIELD_U32 || type == USRL_FIELD_I32) {
+        uint32_t x = (uint32_t)v;
+        memcpy(p, &x, 4);
+    } else {
+        memcpy(p, &v, 8);
+    }
+}
+
+/* Deltas of consecutive values, zigzag-mapped, LEB128 */
+static uint32_t delta_encode(uint32_t type, uint32_t width, const uint8_t *in, uint32_t rows, uint8_t *out)
+{
+    uint8_t *o = out;
+    int64_t prev = 0;
+    for (uint32_t i = 0; i < rows; i++) {
+        int64_t v = col_load_i64(type, in + (size_t)i * width);
+        uint64_t d = (uint64_t)v - (uint64_t)prev;
+        uint64_t z = (d << 1) ^ (uint64_t)((int64_t)d >> 63);
+        prev = v;
+        while (z >= 0x80) {
+            *o++ = (uint8_t)(z | 0x80);
+            z >>= 7;
+        }
+        *o++ = (uint8_t)z;
+    }
+    return (uint32_t)(o - out);
+}
+
+static int delta_decode(uint32_t type, uint32_t width, const uint8_t *in, uint32_t len,
+                        uint32_t rows, uint8_t *out)
+{
+    const uint8_t *p = in, *end = in + len;
+    int64_t prev = 0;
+    for (uint32_t i = 0; i < rows; i++) {
+        uint64_t z = 0;
+        for (uint32_t shift = 0;; shift += 7) {
+            if (p == end || shift > 63) return -1;
+            uint8_t b = *p++;
+            z |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        uint64_t d = (z >> 1) ^ (0 - (z & 1));
+        prev = (int64_t)((uint64_t)prev + d);
+        col_store_i64(type, out + (size_t)i * width, prev);
+    }
+    return 0;
+}
+
+static void block_range(uint32_t type, uint32_t width, const uint8_t *v, uint32_t rows,
+                        UsrlColValue *min, UsrlColValue *max)
+{
+    min->u = max->u = 0;
+    if (rows == 0) return;
+
+    if (type == USRL_FIELD_F64 || type == USRL_FIELD_F32) {
+        double lo = 0, hi = 0;
+        for (uint32_t i = 0; i < rows; i++) {
+            double x;
+            if (type == USRL_FIELD_F64) {
+                memcpy(&x, v + (size_t)i * 8, 8);
+            } else {
+                float f;
+                memcpy(&f, v + (size_t)i * 4, 4);
+                x = f;
+            }
+            if (i == 0 || x < lo) lo = x;
+            if (i == 0 || x > hi) hi = x;
+        }
+        min->f = lo;
+        max->f = hi;
+    } else if (type == USRL_FIELD_U64) {
+        uint64_t lo = UINT64_MAX, hi = 0;
+        for (uint32_t i = 0; i < rows; i++) {
+            uint64_t x;
+            memcpy(&x, v + (size_t)i * 8, 8);
+            if (x < lo) lo = x;
+            if (x > hi) hi = x;
+        }
+        min->u = lo;
+        max->u = hi;
+    } else if (col_integer(type)) {
+        int64_t lo = INT64_MAX, hi = INT64_MIN;
+        for (uint32_t i = 0; i < rows; i++) {
+            int64_t x = col_load_i64(type, v + (size_t)i * width);
+            if (x < lo) lo = x;
+            if (x > hi) hi = x;
+        }
+        min->i = lo;
+        max->i = hi;
+    }
+}
+
+/* ============================================================================
+ * EXPORT
+ * ============================================================================ */
+
+typedef struct {
+    char path[COL_PATH_MAX];
+    int fd;
+    int src;                    /* schema field index, or COL_SRC_* */
+    uint32_t src_offset;        /* in the record payload */
+    UsrlColHeader hdr;
+    uint8_t *buf;               /* block_rows values */
+    uint64_t file_off;
+    UsrlColBlock *index;
+    uint32_t index_cap;
+} ColWriter;
+
+typedef struct {
+    const UsrlColSpec *spec;
+    uint32_t block_rows;
+    uint32_t block_fill;
+    ColWriter cols[USRL_COL_MAX_COLUMNS];
+    uint32_t col_count;
+    uint8_t *enc;               /* encode buffer, block_rows * VARINT_MAX */
+    uint8_t zero[USRL_COL_ALIGN];
+    UsrlColStats *st;
+} ColExport;
+
+static int write_all(int fd, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int field_selected(const char *list, const char *name)
+{
+    if (!list) return 1;
+    size_t n = strlen(name);
+    for (const char *p = list; *p;) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == n && strncmp(p, name, n) == 0) return 1;
+        if (!end) break;
+        p = end + 1;
+    }
+    return 0;
+}
+
+static int add_column(ColExport *x, const char *out_dir, const char *topic, const char *name,
+                      int src, uint32_t type, uint32_t width, uint32_t offset)
+{
+    if (x->col_count >= USRL_COL_MAX_COLUMNS) return -1;
+    ColWriter *c = &x->cols[x->col_count];
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+    c->src = src;
+    c->src_offset = offset;
+
+    UsrlColHeader *h = &c->hdr;
+    h->magic = USRL_COL_MAGIC;
+    h->version = USRL_COL_VERSION;
+    h->codec = (col_integer(type) && x->spec->codec == USRL_COL_DELTA) ? USRL_COL_DELTA : USRL_COL_RAW;
+    h->type = type;
+    h->width = width;
+    h->block_rows = x->block_rows;
+    snprintf(h->name, sizeof(h->name), "%s", name);
+    snprintf(h->topic, sizeof(h->topic), "%s", topic);
+
+    if (snprintf(c->path, sizeof(c->path), "%s/%s" USRL_COL_EXT COL_TMP_SUFFIX, out_dir, name) >=
+        (int)sizeof(c->path))
+        return -1;
+    c->buf = aligned_alloc(USRL_COL_ALIGN, usrl_align_up((uint64_t)x->block_rows * width, USRL_COL_ALIGN));
+    c->index_cap = 64;
+    c->index = malloc(c->index_cap * sizeof(UsrlColBlock));
+    c->fd = open(c->path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    x->col_count++;
+    if (!c->buf || !c->index || c->fd < 0) return -1;
+
+    /* Header is rewritten at the end; blocks start right after it */
+    c->file_off = sizeof(*h);
+    return write_all(c->fd, h, sizeof(*h));
+}
+
+static int flush_block(ColExport *x)
+{
+    uint32_t rows = x->block_fill;
+    if (rows == 0) return 0;
+
+    for (uint32_t i = 0; i < x->col_count; i++) {
+        ColWriter *c = &x->cols[i];
+        UsrlColHeader *h = &c->hdr;
+
+        const uint8_t *data = c->buf;
+        uint32_t bytes = rows * h->width;
+        if (h->codec == USRL_COL_DELTA) {
+            bytes = delta_encode(h->type, h->width, c->buf, rows, x->enc);
+            data = x->enc;
+        }
+
+        if (h->block_count == c->index_cap) {
+            UsrlColBlock *g = realloc(c->index, (size_t)c->index_cap * 2 * sizeof(*g));
+            if (!g) return -1;
+            c->index = g;
+            c->index_cap *= 2;
+        }
+        UsrlColBlock *b = &c->index[h->block_count++];
+        b->offset = c->file_off;
+        b->first_row = h->rows;
+        b->rows = rows;
+        b->bytes = bytes;
+        block_range(h->type, h->width, c->buf, rows, &b->min, &b->max);
+
+        uint32_t pad = (uint32_t)(usrl_align_up(bytes, USRL_COL_ALIGN) - bytes);
+        if (write_all(c->fd, data, bytes) != 0 || write_all(c->fd, x->zero, pad) != 0) return -1;
+        c->file_off += bytes + pad;
+        h->rows += rows;
+
+        x->st->bytes_raw += (uint64_t)rows * h->width;
+        x->st->bytes_out += bytes + pad;
+    }
+    x->block_fill = 0;
+    return 0;
+}
+
+static int append_row(ColExport *x, const UsrlJournalRecord *r)
+{
+    const uint8_t *payload = usrl_jseg_payload(r);
+    uint32_t row = x->block_fill;
+
+    for (uint32_t i = 0; i < x->col_count; i++) {
+        ColWriter *c = &x->cols[i];
+        uint32_t w = c->hdr.width;
+        uint8_t *dst = c->buf + (size_t)row * w;
+        switch (c->src) {
+        case COL_SRC_SEQ: memcpy(dst, &r->seq, 8); break;
+        case COL_SRC_TS: memcpy(dst, &r->timestamp_ns, 8); break;
+        case COL_SRC_PUB_ID: { uint32_t v = r->pub_id; memcpy(dst, &v, 4); break; }
+        default: memcpy(dst, payload + c->src_offset, w); break;
+        }
+    }
+    if (++x->block_fill == x->block_rows) return flush_block(x);
+    return 0;
+}
+
+static int finish_column(ColWriter *c, uint64_t first_seq, uint64_t last_seq)
+{
+    UsrlColHeader *h = &c->hdr;
+    h->index_offset = c->file_off;
+    h->first_seq = first_seq;
+    h->last_seq = last_seq;
+
+    if (write_all(c->fd, c->index, (size_t)h->block_count * sizeof(UsrlColBlock)) != 0) return -1;
+    if (pwrite(c->fd, h, sizeof(*h), 0) != (ssize_t)sizeof(*h)) return -1;
+    if (fdatasync(c->fd) != 0) return -1;
+
+    char final[COL_PATH_MAX];
+    size_t n = strlen(c->path) - strlen(COL_TMP_SUFFIX);
+    memcpy(final, c->path, n);
+    final[n] = '\0';
+    return rename(c->path, final);
+}
+
+int usrl_col_export(const char *journal_dir, const char *topic, const char *out_dir,
+                    const UsrlColSpec *spec, UsrlColStats *stats)
+{
+    if (!journal_dir || !topic || !out_dir || !spec) return -1;
+    if (mkdir(out_dir, 0755) != 0 && errno != EEXIST) return -1;
+
+    UsrlColStats st;
+    memset(&st, 0, sizeof(st));
+
+    int rc = -1;
+    ColExport *x = calloc(1, sizeof(*x));
+    UsrlJournalSegInfo *segs = NULL;
+    if (!x) return -1;
+    x->spec = spec;
+    x->st = &st;
+    x->block_rows = spec->block_rows ? spec->block_rows : USRL_COL_BLOCK_ROWS;
+    x->enc = malloc((size_t)x->block_rows * VARINT_MAX);
+    if (!x->enc) goto out;
+
+    /* Columns: record metadata, then the selected schema fields */
+    const UsrlSchema *schema = spec->schema;
+    uint32_t min_len = schema ? schema->total_size : 0;
+    if ((field_selected(spec->fields, "_seq") &&
+         add_column(x, out_dir, topic, "_seq", COL_SRC_SEQ, USRL_FIELD_U64, 8, 0) != 0) ||
+        (field_selected(spec->fields, "_ts") &&
+         add_column(x, out_dir, topic, "_ts", COL_SRC_TS, USRL_FIELD_U64, 8, 0) != 0) ||
+        (field_selected(spec->fields, "_pub_id") &&
+         add_column(x, out_dir, topic, "_pub_id", COL_SRC_PUB_ID, USRL_FIELD_U32, 4, 0) != 0))
+        goto out;
+    for (uint32_t i = 0; schema && i < schema->field_count; i++) {
+        const UsrlField *f = &schema->fields[i];
+        if (!field_selected(spec->fields, f->name)) continue;
+        if (add_column(x, out_dir, topic, f->name, (int)i, f->type, f->size, f->offset) != 0) goto out;
+    }
+    if (x->col_count == 0) goto out;
+
+    int n = usrl_journal_list(journal_dir, topic, NULL, 0);
+    segs = malloc((n > 0 ? (size_t)n : 1) * sizeof(*segs));
+    if (n < 0 || !segs) goto out;
+    n = usrl_journal_list(journal_dir, topic, segs, (uint32_t)n);
+
+    uint64_t seen = 0, first = 0;
+    uint64_t to = spec->to_seq ? spec->to_seq : UINT64_MAX;
+    for (int i = 0; i < n && seen < to; i++) {
+        /* Segments wholly before the range are skipped by name */
+        if (i + 1 < n && segs[i + 1].first_seq <= spec->from_seq) continue;
+
+        UsrlJournalSegment s;
+        if (usrl_jseg_open(&s, segs[i].path) != 0) continue;
+        st.segments++;
+
+        const UsrlJournalRecord *r;
+        uint64_t off = spec->from_seq ? usrl_jseg_seek_seq(&s, spec->from_seq) : usrl_jseg_begin(&s);
+        for (; (r = usrl_jseg_record(&s, off)) != NULL; off = usrl_jseg_next(r, off)) {
+            if (r->seq <= seen) continue;
+            if (r->seq > to) break;
+            seen = r->seq;
+            st.bytes_in += r->len;
+            if (r->len < min_len) {
+                st.short_records++;
+                continue;
+            }
+            if (!first) first = r->seq;
+            if (append_row(x, r) != 0) {
+                usrl_jseg_close(&s);
+                goto out;
+            }
+            st.rows++;
+        }
+        usrl_jseg_close(&s);
+    }
+    if (flush_block(x) != 0) goto out;
+
+    for (uint32_t i = 0; i < x->col_count; i++)
+        if (finish_column(&x->cols[i], first, st.rows ? seen : 0) != 0) goto out;
+    st.columns = x->col_count;
+    rc = 0;
+
+out:
+    for (uint32_t i = 0; i < x->col_count; i++) {
+        ColWriter *c = &x->cols[i];
+        if (c->fd >= 0) close(c->fd);
+        if (rc != 0) unlink(c->path);
+        free(c->buf);
+        free(c->index);
+    }
+    free(x->enc);
+    free(x);
+    free(segs);
+    if (stats) *stats = st;
+    return rc;
+}
+
+/* ============================================================================
+ * READER
+ * ============================================================================ */
+
+int usrl_col_open(UsrlColumn *c, const char *dir, const char *name)
+{
+    if (!c || !dir || !name) return -1;
+    memset(c, 0, sizeof(*c));
+
+    char path[COL_PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s" USRL_COL_EXT, dir, name) >= (int)sizeof(path)) return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(UsrlColHeader)) {
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    c->base = map;
+    c->size = (uint64_t)st.st_size;
+    c->hdr = (const UsrlColHeader *)c->base;
+
+    const UsrlColHeader *h = c->hdr;
+    if (h->magic != USRL_COL_MAGIC || h->version != USRL_COL_VERSION || h->width == 0 ||
+        h->index_offset + (uint64_t)h->block_count * sizeof(UsrlColBlock) > c->size) {
+        usrl_col_close(c);
+        return -1;
+    }
+    c->blocks = (const UsrlColBlock *)(c->base + h->index_offset);
+    madvise(map, (size_t)c->size, MADV_SEQUENTIAL);
+    return 0;
+}
+
+void usrl_col_close(UsrlColumn *c)
+{
+    if (!c) return;
+    if (c->base) munmap((void *)c->base, (size_t)c->size);
+    c->base = NULL;
+    c->hdr = NULL;
+    c->blocks = NULL;
+}
+
+void *usrl_col_scratch(const UsrlColumn *c)
+{
+    if (!c || !c->hdr) return NULL;
+    return aligned_alloc(USRL_COL_ALIGN,
+                         usrl_align_up((uint64_t)c->hdr->block_rows * c->hdr->width, USRL_COL_ALIGN));
+}
+
+const void *usrl_col_block(const UsrlColumn *c, uint32_t b, void *scratch)
+{
+    if (!c || !c->hdr || b >= c->hdr->block_count) return NULL;
+    const UsrlColBlock *blk = &c->blocks[b];
+    if (blk->offset + blk->bytes > c->hdr->index_offset || blk->rows > c->hdr->block_rows) return NULL;
+
+    const uint8_t *data = c->base + blk->offset;
+    if (c->hdr->codec == USRL_COL_RAW) return data;
+    if (!scratch) return NULL;
+    return delta_decode(c->hdr->type, c->hdr->width, data, blk->bytes, blk->rows, scratch) == 0
+               ? scratch : NULL;
+}
+
+uint32_t usrl_col_seek(const UsrlColumn *c, int64_t v)
+{
+    uint32_t lo = 0, hi = c->hdr->block_count;
+    int is_unsigned = c->hdr->type == USRL_FIELD_U64 || c->hdr->type == USRL_FIELD_U32;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int below = is_unsigned ? c->blocks[mid].max.u < (uint64_t)v : c->blocks[mid].max.i < v;
+        if (below) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int usrl_col_list(const char *dir, char (*names)[64], uint32_t max)
+{
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+
+    uint32_t n = 0;
+    size_t ext = strlen(USRL_COL_EXT);
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        size_t len = strlen(e->d_name);
+        if (len <= ext || len - ext >= 64 || strcmp(e->d_name + len - ext, USRL_COL_EXT) != 0) continue;
+        if (n < max) {
+            memcpy(names[n], e->d_name, len - ext);
+            names[n][len - ext] = '\0';
+        }
+        n++;
+    }
+    closedir(d);
+    return (int)n;
+}
@@ -0,0 +1,384 @@
+/**
+ * @file usrl_indicators.c
+ * @brief Incremental per-key EMA / VWAP / rolling statistics over schema fields.
+ */
+
+#include "usrl_indicators.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Per-key block: KeyHdr, IndState[count], then each indicator's window ring */
+typedef struct {
+    uint64_t samples;
+    uint64_t timestamp_ns;
+    uint32_t dirty;
+    uint32_t _pad;
+} KeyHdr;
+
+typedef struct {
+    double a;               /* EMA value / mean / sum(v*w) */
+    double b;               /* M2 / sum(w) */
+    double out;             /* last result */
+    uint32_t head;          /* next ring position */
+    uint32_t front;         /* deque front */
+    uint32_t len;           /* deque length */
+    uint32_t _pad;
+} IndState;
+
+/* Monotonic deque entry */
+typedef struct {
+    double v;
+    uint64_t idx;
+} DequeEntry;
+
+static inline uint32_t align_up(uint32_t v, uint32_t a)
+{
+    return (v + a - 1) & ~(a - 1);
+}
+
+static inline KeyHdr *key_hdr(const UsrlIndicators *x, uint32_t key)
+{
+    return (KeyHdr *)(x->state + (uint64_t)key * x->stride);
+}
+
+static inline IndState *ind_state(KeyHdr *k, uint32_t i)
+{
+    return (IndState *)((uint8_t *)k + sizeof(KeyHdr)) + i;
+}
+
+/* ============================================================================
+ * LIFECYCLE
+ * ============================================================================ */
+
+int usrl_ind_init(UsrlIndicators *x, const UsrlSchema *schema, const char *key_field,
+                  uint32_t max_keys, const UsrlIndSpec *specs, uint32_t count)
+{
+    if (!x || !schema || !specs || count == 0 || count > USRL_MAX_INDICATORS || max_keys == 0)
+        return -1;
+    memset(x, 0, sizeof(*x));
+    x->schema = schema;
+    x->count = count;
+    x->max_keys = max_keys;
+
+    const UsrlField *kf = NULL;
+    if (key_field && !(kf = usrl_schema_field(schema, key_field))) return -1;
+
+    uint32_t off = (uint32_t)(sizeof(KeyHdr) + count * sizeof(IndState));
+    for (uint32_t i = 0; i < count; i++) {
+        const UsrlIndSpec *s = &specs[i];
+        UsrlIndDef *d = &x->defs[i];
+
+        d->kind = s->kind;
+        d->period = s->period;
+        d->value = usrl_schema_field(schema, s->field);
+        if (!d->value || !usrl_field_numeric(d->value)) return -1;
+
+        uint32_t ring = 0;
+        switch (s->kind) {
+        case USRL_IND_EMA:
+            if (s->period == 0) return -1;
+            d->alpha = 2.0 / ((double)s->period + 1.0);
+            break;
+        case USRL_IND_VWAP:
+            d->weight = s->weight ? usrl_schema_field(schema, s->weight) : NULL;
+            if (!d->weight || !usrl_field_numeric(d->weight)) return -1;
+            ring = s->period * 2 * (uint32_t)sizeof(double);
+            break;
+        case USRL_IND_MEAN:
+        case USRL_IND_VAR:
+            if (s->period == 0) return -1;
+            ring = s->period * (uint32_t)sizeof(double);
+            break;
+        case USRL_IND_MIN:
+        case USRL_IND_MAX:
+            if (s->period == 0) return -1;
+            ring = s->period * (uint32_t)sizeof(DequeEntry);
+            break;
+        default:
+            return -1;
+        }
+
+        if (ring) {
+            off = align_up(off, 8);
+            d->ring_offset = off;
+            off += ring;
+        }
+    }
+    x->stride = align_up(off, USRL_ALIGNMENT);
+
+    if (usrl_keys_init(&x->keys, kf, max_keys) != 0) return -1;
+
+    x->out_size = usrl_ind_record_size(count);
+    x->dirty = calloc(max_keys, sizeof(uint32_t));
+    x->scratch = malloc(schema->total_size ? schema->total_size : 1);
+    x->out_buf = malloc(x->out_size);
+    if (posix_memalign((void **)&x->state, USRL_ALIGNMENT, (size_t)x->stride * max_keys) != 0)
+        x->state = NULL;
+
+    if (!x->dirty || !x->scratch || !x->out_buf || !x->state) {
+        usrl_ind_free(x);
+        return -1;
+    }
+    memset(x->state, 0, (size_t)x->stride * max_keys);
+    return 0;
+}
+
+void usrl_ind_free(UsrlIndicators *x)
+{
+    if (!x) return;
+    usrl_keys_free(&x->keys);
+    free(x->state);
+    free(x->dirty);
+    free(x->scratch);
+    free(x->out_buf);
+    memset(x, 0, sizeof(*x));
+}
+
+int usrl_ind_attach(UsrlIndicators *x, void *core_base, const char *in_topic,
+                    const char *out_topic, uint16_t pub_id)
+{
+    if (!x || !core_base || !in_topic) return -1;
+
+    usrl_sub_init(&x->in, core_base, in_topic);
+    x->has_in = (x->in.desc != NULL);
+    if (!x->has_in) return -1;
+
+    if (out_topic) {
+        usrl_pub_init(&x->out, core_base, out_topic, pub_id);
+        x->has_out = (x->out.desc != NULL);
+        if (!x->has_out) return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * UPDATES
+ * ============================================================================ */
+
+static inline uint32_t ring_next(uint32_t pos, uint32_t period)
+{
+    return (pos + 1 == period) ? 0 : pos + 1;
+}
+
+static void update_vwap(const UsrlIndDef *d, IndState *st, uint8_t *ring,
+                        uint64_t i, double v, double w)
+{
+    double pv = v * w;
+
+    if (d->period) {
+        double *r = (double *)ring + 2 * st->head;
+        if (i >= d->period) {
+            st->a -= r[0];
+            st->b -= r[1];
+        }
+        r[0] = pv;
+        r[1] = w;
+        st->head = ring_next(st->head, d->period);
+    }
+    st->a += pv;
+    st->b += w;
+    if (st->b > 0.0) st->out = st->a / st->b;
+}
+
+static void update_moments(const UsrlIndDef *d, IndState *st, uint8_t *ring,
+                           uint64_t i, double v)
+{
+    double *r = (double *)ring;
+    double mean = st->a;
+
+    if (i < d->period) {
+        double n = (double)(i + 1);
+        double delta = v - mean;
+        st->a = mean + delta / n;
+        st->b += delta * (v - st->a);
+    } else {
+        double old = r[st->head];
+        double next = mean + (v - old) / (double)d->period;
+        st->b += (v - old) * (v - next + old - mean);
+        if (st->b < 0.0) st->b = 0.0;
+        st->a = next;
+    }
+    r[st->head] = v;
+    st->head = ring_next(st->head, d->period);
+
+    if (d->kind == USRL_IND_MEAN) {
+        st->out = st->a;
+    } else {
+        uint64_t n = (i < d->period) ? i + 1 : d->period;
+        st->out = st->b / (double)n;
+    }
+}
+
+static void update_extreme(const UsrlIndDef *d, IndState *st, uint8_t *ring,
+                           uint64_t i, double v)
+{
+    DequeEntry *q = (DequeEntry *)ring;
+    uint32_t w = d->period;
+    int is_min = (d->kind == USRL_IND_MIN);
+
+    /* Drop entries that left the window, then entries the new sample dominates */
+    while (st->len && i - q[st->front].idx >= w) {
+        st->front = ring_next(st->front, w);
+        st->len--;
+    }
+    while (st->len) {
+        uint32_t back = st->front + st->len - 1;
+        if (back >= w) back -= w;
+        if (is_min ? (q[back].v < v) : (q[back].v > v)) break;
+        st->len--;
+    }
+
+    uint32_t pos = st->front + st->len;
+    if (pos >= w) pos -= w;
+    q[pos].v = v;
+    q[pos].idx = i;
+    st->len++;
+
+    st->out = q[st->front].v;
+}
+
+int32_t usrl_ind_apply(UsrlIndicators *x, const uint8_t *record, uint64_t timestamp_ns)
+{
+    if (USRL_UNLIKELY(!x || !record)) return -1;
+
+    int32_t key = usrl_keys_lookup(&x->keys, record);
+    if (USRL_UNLIKELY(key < 0)) {
+        x->rejected++;
+        return -1;
+    }
+
+    KeyHdr *k = key_hdr(x, (uint32_t)key);
+    uint64_t i = k->samples;
+
+    for (uint32_t n = 0; n < x->count; n++) {
+        const UsrlIndDef *d = &x->defs[n];
+        IndState *st = ind_state(k, n);
+        uint8_t *ring = (uint8_t *)k + d->ring_offset;
+        double v = usrl_field_f64(d->value, record);
+
+        switch (d->kind) {
+        case USRL_IND_EMA:
+            st->a = (i == 0) ? v : st->a + d->alpha * (v - st->a);
+            st->out = st->a;
+            break;
+        case USRL_IND_VWAP:
+            update_vwap(d, st, ring, i, v, usrl_field_f64(d->weight, record));
+            break;
+        case USRL_IND_MEAN:
+        case USRL_IND_VAR:
+            update_moments(d, st, ring, i, v);
+            break;
+        case USRL_IND_MIN:
+        case USRL_IND_MAX:
+            update_extreme(d, st, ring, i, v);
+            break;
+        default:
+            break;
+        }
+    }
+
+    k->samples = i + 1;
+    k->timestamp_ns = timestamp_ns;
+    if (!k->dirty) {
+        k->dirty = 1;
+        x->dirty[x->dirty_count++] = (uint32_t)key;
+    }
+    x->updates++;
+    return key;
+}
+
+int usrl_ind_poll(UsrlIndicators *x, uint32_t max_batch)
+{
+    if (USRL_UNLIKELY(!x || !x->has_in)) return USRL_RING_ERROR;
+    if (max_batch == 0 || max_batch > USRL_IND_MAX_BATCH) max_batch = USRL_IND_MAX_BATCH;
+
+    UsrlSlotView views[USRL_IND_MAX_BATCH];
+    int n = usrl_sub_view_batch(&x->in, views, max_batch);
+    if (n <= 0) return n;
+
+    uint32_t size = x->schema->total_size;
+
+    for (int i = 0; i < n; i++) {
+        if (i + 1 < n) USRL_PREFETCH_R(views[i + 1].data);
+
+        if (USRL_UNLIKELY(views[i].len < size)) {
+            x->rejected++;
+            continue;
+        }
+
+        /* Copy out of the slot so a lapped record is never half-applied */
+        memcpy(x->scratch, views[i].data, size);
+        if (USRL_UNLIKELY(!usrl_view_valid(&views[i]))) {
+            x->lapped++;
+            continue;
+        }
+        usrl_ind_apply(x, x->scratch, views[i].timestamp_ns);
+    }
+
+    usrl_ind_flush(x);
+    return n;
+}
+
+/* ============================================================================
+ * OUTPUT / QUERIES
+ * ============================================================================ */
+
+static void fill_record(const UsrlIndicators *x, uint32_t key, UsrlIndRecord *r)
+{
+    KeyHdr *k = key_hdr(x, key);
+    const char *name = usrl_keys_name(&x->keys, key);
+    uint16_t warm = 0;
+
+    memset(r, 0, sizeof(*r));
+    r->timestamp_ns = k->timestamp_ns;
+    r->samples = k->samples;
+    r->key_id = key;
+    r->count = (uint16_t)x->count;
+    memcpy(r->key, name, strnlen(name, USRL_KEY_MAX));
+
+    for (uint32_t i = 0; i < x->count; i++) {
+        double v = ind_state(k, i)->out;
+        memcpy((uint8_t *)r->value + i * sizeof(double), &v, sizeof(v));
+        if (k->samples >= x->defs[i].period) warm |= (uint16_t)(1u << i);
+    }
+    r->warm = warm;
+}
+
+int usrl_ind_flush(UsrlIndicators *x)
+{
+    if (!x) return 0;
+
+    int published = 0;
+    for (uint32_t i = 0; i < x->dirty_count; i++) {
+        uint32_t key = x->dirty[i];
+        key_hdr(x, key)->dirty = 0;
+
+        if (!x->has_out) continue;
+
+        fill_record(x, key, (UsrlIndRecord *)x->out_buf);
+        if (usrl_pub_publish(&x->out, x->out_buf, x->out_size) == USRL_RING_OK) published++;
+    }
+    x->dirty_count = 0;
+    x->published += (uint64_t)published;
+    return published;
+}
+
+double usrl_ind_value(const UsrlIndicators *x, uint32_t key_id, uint32_t ind)
+{
+    if (!x || key_id >= x->max_keys || ind >= x->count) return 0.0;
+    return ind_state(key_hdr(x, key_id), ind)->out;
+}
+
+int usrl_ind_warm(const UsrlIndicators *x, uint32_t key_id, uint32_t ind)
+{
+    if (!x || key_id >= x->max_keys || ind >= x->count) return 0;
+    return key_hdr(x, key_id)->samples >= x->defs[ind].period;
+}
+
+int usrl_ind_record(const UsrlIndicators *x, uint32_t key_id, UsrlIndRecord *out, uint32_t out_size)
+{
+    if (!x || !out || key_id >= x->max_keys || out_size < x->out_size) return -1;
+    fill_record(x, key_id, out);
+    return (int)x->out_size;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file usrl_join.c
+ * @brief Keyed as-of join of two record streams over per-key right rings.
+ */
+
+#include "usrl_join.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t next_power_of_two_u32(uint32_t v)
+{
+    if (v == 0) return 1;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return ++v;
+}
+
+static inline int field_is_text(const UsrlField *f)
+{
+    return f->type == USRL_FIELD_STRING || f->type == USRL_FIELD_BYTES;
+}
+
+static inline uint8_t *right_entry(const UsrlJoin *j, uint32_t key, uint64_t n)
+{
+    uint64_t slot = (uint64_t)key * j->depth + (n & (j->depth - 1));
+    return j->buf + slot * j->entry_size;
+}
+
+/* ============================================================================
+ * LIFECYCLE
+ * ============================================================================ */
+
+int usrl_join_init(UsrlJoin *j, const UsrlSchema *left, const UsrlSchema *right,
+                   const UsrlJoinSpec *spec, uint32_t max_keys)
+{
+    if (!j || !left || !right || !spec || !spec->left_key || !spec->right_key ||
+        spec->depth == 0 || max_keys == 0 || spec->mode > USRL_JOIN_LEFT)
+        return -1;
+    memset(j, 0, sizeof(*j));
+
+    j->left_key = usrl_schema_field(left, spec->left_key);
+    j->right_key = usrl_schema_field(right, spec->right_key);
+    if (!j->left_key || !j->right_key ||
+        field_is_text(j->left_key) != field_is_text(j->right_key))
+        return -1;
+
+    if (spec->left_time && !(j->left_time = usrl_schema_field(left, spec->left_time))) return -1;
+    if (spec->right_time && !(j->right_time = usrl_schema_field(right, spec->right_time))) return -1;
+
+    j->left = left;
+    j->right = right;
+    j->tolerance_ns = spec->tolerance_ns;
+    j->depth = next_power_of_two_u32(spec->depth);
+    j->mode = spec->mode;
+    j->max_keys = max_keys;
+    j->entry_size = (uint32_t)((sizeof(uint64_t) + right->total_size + 7) & ~7u);
+    j->out_size = (uint32_t)sizeof(UsrlJoinHeader) + left->total_size + right->total_size;
+
+    if (usrl_keys_init(&j->keys, j->right_key, max_keys) != 0) return -1;
+
+    j->buf = calloc((size_t)max_keys * j->depth, j->entry_size);
+    j->count = calloc(max_keys, sizeof(uint64_t));
+    j->scratch = malloc(right->total_size ? right->total_size : 1);
+    j->out_buf = malloc(j->out_size);
+
+    if (!j->buf || !j->count || !j->scratch || !j->out_buf) {
+        usrl_join_free(j);
+        return -1;
+    }
+    return 0;
+}
+
+void usrl_join_free(UsrlJoin *j)
+{
+    if (!j) return;
+    usrl_keys_free(&j->keys);
+    free(j->buf);
+    free(j->count);
+    free(j->scratch);
+    free(j->out_buf);
+    memset(j, 0, sizeof(*j));
+}
+
+int usrl_join_attach(UsrlJoin *j, void *core_base, const char *left_topic,
+                     const char *right_topic, const char *out_topic, uint16_t pub_id)
+{
+    if (!j || !core_base || !left_topic || !right_topic) return -1;
+
+    usrl_sub_init(&j->in_left, core_base, left_topic);
+    usrl_sub_init(&j->in_right, core_base, right_topic);
+    j->has_in = (j->in_left.desc != NULL && j->in_right.desc != NULL);
+    if (!j->has_in) return -1;
+
+    if (out_topic) {
+        usrl_pub_init(&j->out, core_base, out_topic, pub_id);
+        j->has_out = (j->out.desc != NULL);
+        if (!j->has_out) return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * JOIN
+ * ============================================================================ */
+
+int usrl_join_right(UsrlJoin *j, const uint8_t *record, uint64_t timestamp_ns)
+{
+    if (USRL_UNLIKELY(!j || !record)) return -1;
+
+    int32_t key = usrl_keys_lookup(&j->keys, record);
+    if (USRL_UNLIKELY(key < 0)) {
+        j->rejected++;
+        return -1;
+    }
+
+    uint64_t ts = j->right_time ? (uint64_t)usrl_field_i64(j->right_time, record) : timestamp_ns;
+    uint8_t *e = right_entry(j, (uint32_t)key, j->count[key]++);
+    memcpy(e, &ts, sizeof(ts));
+    memcpy(e + sizeof(uint64_t), record, j->right->total_size);
+    j->right_in++;
+    return 0;
+}
+
+/* out already holds the left record after the header */
+static int join_match(UsrlJoin *j, uint64_t timestamp_ns, uint8_t *out)
+{
+    const uint8_t *rec = out + sizeof(UsrlJoinHeader);
+    uint8_t *right_out = out + sizeof(UsrlJoinHeader) + j->left->total_size;
+    uint64_t ts = j->left_time ? (uint64_t)usrl_field_i64(j->left_time, rec) : timestamp_ns;
+
+    UsrlJoinHeader h;
+    memset(&h, 0, sizeof(h));
+    h.left_ns = ts;
+
+    int32_t key = usrl_keys_lookup_field(&j->keys, j->left_key, rec, 0);
+    const uint8_t *hit = NULL;
+
+    if (key >= 0) {
+        /* Newest first: the first entry at or before ts is the prevailing one */
+        uint64_t n = j->count[key];
+        uint64_t stop = (n > j->depth) ? n - j->depth : 0;
+        while (n > stop) {
+            const uint8_t *e = right_entry(j, (uint32_t)key, --n);
+            uint64_t rts;
+            memcpy(&rts, e, sizeof(rts));
+            if (rts <= ts) {
+                if (j->tolerance_ns == 0 || ts - rts <= j->tolerance_ns) {
+                    hit = e;
+                    h.right_ns = rts;
+                }
+                break;
+            }
+        }
+        h.key_id = (uint32_t)key;
+    }
+
+    j->left_in++;
+    if (hit) {
+        h.flags = USRL_JOIN_F_MATCHED;
+        memcpy(right_out, hit + sizeof(uint64_t), j->right->total_size);
+        j->matched++;
+    } else {
+        memset(right_out, 0, j->right->total_size);
+        j->unmatched++;
+    }
+    memcpy(out, &h, sizeof(h));
+    return hit != NULL;
+}
+
+int usrl_join_left(UsrlJoin *j, const uint8_t *record, uint64_t timestamp_ns, uint8_t *out)
+{
+    if (USRL_UNLIKELY(!j || !record || !out)) return -1;
+    memcpy(out + sizeof(UsrlJoinHeader), record, j->left->total_size);
+    return join_match(j, timestamp_ns, out);
+}
+
+int usrl_join_poll(UsrlJoin *j, uint32_t max_batch)
+{
+    if (USRL_UNLIKELY(!j || !j->has_in)) return USRL_RING_ERROR;
+    if (max_batch == 0 || max_batch > USRL_JOIN_MAX_BATCH) max_batch = USRL_JOIN_MAX_BATCH;
+
+    UsrlSlotView views[USRL_JOIN_MAX_BATCH];
+    uint32_t rsize = j->right->total_size;
+    uint32_t lsize = j->left->total_size;
+    int n = 0;
+
+    /* 1. Right side: bring every key's ring up to date, bounded so a busy
+     * right stream cannot starve the left one */
+    for (uint32_t b = 0; b < USRL_JOIN_RIGHT_BATCHES &&
+                         (n = usrl_sub_view_batch(&j->in_right, views, USRL_JOIN_MAX_BATCH)) > 0; b++) {
+        for (int i = 0; i < n; i++) {
+            if (i + 1 < n) USRL_PREFETCH_R(views[i + 1].data);
+            if (USRL_UNLIKELY(views[i].len < rsize)) {
+                j->rejected++;
+                continue;
+            }
+            memcpy(j->scratch, views[i].data, rsize);
+            if (USRL_UNLIKELY(!usrl_view_valid(&views[i]))) {
+                j->lapped++;
+                continue;
+            }
+            usrl_join_right(j, j->scratch, views[i].timestamp_ns);
+        }
+    }
+    if (n < 0) return n;
+
+    /* 2. Left side: copy each record straight into the output record */
+    n = usrl_sub_view_batch(&j->in_left, views, max_batch);
+    if (n <= 0) return n;
+
+    for (int i = 0; i < n; i++) {
+        if (i + 1 < n) USRL_PREFETCH_R(views[i + 1].data);
+        if (USRL_UNLIKELY(views[i].len < lsize)) {
+            j->rejected++;
+            continue;
+        }
+
+        memcpy(j->out_buf + sizeof(UsrlJoinHeader), views[i].data, lsize);
+        if (USRL_UNLIKELY(!usrl_view_valid(&views[i]))) {
+            j->lapped++;
+            continue;
+        }
+
+        int hit = join_match(j, views[i].timestamp_ns, j->out_buf);
+        if (!j->has_out || (!hit && j->mode == USRL_JOIN_INNER)) continue;
+        if (usrl_pub_publish(&j->out, j->out_buf, j->out_size) == USRL_RING_OK) j->published++;
+    }
+    return n;
+}
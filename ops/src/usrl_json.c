@@ -0,0 +1,767 @@
+/**
+ * @file usrl_json.c
+ * @brief JSON-to-schema transcoder with a vectorized structural scanner.
+ */
+
+#include "usrl_json.h"
+#include "usrl_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_BACKEND "avx2"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_BACKEND "sse2"
+#else
+#define JSON_BACKEND "scalar"
+#endif
+
+#if defined(__PCLMUL__)
+#include <wmmintrin.h>
+#endif
+
+#define JSON_BLOCK 64
+#define JSON_NUM_MAX 64     /* longest number literal handed to strtod */
+
+/* ============================================================================
+ * STAGE 1: BLOCK CLASSIFICATION
+ * ============================================================================ */
+
+typedef struct {
+    uint64_t quote;         /* '"' */
+    uint64_t backslash;     /* '\\' */
+    uint64_t op;            /* { } [ ] : , */
+} JsonBlock;
+
+static void classify_scalar(const uint8_t *in, JsonBlock *b)
+{
+    uint64_t quote = 0, bs = 0, op = 0;
+    for (uint32_t i = 0; i < JSON_BLOCK; i++) {
+        uint64_t bit = 1ULL << i;
+        switch (in[i]) {
+        case '"':  quote |= bit; break;
+        case '\\': bs |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            op |= bit; break;
+        default: break;
+        }
+    }
+    b->quote = quote;
+    b->backslash = bs;
+    b->op = op;
+}
+
+/* [ ] { } differ only in bit 5, so (c | 0x20) folds them onto '{' and '}' */
+#if defined(__AVX2__)
+static inline void classify_simd(const uint8_t *in, JsonBlock *b)
+{
+    const __m256i q = _mm256_set1_epi8('"');
+    const __m256i bs = _mm256_set1_epi8('\\');
+    const __m256i fold = _mm256_set1_epi8(0x20);
+    const __m256i lb = _mm256_set1_epi8('{');
+    const __m256i rb = _mm256_set1_epi8('}');
+    const __m256i co = _mm256_set1_epi8(':');
+    const __m256i cm = _mm256_set1_epi8(',');
+
+    uint64_t quote = 0, bsl = 0, op = 0;
+    for (int k = 0; k < 2; k++) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + 32 * k));
+        __m256i f = _mm256_or_si256(v, fold);
+        __m256i o = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(f, lb), _mm256_cmpeq_epi8(f, rb)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, co), _mm256_cmpeq_epi8(v, cm)));
+
+        quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, q)) << (32 * k);
+        bsl   |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bs)) << (32 * k);
+        op    |= (uint64_t)(uint32_t)_mm256_movemask_epi8(o) << (32 * k);
+    }
+    b->quote = quote;
+    b->backslash = bsl;
+    b->op = op;
+}
+#elif defined(__SSE2__)
+static inline void classify_simd(const uint8_t *in, JsonBlock *b)
+{
+    const __m128i q = _mm_set1_epi8('"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i fold = _mm_set1_epi8(0x20);
+    const __m128i lb = _mm_set1_epi8('{');
+    const __m128i rb = _mm_set1_epi8('}');
+    const __m128i co = _mm_set1_epi8(':');
+    const __m128i cm = _mm_set1_epi8(',');
+
+    uint64_t quote = 0, bsl = 0, op = 0;
+    for (int k = 0; k < 4; k++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + 16 * k));
+        __m128i f = _mm_or_si128(v, fold);
+        __m128i o = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(f, lb), _mm_cmpeq_epi8(f, rb)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, co), _mm_cmpeq_epi8(v, cm)));
+
+        quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)) << (16 * k);
+        bsl   |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, bs)) << (16 * k);
+        op    |= (uint64_t)(uint16_t)_mm_movemask_epi8(o) << (16 * k);
+    }
+    b->quote = quote;
+    b->backslash = bsl;
+    b->op = op;
+}
+#else
+#define classify_simd classify_scalar
+#endif
+
+/* Bit i set if an odd number of quotes precede or sit at position i */
+static inline uint64_t prefix_xor(uint64_t x)
+{
+#if defined(__PCLMUL__)
+    __m128i all = _mm_set1_epi8((char)0xFF);
+    __m128i r = _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long)x), all, 0);
+    return (uint64_t)_mm_cvtsi128_si64(r);
+#else
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+#endif
+}
+
+/*
+ * Characters escaped by a backslash: the second of every backslash pair
+ * and whatever follows an odd-length run. Runs are split by start parity
+ * with one add; *carry holds an escape pending into the next block.
+ */
+static inline uint64_t find_escaped(uint64_t backslash, uint64_t *carry)
+{
+    const uint64_t even = 0x5555555555555555ULL;
+
+    backslash &= ~*carry;
+    uint64_t follows = (backslash << 1) | *carry;
+    uint64_t odd_starts = backslash & ~even & ~follows;
+    uint64_t even_runs;
+    *carry = __builtin_add_overflow(odd_starts, backslash, &even_runs);
+    return (even ^ (even_runs << 1)) & follows;
+}
+
+/* Streams structural positions (quotes and unquoted operators) in order */
+typedef struct {
+    const uint8_t *text;
+    uint32_t len;
+    uint32_t next_block;    /* offset of the next block to classify */
+    uint32_t head;          /* next unread entry of pos[] */
+    uint32_t count;         /* entries in pos[] */
+    uint64_t escape_carry;
+    uint64_t in_string;     /* all ones if the previous block ended in a string */
+    int scalar;
+    uint32_t pos[JSON_BLOCK + 8];
+} JsonScan;
+
+/*
+ * Flatten a block's bits into offsets. Writes eight entries per round
+ * whether or not they are all used, so the loop has one branch per eight
+ * positions instead of one per position.
+ */
+static inline void scan_flatten(JsonScan *sc, uint32_t base, uint64_t bits)
+{
+    uint32_t n = (uint32_t)__builtin_popcountll(bits);
+    uint32_t *out = sc->pos;
+
+    for (uint32_t i = 0; i < n; i += 8) {
+        for (int k = 0; k < 8; k++) {
+            out[i + k] = base + (uint32_t)__builtin_ctzll(bits);
+            bits &= bits - 1;
+        }
+    }
+    sc->head = 0;
+    sc->count = n;
+}
+
+static inline int scan_load(JsonScan *sc)
+{
+    if (sc->next_block >= sc->len) return 0;
+
+    const uint8_t *p = sc->text + sc->next_block;
+    uint8_t tail[JSON_BLOCK];
+    uint32_t left = sc->len - sc->next_block;
+    if (left < JSON_BLOCK) {
+        memset(tail, ' ', JSON_BLOCK);
+        memcpy(tail, p, left);
+        p = tail;
+    }
+
+    JsonBlock b;
+    if (sc->scalar) classify_scalar(p, &b);
+    else classify_simd(p, &b);
+
+    uint64_t quote = b.quote & ~find_escaped(b.backslash, &sc->escape_carry);
+    uint64_t in_str = prefix_xor(quote) ^ sc->in_string;
+    sc->in_string = (uint64_t)((int64_t)in_str >> 63);
+
+    scan_flatten(sc, sc->next_block, (b.op & ~in_str) | quote);
+    sc->next_block += JSON_BLOCK;
+    return 1;
+}
+
+/* Next structural offset, or -1 at end of input */
+static inline int64_t scan_next(JsonScan *sc)
+{
+    while (sc->head == sc->count) {
+        if (!scan_load(sc)) return -1;
+    }
+    return sc->pos[sc->head++];
+}
+
+/* ============================================================================
+ * MAP
+ * ============================================================================ */
+
+static uint32_t key_hash(const uint8_t *k, uint32_t len)
+{
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < len; i++) {
+        h ^= k[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int key_insert(UsrlJsonMap *m, const char *key, int32_t field)
+{
+    uint32_t len = (uint32_t)strlen(key);
+    uint32_t i = key_hash((const uint8_t *)key, len) & (USRL_JSON_KEY_SLOTS - 1);
+
+    for (uint32_t n = 0; n < USRL_JSON_KEY_SLOTS; n++) {
+        UsrlJsonKey *k = &m->keys[i];
+        if (k->field < 0) {
+            k->key = key;
+            k->key_len = len;
+            k->field = field;
+            return 0;
+        }
+        if (k->key_len == len && memcmp(k->key, key, len) == 0) {
+            k->field = field; /* rebind */
+            return 0;
+        }
+        i = (i + 1) & (USRL_JSON_KEY_SLOTS - 1);
+    }
+    return -1;
+}
+
+static inline int32_t key_find(const UsrlJsonMap *m, const uint8_t *key, uint32_t len)
+{
+    uint32_t i = key_hash(key, len) & (USRL_JSON_KEY_SLOTS - 1);
+
+    for (uint32_t n = 0; n < USRL_JSON_KEY_SLOTS; n++) {
+        const UsrlJsonKey *k = &m->keys[i];
+        if (k->field < 0) return -1;
+        if (k->key_len == len && memcmp(k->key, key, len) == 0) return k->field;
+        i = (i + 1) & (USRL_JSON_KEY_SLOTS - 1);
+    }
+    return -1;
+}
+
+static int32_t field_index(const UsrlSchema *s, const char *name)
+{
+    const UsrlField *f = usrl_schema_field(s, name);
+    return f ? (int32_t)(f - s->fields) : -1;
+}
+
+int usrl_json_map_init(UsrlJsonMap *m, const UsrlSchema *schema)
+{
+    if (!m || !schema || schema->field_count == 0) return -1;
+    memset(m, 0, sizeof(*m));
+
+    m->schema = schema;
+    m->prefix_field = -1;
+    for (uint32_t i = 0; i < USRL_JSON_KEY_SLOTS; i++) m->keys[i].field = -1;
+
+    for (uint32_t i = 0; i < schema->field_count; i++)
+        if (key_insert(m, schema->fields[i].name, (int32_t)i) != 0) return -1;
+    return 0;
+}
+
+int usrl_json_map_alias(UsrlJsonMap *m, const char *key, const char *field)
+{
+    if (!m || !m->schema || !key || !field) return -1;
+    int32_t f = field_index(m->schema, field);
+    if (f < 0) return -1;
+    return key_insert(m, key, f);
+}
+
+int usrl_json_map_prefix(UsrlJsonMap *m, uint32_t prefix_len, const char *ts_field)
+{
+    if (!m || !m->schema) return -1;
+
+    int32_t f = -1;
+    if (ts_field) {
+        f = field_index(m->schema, ts_field);
+        if (f < 0 || prefix_len < 8) return -1;
+        UsrlFieldType t = m->schema->fields[f].type;
+        if (t != USRL_FIELD_U64 && t != USRL_FIELD_I64) return -1;
+    }
+    m->prefix_len = prefix_len;
+    m->prefix_field = f;
+    return 0;
+}
+
+const char *usrl_json_backend(void)
+{
+    return JSON_BACKEND;
+}
+
+/* ============================================================================
+ * STAGE 2: VALUES
+ * ============================================================================ */
+
+static const double pow10_exact[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static inline int is_ws(uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline int is_digit(uint8_t c)
+{
+    return (uint8_t)(c - '0') < 10;
+}
+
+/*
+ * Parse a number literal spanning exactly [p, p + n).
+ * Mantissas up to 2^53 with |exp| <= 22 convert exactly from the digits
+ * (one IEEE multiply or divide); anything else goes through strtod.
+ */
+static int parse_number(const uint8_t *p, uint32_t n, int *is_int, int64_t *iv, double *dv)
+{
+    const uint8_t *s = p, *end = p + n;
+    int neg = 0;
+    uint64_t mant = 0;
+    int digits = 0, exp10 = 0, integral = 1;
+
+    if (s < end && *s == '-') { neg = 1; s++; }
+    if (s == end || !is_digit(*s)) return -1;
+
+    for (; s < end && is_digit(*s); s++) {
+        if (digits < 19) {
+            mant = mant * 10 + (uint64_t)(*s - '0');
+            if (mant) digits++;
+        } else {
+            exp10++;
+        }
+    }
+    if (s < end && *s == '.') {
+        integral = 0;
+        if (++s == end || !is_digit(*s)) return -1;
+        for (; s < end && is_digit(*s); s++) {
+            if (digits < 19) {
+                mant = mant * 10 + (uint64_t)(*s - '0');
+                if (mant) digits++;
+                exp10--;
+            }
+        }
+    }
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        integral = 0;
+        int eneg = 0, e = 0;
+        s++;
+        if (s < end && (*s == '+' || *s == '-')) eneg = (*s++ == '-');
+        if (s == end || !is_digit(*s)) return -1;
+        for (; s < end && is_digit(*s); s++)
+            if (e < 100000) e = e * 10 + (*s - '0');
+        exp10 += eneg ? -e : e;
+    }
+    if (s != end) return -1;
+
+    if (integral && exp10 == 0) {
+        *is_int = 1;
+        *iv = (int64_t)(neg ? 0 - mant : mant); /* negate unsigned: no overflow */
+        *dv = neg ? -(double)mant : (double)mant;
+        return 0;
+    }
+
+    double d;
+    if (mant <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+        d = (double)mant;
+        d = (exp10 < 0) ? d / pow10_exact[-exp10] : d * pow10_exact[exp10];
+        if (neg) d = -d;
+    } else {
+        char buf[JSON_NUM_MAX];
+        if (n >= sizeof(buf)) return -1;
+        memcpy(buf, p, n);
+        buf[n] = '\0';
+        d = strtod(buf, NULL);
+    }
+
+    *is_int = 0;
+    *dv = d;
+    *iv = (d > -9.2e18 && d < 9.2e18) ? (int64_t)d : 0;
+    return 0;
+}
+
+static void store_number(uint8_t *dst, const UsrlField *f, int is_int, int64_t iv, double dv)
+{
+    int64_t i = is_int ? iv : (int64_t)((dv > -9.2e18 && dv < 9.2e18) ? dv : 0);
+
+    switch (f->type) {
+    case USRL_FIELD_U64:
+    case USRL_FIELD_I64:
+        memcpy(dst, &i, 8);
+        break;
+    case USRL_FIELD_U32:
+    case USRL_FIELD_I32: {
+        int32_t v = (int32_t)i;
+        memcpy(dst, &v, 4);
+        break;
+    }
+    case USRL_FIELD_F64:
+        memcpy(dst, &dv, 8);
+        break;
+    case USRL_FIELD_F32: {
+        float v = (float)dv;
+        memcpy(dst, &v, 4);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static inline int is_text_field(const UsrlField *f)
+{
+    return f->type == USRL_FIELD_STRING || f->type == USRL_FIELD_BYTES;
+}
+
+static uint32_t utf8_put(uint8_t *o, uint32_t cp)
+{
+    if (cp < 0x80) { o[0] = (uint8_t)cp; return 1; }
+    if (cp < 0x800) {
+        o[0] = (uint8_t)(0xC0 | (cp >> 6));
+        o[1] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    o[0] = (uint8_t)(0xE0 | (cp >> 12));
+    o[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+    o[2] = (uint8_t)(0x80 | (cp & 0x3F));
+    return 3;
+}
+
+static int hex4(const uint8_t *p, uint32_t *out)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        uint8_t c = p[i];
+        v <<= 4;
+        if (is_digit(c)) v |= (uint32_t)(c - '0');
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') v |= (uint32_t)((c | 0x20) - 'a' + 10);
+        else return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+/* Unescape a string body into a text field, truncating at the field size */
+static int store_text(uint8_t *dst, uint32_t cap, const uint8_t *s, uint32_t n)
+{
+    uint32_t o = 0;
+
+    if (!memchr(s, '\\', n)) {
+        memcpy(dst, s, n < cap ? n : cap);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < n && o < cap; i++) {
+        uint8_t c = s[i];
+        if (c != '\\') {
+            dst[o++] = c;
+            continue;
+        }
+        if (++i == n) return -1;
+
+        uint8_t u[3];
+        uint32_t ul = 1;
+        switch (s[i]) {
+        case '"': case '\\': case '/': u[0] = s[i]; break;
+        case 'b': u[0] = '\b'; break;
+        case 'f': u[0] = '\f'; break;
+        case 'n': u[0] = '\n'; break;
+        case 'r': u[0] = '\r'; break;
+        case 't': u[0] = '\t'; break;
+        case 'u': {
+            uint32_t cp;
+            if (i + 4 >= n) return -1;
+            if (hex4(s + i + 1, &cp) != 0) return -1;
+            i += 4;
+            if (cp >= 0xD800 && cp <= 0xDFFF) cp = 0xFFFD; /* no surrogate pairing */
+            ul = utf8_put(u, cp);
+            break;
+        }
+        default:
+            return -1;
+        }
+        if (o + ul > cap) break;
+        memcpy(dst + o, u, ul);
+        o += ul;
+    }
+    return 0;
+}
+
+/* Quoted value; numeric fields accept numbers sent as strings ("price":"1.5") */
+static int store_string(const UsrlJsonMap *m, int32_t fi, uint8_t *out,
+                        const uint8_t *s, uint32_t n, uint32_t *present)
+{
+    const UsrlField *f = &m->schema->fields[fi];
+    uint8_t *dst = out + f->offset;
+
+    if (is_text_field(f)) {
+        if (store_text(dst, f->size, s, n) != 0) return -1;
+    } else {
+        int is_int;
+        int64_t iv;
+        double dv;
+        if (parse_number(s, n, &is_int, &iv, &dv) != 0) return 0; /* not a number: leave unset */
+        store_number(dst, f, is_int, iv, dv);
+    }
+    *present |= 1u << fi;
+    return 0;
+}
+
+/* Unquoted value between ':' and the next structural character */
+static int store_scalar(const UsrlJsonMap *m, int32_t fi, uint8_t *out,
+                        const uint8_t *s, uint32_t n, uint32_t *present)
+{
+    while (n && is_ws(*s)) { s++; n--; }
+    while (n && is_ws(s[n - 1])) n--;
+    if (n == 0) return -1;
+    if (fi < 0) return 0;
+
+    const UsrlField *f = &m->schema->fields[fi];
+    uint8_t *dst = out + f->offset;
+    int is_int;
+    int64_t iv;
+    double dv;
+
+    if (n == 4 && memcmp(s, "null", 4) == 0) return 0;
+
+    if (n == 4 && memcmp(s, "true", 4) == 0) {
+        is_int = 1; iv = 1; dv = 1.0;
+    } else if (n == 5 && memcmp(s, "false", 5) == 0) {
+        is_int = 1; iv = 0; dv = 0.0;
+    } else if (parse_number(s, n, &is_int, &iv, &dv) != 0) {
+        return -1;
+    }
+
+    if (is_text_field(f)) memcpy(dst, s, n < f->size ? n : f->size);
+    else store_number(dst, f, is_int, iv, dv);
+    *present |= 1u << fi;
+    return 0;
+}
+
+static inline int ws_only(const uint8_t *s, int64_t from, int64_t to)
+{
+    for (int64_t i = from; i < to; i++)
+        if (!is_ws(s[i])) return 0;
+    return 1;
+}
+
+/* Skip a nested object/array whose opening bracket was just consumed;
+ * returns the offset of its closing bracket */
+static int64_t skip_nested(JsonScan *sc, const uint8_t *text)
+{
+    uint32_t depth = 1;
+    while (depth) {
+        int64_t p = scan_next(sc);
+        if (p < 0) return -1;
+        switch (text[p]) {
+        case '{': case '[': depth++; break;
+        case '}': case ']': depth--; break;
+        case '"':
+            if (scan_next(sc) < 0) return -1; /* closing quote */
+            break;
+        default: break;
+        }
+        if (!depth) return p;
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * TRANSCODE
+ * ============================================================================ */
+
+int usrl_json_transcode(const UsrlJsonMap *m, const uint8_t *in, uint32_t len,
+                        uint8_t *out, uint32_t out_cap, uint32_t *present)
+{
+    if (USRL_UNLIKELY(!m || !m->schema || !in || !out)) return -1;
+
+    const UsrlSchema *schema = m->schema;
+    if (out_cap < schema->total_size || len < m->prefix_len) return -1;
+
+    uint32_t got = 0;
+    memset(out, 0, schema->total_size);
+
+    if (m->prefix_field >= 0) {
+        uint64_t ts = 0;
+        for (int i = 7; i >= 0; i--) ts = (ts << 8) | in[i];
+        memcpy(out + schema->fields[m->prefix_field].offset, &ts, 8);
+        got |= 1u << m->prefix_field;
+    }
+
+    const uint8_t *text = in + m->prefix_len;
+    JsonScan sc;
+    sc.head = sc.count = 0;
+    sc.next_block = 0;
+    sc.escape_carry = 0;
+    sc.in_string = 0;
+    sc.text = text;
+    sc.len = len - m->prefix_len;
+    sc.scalar = (m->flags & USRL_JSON_F_SCALAR) != 0;
+
+    int64_t p = scan_next(&sc), prev;
+    if (p < 0 || text[p] != '{' || !ws_only(text, 0, p)) return -1;
+
+    prev = p;
+    p = scan_next(&sc);
+    if (p >= 0 && text[p] == '}' && ws_only(text, prev + 1, p)) goto done;
+
+    for (;;) {
+        /* "key" : */
+        if (p < 0 || text[p] != '"' || !ws_only(text, prev + 1, p)) return -1;
+        int64_t q = scan_next(&sc);
+        if (q < 0) return -1;
+        int32_t fi = key_find(m, text + p + 1, (uint32_t)(q - p - 1));
+
+        int64_t c = scan_next(&sc);
+        if (c < 0 || text[c] != ':' || !ws_only(text, q + 1, c)) return -1;
+
+        /* value; `end` is its closing quote / bracket, if it has one */
+        int64_t v = scan_next(&sc), end, after;
+        if (v < 0) return -1;
+
+        switch (text[v]) {
+        case '"':
+            end = scan_next(&sc);
+            if (end < 0 || !ws_only(text, c + 1, v)) return -1;
+            if (fi >= 0 &&
+                store_string(m, fi, out, text + v + 1, (uint32_t)(end - v - 1), &got) != 0)
+                return -1;
+            break;
+        case '{':
+        case '[':
+            if (!ws_only(text, c + 1, v)) return -1;
+            end = skip_nested(&sc, text);
+            if (end < 0) return -1;
+            break;
+        case ',':
+        case '}':
+            if (store_scalar(m, fi, out, text + c + 1, (uint32_t)(v - c - 1), &got) != 0)
+                return -1;
+            end = -1;
+            break;
+        default:
+            return -1;
+        }
+
+        if (end < 0) {
+            after = v;
+        } else {
+            after = scan_next(&sc);
+            if (after < 0 || !ws_only(text, end + 1, after)) return -1;
+        }
+
+        if (text[after] == '}') {
+            p = after;
+            break;
+        }
+        if (text[after] != ',') return -1;
+        prev = after;
+        p = scan_next(&sc);
+    }
+
+done:
+    /* Nothing but whitespace after the top-level object */
+    if (!ws_only(text, p + 1, sc.len)) return -1;
+    if (present) *present = got;
+    return (int)schema->total_size;
+}
+
+/* ============================================================================
+ * TRANSCODER STAGE
+ * ============================================================================ */
+
+int usrl_json_tc_init(UsrlJsonTranscoder *t, const UsrlSchema *schema)
+{
+    if (!t || !schema) return -1;
+    memset(t, 0, sizeof(*t));
+
+    if (usrl_json_map_init(&t->map, schema) != 0) return -1;
+    t->record = calloc(1, schema->total_size ? schema->total_size : 1);
+    return t->record ? 0 : -1;
+}
+
+void usrl_json_tc_free(UsrlJsonTranscoder *t)
+{
+    if (!t) return;
+    free(t->record);
+    memset(t, 0, sizeof(*t));
+}
+
+int usrl_json_tc_attach(UsrlJsonTranscoder *t, void *core_base, const char *in_topic,
+                        const char *out_topic, uint16_t pub_id)
+{
+    if (!t || !core_base || !in_topic) return -1;
+
+    usrl_sub_init(&t->in, core_base, in_topic);
+    t->has_in = (t->in.desc != NULL);
+    if (!t->has_in) return -1;
+
+    if (out_topic) {
+        usrl_pub_init(&t->out, core_base, out_topic, pub_id);
+        t->has_out = (t->out.desc != NULL);
+        if (!t->has_out) return -1;
+    }
+    return 0;
+}
+
+int usrl_json_tc_poll(UsrlJsonTranscoder *t, uint32_t max_batch)
+{
+    if (USRL_UNLIKELY(!t || !t->has_in || !t->record)) return USRL_RING_ERROR;
+    if (max_batch == 0 || max_batch > USRL_JSON_MAX_BATCH) max_batch = USRL_JSON_MAX_BATCH;
+
+    UsrlSlotView views[USRL_JSON_MAX_BATCH];
+    int n = usrl_sub_view_batch(&t->in, views, max_batch);
+    if (n <= 0) return n;
+
+    uint32_t size = t->map.schema->total_size;
+
+    for (int i = 0; i < n; i++) {
+        if (i + 1 < n) USRL_PREFETCH_R(views[i + 1].data);
+
+        /* Parse straight out of the slot; a lapped slot may parse as garbage,
+         * so the result only counts if the slot still holds this seq. */
+        UsrlTraceContext ctx;
+        int traced = usrl_view_trace(&views[i], &ctx);
+        int r = usrl_json_transcode(&t->map, views[i].data, views[i].len,
+                                    t->record, size, NULL);
+        if (USRL_UNLIKELY(traced < 0 || !usrl_view_valid(&views[i]))) {
+            t->lapped++;
+            continue;
+        }
+        if (USRL_UNLIKELY(r < 0)) {
+            t->rejected++;
+            continue;
+        }
+        t->records++;
+
+        if (t->has_out &&
+            usrl_pub_forward(&t->out, t->record, size, traced ? &ctx : NULL) == USRL_RING_OK)
+            t->published++;
+    }
+    return n;
+}
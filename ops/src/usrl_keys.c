@@ -0,0 +1,104 @@
+/**
+ * @file usrl_keys.c
+ * @brief Record key field to dense key id.
+ */
+
+#include "usrl_keys.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t next_power_of_two_u32(uint32_t v)
+{
+    if (v == 0) return 1;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return ++v;
+}
+
+static inline int key_is_text(const UsrlField *f)
+{
+    return f && (f->type == USRL_FIELD_STRING || f->type == USRL_FIELD_BYTES);
+}
+
+int usrl_keys_init(UsrlKeyIndex *k, const UsrlField *field, uint32_t max_keys)
+{
+    if (!k || max_keys == 0) return -1;
+    memset(k, 0, sizeof(*k));
+
+    k->field = field;
+    k->max_keys = max_keys;
+
+    if (key_is_text(field)) {
+        uint32_t slots = next_power_of_two_u32(max_keys * 2);
+        k->table = malloc(sizeof(int32_t) * slots);
+        k->names = calloc(max_keys, USRL_KEY_MAX + 1);
+        if (!k->table || !k->names) {
+            usrl_keys_free(k);
+            return -1;
+        }
+        memset(k->table, 0xFF, sizeof(int32_t) * slots);
+        k->mask = slots - 1;
+    }
+    return 0;
+}
+
+void usrl_keys_free(UsrlKeyIndex *k)
+{
+    if (!k) return;
+    free(k->table);
+    free(k->names);
+    memset(k, 0, sizeof(*k));
+}
+
+int32_t usrl_keys_lookup(UsrlKeyIndex *k, const uint8_t *record)
+{
+    return usrl_keys_lookup_field(k, k->field, record, 1);
+}
+
+int32_t usrl_keys_lookup_field(UsrlKeyIndex *k, const UsrlField *f,
+                               const uint8_t *record, int assign)
+{
+    if (!f) return 0;
+
+    if (!key_is_text(f)) {
+        int64_t id = usrl_field_i64(f, record);
+        return (id >= 0 && id < (int64_t)k->max_keys) ? (int32_t)id : -1;
+    }
+
+    if (!k->table) return -1; /* integer index, text field */
+
+    /* Copy the key NUL padded so equal names compare equal as 16 bytes */
+    char key[USRL_KEY_MAX] = {0};
+    const uint8_t *p = record + f->offset;
+    uint32_t n = f->size < USRL_KEY_MAX ? f->size : USRL_KEY_MAX;
+    for (uint32_t i = 0; i < n && p[i]; i++) key[i] = (char)p[i];
+
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < USRL_KEY_MAX; i++) {
+        h ^= (uint8_t)key[i];
+        h *= 16777619u;
+    }
+
+    for (uint32_t i = h & k->mask;; i = (i + 1) & k->mask) {
+        int32_t id = k->table[i];
+        if (id < 0) {
+            if (!assign || k->count == k->max_keys) return -1;
+            id = (int32_t)k->count++;
+            memcpy(k->names[id], key, USRL_KEY_MAX);
+            k->table[i] = id;
+            return id;
+        }
+        if (memcmp(k->names[id], key, USRL_KEY_MAX) == 0) return id;
+    }
+}
+
+const char *usrl_keys_name(const UsrlKeyIndex *k, uint32_t id)
+{
+    if (!k || !k->names || id >= k->count) return "";
+    return k->names[id];
+}
@@ -0,0 +1,1416 @@
+/**
+ * @file usrl_pipeline.c
+ * @brief Declarative operator graphs: JSON config, fusion and executor threads.
+ */
+
+#define _GNU_SOURCE
+#include "usrl_pipeline.h"
+#include "usrl_ring.h"
+#include "usrl_trace.h"
+#include "usrl_lanes.h"
+#include "usrl_metrics.h"
+#include "usrl_schema.h"
+#include "usrl_keys.h"
+#include "usrl_json.h"
+#include "usrl_indicators.h"
+#include "usrl_window.h"
+#include "usrl_join.h"
+#include "usrl_book.h"
+#include "usrl_net.h"
+
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+
+#define PIPE_BATCH 256
+#define PIPE_MAX_SCHEMAS 16
+#define PIPE_JSON_DEPTH 32
+#define PIPE_DEFAULT_SLOTS 4096
+
+static uint32_t next_power_of_two_u32(uint32_t v)
+{
+    if (v == 0) return 1;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return ++v;
+}
+
+static void set_err(char *err, size_t len, const char *fmt, ...)
+{
+    if (!err || len == 0) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(err, len, fmt, ap);
+    va_end(ap);
+}
+
+/* ============================================================================
+ * CONFIG DOM
+ *
+ * Pipeline files are small and read once, so a plain tree of nodes is
+ * enough here (the transcoder in usrl_json.c is for flat hot-path records).
+ * ============================================================================ */
+
+typedef enum { JV_NULL, JV_BOOL, JV_NUM, JV_STR, JV_ARR, JV_OBJ } JvKind;
+
+typedef struct Jv {
+    JvKind kind;
+    double num;             /* JV_NUM, JV_BOOL */
+    char *str;              /* JV_STR */
+    char *key;              /* member name inside an object */
+    struct Jv *child;       /* first element / member */
+    struct Jv *next;
+} Jv;
+
+typedef struct {
+    const char *p;
+    const char *end;
+    const char *err;
+} JvParser;
+
+static void jv_free(Jv *v)
+{
+    while (v) {
+        Jv *next = v->next;
+        jv_free(v->child);
+        free(v->str);
+        free(v->key);
+        free(v);
+        v = next;
+    }
+}
+
+static void jv_ws(JvParser *ps)
+{
+    while (ps->p < ps->end && (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n' || *ps->p == '\r'))
+        ps->p++;
+}
+
+static int hex4(const char *p, uint32_t *out)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (uint32_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (uint32_t)(c - 'A' + 10);
+        else return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+static char *jv_string(JvParser *ps)
+{
+    const char *p = ++ps->p;    /* opening quote */
+    size_t cap = 16, n = 0;
+    char *s = malloc(cap);
+    if (!s) return NULL;
+
+    while (p < ps->end && *p != '"') {
+        if (n + 4 >= cap) {
+            char *t = realloc(s, cap *= 2);
+            if (!t) { free(s); return NULL; }
+            s = t;
+        }
+        char c = *p++;
+        if (c != '\\') { s[n++] = c; continue; }
+        if (p >= ps->end) break;
+
+        switch (c = *p++) {
+        case 'n': s[n++] = '\n'; break;
+        case 't': s[n++] = '\t'; break;
+        case 'r': s[n++] = '\r'; break;
+        case 'b': s[n++] = '\b'; break;
+        case 'f': s[n++] = '\f'; break;
+        case 'u': {
+            uint32_t cp;
+            if (ps->end - p < 4 || hex4(p, &cp) != 0) goto bad;
+            p += 4;
+            if (cp < 0x80) {
+                s[n++] = (char)cp;
+            } else if (cp < 0x800) {
+                s[n++] = (char)(0xC0 | (cp >> 6));
+                s[n++] = (char)(0x80 | (cp & 0x3F));
+            } else {
+                s[n++] = (char)(0xE0 | (cp >> 12));
+                s[n++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                s[n++] = (char)(0x80 | (cp & 0x3F));
+            }
+            break;
+        }
+        default: s[n++] = c; break;    /* \" \\ \/ */
+        }
+    }
+    if (p >= ps->end) goto bad;
+
+    ps->p = p + 1;
+    s[n] = '\0';
+    return s;
+
+bad:
+    ps->err = "bad string";
+    free(s);
+    return NULL;
+}
+
+static Jv *jv_value(JvParser *ps, int depth)
+{
+    jv_ws(ps);
+    if (ps->p >= ps->end) { ps->err = "unexpected end"; return NULL; }
+    if (depth > PIPE_JSON_DEPTH) { ps->err = "nested too deep"; return NULL; }
+
+    Jv *v = calloc(1, sizeof(*v));
+    if (!v) { ps->err = "out of memory"; return NULL; }
+
+    char c = *ps->p;
+    if (c == '{' || c == '[') {
+        char close = (c == '{') ? '}' : ']';
+        Jv **tail = &v->child;
+        v->kind = (c == '{') ? JV_OBJ : JV_ARR;
+        ps->p++;
+        jv_ws(ps);
+        if (ps->p < ps->end && *ps->p == close) { ps->p++; return v; }
+
+        for (;;) {
+            char *key = NULL;
+            if (v->kind == JV_OBJ) {
+                jv_ws(ps);
+                if (ps->p >= ps->end || *ps->p != '"') { ps->err = "expected key"; goto fail; }
+                if (!(key = jv_string(ps))) goto fail;
+                jv_ws(ps);
+                if (ps->p >= ps->end || *ps->p != ':') { free(key); ps->err = "expected ':'"; goto fail; }
+                ps->p++;
+            }
+            Jv *item = jv_value(ps, depth + 1);
+            if (!item) { free(key); goto fail; }
+            item->key = key;
+            *tail = item;
+            tail = &item->next;
+
+            jv_ws(ps);
+            if (ps->p < ps->end && *ps->p == ',') { ps->p++; continue; }
+            if (ps->p < ps->end && *ps->p == close) { ps->p++; return v; }
+            ps->err = "expected ',' or closing bracket";
+            goto fail;
+        }
+    }
+
+    if (c == '"') {
+        v->kind = JV_STR;
+        if (!(v->str = jv_string(ps))) goto fail;
+        return v;
+    }
+
+    static const struct { const char *lit; JvKind kind; double num; } lits[] = {
+        { "true", JV_BOOL, 1 }, { "false", JV_BOOL, 0 }, { "null", JV_NULL, 0 },
+    };
+    for (size_t i = 0; i < sizeof(lits) / sizeof(lits[0]); i++) {
+        size_t n = strlen(lits[i].lit);
+        if ((size_t)(ps->end - ps->p) >= n && memcmp(ps->p, lits[i].lit, n) == 0) {
+            v->kind = lits[i].kind;
+            v->num = lits[i].num;
+            ps->p += n;
+            return v;
+        }
+    }
+
+    char *end;
+    v->num = strtod(ps->p, &end);
+    if (end == ps->p || end > ps->end) { ps->err = "unexpected character"; goto fail; }
+    v->kind = JV_NUM;
+    ps->p = end;
+    return v;
+
+fail:
+    jv_free(v);
+    return NULL;
+}
+
+static const Jv *jv_get(const Jv *o, const char *key)
+{
+    if (!o || o->kind != JV_OBJ) return NULL;
+    for (const Jv *m = o->child; m; m = m->next)
+        if (strcmp(m->key, key) == 0) return m;
+    return NULL;
+}
+
+static const char *jv_str(const Jv *o, const char *key, const char *def)
+{
+    const Jv *v = jv_get(o, key);
+    return (v && v->kind == JV_STR) ? v->str : def;
+}
+
+static uint64_t jv_u64(const Jv *o, const char *key, uint64_t def)
+{
+    const Jv *v = jv_get(o, key);
+    return (v && v->kind == JV_NUM && v->num >= 0) ? (uint64_t)v->num : def;
+}
+
+static int64_t jv_i64(const Jv *o, const char *key, int64_t def)
+{
+    const Jv *v = jv_get(o, key);
+    return (v && v->kind == JV_NUM) ? (int64_t)v->num : def;
+}
+
+static int jv_bool(const Jv *o, const char *key, int def)
+{
+    const Jv *v = jv_get(o, key);
+    return (v && v->kind == JV_BOOL) ? (v->num != 0) : def;
+}
+
+/* "<name>_ns", else "<name>_ms" */
+static uint64_t jv_duration_ns(const Jv *o, const char *name, uint64_t def)
+{
+    char key[48];
+    snprintf(key, sizeof(key), "%s_ns", name);
+    if (jv_get(o, key)) return jv_u64(o, key, def);
+    snprintf(key, sizeof(key), "%s_ms", name);
+    if (jv_get(o, key)) return jv_u64(o, key, 0) * 1000000ULL;
+    return def;
+}
+
+/* ============================================================================
+ * GRAPH
+ * ============================================================================ */
+
+enum {
+    OP_JSON = 1,
+    OP_INDICATORS,
+    OP_WINDOW,
+    OP_JOIN,
+    OP_BOOK,
+    OP_ROUTER,
+    OP_BRIDGE,
+};
+
+static const char *const op_names[] = {
+    [OP_JSON] = "json",
+    [OP_INDICATORS] = "indicators",
+    [OP_WINDOW] = "window",
+    [OP_JOIN] = "join",
+    [OP_BOOK] = "book",
+    [OP_ROUTER] = "router",
+    [OP_BRIDGE] = "bridge",
+};
+
+typedef struct PipeStage PipeStage;
+
+typedef struct {
+    const char *topic;
+    PipeStage *next;            /* fused consumer, NULL = ring */
+    uint32_t next_input;
+    UsrlPublisher pub;
+    int has_pub;
+} PipePort;
+
+typedef struct {
+    const char *topic;
+    uint32_t min_len;           /* shorter records are rejected by the operator */
+    int fused;                  /* fed by an upstream stage on this thread */
+    int drain;                  /* read up to USRL_JOIN_RIGHT_BATCHES first (join right side) */
+    UsrlSubscriber sub;
+    uint8_t *buf;               /* record copy, slot payload sized */
+    uint32_t cap;
+    uint64_t skipped;           /* sub.skipped_count already counted as dropped */
+    UsrlMetricCell *pos;        /* last seq read, for lag */
+} PipeInput;
+
+typedef struct {
+    UsrlKeyIndex keys;
+    const UsrlField *field;
+    const Jv *routes;           /* { "key value": "topic" } */
+    int16_t *port_of;           /* per key id: port, -1 = drop, -2 = unresolved */
+    int32_t default_port;
+    uint32_t partitions;        /* hash partitioning when non-zero */
+} PipeRouter;
+
+typedef struct {
+    usrl_transport_type_t type;
+    const char *host;
+    int port;
+    usrl_transport_t *tr;
+    uint8_t *frame;             /* TCP: 4-byte big-endian length + record */
+    uint32_t cap;
+} PipeBridge;
+
+struct PipeStage {
+    const char *name;
+    uint32_t kind;
+    uint32_t thread;
+    uint16_t pub_id;
+    uint32_t slots;             /* intermediate output ring size */
+    int fuse;
+    const Jv *cfg;
+
+    PipeInput in[2];
+    uint32_t in_count;
+    PipePort port[USRL_PIPE_MAX_PORTS];
+    uint32_t port_count;
+    uint32_t out_size;          /* record size on every port */
+    uint8_t *rec;               /* output record */
+
+    union {
+        UsrlJsonMap json;
+        UsrlIndicators ind;
+        UsrlWindowAgg win;
+        UsrlJoin join;
+        UsrlBookBuilder book;
+        PipeRouter router;
+        PipeBridge bridge;
+    } op;
+
+    /* Stats: plain counters owned by the executor, mirrored per batch */
+    uint64_t n_in;
+    uint64_t n_out;
+    uint64_t n_drop;
+    UsrlMetricCell *m_in;
+    UsrlMetricCell *m_out;
+    UsrlMetricCell *m_drop;
+};
+
+typedef struct {
+    const char *name;
+    int cpu;                    /* -1 = not pinned */
+    int idle;                   /* 0 spin, 1 yield, 2 sleep */
+    uint32_t sleep_us;
+    PipeStage *stages[USRL_PIPE_MAX_STAGES];
+    uint32_t stage_count;
+    pthread_t tid;
+    int started;
+    UsrlPipeline *p;
+} PipeThread;
+
+struct UsrlPipeline {
+    Jv *root;
+    const char *core_path;
+    uint64_t mem_size;
+    void *core;
+
+    UsrlTopicConfig topics[USRL_PIPE_MAX_TOPICS];
+    uint32_t topic_count;
+    uint32_t declared_count;
+
+    UsrlSchema *schemas[PIPE_MAX_SCHEMAS];
+    uint32_t schema_count;
+
+    PipeThread threads[USRL_PIPE_MAX_THREADS];
+    uint32_t thread_count;
+
+    PipeStage stages[USRL_PIPE_MAX_STAGES];
+    uint32_t stage_count;
+
+    UsrlMetrics metrics;
+    int has_metrics;
+    int attached;
+    atomic_int running;
+};
+
+static void stage_push(PipeStage *s, uint32_t input, const uint8_t *rec, uint32_t len,
+                       uint64_t ts, const UsrlTraceContext *ctx);
+
+/* ============================================================================
+ * EMISSION
+ * ============================================================================ */
+
+static void stage_emit(PipeStage *s, uint32_t port, const uint8_t *rec, uint32_t len,
+                       uint64_t ts, const UsrlTraceContext *ctx)
+{
+    s->n_out++;
+    if (port >= s->port_count) return;
+
+    PipePort *o = &s->port[port];
+    if (o->next) {
+        stage_push(o->next, o->next_input, rec, len, ts, ctx);
+    } else if (o->has_pub && usrl_pub_forward(&o->pub, rec, len, ctx) != USRL_RING_OK) {
+        s->n_drop++;
+    }
+}
+
+static void on_bar(const UsrlBar *bar, void *arg)
+{
+    PipeStage *s = arg;
+    stage_emit(s, 0, (const uint8_t *)bar, sizeof(*bar), bar->end_ns, NULL);
+}
+
+static int32_t route_port(PipeStage *s, const uint8_t *rec)
+{
+    PipeRouter *r = &s->op.router;
+
+    if (r->partitions) {
+        /* FNV-1a over the key bytes: stable across runs and processes */
+        uint32_t h = 2166136261u;
+        uint32_t n = r->field->size;
+        if (r->field->type == USRL_FIELD_STRING) n = (uint32_t)strnlen((const char *)rec + r->field->offset, n);
+        for (uint32_t i = 0; i < n; i++) h = (h ^ rec[r->field->offset + i]) * 16777619u;
+        return (int32_t)(h % r->partitions);
+    }
+
+    int32_t key = usrl_keys_lookup(&r->keys, rec);
+    if (key < 0) return r->default_port;
+
+    int16_t port = r->port_of[key];
+    if (USRL_LIKELY(port != -2)) return port;
+
+    /* First sight of this key: resolve it against the route table once */
+    char name[32];
+    if (r->field->type == USRL_FIELD_STRING || r->field->type == USRL_FIELD_BYTES)
+        snprintf(name, sizeof(name), "%s", usrl_keys_name(&r->keys, (uint32_t)key));
+    else
+        snprintf(name, sizeof(name), "%lld", (long long)usrl_field_i64(r->field, rec));
+
+    port = (int16_t)r->default_port;
+    for (const Jv *m = r->routes ? r->routes->child : NULL; m; m = m->next) {
+        if (strcmp(m->key, name) != 0) continue;
+        for (uint32_t i = 0; i < s->port_count; i++)
+            if (strcmp(s->port[i].topic, m->str) == 0) port = (int16_t)i;
+        break;
+    }
+    r->port_of[key] = port;
+    return port;
+}
+
+static int bridge_send(PipeStage *s, const uint8_t *rec, uint32_t len)
+{
+    PipeBridge *b = &s->op.bridge;
+    if (USRL_UNLIKELY(!b->tr)) return -1;
+
+    if (b->type == USRL_TRANS_UDP)
+        return usrl_trans_send(b->tr, rec, len) == (ssize_t)len ? 0 : -1;
+
+    if (USRL_UNLIKELY(len + 4 > b->cap)) {
+        uint8_t *f = realloc(b->frame, len + 4);
+        if (!f) return -1;
+        b->frame = f;
+        b->cap = len + 4;
+    }
+    uint32_t be = htonl(len);
+    memcpy(b->frame, &be, 4);
+    memcpy(b->frame + 4, rec, len);
+    return usrl_trans_send(b->tr, b->frame, len + 4) == (ssize_t)(len + 4) ? 0 : -1;
+}
+
+/* ============================================================================
+ * OPERATOR DISPATCH
+ * ============================================================================ */
+
+static void stage_push(PipeStage *s, uint32_t input, const uint8_t *rec, uint32_t len,
+                       uint64_t ts, const UsrlTraceContext *ctx)
+{
+    int r = 0;
+    s->n_in++;
+
+    if (USRL_UNLIKELY(len < s->in[input].min_len)) {
+        s->n_drop++;
+        return;
+    }
+
+    switch (s->kind) {
+    case OP_JSON:
+        r = usrl_json_transcode(&s->op.json, rec, len, s->rec, s->out_size, NULL);
+        if (r >= 0) stage_emit(s, 0, s->rec, s->out_size, ts, ctx);
+        break;
+
+    case OP_INDICATORS:
+        r = usrl_ind_apply(&s->op.ind, rec, ts);
+        break;
+
+    case OP_WINDOW:
+        r = usrl_window_apply(&s->op.win, rec, ts);     /* bars go out through on_bar() */
+        break;
+
+    case OP_JOIN:
+        if (input == 1) {
+            r = usrl_join_right(&s->op.join, rec, ts);
+        } else {
+            r = usrl_join_left(&s->op.join, rec, ts, s->rec);
+            if (r == 1 || (r == 0 && s->op.join.mode == USRL_JOIN_LEFT))
+                stage_emit(s, 0, s->rec, s->out_size, ts, ctx);
+        }
+        break;
+
+    case OP_BOOK: {
+        UsrlBookUpdate u;
+        memcpy(&u, rec, sizeof(u));
+        r = usrl_book_apply(&s->op.book, &u);
+        break;
+    }
+
+    case OP_ROUTER:
+        r = route_port(s, rec);
+        if (r >= 0) stage_emit(s, (uint32_t)r, rec, len, ts, ctx);
+        break;
+
+    case OP_BRIDGE:
+        r = bridge_send(s, rec, len);
+        if (r == 0) s->n_out++;
+        break;
+    }
+
+    if (r < 0) s->n_drop++;
+}
+
+/* Publish conflated output, then let fused consumers close their batch */
+static void stage_end_batch(PipeStage *s)
+{
+    if (s->kind == OP_INDICATORS) {
+        UsrlIndicators *x = &s->op.ind;
+        UsrlIndRecord *r = (UsrlIndRecord *)s->rec;
+        for (uint32_t i = 0; i < x->dirty_count; i++) {
+            if (usrl_ind_record(x, x->dirty[i], r, s->out_size) > 0)
+                stage_emit(s, 0, s->rec, s->out_size, r->timestamp_ns, NULL);
+        }
+        usrl_ind_flush(x);      /* not attached: only clears the dirty list */
+    } else if (s->kind == OP_BOOK) {
+        UsrlBookBuilder *b = &s->op.book;
+        UsrlTopOfBook tob;
+        for (uint32_t i = 0; i < b->dirty_count; i++) {
+            if (usrl_book_top(b, b->dirty[i], &tob) == 0)
+                stage_emit(s, 0, (const uint8_t *)&tob, sizeof(tob), tob.timestamp_ns, NULL);
+        }
+        usrl_book_flush(b);
+    }
+
+    for (uint32_t i = 0; i < s->port_count; i++)
+        if (s->port[i].next) stage_end_batch(s->port[i].next);
+
+    if (s->m_in) {
+        usrl_metric_set(s->m_in, (int64_t)s->n_in);
+        usrl_metric_set(s->m_out, (int64_t)s->n_out);
+        usrl_metric_set(s->m_drop, (int64_t)s->n_drop);
+    }
+}
+
+/* ============================================================================
+ * LOAD
+ * ============================================================================ */
+
+static const UsrlSchema *find_schema(const UsrlPipeline *p, const char *name)
+{
+    for (uint32_t i = 0; name && i < p->schema_count; i++)
+        if (strcmp(p->schemas[i]->name, name) == 0) return p->schemas[i];
+    return NULL;
+}
+
+static int find_topic(const UsrlPipeline *p, const char *name, uint32_t limit)
+{
+    for (uint32_t i = 0; i < limit; i++)
+        if (strcmp(p->topics[i].name, name) == 0) return (int)i;
+    return -1;
+}
+
+static int load_topics(UsrlPipeline *p, const Jv *arr, char *err, size_t err_len)
+{
+    for (const Jv *t = arr ? arr->child : NULL; t; t = t->next) {
+        const char *name = jv_str(t, "name", NULL);
+        if (!name || !jv_get(t, "slots") || !jv_get(t, "payload_size")) {
+            set_err(err, err_len, "topic needs name, slots and payload_size");
+            return -1;
+        }
+        if (strlen(name) >= USRL_MAX_TOPIC_NAME || p->topic_count >= USRL_PIPE_MAX_TOPICS) {
+            set_err(err, err_len, "topic %s: name too long or too many topics", name);
+            return -1;
+        }
+
+        UsrlTopicConfig c;
+        memset(&c, 0, sizeof(c));
+        snprintf(c.name, sizeof(c.name), "%s", name);
+        c.slot_count = (uint32_t)jv_u64(t, "slots", 0);
+        c.slot_size = (uint32_t)jv_u64(t, "payload_size", 0);
+        const char *type = jv_str(t, "type", "swmr");
+        c.type = (strstr(type, "mwmr") || strstr(type, "MWMR")) ? USRL_RING_TYPE_MWMR
+                                                                 : USRL_RING_TYPE_SWMR;
+
+        /* Priority lanes: one ring per lane, as core_loader does */
+        uint32_t lanes = (uint32_t)jv_u64(t, "lanes", 1);
+        if (lanes > 1) {
+            int n = usrl_lanes_expand(&c, lanes, &p->topics[p->topic_count],
+                                      USRL_PIPE_MAX_TOPICS - p->topic_count);
+            if (n < 0) {
+                set_err(err, err_len, "topic %s: cannot expand %u lanes", name, lanes);
+                return -1;
+            }
+            p->topic_count += (uint32_t)n;
+        } else {
+            p->topics[p->topic_count++] = c;
+        }
+    }
+    p->declared_count = p->topic_count;
+    return 0;
+}
+
+static int load_schemas(UsrlPipeline *p, const Jv *arr, char *err, size_t err_len)
+{
+    static const struct { const char *name; UsrlFieldType type; uint32_t size; } types[] = {
+        { "u64", USRL_FIELD_U64, 8 }, { "i64", USRL_FIELD_I64, 8 }, { "f64", USRL_FIELD_F64, 8 },
+        { "u32", USRL_FIELD_U32, 4 }, { "i32", USRL_FIELD_I32, 4 }, { "f32", USRL_FIELD_F32, 4 },
+        { "bytes", USRL_FIELD_BYTES, 0 }, { "string", USRL_FIELD_STRING, 0 },
+    };
+
+    for (const Jv *s = arr ? arr->child : NULL; s; s = s->next) {
+        const char *name = jv_str(s, "name", NULL);
+        const Jv *fields = jv_get(s, "fields");
+        if (!name || !fields || fields->kind != JV_ARR || p->schema_count >= PIPE_MAX_SCHEMAS) {
+            set_err(err, err_len, "schema needs a name and a fields array");
+            return -1;
+        }
+
+        UsrlSchema *sc = usrl_schema_create((uint32_t)jv_u64(s, "id", p->schema_count + 1), name);
+        if (!sc) return -1;
+        p->schemas[p->schema_count++] = sc;
+
+        for (const Jv *f = fields->child; f; f = f->next) {
+            const char *fname = jv_str(f, "name", NULL);
+            const char *ftype = jv_str(f, "type", NULL);
+            size_t k = 0;
+            while (ftype && k < sizeof(types) / sizeof(types[0]) && strcmp(types[k].name, ftype) != 0) k++;
+            if (!fname || !ftype || k == sizeof(types) / sizeof(types[0])) {
+                set_err(err, err_len, "schema %s: field needs a name and a known type", name);
+                return -1;
+            }
+            uint32_t size = types[k].size ? types[k].size : (uint32_t)jv_u64(f, "size", 0);
+            if (size == 0 || usrl_schema_add_field(sc, fname, types[k].type, size) != 0) {
+                set_err(err, err_len, "schema %s: bad field %s", name, fname);
+                return -1;
+            }
+        }
+        if (usrl_schema_finalize(sc) != 0) {
+            set_err(err, err_len, "schema %s has no fields", name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int load_threads(UsrlPipeline *p, const Jv *arr, char *err, size_t err_len)
+{
+    for (const Jv *t = arr ? arr->child : NULL; t; t = t->next) {
+        if (p->thread_count >= USRL_PIPE_MAX_THREADS) {
+            set_err(err, err_len, "too many threads");
+            return -1;
+        }
+        PipeThread *th = &p->threads[p->thread_count++];
+        const char *idle = jv_str(t, "idle", "yield");
+        th->name = jv_str(t, "name", "main");
+        th->cpu = (int)jv_i64(t, "cpu", -1);
+        th->idle = (strcmp(idle, "spin") == 0) ? 0 : (strcmp(idle, "sleep") == 0) ? 2 : 1;
+        th->sleep_us = (uint32_t)jv_u64(t, "sleep_us", 50);
+    }
+    if (p->thread_count == 0) {
+        p->threads[0].name = "main";
+        p->threads[0].cpu = -1;
+        p->threads[0].idle = 1;
+        p->thread_count = 1;
+    }
+    for (uint32_t i = 0; i < p->thread_count; i++) p->threads[i].p = p;
+    return 0;
+}
+
+static int add_port(PipeStage *s, const char *topic)
+{
+    for (uint32_t i = 0; i < s->port_count; i++)
+        if (strcmp(s->port[i].topic, topic) == 0) return (int)i;
+    if (s->port_count >= USRL_PIPE_MAX_PORTS) return -1;
+    s->port[s->port_count].topic = topic;
+    return (int)s->port_count++;
+}
+
+/* Resolve one stage's operator from its config and initialise it */
+static int stage_init_op(UsrlPipeline *p, PipeStage *s, char *err, size_t err_len)
+{
+    const Jv *c = s->cfg;
+    const char *schema_name = jv_str(c, "schema", NULL);
+    const UsrlSchema *schema = find_schema(p, schema_name);
+    const char *out = jv_str(c, "out", NULL);
+    uint32_t max_keys = (uint32_t)jv_u64(c, "max_keys", 1024);
+
+    s->in[0].topic = jv_str(c, "in", NULL);
+    s->in_count = 1;
+    if (out) add_port(s, out);
+
+    if (s->kind != OP_BOOK && s->kind != OP_BRIDGE && s->kind != OP_JOIN && !schema) {
+        set_err(err, err_len, "stage %s: unknown schema '%s'", s->name, schema_name ? schema_name : "");
+        return -1;
+    }
+
+    switch (s->kind) {
+    case OP_JSON: {
+        if (usrl_json_map_init(&s->op.json, schema) != 0) break;
+        const Jv *aliases = jv_get(c, "aliases");
+        for (const Jv *a = aliases ? aliases->child : NULL; a; a = a->next) {
+            if (a->kind != JV_STR || usrl_json_map_alias(&s->op.json, a->key, a->str) != 0) {
+                set_err(err, err_len, "stage %s: bad alias %s", s->name, a->key);
+                return -1;
+            }
+        }
+        uint32_t prefix = (uint32_t)jv_u64(c, "prefix", 0);
+        if (prefix && usrl_json_map_prefix(&s->op.json, prefix, jv_str(c, "ts_field", NULL)) != 0) break;
+        s->out_size = schema->total_size;
+        return 0;
+    }
+
+    case OP_INDICATORS: {
+        static const char *const kinds[] = { "", "ema", "vwap", "mean", "var", "min", "max" };
+        UsrlIndSpec specs[USRL_MAX_INDICATORS];
+        uint32_t n = 0;
+        const Jv *list = jv_get(c, "indicators");
+        for (const Jv *e = list ? list->child : NULL; e; e = e->next) {
+            const char *kind = jv_str(e, "kind", "");
+            uint32_t k = 1;
+            while (k < 7 && strcmp(kinds[k], kind) != 0) k++;
+            if (k == 7 || n >= USRL_MAX_INDICATORS) {
+                set_err(err, err_len, "stage %s: bad indicator '%s'", s->name, kind);
+                return -1;
+            }
+            specs[n].kind = (UsrlIndKind)k;
+            specs[n].field = jv_str(e, "field", NULL);
+            specs[n].weight = jv_str(e, "weight", NULL);
+            specs[n].period = (uint32_t)jv_u64(e, "period", 0);
+            n++;
+        }
+        if (usrl_ind_init(&s->op.ind, schema, jv_str(c, "key", NULL), max_keys, specs, n) != 0) break;
+        s->in[0].min_len = schema->total_size;
+        s->out_size = usrl_ind_record_size(n);
+        return 0;
+    }
+
+    case OP_WINDOW: {
+        UsrlWindowSpec spec = {
+            .size_ns = jv_duration_ns(c, "size", 0),
+            .slide_ns = jv_duration_ns(c, "slide", 0),
+            .lateness_ns = jv_duration_ns(c, "lateness", 0),
+            .key = jv_str(c, "key", NULL),
+            .price = jv_str(c, "price", NULL),
+            .qty = jv_str(c, "qty", NULL),
+            .time = jv_str(c, "time", NULL),
+        };
+        if (usrl_window_init(&s->op.win, schema, &spec, max_keys) != 0) break;
+        usrl_window_on_bar(&s->op.win, on_bar, s);
+        s->in[0].min_len = schema->total_size;
+        s->out_size = sizeof(UsrlBar);
+        return 0;
+    }
+
+    case OP_JOIN: {
+        const UsrlSchema *left = find_schema(p, jv_str(c, "left_schema", schema_name));
+        const UsrlSchema *right = find_schema(p, jv_str(c, "right_schema", schema_name));
+        const char *mode = jv_str(c, "mode", "inner");
+        UsrlJoinSpec spec = {
+            .left_key = jv_str(c, "left_key", jv_str(c, "key", NULL)),
+            .right_key = jv_str(c, "right_key", jv_str(c, "key", NULL)),
+            .left_time = jv_str(c, "left_time", NULL),
+            .right_time = jv_str(c, "right_time", NULL),
+            .tolerance_ns = jv_duration_ns(c, "tolerance", 0),
+            .depth = (uint32_t)jv_u64(c, "depth", 16),
+            .mode = (strcmp(mode, "left") == 0) ? USRL_JOIN_LEFT : USRL_JOIN_INNER,
+        };
+        s->in[0].topic = jv_str(c, "left", NULL);
+        s->in[1].topic = jv_str(c, "right", NULL);
+        s->in[1].drain = 1;
+        s->in_count = 2;
+        if (!left || !right || usrl_join_init(&s->op.join, left, right, &spec, max_keys) != 0) break;
+        s->in[0].min_len = left->total_size;
+        s->in[1].min_len = right->total_size;
+        s->out_size = usrl_join_record_size(&s->op.join);
+        return 0;
+    }
+
+    case OP_BOOK:
+        if (usrl_book_init(&s->op.book, (uint32_t)jv_u64(c, "max_symbols", 1024),
+                           (uint32_t)jv_u64(c, "window_ticks", 1024)) != 0) break;
+        s->in[0].min_len = sizeof(UsrlBookUpdate);
+        s->out_size = sizeof(UsrlTopOfBook);
+        return 0;
+
+    case OP_ROUTER: {
+        PipeRouter *r = &s->op.router;
+        const Jv *parts = jv_get(c, "partitions");
+        r->field = usrl_schema_field(schema, jv_str(c, "key", ""));
+        r->routes = jv_get(c, "routes");
+        if (!r->field) {
+            set_err(err, err_len, "stage %s: router needs a key field", s->name);
+            return -1;
+        }
+
+        if (parts && parts->kind == JV_ARR) {
+            for (const Jv *t = parts->child; t; t = t->next)
+                if (t->kind != JV_STR || add_port(s, t->str) < 0) goto bad_routes;
+            r->partitions = s->port_count;
+        } else {
+            for (const Jv *m = r->routes ? r->routes->child : NULL; m; m = m->next)
+                if (m->kind != JV_STR || add_port(s, m->str) < 0) goto bad_routes;
+            const char *def = jv_str(c, "default", NULL);
+            r->default_port = def ? add_port(s, def) : -1;
+            if (usrl_keys_init(&r->keys, r->field, max_keys) != 0) break;
+            r->port_of = malloc(sizeof(int16_t) * max_keys);
+            if (!r->port_of) break;
+            for (uint32_t i = 0; i < max_keys; i++) r->port_of[i] = -2;
+        }
+        if (s->port_count == 0) goto bad_routes;
+        s->in[0].min_len = schema->total_size;
+        s->out_size = schema->total_size;
+        return 0;
+
+    bad_routes:
+        set_err(err, err_len, "stage %s: router needs string routes or partitions", s->name);
+        return -1;
+    }
+
+    case OP_BRIDGE: {
+        PipeBridge *b = &s->op.bridge;
+        const char *tr = jv_str(c, "transport", "tcp");
+        b->type = (strcmp(tr, "udp") == 0) ? USRL_TRANS_UDP : USRL_TRANS_TCP;
+        b->host = jv_str(c, "host", "127.0.0.1");
+        b->port = (int)jv_u64(c, "port", 0);
+        s->port_count = 0;
+        if (b->port == 0) {
+            set_err(err, err_len, "stage %s: bridge needs a port", s->name);
+            return -1;
+        }
+        return 0;
+    }
+    }
+
+    set_err(err, err_len, "stage %s: invalid %s operator settings", s->name, op_names[s->kind]);
+    return -1;
+}
+
+static int load_stages(UsrlPipeline *p, const Jv *arr, char *err, size_t err_len)
+{
+    for (const Jv *c = arr ? arr->child : NULL; c; c = c->next) {
+        if (p->stage_count >= USRL_PIPE_MAX_STAGES) {
+            set_err(err, err_len, "too many stages");
+            return -1;
+        }
+        PipeStage *s = &p->stages[p->stage_count];
+        const char *op = jv_str(c, "op", "");
+        const char *thread = jv_str(c, "thread", NULL);
+
+        s->cfg = c;
+        s->name = jv_str(c, "name", NULL);
+        if (!s->name || strlen(s->name) >= USRL_PIPE_NAME_MAX) {
+            set_err(err, err_len, "stage %u needs a name shorter than %d", p->stage_count, USRL_PIPE_NAME_MAX);
+            return -1;
+        }
+        for (uint32_t i = 0; i < p->stage_count; i++) {
+            if (strcmp(p->stages[i].name, s->name) == 0) {
+                set_err(err, err_len, "duplicate stage %s", s->name);
+                return -1;
+            }
+        }
+
+        for (s->kind = OP_JSON; s->kind <= OP_BRIDGE && strcmp(op_names[s->kind], op) != 0; s->kind++)
+            ;
+        if (s->kind > OP_BRIDGE) {
+            set_err(err, err_len, "stage %s: unknown op '%s'", s->name, op);
+            return -1;
+        }
+
+        s->thread = 0;
+        if (thread) {
+            while (s->thread < p->thread_count && strcmp(p->threads[s->thread].name, thread) != 0)
+                s->thread++;
+            if (s->thread == p->thread_count) {
+                set_err(err, err_len, "stage %s: unknown thread %s", s->name, thread);
+                return -1;
+            }
+        }
+        s->pub_id = (uint16_t)jv_u64(c, "pub_id", 0x100 + p->stage_count);
+        s->slots = (uint32_t)jv_u64(c, "slots", jv_u64(p->root, "intermediate_slots", PIPE_DEFAULT_SLOTS));
+        s->fuse = jv_bool(c, "fuse", jv_bool(p->root, "fuse", 1));
+
+        p->stage_count++;
+        if (stage_init_op(p, s, err, err_len) != 0) return -1;
+        for (uint32_t i = 0; i < s->in_count; i++) {
+            if (!s->in[i].topic) {
+                set_err(err, err_len, "stage %s: missing input topic", s->name);
+                return -1;
+            }
+        }
+
+        s->rec = calloc(1, s->out_size ? s->out_size : 1);
+        if (!s->rec) return -1;
+
+        PipeThread *th = &p->threads[s->thread];
+        th->stages[th->stage_count++] = s;
+    }
+    return 0;
+}
+
+/* True if following fused edges from `from` reaches `to` */
+static int fused_reaches(const PipeStage *from, const PipeStage *to)
+{
+    if (from == to) return 1;
+    for (uint32_t i = 0; i < from->port_count; i++)
+        if (from->port[i].next && fused_reaches(from->port[i].next, to)) return 1;
+    return 0;
+}
+
+/* Fuse same-thread single-consumer edges, then size the remaining rings */
+static int resolve_graph(UsrlPipeline *p, char *err, size_t err_len)
+{
+    for (uint32_t a = 0; a < p->stage_count; a++) {
+        PipeStage *s = &p->stages[a];
+
+        for (uint32_t k = 0; k < s->port_count; k++) {
+            PipePort *o = &s->port[k];
+            int declared = find_topic(p, o->topic, p->declared_count);
+            PipeStage *consumer = NULL;
+            uint32_t consumers = 0, input = 0;
+
+            for (uint32_t b = 0; b < p->stage_count; b++) {
+                PipeStage *t = &p->stages[b];
+                if (t != s) {
+                    for (uint32_t q = 0; q < t->port_count; q++) {
+                        if (strcmp(t->port[q].topic, o->topic) == 0) {
+                            set_err(err, err_len, "topic %s has two producers (%s, %s)",
+                                    o->topic, s->name, t->name);
+                            return -1;
+                        }
+                    }
+                }
+                for (uint32_t i = 0; i < t->in_count; i++) {
+                    if (strcmp(t->in[i].topic, o->topic) == 0) {
+                        consumer = t;
+                        input = i;
+                        consumers++;
+                    }
+                }
+            }
+
+            if (declared >= 0 && p->topics[declared].type != USRL_RING_TYPE_SWMR) {
+                set_err(err, err_len, "stage %s: output topic %s must be swmr", s->name, o->topic);
+                return -1;
+            }
+
+            if (declared < 0 && consumers == 1 && consumer->thread == s->thread &&
+                s->fuse && consumer->fuse && !fused_reaches(consumer, s)) {
+                o->next = consumer;
+                o->next_input = input;
+                consumer->in[input].fused = 1;
+                continue;
+            }
+
+            if (declared < 0) {
+                if (p->topic_count >= USRL_PIPE_MAX_TOPICS || strlen(o->topic) >= USRL_MAX_TOPIC_NAME) {
+                    set_err(err, err_len, "cannot add intermediate topic %s", o->topic);
+                    return -1;
+                }
+                UsrlTopicConfig *c = &p->topics[p->topic_count++];
+                memset(c, 0, sizeof(*c));
+                snprintf(c->name, sizeof(c->name), "%s", o->topic);
+                c->slot_count = s->slots;
+                c->slot_size = s->out_size;
+                c->type = USRL_RING_TYPE_SWMR;
+            }
+        }
+    }
+
+    /* Every ring input must come from somewhere */
+    for (uint32_t a = 0; a < p->stage_count; a++) {
+        PipeStage *s = &p->stages[a];
+        for (uint32_t i = 0; i < s->in_count; i++) {
+            if (!s->in[i].fused && find_topic(p, s->in[i].topic, p->topic_count) < 0) {
+                set_err(err, err_len, "stage %s: input topic %s is neither declared nor produced",
+                        s->name, s->in[i].topic);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+UsrlPipeline *usrl_pipeline_load(const char *json, char *err, size_t err_len)
+{
+    if (!json) return NULL;
+
+    UsrlPipeline *p = calloc(1, sizeof(*p));
+    if (!p) return NULL;
+
+    JvParser ps = { json, json + strlen(json), NULL };
+    p->root = jv_value(&ps, 0);
+    if (!p->root || p->root->kind != JV_OBJ) {
+        set_err(err, err_len, "parse error at byte %ld: %s", (long)(ps.p - json),
+                ps.err ? ps.err : "not an object");
+        usrl_pipeline_free(p);
+        return NULL;
+    }
+
+    p->core_path = jv_str(p->root, "core", "/usrl_core");
+    p->mem_size = jv_u64(p->root, "memory_size_mb", 128) * 1024 * 1024;
+
+    if (load_topics(p, jv_get(p->root, "topics"), err, err_len) != 0 ||
+        load_schemas(p, jv_get(p->root, "schemas"), err, err_len) != 0 ||
+        load_threads(p, jv_get(p->root, "threads"), err, err_len) != 0 ||
+        load_stages(p, jv_get(p->root, "stages"), err, err_len) != 0 ||
+        resolve_graph(p, err, err_len) != 0) {
+        usrl_pipeline_free(p);
+        return NULL;
+    }
+    if (p->stage_count == 0) {
+        set_err(err, err_len, "no stages");
+        usrl_pipeline_free(p);
+        return NULL;
+    }
+    return p;
+}
+
+void usrl_pipeline_free(UsrlPipeline *p)
+{
+    if (!p) return;
+    usrl_pipeline_stop(p);
+
+    for (uint32_t i = 0; i < p->stage_count; i++) {
+        PipeStage *s = &p->stages[i];
+        switch (s->kind) {
+        case OP_INDICATORS: usrl_ind_free(&s->op.ind); break;
+        case OP_WINDOW: usrl_window_free(&s->op.win); break;
+        case OP_JOIN: usrl_join_free(&s->op.join); break;
+        case OP_BOOK: usrl_book_free(&s->op.book); break;
+        case OP_ROUTER:
+            usrl_keys_free(&s->op.router.keys);
+            free(s->op.router.port_of);
+            break;
+        case OP_BRIDGE:
+            if (s->op.bridge.tr) usrl_trans_destroy(s->op.bridge.tr);
+            free(s->op.bridge.frame);
+            break;
+        }
+        for (uint32_t k = 0; k < s->in_count; k++) free(s->in[k].buf);
+        free(s->rec);
+    }
+    for (uint32_t i = 0; i < p->schema_count; i++) usrl_schema_free(p->schemas[i]);
+    if (p->has_metrics) {
+        if (p->metrics.owned) usrl_metrics_free(&p->metrics);
+        else usrl_metrics_close(&p->metrics);
+    }
+    if (p->core) {
+        CoreHeader *hdr = p->core;
+        usrl_core_unmap(p->core, hdr->mmap_size);
+    }
+    jv_free(p->root);
+    free(p);
+}
+
+int usrl_pipeline_topics(const UsrlPipeline *p, UsrlTopicConfig *out, uint32_t max)
+{
+    if (!p || !out) return -1;
+    uint32_t n = p->topic_count < max ? p->topic_count : max;
+    memcpy(out, p->topics, n * sizeof(*out));
+    return (int)p->topic_count;
+}
+
+/* ============================================================================
+ * ATTACH
+ * ============================================================================ */
+
+static int attach_metrics(UsrlPipeline *p, char *err, size_t err_len)
+{
+    const char *path = jv_str(p->root, "metrics", NULL);
+    uint32_t cap = next_power_of_two_u32(p->stage_count * 6 + 16);
+
+    if (path) {
+        if (usrl_metrics_create(path, cap) < 0 || usrl_metrics_open(&p->metrics, path) != 0) {
+            set_err(err, err_len, "cannot open metrics registry %s", path);
+            return -1;
+        }
+    } else if (usrl_metrics_init(&p->metrics, cap) != 0) {
+        return -1;
+    }
+    p->has_metrics = 1;
+
+    for (uint32_t i = 0; i < p->stage_count; i++) {
+        PipeStage *s = &p->stages[i];
+        char name[USRL_METRIC_NAME_MAX];
+
+        snprintf(name, sizeof(name), "pipe.%s.in", s->name);
+        s->m_in = usrl_metric_counter(&p->metrics, name);
+        snprintf(name, sizeof(name), "pipe.%s.out", s->name);
+        s->m_out = usrl_metric_counter(&p->metrics, name);
+        snprintf(name, sizeof(name), "pipe.%s.dropped", s->name);
+        s->m_drop = usrl_metric_counter(&p->metrics, name);
+        if (!s->m_in || !s->m_out || !s->m_drop) goto full;
+
+        for (uint32_t k = 0; k < s->in_count; k++) {
+            if (s->in[k].fused) continue;
+            snprintf(name, sizeof(name), "pipe.%s.pos%u", s->name, k);
+            if (!(s->in[k].pos = usrl_metric_gauge(&p->metrics, name))) goto full;
+        }
+    }
+    return 0;
+
+full:
+    set_err(err, err_len, "metrics registry full");
+    return -1;
+}
+
+int usrl_pipeline_attach(UsrlPipeline *p, void *core_base, char *err, size_t err_len)
+{
+    if (!p || !core_base) return -1;
+    if (attach_metrics(p, err, err_len) != 0) return -1;
+
+    for (uint32_t i = 0; i < p->stage_count; i++) {
+        PipeStage *s = &p->stages[i];
+
+        for (uint32_t k = 0; k < s->in_count; k++) {
+            PipeInput *in = &s->in[k];
+            if (in->fused) continue;
+
+            TopicEntry *t = usrl_get_topic(core_base, in->topic);
+            usrl_sub_init(&in->sub, core_base, in->topic);
+            if (!t || !in->sub.desc) {
+                set_err(err, err_len, "stage %s: topic %s not in core", s->name, in->topic);
+                return -1;
+            }
+            in->cap = t->slot_size - (uint32_t)sizeof(SlotHeader);
+            in->buf = malloc(in->cap ? in->cap : 1);
+            if (!in->buf) return -1;
+        }
+
+        for (uint32_t k = 0; k < s->port_count; k++) {
+            PipePort *o = &s->port[k];
+            if (o->next) continue;
+
+            TopicEntry *t = usrl_get_topic(core_base, o->topic);
+            if (!t || t->slot_size - sizeof(SlotHeader) < s->out_size) {
+                set_err(err, err_len, "stage %s: topic %s missing or smaller than %u-byte records",
+                        s->name, o->topic, s->out_size);
+                return -1;
+            }
+            usrl_pub_init(&o->pub, core_base, o->topic, s->pub_id);
+            o->has_pub = (o->pub.desc != NULL);
+        }
+
+        if (s->kind == OP_BRIDGE) {
+            PipeBridge *b = &s->op.bridge;
+            b->tr = usrl_trans_create(b->type, b->host, b->port, 0, USRL_SWMR, false);
+            if (!b->tr) {
+                set_err(err, err_len, "stage %s: cannot reach %s:%d", s->name, b->host, b->port);
+                return -1;
+            }
+        }
+    }
+    p->attached = 1;
+    return 0;
+}
+
+int usrl_pipeline_open(UsrlPipeline *p, char *err, size_t err_len)
+{
+    if (!p || p->core) return -1;
+
+    /* Grow the region if the declared size cannot hold every ring */
+    uint64_t need = 64 * 1024;
+    for (uint32_t i = 0; i < p->topic_count; i++) {
+        uint64_t slot = usrl_align_up(sizeof(SlotHeader) + p->topics[i].slot_size, 8);
+        need += (uint64_t)next_power_of_two_u32(p->topics[i].slot_count) * slot + USRL_ALIGNMENT;
+        need += sizeof(TopicEntry) + sizeof(RingDesc) + sizeof(TopicExt);
+    }
+    need = usrl_align_up(need, 1024 * 1024);
+    if (p->mem_size < need) p->mem_size = need;
+
+    /* An existing region is reused; its topics must already match */
+    int rc = usrl_core_init(p->core_path, p->mem_size, p->topics, p->topic_count);
+    if (rc < 0) {
+        set_err(err, err_len, "cannot create core %s (%d)", p->core_path, rc);
+        return -1;
+    }
+
+    p->core = usrl_core_map(p->core_path, 0);
+    if (!p->core) {
+        set_err(err, err_len, "cannot map core %s", p->core_path);
+        return -1;
+    }
+    return usrl_pipeline_attach(p, p->core, err, err_len);
+}
+
+/* ============================================================================
+ * EXECUTION
+ * ============================================================================ */
+
+static int pump_input(PipeStage *s, uint32_t idx)
+{
+    PipeInput *in = &s->in[idx];
+    UsrlSlotView views[PIPE_BATCH];
+
+    int n = usrl_sub_view_batch(&in->sub, views, PIPE_BATCH);
+    if (n <= 0) return n;
+
+    for (int i = 0; i < n; i++) {
+        if (i + 1 < n) USRL_PREFETCH_R(views[i + 1].data);
+
+        uint32_t len = views[i].len < in->cap ? views[i].len : in->cap;
+        UsrlTraceContext ctx;
+        int traced = usrl_view_trace(&views[i], &ctx);
+        memcpy(in->buf, views[i].data, len);
+        if (USRL_UNLIKELY(traced < 0 || !usrl_view_valid(&views[i]))) {
+            s->n_in++;
+            s->n_drop++;
+            continue;
+        }
+        stage_push(s, idx, in->buf, len, views[i].timestamp_ns, traced ? &ctx : NULL);
+    }
+
+    /* Slots the writer lapped before we got to them */
+    if (USRL_UNLIKELY(in->sub.skipped_count != in->skipped)) {
+        s->n_drop += in->sub.skipped_count - in->skipped;
+        in->skipped = in->sub.skipped_count;
+    }
+    usrl_metric_set(in->pos, (int64_t)in->sub.last_seq);
+    return n;
+}
+
+int usrl_pipeline_poll(UsrlPipeline *p, uint32_t thread)
+{
+    if (USRL_UNLIKELY(!p || thread >= p->thread_count)) return USRL_RING_ERROR;
+
+    PipeThread *th = &p->threads[thread];
+    int total = 0;
+
+    for (uint32_t i = 0; i < th->stage_count; i++) {
+        PipeStage *s = th->stages[i];
+        int work = 0;
+
+        /* Higher inputs first: a join sees every committed quote before the trade */
+        for (uint32_t k = s->in_count; k-- > 0;) {
+            if (s->in[k].fused) continue;
+            /* Bounded like usrl_join_poll(): a busy right side cannot starve the left */
+            uint32_t rounds = s->in[k].drain ? USRL_JOIN_RIGHT_BATCHES : 1;
+            int n;
+            for (uint32_t b = 0; b < rounds && (n = pump_input(s, k)) > 0; b++) work += n;
+        }
+        if (work) {
+            stage_end_batch(s);
+            total += work;
+        }
+    }
+    return total;
+}
+
+static void *executor_main(void *arg)
+{
+    PipeThread *th = arg;
+    UsrlPipeline *p = th->p;
+    uint32_t thread = (uint32_t)(th - p->threads);
+    uint32_t idle = 0;
+
+    if (th->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(th->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    while (atomic_load_explicit(&p->running, memory_order_relaxed)) {
+        if (usrl_pipeline_poll(p, thread) > 0) {
+            idle = 0;
+            continue;
+        }
+        if (th->idle == 0 || ++idle < 64) {
+            CPU_RELAX();
+        } else if (th->idle == 1) {
+            sched_yield();
+        } else {
+            struct timespec ts = { 0, (long)th->sleep_us * 1000L };
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+int usrl_pipeline_start(UsrlPipeline *p)
+{
+    if (!p || !p->attached) return -1;
+
+    atomic_store(&p->running, 1);
+    for (uint32_t i = 0; i < p->thread_count; i++) {
+        PipeThread *th = &p->threads[i];
+        if (th->stage_count == 0) continue;
+        if (pthread_create(&th->tid, NULL, executor_main, th) != 0) {
+            usrl_pipeline_stop(p);
+            return -1;
+        }
+        th->started = 1;
+        pthread_setname_np(th->tid, th->name);
+    }
+    return 0;
+}
+
+void usrl_pipeline_stop(UsrlPipeline *p)
+{
+    if (!p) return;
+
+    atomic_store(&p->running, 0);
+    for (uint32_t i = 0; i < p->thread_count; i++) {
+        if (!p->threads[i].started) continue;
+        pthread_join(p->threads[i].tid, NULL);
+        p->threads[i].started = 0;
+    }
+    if (!p->attached) return;
+
+    /* Close every open window and publish what is still conflated */
+    for (uint32_t i = 0; i < p->stage_count; i++) {
+        PipeStage *s = &p->stages[i];
+        if (s->kind == OP_WINDOW) usrl_window_advance(&s->op.win, UINT64_MAX);
+        stage_end_batch(s);
+    }
+}
+
+/* ============================================================================
+ * INTROSPECTION
+ * ============================================================================ */
+
+uint32_t usrl_pipeline_stage_count(const UsrlPipeline *p)
+{
+    return p ? p->stage_count : 0;
+}
+
+uint32_t usrl_pipeline_thread_count(const UsrlPipeline *p)
+{
+    return p ? p->thread_count : 0;
+}
+
+int usrl_pipeline_stats(const UsrlPipeline *p, UsrlPipeStageStats *out, uint32_t max)
+{
+    if (!p || !out) return -1;
+
+    uint32_t n = p->stage_count < max ? p->stage_count : max;
+    for (uint32_t i = 0; i < n; i++) {
+        const PipeStage *s = &p->stages[i];
+        UsrlPipeStageStats *st = &out[i];
+
+        memset(st, 0, sizeof(*st));
+        snprintf(st->name, sizeof(st->name), "%s", s->name);
+        snprintf(st->op, sizeof(st->op), "%s", op_names[s->kind]);
+        snprintf(st->thread, sizeof(st->thread), "%s", p->threads[s->thread].name);
+        if (s->m_in) {
+            st->in = (uint64_t)usrl_metric_read(s->m_in);
+            st->out = (uint64_t)usrl_metric_read(s->m_out);
+            st->dropped = (uint64_t)usrl_metric_read(s->m_drop);
+        }
+
+        for (uint32_t k = 0; k < s->in_count; k++) {
+            const PipeInput *in = &s->in[k];
+            if (in->fused) {
+                st->fused++;
+                continue;
+            }
+            if (!in->sub.desc || !in->pos) continue;
+            uint64_t head = atomic_load_explicit(&in->sub.desc->w_head, memory_order_relaxed);
+            uint64_t pos = (uint64_t)usrl_metric_read(in->pos);
+            if (head > pos) st->lag += head - pos;
+        }
+    }
+    return (int)p->stage_count;
+}
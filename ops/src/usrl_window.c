@@ -0,0 +1,295 @@
+/**
+ * @file usrl_window.c
+ * @brief Event-time tumbling / sliding OHLCV windows over pane rings.
+ */
+
+#include "usrl_window.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t next_power_of_two_u32(uint32_t v)
+{
+    if (v == 0) return 1;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return ++v;
+}
+
+static inline UsrlPane *key_pane(const UsrlWindowAgg *w, uint32_t key, uint64_t pane)
+{
+    return &w->panes[(uint64_t)key * (w->ring_mask + 1) + (pane & w->ring_mask)];
+}
+
+/* ============================================================================
+ * LIFECYCLE
+ * ============================================================================ */
+
+int usrl_window_init(UsrlWindowAgg *w, const UsrlSchema *schema, const UsrlWindowSpec *spec,
+                     uint32_t max_keys)
+{
+    if (!w || !schema || !spec || !spec->price || spec->size_ns == 0 || max_keys == 0) return -1;
+    memset(w, 0, sizeof(*w));
+
+    uint64_t slide = spec->slide_ns ? spec->slide_ns : spec->size_ns;
+    if (spec->size_ns % slide != 0 || spec->size_ns / slide > 65536) return -1;
+
+    const UsrlField *kf = NULL;
+    if (spec->key && !(kf = usrl_schema_field(schema, spec->key))) return -1;
+    w->price = usrl_schema_field(schema, spec->price);
+    if (!w->price || !usrl_field_numeric(w->price)) return -1;
+    if (spec->qty) {
+        w->qty = usrl_schema_field(schema, spec->qty);
+        if (!w->qty || !usrl_field_numeric(w->qty)) return -1;
+    }
+    if (spec->time) {
+        w->time = usrl_schema_field(schema, spec->time);
+        if (!w->time || !usrl_field_numeric(w->time)) return -1;
+    }
+
+    w->schema = schema;
+    w->slide_ns = slide;
+    w->lateness_ns = spec->lateness_ns;
+    w->panes_per_window = (uint32_t)(spec->size_ns / slide);
+    w->max_keys = max_keys;
+
+    /* Live panes per key span one window plus the lateness horizon */
+    uint64_t span = (uint64_t)w->panes_per_window + spec->lateness_ns / slide + 2;
+    if (span > (1u << 20)) return -1;
+    uint32_t ring = next_power_of_two_u32((uint32_t)span);
+    w->ring_mask = ring - 1;
+
+    if (usrl_keys_init(&w->keys, kf, max_keys) != 0) return -1;
+
+    w->panes = calloc((size_t)max_keys * ring, sizeof(UsrlPane));
+    w->newest = calloc(max_keys, sizeof(uint64_t));
+    w->active = calloc(max_keys, sizeof(uint32_t));
+    w->active_pos = malloc(sizeof(int32_t) * max_keys);
+    w->scratch = malloc(schema->total_size ? schema->total_size : 1);
+
+    if (!w->panes || !w->newest || !w->active || !w->active_pos || !w->scratch) {
+        usrl_window_free(w);
+        return -1;
+    }
+    memset(w->active_pos, 0xFF, sizeof(int32_t) * max_keys);
+    return 0;
+}
+
+void usrl_window_free(UsrlWindowAgg *w)
+{
+    if (!w) return;
+    usrl_keys_free(&w->keys);
+    free(w->panes);
+    free(w->newest);
+    free(w->active);
+    free(w->active_pos);
+    free(w->scratch);
+    memset(w, 0, sizeof(*w));
+}
+
+int usrl_window_attach(UsrlWindowAgg *w, void *core_base, const char *in_topic,
+                       const char *out_topic, uint16_t pub_id)
+{
+    if (!w || !core_base || !in_topic) return -1;
+
+    usrl_sub_init(&w->in, core_base, in_topic);
+    w->has_in = (w->in.desc != NULL);
+    if (!w->has_in) return -1;
+
+    if (out_topic) {
+        usrl_pub_init(&w->out, core_base, out_topic, pub_id);
+        w->has_out = (w->out.desc != NULL);
+        if (!w->has_out) return -1;
+    }
+    return 0;
+}
+
+void usrl_window_on_bar(UsrlWindowAgg *w, UsrlBarFn fn, void *arg)
+{
+    if (!w) return;
+    w->on_bar = fn;
+    w->on_bar_arg = arg;
+}
+
+/* ============================================================================
+ * EMISSION
+ * ============================================================================ */
+
+static void emit_bar(UsrlWindowAgg *w, const UsrlBar *bar)
+{
+    w->bars++;
+    if (w->on_bar) w->on_bar(bar, w->on_bar_arg);
+    if (w->has_out && usrl_pub_publish(&w->out, bar, sizeof(*bar)) == USRL_RING_OK)
+        w->published++;
+}
+
+/* Emit the window made of panes [end - P, end - 1] for every active key */
+static int close_window(UsrlWindowAgg *w, uint64_t end)
+{
+    uint32_t P = w->panes_per_window;
+    uint64_t first = (end >= P) ? end - P : 0;
+    int emitted = 0;
+
+    for (uint32_t i = w->active_count; i-- > 0;) {
+        uint32_t key = w->active[i];
+        UsrlBar bar;
+        uint64_t open_ns = UINT64_MAX, close_ns = 0;
+        double notional = 0.0;
+
+        memset(&bar, 0, sizeof(bar));
+        for (uint64_t p = first; p < end; p++) {
+            const UsrlPane *pn = key_pane(w, key, p);
+            if (pn->pane != p + 1 || pn->count == 0) continue;
+
+            if (bar.count == 0) {
+                bar.high = pn->high;
+                bar.low = pn->low;
+            } else {
+                if (pn->high > bar.high) bar.high = pn->high;
+                if (pn->low < bar.low) bar.low = pn->low;
+            }
+            if (pn->first_ns < open_ns) { open_ns = pn->first_ns; bar.open = pn->open; }
+            if (pn->last_ns >= close_ns) { close_ns = pn->last_ns; bar.close = pn->close; }
+            bar.count += pn->count;
+            bar.volume += pn->volume;
+            notional += pn->notional;
+        }
+
+        if (bar.count) {
+            const char *name = usrl_keys_name(&w->keys, key);
+            bar.start_ns = first * w->slide_ns;
+            bar.end_ns = end * w->slide_ns;
+            bar.key_id = key;
+            memcpy(bar.key, name, strnlen(name, USRL_KEY_MAX));
+            bar.vwap = (bar.volume != 0.0) ? notional / bar.volume : bar.close;
+            emit_bar(w, &bar);
+            emitted++;
+        }
+
+        /* No later window can include this key's panes: retire it */
+        if (w->newest[key] - 1 + P <= end) {
+            uint32_t last = w->active[--w->active_count];
+            w->active[i] = last;
+            w->active_pos[last] = (int32_t)i;
+            w->active_pos[key] = -1;
+        }
+    }
+    return emitted;
+}
+
+int usrl_window_advance(UsrlWindowAgg *w, uint64_t watermark_ns)
+{
+    if (!w || !w->started) return 0;
+
+    uint64_t target = watermark_ns / w->slide_ns;
+    int emitted = 0;
+
+    while (w->closed_pane < target) {
+        if (w->active_count == 0) {
+            w->closed_pane = target;
+            break;
+        }
+        emitted += close_window(w, ++w->closed_pane);
+    }
+    return emitted;
+}
+
+uint64_t usrl_window_watermark(const UsrlWindowAgg *w)
+{
+    return w ? w->closed_pane * w->slide_ns : 0;
+}
+
+/* ============================================================================
+ * UPDATES
+ * ============================================================================ */
+
+int32_t usrl_window_apply(UsrlWindowAgg *w, const uint8_t *record, uint64_t timestamp_ns)
+{
+    if (USRL_UNLIKELY(!w || !record)) return -1;
+
+    uint64_t ts = w->time ? (uint64_t)usrl_field_i64(w->time, record) : timestamp_ns;
+    uint64_t wm = (ts > w->lateness_ns) ? ts - w->lateness_ns : 0;
+
+    /* Advance first, so the pane ring only ever holds live panes */
+    if (USRL_UNLIKELY(!w->started)) {
+        w->started = 1;
+        w->max_event_ns = ts;
+        w->closed_pane = wm / w->slide_ns;
+    } else if (ts > w->max_event_ns) {
+        w->max_event_ns = ts;
+        usrl_window_advance(w, wm);
+    }
+
+    uint64_t p = ts / w->slide_ns;
+    if (p + w->panes_per_window <= w->closed_pane) {
+        w->late++;
+        return -1;
+    }
+
+    int32_t key = usrl_keys_lookup(&w->keys, record);
+    if (USRL_UNLIKELY(key < 0)) {
+        w->rejected++;
+        return -1;
+    }
+
+    double price = usrl_field_f64(w->price, record);
+    double qty = w->qty ? usrl_field_f64(w->qty, record) : 1.0;
+
+    UsrlPane *pn = key_pane(w, (uint32_t)key, p);
+    if (pn->pane != p + 1) {
+        memset(pn, 0, sizeof(*pn));
+        pn->pane = p + 1;
+        pn->first_ns = ts;
+        pn->last_ns = ts;
+        pn->open = pn->high = pn->low = pn->close = price;
+    } else {
+        if (ts < pn->first_ns) { pn->first_ns = ts; pn->open = price; }
+        if (ts >= pn->last_ns) { pn->last_ns = ts; pn->close = price; }
+        if (price > pn->high) pn->high = price;
+        if (price < pn->low) pn->low = price;
+    }
+    pn->volume += qty;
+    pn->notional += price * qty;
+    pn->count++;
+
+    if (p + 1 > w->newest[key]) w->newest[key] = p + 1;
+    if (w->active_pos[key] < 0) {
+        w->active_pos[key] = (int32_t)w->active_count;
+        w->active[w->active_count++] = (uint32_t)key;
+    }
+    w->records++;
+    return key;
+}
+
+int usrl_window_poll(UsrlWindowAgg *w, uint32_t max_batch)
+{
+    if (USRL_UNLIKELY(!w || !w->has_in)) return USRL_RING_ERROR;
+    if (max_batch == 0 || max_batch > USRL_WINDOW_MAX_BATCH) max_batch = USRL_WINDOW_MAX_BATCH;
+
+    UsrlSlotView views[USRL_WINDOW_MAX_BATCH];
+    int n = usrl_sub_view_batch(&w->in, views, max_batch);
+    if (n <= 0) return n;
+
+    uint32_t size = w->schema->total_size;
+
+    for (int i = 0; i < n; i++) {
+        if (i + 1 < n) USRL_PREFETCH_R(views[i + 1].data);
+
+        if (USRL_UNLIKELY(views[i].len < size)) {
+            w->rejected++;
+            continue;
+        }
+
+        memcpy(w->scratch, views[i].data, size);
+        if (USRL_UNLIKELY(!usrl_view_valid(&views[i]))) {
+            w->lapped++;
+            continue;
+        }
+        usrl_window_apply(w, w->scratch, views[i].timestamp_ns);
+    }
+    return n;
+}
@@ -1,4 +1,5 @@
 #include "usrl_core.h"
+#include "usrl_lanes.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -106,6 +107,10 @@ int main(void)
                 char *slots_p = find_key(topic_start, "slots");
                 char *size_p = find_key(topic_start, "payload_size");
                 char *type_p = find_key(topic_start, "type");
+                char *lanes_p = find_key(topic_start, "lanes");
+                char *obj_end = strchr(topic_start, '}');
+                if (lanes_p && obj_end && lanes_p > obj_end)
+                    lanes_p = NULL; // Key belongs to a later topic
 
                 if (name_p && slots_p && size_p)
                 {
@@ -130,7 +135,27 @@ int main(void)
                            topics[count].slot_count,
                            topics[count].slot_size,
                            topics[count].type == USRL_RING_TYPE_SWMR ? "SWMR" : "MWMR");
-                    count++;
+
+                    // Priority lanes: one ring per lane, "<name>#p<k>"
+                    int lanes = lanes_p ? parse_int_val(lanes_p) : 1;
+                    if (lanes > 1)
+                    {
+                        UsrlTopicConfig logical = topics[count];
+                        int n = usrl_lanes_expand(&logical, (uint32_t)lanes,
+                                                  &topics[count], MAX_CONFIG_TOPICS - count);
+                        if (n < 0)
+                        {
+                            printf("  ERROR: cannot expand %d lanes for %s\n", lanes, logical.name);
+                            free(buffer);
+                            return 1;
+                        }
+                        printf("          %d priority lanes\n", n);
+                        count += n;
+                    }
+                    else
+                    {
+                        count++;
+                    }
                 }
 
                 // Move to next topic object
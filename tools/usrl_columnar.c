@@ -0,0 +1,236 @@
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_schema.h"
+#include "usrl_columnar.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+/* ---------------------------------------------------------------------------
+ * UTILS
+ * --------------------------------------------------------------------------- */
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(void) {
+    printf("Usage: usrl_columnar <command> ...\n");
+    printf("Commands:\n");
+    printf("  export <journal_dir> <topic> <out_dir> [options]\n");
+    printf("      --schema <f:type[:size],...>  Payload layout (u64 i64 f64 u32 i32 f32 bytes string)\n");
+    printf("      --fields <a,b,...>            Columns to export (default all, plus _seq _ts _pub_id)\n");
+    printf("      --codec <raw|delta>           Integer column encoding (default delta)\n");
+    printf("      --block-rows <n>              Rows per block (default %u)\n", USRL_COL_BLOCK_ROWS);
+    printf("      --from-seq <n> --to-seq <n>   Journal range\n");
+    printf("  info <out_dir>                    List columns\n");
+    printf("  scan <out_dir> <column> [--from-seq n] [--to-seq n]\n");
+    printf("                                    Count / sum / min / max of a numeric column\n");
+    exit(1);
+}
+
+static const char *type_name(uint32_t type) {
+    static const char *names[] = { "u64", "i64", "f64", "u32", "i32", "f32", "bytes", "string" };
+    return type < sizeof(names) / sizeof(names[0]) ? names[type] : "?";
+}
+
+/* "price:f64,qty:u32,symbol:string:16" */
+static UsrlSchema *parse_schema(const char *spec) {
+    static const struct { const char *name; UsrlFieldType type; uint32_t size; } types[] = {
+        { "u64", USRL_FIELD_U64, 8 }, { "i64", USRL_FIELD_I64, 8 }, { "f64", USRL_FIELD_F64, 8 },
+        { "u32", USRL_FIELD_U32, 4 }, { "i32", USRL_FIELD_I32, 4 }, { "f32", USRL_FIELD_F32, 4 },
+        { "bytes", USRL_FIELD_BYTES, 0 }, { "string", USRL_FIELD_STRING, 0 },
+    };
+
+    UsrlSchema *sc = usrl_schema_create(1, "export");
+    char *copy = strdup(spec);
+    if (!sc || !copy) return NULL;
+
+    char *save = NULL;
+    for (char *f = strtok_r(copy, ",", &save); f; f = strtok_r(NULL, ",", &save)) {
+        char *type = strchr(f, ':');
+        if (!type) goto bad;
+        *type++ = '\0';
+        char *size = strchr(type, ':');
+        if (size) *size++ = '\0';
+
+        size_t k = 0;
+        while (k < sizeof(types) / sizeof(types[0]) && strcmp(types[k].name, type) != 0) k++;
+        if (k == sizeof(types) / sizeof(types[0])) goto bad;
+        uint32_t n = types[k].size ? types[k].size : (size ? (uint32_t)atoi(size) : 0);
+        if (n == 0 || usrl_schema_add_field(sc, f, types[k].type, n) != 0) goto bad;
+    }
+    if (usrl_schema_finalize(sc) != 0) goto bad;
+    free(copy);
+    return sc;
+
+bad:
+    fprintf(stderr, "Bad schema: %s\n", spec);
+    free(copy);
+    usrl_schema_free(sc);
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * COMMANDS
+ * --------------------------------------------------------------------------- */
+
+static int do_export(int argc, char **argv) {
+    if (argc < 5) usage();
+    const char *jdir = argv[2], *topic = argv[3], *out = argv[4];
+
+    UsrlColSpec spec = { .codec = USRL_COL_DELTA };
+    UsrlSchema *schema = NULL;
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--schema") == 0 && i + 1 < argc) {
+            if (!(schema = parse_schema(argv[++i]))) return 1;
+        }
+        else if (strcmp(argv[i], "--fields") == 0 && i + 1 < argc) spec.fields = argv[++i];
+        else if (strcmp(argv[i], "--codec") == 0 && i + 1 < argc) spec.codec = strcmp(argv[++i], "raw") == 0 ? USRL_COL_RAW : USRL_COL_DELTA;
+        else if (strcmp(argv[i], "--block-rows") == 0 && i + 1 < argc) spec.block_rows = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--from-seq") == 0 && i + 1 < argc) spec.from_seq = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--to-seq") == 0 && i + 1 < argc) spec.to_seq = strtoull(argv[++i], NULL, 10);
+        else usage();
+    }
+    spec.schema = schema;
+
+    UsrlColStats st;
+    uint64_t t0 = mono_ns();
+    int rc = usrl_col_export(jdir, topic, out, &spec, &st);
+    double s = (double)(mono_ns() - t0) / 1e9;
+    if (schema) usrl_schema_free(schema);
+    if (rc != 0) {
+        perror("usrl_col_export");
+        return 1;
+    }
+
+    printf("Exported %" PRIu64 " rows x %u columns from %" PRIu64 " segments in %.2f s\n",
+           st.rows, st.columns, st.segments, s);
+    if (st.short_records)
+        printf("  %" PRIu64 " records shorter than the schema skipped\n", st.short_records);
+    printf("  journal payload %.1f MB, columns %.1f MB raw -> %.1f MB stored\n",
+           (double)st.bytes_in / (1024.0 * 1024.0), (double)st.bytes_raw / (1024.0 * 1024.0),
+           (double)st.bytes_out / (1024.0 * 1024.0));
+    return 0;
+}
+
+static int do_info(const char *dir) {
+    char names[USRL_COL_MAX_COLUMNS][64];
+    int n = usrl_col_list(dir, names, USRL_COL_MAX_COLUMNS);
+    if (n < 0) {
+        perror(dir);
+        return 1;
+    }
+    if (n > USRL_COL_MAX_COLUMNS) n = USRL_COL_MAX_COLUMNS;
+
+    printf("%-20s %-8s %-6s %-6s %-12s %-8s %s\n", "COLUMN", "TYPE", "WIDTH", "CODEC", "ROWS", "BLOCKS", "SIZE_MB");
+    for (int i = 0; i < n; i++) {
+        UsrlColumn c;
+        if (usrl_col_open(&c, dir, names[i]) != 0) {
+            printf("%-20s (unreadable)\n", names[i]);
+            continue;
+        }
+        const UsrlColHeader *h = c.hdr;
+        printf("%-20s %-8s %-6u %-6s %-12" PRIu64 " %-8u %.1f\n", h->name, type_name(h->type), h->width,
+               h->codec == USRL_COL_DELTA ? "delta" : "raw", h->rows, h->block_count,
+               (double)c.size / (1024.0 * 1024.0));
+        usrl_col_close(&c);
+    }
+    return 0;
+}
+
+/* Typed loop over one aligned block, so the compiler sees a plain array */
+#define SCAN_BLOCK(T)                                                        \
+    do {                                                                     \
+        const T *p = (const T *)__builtin_assume_aligned(v, USRL_COL_ALIGN); \
+        for (uint32_t r = 0; r < blk->rows; r++) {                           \
+            if (seqs && (seqs[r] < from || seqs[r] > to)) continue;          \
+            double x = (double)p[r];                                         \
+            if (count == 0 || x < lo) lo = x;                                \
+            if (count == 0 || x > hi) hi = x;                                \
+            sum += x;                                                        \
+            count++;                                                         \
+        }                                                                    \
+    } while (0)
+
+static int do_scan(int argc, char **argv) {
+    if (argc < 4) usage();
+    const char *dir = argv[2], *name = argv[3];
+    uint64_t from = 0, to = UINT64_MAX;
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--from-seq") == 0 && i + 1 < argc) from = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--to-seq") == 0 && i + 1 < argc) to = strtoull(argv[++i], NULL, 10);
+        else usage();
+    }
+
+    UsrlColumn c, seq;
+    if (usrl_col_open(&c, dir, name) != 0) {
+        fprintf(stderr, "Cannot open column %s in %s\n", name, dir);
+        return 1;
+    }
+    if (c.hdr->type > USRL_FIELD_F32) {
+        fprintf(stderr, "Column %s is not numeric\n", name);
+        return 1;
+    }
+
+    /* Blocks are row-aligned across columns: the _seq index bounds the scan */
+    int ranged = from > 0 || to != UINT64_MAX;
+    if (ranged && usrl_col_open(&seq, dir, "_seq") != 0) {
+        fprintf(stderr, "A seq range needs the _seq column\n");
+        return 1;
+    }
+    void *scratch = usrl_col_scratch(&c);
+    void *seq_scratch = ranged ? usrl_col_scratch(&seq) : NULL;
+    uint32_t first = ranged ? usrl_col_seek(&seq, (int64_t)from) : 0;
+
+    uint64_t count = 0, t0 = mono_ns();
+    double sum = 0, lo = 0, hi = 0;
+    for (uint32_t b = first; b < c.hdr->block_count; b++) {
+        const UsrlColBlock *blk = &c.blocks[b];
+        if (ranged && seq.blocks[b].min.u > to) break;
+
+        const uint8_t *v = usrl_col_block(&c, b, scratch);
+        const uint64_t *seqs = ranged ? usrl_col_block(&seq, b, seq_scratch) : NULL;
+        if (!v || (ranged && !seqs)) {
+            fprintf(stderr, "Corrupt block %u\n", b);
+            return 1;
+        }
+        switch (c.hdr->type) {
+        case USRL_FIELD_U64: SCAN_BLOCK(uint64_t); break;
+        case USRL_FIELD_I64: SCAN_BLOCK(int64_t); break;
+        case USRL_FIELD_F64: SCAN_BLOCK(double); break;
+        case USRL_FIELD_U32: SCAN_BLOCK(uint32_t); break;
+        case USRL_FIELD_I32: SCAN_BLOCK(int32_t); break;
+        case USRL_FIELD_F32: SCAN_BLOCK(float); break;
+        }
+    }
+    double s = (double)(mono_ns() - t0) / 1e9;
+
+    printf("%s: count %" PRIu64 " sum %.6g min %.6g max %.6g mean %.6g\n", name, count, sum, lo, hi,
+           count ? sum / (double)count : 0.0);
+    printf("  scanned in %.3f s (%.1f M rows/s)\n", s, s > 0 ? (double)count / s / 1e6 : 0.0);
+
+    free(scratch);
+    free(seq_scratch);
+    if (ranged) usrl_col_close(&seq);
+    usrl_col_close(&c);
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * MAIN
+ * --------------------------------------------------------------------------- */
+
+int main(int argc, char **argv) {
+    if (argc < 3) usage();
+    if (strcmp(argv[1], "export") == 0) return do_export(argc, argv);
+    if (strcmp(argv[1], "info") == 0) return do_info(argv[2]);
+    if (strcmp(argv[1], "scan") == 0) return do_scan(argc, argv);
+    usage();
+    return 1;
+}
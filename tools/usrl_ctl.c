@@ -1,6 +1,9 @@
 #define _GNU_SOURCE
 #include "usrl_core.h"
 #include "usrl_ring.h"
+#include "usrl_trace.h"
+#include "usrl_backpressure.h"
+#include "usrl_stage.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,9 +14,22 @@
 #include <fcntl.h>
 #include <time.h>
 #include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
 
 #define SHM_PATH "/usrl_core"
 
+#define PROBE_MAGIC 0x45424F52504C5255ULL   /* "URLPROBE" */
+#define PROBE_PUB_ID 0xFFFE
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
 /* --------------------------------------------------------------------------
  * UTILS
  * -------------------------------------------------------------------------- */
@@ -113,6 +129,15 @@ static void do_list(void *base) {
     printf("\n");
 }
 
+static void print_policy(const UsrlPolicy *pol) {
+    if (pol->flags & USRL_POLICY_RATE) printf("  Rate Limit: %lu Hz%s\n", pol->rate_limit_hz, pol->rate_limit_hz ? "" : " (unlimited)");
+    else printf("  Rate Limit: (config)\n");
+    if (pol->flags & USRL_POLICY_BP) printf("  On Full:    %s\n", pol->bp_mode == USRL_BP_BLOCK ? "block" : "drop");
+    else printf("  On Full:    (config)\n");
+    if (pol->flags & USRL_POLICY_LAG) printf("  Lag Limit:  %lu slots\n", pol->lag_threshold);
+    else printf("  Lag Limit:  (config)\n");
+}
+
 static void do_info(void *base, const char *topic_name) {
     TopicEntry *t = usrl_get_topic(base, topic_name);
     if (!t) {
@@ -132,6 +157,14 @@ static void do_info(void *base, const char *topic_name) {
     printf("  Base Offset: 0x%lx\n", r->base_offset);
     printf("\nMemory:\n");
     printf("  Ring Size:  %.2f MB\n", (double)(r->slot_count * r->slot_size) / (1024.0 * 1024.0));
+
+    UsrlTopicCtl *ctl = usrl_topic_ctl(base, t);
+    UsrlPolicy pol;
+    uint64_t version;
+    if (ctl && usrl_policy_read(ctl, &pol, &version) == 0) {
+        printf("\nPolicy (v%lu):\n", version);
+        print_policy(&pol);
+    }
 }
 
 static void do_tail(void *base, const char *topic_name) {
@@ -190,6 +223,355 @@ static void do_tail(void *base, const char *topic_name) {
     free(buf);
 }
 
+/* Collect sampled traces from a topic and print per-path latency. The
+ * collector's own read is appended as a final hop (USRL_TRACE_COLLECTOR_ID). */
+static void do_trace(void *base, const char *topic_name, int seconds) {
+    TopicEntry *t = usrl_get_topic(base, topic_name);
+    if (!t) {
+        fprintf(stderr, "Topic '%s' not found.\n", topic_name);
+        return;
+    }
+
+    UsrlSubscriber sub;
+    usrl_sub_init(&sub, base, topic_name);
+    RingDesc *d = sub.desc;
+    sub.last_seq = atomic_load_explicit(&d->w_head, memory_order_acquire);
+
+    uint8_t *buf = malloc(d->slot_size);
+    UsrlTraceCollector *c = malloc(sizeof(UsrlTraceCollector));
+    if (!buf || !c) {
+        fprintf(stderr, "OOM\n");
+        free(buf);
+        free(c);
+        return;
+    }
+    usrl_trace_collector_init(c);
+
+    printf("Collecting traces on '%s' for %d s...\n", topic_name, seconds);
+
+    uint64_t messages = 0;
+    time_t end = time(NULL) + seconds;
+    while (time(NULL) < end) {
+        int len = usrl_sub_next(&sub, buf, d->slot_size, NULL);
+        if (len >= 0) {
+            UsrlTraceContext ctx;
+            messages++;
+            if (usrl_sub_last_trace(&sub, &ctx) == 1) {
+                usrl_trace_hop(&ctx, USRL_TRACE_COLLECTOR_ID);
+                usrl_trace_collect(c, &ctx);
+            }
+        } else if (len == USRL_RING_NO_DATA) {
+            usleep(100);
+        }
+    }
+
+    printf("Messages: %lu\n", messages);
+    usrl_trace_report(c, stdout);
+    free(c);
+    free(buf);
+}
+
+/* --------------------------------------------------------------------------
+ * PROBE
+ *
+ * MWMR topics: an injector thread publishes USRL_SLOT_F_PROBE messages at a
+ * low rate (subscribers skip them) and a passive observer, following the
+ * ring headers without a subscriber, times publish -> visible for each one.
+ * SWMR topics cannot take a second writer, so the observer times the live
+ * traffic instead (SlotHeader.timestamp_ns -> visible).
+ * -------------------------------------------------------------------------- */
+
+typedef struct __attribute__((packed)) {
+    uint64_t magic;
+    uint64_t send_ns;
+    uint32_t nonce;
+    uint32_t pid;
+} ProbeMsg;
+
+typedef struct {
+    UsrlMwmrPublisher pub;
+    uint32_t rate;
+    volatile int running;
+    uint64_t sent;
+    uint64_t failed;
+} ProbeInjector;
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void probe_hist_add(UsrlTraceHist *h, uint64_t ns) {
+    uint32_t b = (ns == 0) ? 0 : (uint32_t)(63 - __builtin_clzll(ns));
+    if (b >= USRL_TRACE_HIST_BUCKETS) b = USRL_TRACE_HIST_BUCKETS - 1;
+    h->buckets[b]++;
+    h->count++;
+    h->sum_ns += ns;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+static void *probe_inject(void *arg) {
+    ProbeInjector *in = arg;
+    uint64_t period = 1000000000ULL / in->rate;
+    ProbeMsg m = { .magic = PROBE_MAGIC, .pid = (uint32_t)getpid() };
+
+    while (in->running) {
+        m.nonce++;
+        m.send_ns = mono_ns();
+        if (usrl_mwmr_pub_probe(&in->pub, &m, sizeof(m)) == USRL_RING_OK) in->sent++;
+        else in->failed++;
+
+        struct timespec ts = { (time_t)(period / 1000000000ULL), (long)(period % 1000000000ULL) };
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+static void probe_report(const UsrlTraceHist *h) {
+    if (h->count == 0) {
+        printf("No samples.\n");
+        return;
+    }
+    printf("Samples: %lu  avg %.0f ns  max %lu ns\n",
+           h->count, (double)h->sum_ns / (double)h->count, h->max_ns);
+    printf("  p50 <= %lu ns  p90 <= %lu ns  p99 <= %lu ns  p99.9 <= %lu ns\n",
+           usrl_trace_hist_quantile(h, 0.50), usrl_trace_hist_quantile(h, 0.90),
+           usrl_trace_hist_quantile(h, 0.99), usrl_trace_hist_quantile(h, 0.999));
+
+    uint64_t peak = 0;
+    for (int i = 0; i < USRL_TRACE_HIST_BUCKETS; i++)
+        if (h->buckets[i] > peak) peak = h->buckets[i];
+
+    printf("\n%12s  %10s\n", "< NS", "COUNT");
+    for (int i = 0; i < USRL_TRACE_HIST_BUCKETS; i++) {
+        if (!h->buckets[i]) continue;
+        int bar = (int)((h->buckets[i] * 50 + peak - 1) / peak);
+        printf("%12lu  %10lu  %.*s\n", (uint64_t)2 << i, h->buckets[i], bar,
+               "##################################################");
+    }
+}
+
+static void do_probe(void *base, const char *topic_name, int seconds, int rate, int passive) {
+    TopicEntry *t = usrl_get_topic(base, topic_name);
+    if (!t) {
+        fprintf(stderr, "Topic '%s' not found.\n", topic_name);
+        return;
+    }
+
+    RingDesc *d = (RingDesc*)((uint8_t*)base + t->ring_desc_offset);
+    uint8_t *slots = (uint8_t*)base + d->base_offset;
+    uint64_t mask = d->slot_count - 1;
+
+    if (t->type != USRL_RING_TYPE_MWMR) passive = 1;
+    if (!passive && t->slot_size < sizeof(SlotHeader) + sizeof(ProbeMsg)) {
+        fprintf(stderr, "Slots on '%s' too small for a probe, using passive mode.\n", topic_name);
+        passive = 1;
+    }
+    if (rate <= 0) rate = 100;
+
+    ProbeInjector in;
+    memset(&in, 0, sizeof(in));
+    pthread_t tid;
+    uint32_t pid = (uint32_t)getpid();
+
+    uint64_t next = atomic_load_explicit(&d->w_head, memory_order_acquire) + 1;
+
+    if (!passive) {
+        usrl_mwmr_pub_init(&in.pub, base, topic_name, PROBE_PUB_ID);
+        in.rate = (uint32_t)rate;
+        in.running = 1;
+        if (!in.pub.desc || pthread_create(&tid, NULL, probe_inject, &in) != 0) {
+            fprintf(stderr, "Cannot start probe injector on '%s'.\n", topic_name);
+            return;
+        }
+        printf("Probing '%s' at %d/s for %d s...\n", topic_name, rate, seconds);
+    } else {
+        printf("Sampling '%s' passively for %d s (publish -> visible)...\n", topic_name, seconds);
+    }
+
+    UsrlTraceHist h;
+    memset(&h, 0, sizeof(h));
+    uint64_t seen = 0, lapped = 0;
+    uint32_t idle = 0;
+    uint64_t end = mono_ns() + (uint64_t)seconds * 1000000000ULL;
+
+    while (mono_ns() < end) {
+        uint64_t head = atomic_load_explicit(&d->w_head, memory_order_acquire);
+        if (head >= next && head - next + 1 > d->slot_count) {
+            lapped += head - d->slot_count + 1 - next;
+            next = head - d->slot_count + 1;
+        }
+
+        int progressed = 0;
+        while (next <= head) {
+            SlotHeader *hdr = (SlotHeader*)(slots + ((next - 1) & mask) * d->slot_size);
+            uint64_t seq = atomic_load_explicit(&hdr->seq, memory_order_acquire);
+            if (seq < next) break; /* claimed, not yet committed */
+            uint64_t now = mono_ns();
+            progressed = 1;
+            if (seq > next) {
+                lapped++;
+                next++;
+                continue;
+            }
+            seen++;
+
+            if (passive) {
+                uint64_t ts = hdr->timestamp_ns;
+                probe_hist_add(&h, (now > ts) ? now - ts : 0);
+            } else if ((hdr->flags & USRL_SLOT_F_PROBE) && hdr->payload_len == sizeof(ProbeMsg)) {
+                ProbeMsg m;
+                memcpy(&m, (uint8_t*)hdr + sizeof(SlotHeader), sizeof(m));
+                if (atomic_load_explicit(&hdr->seq, memory_order_acquire) == seq &&
+                    m.magic == PROBE_MAGIC && m.pid == pid)
+                    probe_hist_add(&h, (now > m.send_ns) ? now - m.send_ns : 0);
+            }
+            next++;
+        }
+
+        if (progressed) {
+            idle = 0;
+        } else if (++idle < 1024) {
+            CPU_RELAX();
+        } else {
+            sched_yield();
+        }
+    }
+
+    if (!passive) {
+        in.running = 0;
+        pthread_join(tid, NULL);
+        printf("Probes: %lu sent, %lu seen, %lu failed\n", in.sent, h.count, in.failed);
+    }
+    printf("Messages: %lu (lapped %lu)\n", seen, lapped);
+    probe_report(&h);
+}
+
+/* --------------------------------------------------------------------------
+ * SET (live policy)
+ * -------------------------------------------------------------------------- */
+
+void usage(void);
+
+/* Facade topics live in their own region, "/usrl-<topic>" */
+static void *map_topic_region(const char *topic_name) {
+    char path[128];
+    snprintf(path, sizeof(path), "/usrl-%s", topic_name);
+    void *base = usrl_core_map(path, 0);
+    if (base && usrl_get_topic(base, topic_name)) return base;
+
+    base = usrl_core_map(SHM_PATH, 0);
+    if (base && usrl_get_topic(base, topic_name)) return base;
+    return NULL;
+}
+
+static void do_set(int argc, char **argv) {
+    const char *topic_name = argv[2];
+    void *base = map_topic_region(topic_name);
+    if (!base) {
+        fprintf(stderr, "Topic '%s' not found in %s or /usrl-%s.\n", topic_name, SHM_PATH, topic_name);
+        exit(1);
+    }
+    UsrlTopicCtl *ctl = usrl_topic_ctl(base, usrl_get_topic(base, topic_name));
+    if (!ctl) {
+        fprintf(stderr, "Region predates the control block (layout v3): recreate it.\n");
+        exit(1);
+    }
+
+    /* key=value, or key=- to drop the override */
+    UsrlPolicy set = { 0 };
+    uint32_t clear = 0;
+    int force = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--force") == 0) {
+            force = 1;
+            continue;
+        }
+        char *eq = strchr(argv[i], '=');
+        if (!eq) usage();
+        *eq++ = '\0';
+        uint32_t flag = (strcmp(argv[i], "rate") == 0) ? USRL_POLICY_RATE :
+                        (strcmp(argv[i], "bp") == 0)   ? USRL_POLICY_BP :
+                        (strcmp(argv[i], "lag") == 0)  ? USRL_POLICY_LAG : 0;
+        if (!flag) usage();
+
+        if (strcmp(eq, "-") == 0) {
+            clear |= flag;
+            continue;
+        }
+        set.flags |= flag;
+        if (flag == USRL_POLICY_RATE) set.rate_limit_hz = strtoull(eq, NULL, 10);
+        else if (flag == USRL_POLICY_LAG) set.lag_threshold = strtoull(eq, NULL, 10);
+        else if (strcmp(eq, "block") == 0) set.bp_mode = USRL_BP_BLOCK;
+        else if (strcmp(eq, "drop") == 0) set.bp_mode = USRL_BP_DROP;
+        else usage();
+    }
+    if (!set.flags && !clear && !force) usage();
+
+    /* --force first drops every override, including a dead writer's lock */
+    if (force) usrl_policy_reset(ctl);
+    if ((set.flags || clear) && usrl_policy_update(ctl, &set, clear) != 0) {
+        fprintf(stderr, "Policy lock held (version %lu): a writer died mid-update, retry with --force.\n",
+                usrl_policy_version(ctl));
+        exit(1);
+    }
+
+    UsrlPolicy pol;
+    uint64_t version;
+    if (usrl_policy_read(ctl, &pol, &version) == 0) {
+        printf("Topic '%s' policy v%lu:\n", topic_name, version);
+        print_policy(&pol);
+    }
+}
+
+/* --------------------------------------------------------------------------
+ * STAGE (stale-cursor recovery)
+ * -------------------------------------------------------------------------- */
+
+static void do_stage(int argc, char **argv) {
+    const char *topic_name = argv[2];
+    void *base = map_topic_region(topic_name);
+    if (!base) {
+        fprintf(stderr, "Topic '%s' not found in %s or /usrl-%s.\n", topic_name, SHM_PATH, topic_name);
+        exit(1);
+    }
+    TopicEntry *t = usrl_get_topic(base, topic_name);
+    TopicExt *x = usrl_topic_ext(base, t);
+    if (!x) {
+        fprintf(stderr, "Region predates stage cursors: recreate it.\n");
+        exit(1);
+    }
+
+    if (argc >= 5) {
+        uint32_t k = (uint32_t)strtoul(argv[4], NULL, 10);
+        if (strcmp(argv[3], "skip") == 0) {
+            int64_t n = usrl_stage_skip(base, topic_name, k);
+            if (n < 0) { fprintf(stderr, "No stage %u on '%s'.\n", k, topic_name); exit(1); }
+            printf("Stage %u: skipped %ld seqs\n", k, (long)n);
+        } else if (strcmp(argv[3], "detach") == 0) {
+            if (usrl_stage_detach(base, topic_name, k) != 0) {
+                fprintf(stderr, "Stage %u is not the last stage of '%s'.\n", k, topic_name);
+                exit(1);
+            }
+            printf("Stage %u detached\n", k);
+        } else {
+            usage();
+        }
+    } else if (argc != 3) {
+        usage();
+    }
+
+    RingDesc *d = (RingDesc *)((uint8_t *)base + t->ring_desc_offset);
+    uint64_t head = atomic_load_explicit(&d->w_head, memory_order_acquire);
+    int n = usrl_stage_count(base, topic_name);
+    printf("Topic '%s': w_head %lu, %d stage(s)\n", topic_name, head, n);
+    for (int k = 0; k < n; k++) {
+        uint64_t cur = atomic_load_explicit(&x->stages[k].seq, memory_order_acquire);
+        printf("  stage %d: cursor %-12lu behind %lu\n", k, cur, head - cur);
+    }
+}
+
 /* --------------------------------------------------------------------------
  * MAIN
  * -------------------------------------------------------------------------- */
@@ -200,12 +582,27 @@ void usage() {
     printf("  list            List all topics\n");
     printf("  info <topic>    Show topic details\n");
     printf("  tail <topic>    Follow topic data\n");
+    printf("  trace <topic> [sec]  Per-path latency of sampled traces\n");
+    printf("  probe <topic> [sec] [rate] [--passive]  Publish -> visible latency histogram\n");
+    printf("  set <topic> [rate=HZ] [bp=block|drop] [lag=SLOTS] [--force]  Live policy (value - = config default)\n");
+    printf("  stage <topic> [skip|detach K]  Stage cursors; skip a stuck stage, detach the last\n");
     exit(1);
 }
 
 int main(int argc, char **argv) {
     if (argc < 2) usage();
 
+    if (strcmp(argv[1], "set") == 0) {
+        if (argc < 4) usage();
+        do_set(argc, argv);
+        return 0;
+    }
+    if (strcmp(argv[1], "stage") == 0) {
+        if (argc < 3) usage();
+        do_stage(argc, argv);
+        return 0;
+    }
+
     void *base = map_system();
 
     if (strcmp(argv[1], "list") == 0) {
@@ -219,6 +616,17 @@ int main(int argc, char **argv) {
         if (argc < 3) usage();
         do_tail(base, argv[2]);
     }
+    else if (strcmp(argv[1], "trace") == 0) {
+        if (argc < 3) usage();
+        do_trace(base, argv[2], (argc > 3) ? atoi(argv[3]) : 5);
+    }
+    else if (strcmp(argv[1], "probe") == 0) {
+        if (argc < 3) usage();
+        int passive = (strcmp(argv[argc - 1], "--passive") == 0);
+        int nargs = argc - passive;
+        do_probe(base, argv[2], (nargs > 3) ? atoi(argv[3]) : 5,
+                 (nargs > 4) ? atoi(argv[4]) : 100, passive);
+    }
     else {
         usage();
     }
@@ -0,0 +1,299 @@
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_journal.h"
+#include "usrl_durable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+
+#define SHM_PATH "/usrl_core"
+
+#define FLUSH_INTERVAL_NS 100000000ull  /* 100 ms */
+#define IDLE_SLEEP_US 200
+#define DURABLE_IDLE_US 20
+
+static atomic_int g_running = 1;
+
+static void on_signal(int sig) {
+    (void)sig;
+    atomic_store(&g_running, 0);
+}
+
+/* ---------------------------------------------------------------------------
+ * UTILS
+ * --------------------------------------------------------------------------- */
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(void) {
+    printf("Usage: usrl_journal <command> <dir> <topic> [options]\n");
+    printf("Commands:\n");
+    printf("  record   Append the topic's records to <dir>/<topic>/\n");
+    printf("           [--segment-mb N] [--duration sec]\n");
+    printf("           --durable [--stage K] [--group-records N] [--group-us U]\n");
+    printf("             Group-commit as pipeline stage K and publish the durable seq\n");
+    printf("  info     List segments\n");
+    printf("  compact  Keep the newest record per key in sealed segments\n");
+    printf("           --key-offset N --key-len M (0 = pub_id) [--horizon-ms H] [--segment-mb N]\n");
+    exit(1);
+}
+
+static void flag_str(uint16_t flags, char *out, size_t n) {
+    snprintf(out, n, "%s%s", (flags & USRL_JSEG_F_SEALED) ? "sealed" : "active",
+             (flags & USRL_JSEG_F_COMPACTED) ? ",compacted" : "");
+}
+
+/* ---------------------------------------------------------------------------
+ * COMMANDS
+ * --------------------------------------------------------------------------- */
+
+static int do_record(const char *dir, const char *topic, uint64_t segment_bytes, uint64_t duration_s) {
+    void *core = usrl_core_map(SHM_PATH, 0);
+    if (!core) {
+        fprintf(stderr, "Cannot map %s. Hint: Have you run core_loader?\n", SHM_PATH);
+        return 1;
+    }
+    if (!usrl_get_topic(core, topic)) {
+        fprintf(stderr, "Topic '%s' not found.\n", topic);
+        return 1;
+    }
+
+    UsrlJournalWriter w;
+    if (usrl_journal_writer_open(&w, dir, topic, segment_bytes) != 0) {
+        perror("usrl_journal_writer_open");
+        return 1;
+    }
+
+    UsrlSubscriber sub;
+    usrl_sub_init(&sub, core, topic);
+    uint64_t head = atomic_load_explicit(&sub.desc->w_head, memory_order_acquire);
+
+    /* Resume where the last run stopped if the ring still holds it */
+    if (w.last_seq > head) {
+        fprintf(stderr, "Journal is ahead of the ring (seq %" PRIu64 " > head %" PRIu64
+                "): the region was recreated, record into a new directory.\n", w.last_seq, head);
+        usrl_journal_writer_close(&w);
+        return 1;
+    }
+    if (w.last_seq && head - w.last_seq < sub.desc->slot_count) {
+        sub.last_seq = w.last_seq;
+    } else {
+        if (w.last_seq)
+            fprintf(stderr, "Warning: seqs %" PRIu64 "..%" PRIu64 " already overwritten, gap in journal\n",
+                    w.last_seq + 1, head);
+        sub.last_seq = head;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    printf("Recording '%s' into %s from seq %" PRIu64 "...\n", topic, w.dir, sub.last_seq + 1);
+    fflush(stdout);
+
+    uint64_t start = mono_ns();
+    uint64_t end = duration_s ? start + duration_s * 1000000000ull : UINT64_MAX;
+    uint64_t next_flush = start + FLUSH_INTERVAL_NS;
+    int rc = 0;
+
+    while (atomic_load(&g_running)) {
+        int n = usrl_journal_record(&w, &sub, 0);
+        if (n < 0) {
+            perror("usrl_journal_record");
+            rc = 1;
+            break;
+        }
+
+        uint64_t now = mono_ns();
+        if (now >= end) break;
+        if (now >= next_flush) {
+            if (usrl_journal_flush(&w) != 0) {
+                perror("usrl_journal_flush");
+                rc = 1;
+                break;
+            }
+            next_flush = now + FLUSH_INTERVAL_NS;
+        }
+        if (n == 0) usleep(IDLE_SLEEP_US);
+    }
+
+    uint64_t records = w.records, bytes = w.bytes, lapped = w.lapped;
+    usrl_journal_writer_close(&w);
+    printf("Recorded %" PRIu64 " records (%.1f MB), %" PRIu64 " segments, %" PRIu64 " lapped, %" PRIu64 " skipped\n",
+           records, (double)bytes / (1024.0 * 1024.0), w.segments, lapped, sub.skipped_count);
+    return rc;
+}
+
+static int do_record_durable(const char *dir, const char *topic, uint64_t segment_bytes,
+                             uint64_t duration_s, uint32_t stage, uint32_t group_records,
+                             uint64_t group_ns) {
+    void *core = usrl_core_map(SHM_PATH, 0);
+    if (!core) {
+        fprintf(stderr, "Cannot map %s. Hint: Have you run core_loader?\n", SHM_PATH);
+        return 1;
+    }
+    if (!usrl_get_topic(core, topic)) {
+        fprintf(stderr, "Topic '%s' not found.\n", topic);
+        return 1;
+    }
+
+    UsrlDurableWriter d;
+    if (usrl_durable_open(&d, core, topic, stage, dir, segment_bytes, group_records, group_ns) != 0) {
+        if (errno == ESTALE)
+            fprintf(stderr, "Journal is ahead of the ring: the region was recreated, record into a new directory.\n");
+        else
+            perror("usrl_durable_open");
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    printf("Durable recording '%s' into %s as stage %u from seq %" PRIu64 " (group %u records / %" PRIu64 " us)...\n",
+           topic, d.w.dir, stage, d.stage.next, d.group_records, d.group_ns / 1000);
+    fflush(stdout);
+
+    uint64_t end = duration_s ? mono_ns() + duration_s * 1000000000ull : UINT64_MAX;
+    int rc = 0;
+
+    while (atomic_load(&g_running)) {
+        int n = usrl_durable_poll(&d);
+        if (n < 0) {
+            perror("usrl_durable_poll");
+            rc = 1;
+            break;
+        }
+        if (mono_ns() >= end) break;
+        if (n == 0) usleep(DURABLE_IDLE_US);
+    }
+
+    if (usrl_durable_close(&d) != 0) {
+        perror("usrl_durable_close");
+        rc = 1;
+    }
+    printf("Recorded %" PRIu64 " records (%.1f MB) in %" PRIu64 " groups, durable seq %" PRIu64 "\n",
+           d.w.records, (double)d.w.bytes / (1024.0 * 1024.0), d.groups, usrl_durable_seq(d.ext));
+    if (d.groups)
+        printf("  group avg %.1f max %" PRIu64 " records, sync avg %.1f us max %.1f us\n",
+               (double)d.w.records / (double)d.groups, d.max_group,
+               (double)d.sync_ns_total / (double)d.groups / 1e3, (double)d.sync_ns_max / 1e3);
+    return rc;
+}
+
+static int do_info(const char *dir, const char *topic) {
+    int n = usrl_journal_list(dir, topic, NULL, 0);
+    if (n < 0) {
+        perror("usrl_journal_list");
+        return 1;
+    }
+    UsrlJournalSegInfo *segs = malloc((n > 0 ? (size_t)n : 1) * sizeof(*segs));
+    if (!segs) return 1;
+    n = usrl_journal_list(dir, topic, segs, (uint32_t)n);
+
+    printf("%-22s %-22s %-12s %-10s %s\n", "FIRST_SEQ", "LAST_SEQ", "RECORDS", "SIZE_MB", "STATE");
+    uint64_t total_records = 0, total_bytes = 0;
+    for (int i = 0; i < n; i++) {
+        UsrlJournalSegment s;
+        if (usrl_jseg_open(&s, segs[i].path) != 0) {
+            printf("%-22" PRIu64 " (unreadable)\n", segs[i].first_seq);
+            continue;
+        }
+
+        /* The active segment's header is not final yet: count its records */
+        uint64_t last = s.hdr->last_seq, count = s.hdr->count;
+        if (!(s.hdr->flags & USRL_JSEG_F_SEALED)) {
+            const UsrlJournalRecord *r;
+            count = 0;
+            for (uint64_t off = usrl_jseg_begin(&s); (r = usrl_jseg_record(&s, off)) != NULL;
+                 off = usrl_jseg_next(r, off)) {
+                last = r->seq;
+                count++;
+            }
+        }
+
+        char state[32];
+        flag_str(s.hdr->flags, state, sizeof(state));
+        printf("%-22" PRIu64 " %-22" PRIu64 " %-12" PRIu64 " %-10.1f %s\n",
+               s.hdr->first_seq, last, count, (double)s.size / (1024.0 * 1024.0), state);
+        total_records += count;
+        total_bytes += s.size;
+        usrl_jseg_close(&s);
+    }
+    printf("%d segments, %" PRIu64 " records, %.1f MB\n", n, total_records,
+           (double)total_bytes / (1024.0 * 1024.0));
+    free(segs);
+    return 0;
+}
+
+static int do_compact(const char *dir, const char *topic, const UsrlCompactSpec *spec) {
+    UsrlCompactStats st;
+    uint64_t t0 = mono_ns();
+    if (usrl_journal_compact(dir, topic, spec, &st) != 0) {
+        perror("usrl_journal_compact");
+        return 1;
+    }
+    double ms = (double)(mono_ns() - t0) / 1e6;
+
+    if (st.segments_in == 0) {
+        printf("Nothing to compact.\n");
+        return 0;
+    }
+    printf("Compacted %" PRIu64 " -> %" PRIu64 " segments in %.1f ms\n", st.segments_in, st.segments_out, ms);
+    printf("  records: %" PRIu64 " -> %" PRIu64 " (%" PRIu64 " keys)\n", st.records_in, st.records_out, st.keys);
+    printf("  size:    %.1f MB -> %.1f MB\n", (double)st.bytes_in / (1024.0 * 1024.0),
+           (double)st.bytes_out / (1024.0 * 1024.0));
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * MAIN
+ * --------------------------------------------------------------------------- */
+
+int main(int argc, char **argv) {
+    if (argc < 4) usage();
+    const char *cmd = argv[1], *dir = argv[2], *topic = argv[3];
+
+    uint64_t segment_bytes = 0, duration_s = 0, group_ns = 0;
+    uint32_t stage = 0, group_records = 0;
+    UsrlCompactSpec spec = { 0 };
+    int have_key = 0, durable = 0;
+
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--segment-mb") == 0 && i + 1 < argc) segment_bytes = strtoull(argv[++i], NULL, 10) << 20;
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) duration_s = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--key-offset") == 0 && i + 1 < argc) spec.key_offset = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--key-len") == 0 && i + 1 < argc) {
+            spec.key_len = (uint32_t)atoi(argv[++i]);
+            have_key = 1;
+        }
+        else if (strcmp(argv[i], "--horizon-ms") == 0 && i + 1 < argc) spec.horizon_ns = strtoull(argv[++i], NULL, 10) * 1000000ull;
+        else if (strcmp(argv[i], "--durable") == 0) durable = 1;
+        else if (strcmp(argv[i], "--stage") == 0 && i + 1 < argc) stage = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--group-records") == 0 && i + 1 < argc) group_records = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--group-us") == 0 && i + 1 < argc) group_ns = strtoull(argv[++i], NULL, 10) * 1000ull;
+        else usage();
+    }
+    spec.segment_bytes = segment_bytes;
+
+    if (strcmp(cmd, "record") == 0 && durable)
+        return do_record_durable(dir, topic, segment_bytes, duration_s, stage, group_records, group_ns);
+    if (strcmp(cmd, "record") == 0) return do_record(dir, topic, segment_bytes, duration_s);
+    if (strcmp(cmd, "info") == 0) return do_info(dir, topic);
+    if (strcmp(cmd, "compact") == 0) {
+        if (!have_key) usage();
+        return do_compact(dir, topic, &spec);
+    }
+    usage();
+    return 1;
+}
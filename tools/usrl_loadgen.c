@@ -0,0 +1,601 @@
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_metrics.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <math.h>
+
+#define SHM_PATH "/usrl_core"
+
+#define MAX_STREAMS 16
+#define MAX_PUBLISHERS 16       /* per stream */
+#define MAX_TABLE 1000000       /* replay / size file entries */
+#define METRICS_CAPACITY 256
+
+#define DEFAULT_DURATION_S 10
+#define DEFAULT_REPORT_MS 1000
+#define DEFAULT_SPIN_US 50
+#define DEFAULT_RATE 1000.0
+#define DEFAULT_SIZE 64
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+/* --------------------------------------------------------------------------
+ * STATE
+ *
+ * Each stream drives one topic from one or more publisher threads. A
+ * publisher is open loop: arrival k is scheduled at an absolute time drawn
+ * from the arrival process, and a publisher that falls behind sends late
+ * rather than skipping, so a stalled ring shows up as lateness instead of
+ * silently lowering the offered load. The pacer sleeps until --spin-us
+ * before each deadline and spins the rest.
+ *
+ * Every payload starts with a LoadgenStamp so consumers can measure
+ * end-to-end latency against the scheduled send time.
+ * -------------------------------------------------------------------------- */
+
+typedef enum { ARRIVAL_CONSTANT, ARRIVAL_POISSON, ARRIVAL_ONOFF, ARRIVAL_REPLAY } ArrivalKind;
+typedef enum { SIZE_FIXED, SIZE_UNIFORM, SIZE_LOGNORMAL, SIZE_FILE } SizeKind;
+
+typedef struct __attribute__((packed)) {
+    uint64_t seq;               /* per publisher */
+    uint64_t sched_ns;          /* CLOCK_MONOTONIC deadline of this message */
+} LoadgenStamp;
+
+typedef struct {
+    uint64_t *v;
+    uint32_t n;
+} Table;                        /* values loaded from a file */
+
+typedef struct {
+    char topic[USRL_MAX_TOPIC_NAME];
+    uint32_t publishers;
+    uint16_t pub_id;            /* first publisher id */
+    int cpu;                    /* first CPU, -1 = unpinned */
+
+    ArrivalKind arrival;
+    double rate;                /* per stream; during bursts for onoff */
+    uint64_t on_ns, off_ns;
+    Table replay;               /* inter-arrival ns */
+    double speed;
+
+    SizeKind size;
+    uint32_t size_a, size_b;    /* fixed / uniform bounds, lognormal median */
+    double sigma;
+    Table sizes;
+
+    uint32_t max_len;           /* slot payload capacity */
+    uint64_t count;             /* per publisher, 0 = until --duration */
+    int is_mwmr;
+
+    UsrlMetricCell *m_sched;
+    UsrlMetricCell *m_sent;
+    UsrlMetricCell *m_failed;
+    UsrlMetricCell *m_bytes;
+    UsrlMetricCell *m_late;     /* send time - deadline, ns */
+} Stream;
+
+typedef struct {
+    Stream *s;
+    uint32_t index;
+    void *core;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    uint64_t rng;
+    pthread_t tid;
+} Publisher;
+
+static atomic_int g_running = 1;
+
+static void on_signal(int sig) {
+    (void)sig;
+    atomic_store(&g_running, 0);
+}
+
+/* --------------------------------------------------------------------------
+ * UTILS
+ * -------------------------------------------------------------------------- */
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t rng_next(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* Uniform in (0, 1] */
+static inline double rng_unit(uint64_t *s) {
+    return (double)((rng_next(s) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static inline double rng_normal(uint64_t *s) {
+    return sqrt(-2.0 * log(rng_unit(s))) * cos(2.0 * M_PI * rng_unit(s));
+}
+
+/* One unsigned integer per line, '#' starts a comment */
+static int load_table(const char *path, Table *t) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    uint32_t cap = 1024;
+    t->v = malloc(cap * sizeof(uint64_t));
+    t->n = 0;
+
+    char line[128];
+    while (t->v && fgets(line, sizeof(line), f) && t->n < MAX_TABLE) {
+        char *end;
+        unsigned long long v = strtoull(line, &end, 10);
+        if (end == line) continue;
+        if (t->n == cap) {
+            uint64_t *g = realloc(t->v, (size_t)cap * 2 * sizeof(uint64_t));
+            if (!g) break;
+            t->v = g;
+            cap *= 2;
+        }
+        t->v[t->n++] = v;
+    }
+    fclose(f);
+
+    if (t->n == 0) {
+        fprintf(stderr, "%s: no values\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/* --------------------------------------------------------------------------
+ * ARRIVALS & SIZES
+ * -------------------------------------------------------------------------- */
+
+/* Next deadline after `t` for a publisher carrying 1 / publishers of the load */
+static uint64_t next_arrival(const Stream *s, Publisher *p, uint64_t t, uint64_t k) {
+    double rate = s->rate / s->publishers;
+    uint64_t gap;
+
+    switch (s->arrival) {
+    case ARRIVAL_CONSTANT:
+        /* From the start, so rounding never accumulates; publishers are
+         * staggered across the period instead of firing together */
+        return p->start_ns +
+               (uint64_t)(((double)k + 1.0 + (double)p->index / s->publishers) * 1e9 / rate);
+
+    case ARRIVAL_POISSON:
+        gap = (uint64_t)(-log(rng_unit(&p->rng)) * 1e9 / rate);
+        return t + gap;
+
+    case ARRIVAL_ONOFF: {
+        /* Poisson at `rate` inside each on period, silence in between */
+        uint64_t period = s->on_ns + s->off_ns;
+        uint64_t next = t + (uint64_t)(-log(rng_unit(&p->rng)) * 1e9 / rate);
+        uint64_t phase = (next - p->start_ns) % period;
+        if (phase >= s->on_ns) next += period - phase;
+        return next;
+    }
+
+    case ARRIVAL_REPLAY:
+        gap = s->replay.v[(k + p->index) % s->replay.n];
+        return t + (uint64_t)((double)gap / s->speed);
+    }
+    return t;
+}
+
+static uint32_t next_size(const Stream *s, Publisher *p) {
+    uint64_t len = s->size_a;
+
+    switch (s->size) {
+    case SIZE_FIXED:
+        break;
+    case SIZE_UNIFORM:
+        len = s->size_a + rng_next(&p->rng) % (s->size_b - s->size_a + 1);
+        break;
+    case SIZE_LOGNORMAL:
+        len = (uint64_t)((double)s->size_a * exp(s->sigma * rng_normal(&p->rng)));
+        break;
+    case SIZE_FILE:
+        len = s->sizes.v[rng_next(&p->rng) % s->sizes.n];
+        break;
+    }
+
+    if (len < sizeof(LoadgenStamp)) len = sizeof(LoadgenStamp);
+    if (len > s->max_len) len = s->max_len;
+    return (uint32_t)len;
+}
+
+/* --------------------------------------------------------------------------
+ * PUBLISHER
+ * -------------------------------------------------------------------------- */
+
+static void pace_until(uint64_t deadline, uint64_t spin_ns) {
+    uint64_t now = mono_ns();
+    if (deadline > now + spin_ns) {
+        uint64_t wake = deadline - spin_ns;
+        struct timespec ts = { (time_t)(wake / 1000000000ULL), (long)(wake % 1000000000ULL) };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+    while (mono_ns() < deadline) CPU_RELAX();
+}
+
+static uint64_t g_spin_ns = (uint64_t)DEFAULT_SPIN_US * 1000;
+
+static void *publisher_main(void *arg) {
+    Publisher *p = arg;
+    Stream *s = p->s;
+    uint16_t pub_id = (uint16_t)(s->pub_id + p->index);
+
+    if (s->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(s->cpu + (int)p->index, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    UsrlPublisher swmr;
+    UsrlMwmrPublisher mwmr;
+    if (s->is_mwmr) usrl_mwmr_pub_init(&mwmr, p->core, s->topic, pub_id);
+    else usrl_pub_init(&swmr, p->core, s->topic, pub_id);
+
+    uint8_t *buf = calloc(1, s->max_len);
+    if (!buf) return NULL;
+
+    LoadgenStamp stamp = { 0, 0 };
+    uint64_t deadline = next_arrival(s, p, p->start_ns, 0);
+
+    while (atomic_load_explicit(&g_running, memory_order_relaxed) && deadline < p->end_ns) {
+        pace_until(deadline, g_spin_ns);
+
+        uint32_t len = next_size(s, p);
+        stamp.sched_ns = deadline;
+        memcpy(buf, &stamp, sizeof(stamp));
+
+        uint64_t now = mono_ns();
+        int rc = s->is_mwmr ? usrl_mwmr_pub_publish(&mwmr, buf, len)
+                            : usrl_pub_publish(&swmr, buf, len);
+
+        usrl_metric_add(s->m_sched, 1);
+        usrl_metric_observe(s->m_late, now - deadline);
+        if (rc == USRL_RING_OK) {
+            usrl_metric_add(s->m_sent, 1);
+            usrl_metric_add(s->m_bytes, len);
+        } else {
+            usrl_metric_add(s->m_failed, 1);
+        }
+
+        if (++stamp.seq == s->count) break;
+        deadline = next_arrival(s, p, deadline, stamp.seq);
+    }
+
+    free(buf);
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------
+ * REPORT
+ * -------------------------------------------------------------------------- */
+
+typedef struct {
+    int64_t sched, sent, failed, bytes;
+} StreamSnap;
+
+static void snap(const Stream *s, StreamSnap *out) {
+    out->sched = usrl_metric_read(s->m_sched);
+    out->sent = usrl_metric_read(s->m_sent);
+    out->failed = usrl_metric_read(s->m_failed);
+    out->bytes = usrl_metric_read(s->m_bytes);
+}
+
+/* Mean offered rate of the arrival process */
+static double target_rate(const Stream *s) {
+    if (s->arrival == ARRIVAL_ONOFF)
+        return s->rate * (double)s->on_ns / (double)(s->on_ns + s->off_ns);
+    if (s->arrival == ARRIVAL_REPLAY) {
+        double sum = 0.0;
+        for (uint32_t i = 0; i < s->replay.n; i++) sum += (double)s->replay.v[i];
+        return (sum > 0.0) ? s->publishers * s->speed * 1e9 * s->replay.n / sum : 0.0;
+    }
+    return s->rate;
+}
+
+static void report(const Stream *streams, uint32_t n, const StreamSnap *now,
+                   const StreamSnap *prev, double secs) {
+    printf("%-20s %12s %12s %8s %10s %10s %10s %10s\n",
+           "TOPIC", "TARGET/s", "SENT/s", "ACHIEVED", "FAILED", "MB/s", "LATE_P50", "LATE_P99");
+    for (uint32_t i = 0; i < n; i++) {
+        const Stream *s = &streams[i];
+        double target = target_rate(s);
+        double sent = (double)(now[i].sent - prev[i].sent) / secs;
+        printf("%-20s %12.0f %12.0f %7.1f%% %10ld %10.2f %9luns %9luns\n",
+               s->topic, target, sent, (target > 0.0) ? 100.0 * sent / target : 0.0,
+               now[i].failed - prev[i].failed,
+               (double)(now[i].bytes - prev[i].bytes) / secs / (1024.0 * 1024.0),
+               usrl_metric_hist_quantile(s->m_late, 0.50),
+               usrl_metric_hist_quantile(s->m_late, 0.99));
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+/* --------------------------------------------------------------------------
+ * MAIN
+ * -------------------------------------------------------------------------- */
+
+static void usage(void) {
+    printf("Usage: usrl_loadgen [global options] -t <topic> [stream options] [-t <topic> ...]\n");
+    printf("Global options:\n");
+    printf("  --duration <sec>       Run time (default %d)\n", DEFAULT_DURATION_S);
+    printf("  --report-ms <ms>       Stats interval (default %d, 0 = final only)\n", DEFAULT_REPORT_MS);
+    printf("  --spin-us <us>         Spin this long before each deadline (default %d)\n", DEFAULT_SPIN_US);
+    printf("  --metrics <path>       Publish counters to a SHM metrics registry\n");
+    printf("  --seed <n>             RNG seed\n");
+    printf("Stream options (before any -t they set the defaults):\n");
+    printf("  --arrival <kind>       constant | poisson | onoff | replay (default constant)\n");
+    printf("  --rate <hz>            Stream rate; the in-burst rate for onoff (default %.0f)\n", DEFAULT_RATE);
+    printf("  --on-ms <ms> --off-ms <ms>  onoff burst and gap lengths\n");
+    printf("  --replay <file>        Inter-arrival times in ns, one per line\n");
+    printf("  --speed <x>            Replay speed-up (default 1)\n");
+    printf("  --size <dist>          N | uniform:A:B | lognormal:MEDIAN:SIGMA | file:<path> (default %d)\n", DEFAULT_SIZE);
+    printf("  --publishers <n>       Publisher threads, MWMR topics only (default 1)\n");
+    printf("  --pub-id <id>          First publisher id (default 1)\n");
+    printf("  --cpu <n>              Pin publisher k to CPU n + k\n");
+    printf("  --count <n>            Stop each publisher after n messages\n");
+    exit(1);
+}
+
+static int parse_size(Stream *s, const char *spec) {
+    if (strncmp(spec, "uniform:", 8) == 0) {
+        s->size = SIZE_UNIFORM;
+        return (sscanf(spec + 8, "%u:%u", &s->size_a, &s->size_b) == 2 && s->size_a <= s->size_b) ? 0 : -1;
+    }
+    if (strncmp(spec, "lognormal:", 10) == 0) {
+        s->size = SIZE_LOGNORMAL;
+        return (sscanf(spec + 10, "%u:%lf", &s->size_a, &s->sigma) == 2) ? 0 : -1;
+    }
+    if (strncmp(spec, "file:", 5) == 0) {
+        s->size = SIZE_FILE;
+        return load_table(spec + 5, &s->sizes);
+    }
+    s->size = SIZE_FIXED;
+    s->size_a = (uint32_t)atoi(spec);
+    return 0;
+}
+
+static int parse_arrival(Stream *s, const char *kind) {
+    if (strcmp(kind, "constant") == 0) s->arrival = ARRIVAL_CONSTANT;
+    else if (strcmp(kind, "poisson") == 0) s->arrival = ARRIVAL_POISSON;
+    else if (strcmp(kind, "onoff") == 0) s->arrival = ARRIVAL_ONOFF;
+    else if (strcmp(kind, "replay") == 0) s->arrival = ARRIVAL_REPLAY;
+    else return -1;
+    return 0;
+}
+
+/* Bind a parsed stream to its topic and metrics */
+static int stream_attach(Stream *s, void *core, UsrlMetrics *m) {
+    TopicEntry *t = usrl_get_topic(core, s->topic);
+    if (!t) {
+        fprintf(stderr, "Topic '%s' not found.\n", s->topic);
+        return -1;
+    }
+
+    s->is_mwmr = (t->type == USRL_RING_TYPE_MWMR);
+    s->max_len = t->slot_size - (uint32_t)sizeof(SlotHeader);
+    if (!s->is_mwmr && s->publishers > 1) {
+        fprintf(stderr, "%s: SWMR topics take one publisher\n", s->topic);
+        return -1;
+    }
+    if (s->arrival == ARRIVAL_REPLAY && s->replay.n == 0) {
+        fprintf(stderr, "%s: --arrival replay needs --replay <file>\n", s->topic);
+        return -1;
+    }
+    if (s->arrival == ARRIVAL_ONOFF && (s->on_ns == 0 || s->off_ns == 0)) {
+        fprintf(stderr, "%s: --arrival onoff needs --on-ms and --off-ms\n", s->topic);
+        return -1;
+    }
+    if (s->rate <= 0.0 || s->publishers == 0 || s->publishers > MAX_PUBLISHERS) {
+        fprintf(stderr, "%s: bad rate or publisher count\n", s->topic);
+        return -1;
+    }
+
+    char name[USRL_METRIC_NAME_MAX];
+    snprintf(name, sizeof(name), "loadgen.%.31s.sched", s->topic);
+    s->m_sched = usrl_metric_counter(m, name);
+    snprintf(name, sizeof(name), "loadgen.%.31s.sent", s->topic);
+    s->m_sent = usrl_metric_counter(m, name);
+    snprintf(name, sizeof(name), "loadgen.%.31s.failed", s->topic);
+    s->m_failed = usrl_metric_counter(m, name);
+    snprintf(name, sizeof(name), "loadgen.%.31s.bytes", s->topic);
+    s->m_bytes = usrl_metric_counter(m, name);
+    snprintf(name, sizeof(name), "loadgen.%.31s.late_ns", s->topic);
+    s->m_late = usrl_metric_hist(m, name);
+
+    if (!s->m_sched || !s->m_sent || !s->m_failed || !s->m_bytes || !s->m_late) {
+        fprintf(stderr, "%s: metrics registry full or name taken\n", s->topic);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Stream streams[MAX_STREAMS];
+    Stream defaults;
+    memset(&defaults, 0, sizeof(defaults));
+    defaults.publishers = 1;
+    defaults.pub_id = 1;
+    defaults.cpu = -1;
+    defaults.rate = DEFAULT_RATE;
+    defaults.speed = 1.0;
+    defaults.size_a = DEFAULT_SIZE;
+
+    uint32_t n = 0;
+    uint64_t duration_ms = (uint64_t)DEFAULT_DURATION_S * 1000;
+    uint32_t report_ms = DEFAULT_REPORT_MS;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL ^ (uint64_t)getpid();
+    const char *metrics_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        Stream *s = n ? &streams[n - 1] : &defaults;
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = 1;
+
+        if (strcmp(a, "-t") == 0 && v) {
+            if (n == MAX_STREAMS) usage();
+            streams[n] = defaults;
+            snprintf(streams[n].topic, USRL_MAX_TOPIC_NAME, "%s", v);
+            n++;
+        }
+        else if (strcmp(a, "--duration") == 0 && v) duration_ms = (uint64_t)(atof(v) * 1000.0);
+        else if (strcmp(a, "--report-ms") == 0 && v) report_ms = (uint32_t)atoi(v);
+        else if (strcmp(a, "--spin-us") == 0 && v) g_spin_ns = (uint64_t)atoi(v) * 1000;
+        else if (strcmp(a, "--metrics") == 0 && v) metrics_path = v;
+        else if (strcmp(a, "--seed") == 0 && v) seed = strtoull(v, NULL, 0);
+        else if (strcmp(a, "--arrival") == 0 && v) ok = (parse_arrival(s, v) == 0);
+        else if (strcmp(a, "--rate") == 0 && v) s->rate = atof(v);
+        else if (strcmp(a, "--on-ms") == 0 && v) s->on_ns = (uint64_t)(atof(v) * 1e6);
+        else if (strcmp(a, "--off-ms") == 0 && v) s->off_ns = (uint64_t)(atof(v) * 1e6);
+        else if (strcmp(a, "--replay") == 0 && v) ok = (load_table(v, &s->replay) == 0);
+        else if (strcmp(a, "--speed") == 0 && v) s->speed = atof(v);
+        else if (strcmp(a, "--size") == 0 && v) ok = (parse_size(s, v) == 0);
+        else if (strcmp(a, "--publishers") == 0 && v) s->publishers = (uint32_t)atoi(v);
+        else if (strcmp(a, "--pub-id") == 0 && v) s->pub_id = (uint16_t)atoi(v);
+        else if (strcmp(a, "--cpu") == 0 && v) s->cpu = atoi(v);
+        else if (strcmp(a, "--count") == 0 && v) s->count = strtoull(v, NULL, 10);
+        else usage();
+
+        if (!ok) {
+            fprintf(stderr, "Bad value for %s: %s\n", a, v);
+            return 1;
+        }
+        i++;
+    }
+    if (n == 0 || duration_ms == 0) usage();
+
+    void *core = usrl_core_map(SHM_PATH, 0);
+    if (!core) {
+        fprintf(stderr, "Cannot map %s. Hint: Have you run core_loader?\n", SHM_PATH);
+        return 1;
+    }
+
+    UsrlMetrics metrics;
+    if (metrics_path) {
+        if (usrl_metrics_create(metrics_path, METRICS_CAPACITY) < 0 ||
+            usrl_metrics_open(&metrics, metrics_path) != 0) {
+            fprintf(stderr, "Cannot open metrics registry %s\n", metrics_path);
+            return 1;
+        }
+    } else if (usrl_metrics_init(&metrics, METRICS_CAPACITY) != 0) {
+        fprintf(stderr, "OOM\n");
+        return 1;
+    }
+
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (stream_attach(&streams[i], core, &metrics) != 0) return 1;
+        total += streams[i].publishers;
+    }
+
+    Publisher *pubs = calloc(total, sizeof(Publisher));
+    StreamSnap *now = calloc(n, sizeof(StreamSnap));
+    StreamSnap *prev = calloc(n, sizeof(StreamSnap));
+    if (!pubs || !now || !prev) {
+        fprintf(stderr, "OOM\n");
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    for (uint32_t i = 0; i < n; i++) {
+        const Stream *s = &streams[i];
+        printf("[LOADGEN] %-20s %s, %u publisher(s), target %.0f msg/s, %s\n", s->topic,
+               s->arrival == ARRIVAL_CONSTANT ? "constant" :
+               s->arrival == ARRIVAL_POISSON ? "poisson" :
+               s->arrival == ARRIVAL_ONOFF ? "on/off" : "replay",
+               s->publishers, target_rate(s), s->is_mwmr ? "MWMR" : "SWMR");
+    }
+    printf("\n");
+
+    /* Start slightly in the future so every publisher shares time zero */
+    uint64_t start = mono_ns() + 10000000ULL;
+    uint64_t end = start + duration_ms * 1000000ULL;
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = 0; j < streams[i].publishers; j++, k++) {
+            Publisher *p = &pubs[k];
+            p->s = &streams[i];
+            p->index = j;
+            p->core = core;
+            p->start_ns = start;
+            p->end_ns = end;
+            p->rng = seed + 0x632BE59BD9B4E019ULL * (k + 1);
+            if (pthread_create(&p->tid, NULL, publisher_main, p) != 0) {
+                fprintf(stderr, "Failed to start publisher %u\n", k);
+                atomic_store(&g_running, 0);
+                total = k;
+                break;
+            }
+        }
+    }
+
+    uint64_t last = start;
+    while (atomic_load(&g_running) && mono_ns() < end) {
+        usleep(20 * 1000);
+        uint64_t t = mono_ns();
+        if (report_ms == 0 || t < last + (uint64_t)report_ms * 1000000ULL) continue;
+
+        for (uint32_t i = 0; i < n; i++) snap(&streams[i], &now[i]);
+        report(streams, n, now, prev, (double)(t - last) / 1e9);
+        memcpy(prev, now, n * sizeof(*now));
+        last = t;
+    }
+
+    atomic_store(&g_running, 0);
+    for (uint32_t i = 0; i < total; i++) pthread_join(pubs[i].tid, NULL);
+
+    uint64_t t = mono_ns();
+    if (t > end) t = end;
+    double secs = (t > start) ? (double)(t - start) / 1e9 : 1.0;
+    memset(prev, 0, n * sizeof(*prev));
+    for (uint32_t i = 0; i < n; i++) snap(&streams[i], &now[i]);
+    printf("[LOADGEN] Totals over %.1f s\n", secs);
+    report(streams, n, now, prev, secs);
+
+    for (uint32_t i = 0; i < n; i++) {
+        const Stream *s = &streams[i];
+        printf("  %-20s scheduled %ld, sent %ld, failed %ld, late p99.9 %lu ns, max < %lu ns\n",
+               s->topic, now[i].sched, now[i].sent, now[i].failed,
+               usrl_metric_hist_quantile(s->m_late, 0.999),
+               usrl_metric_hist_quantile(s->m_late, 1.0));
+    }
+
+    if (metrics.owned) usrl_metrics_free(&metrics);
+    else usrl_metrics_close(&metrics);
+    free(pubs);
+    free(now);
+    free(prev);
+    return 0;
+}
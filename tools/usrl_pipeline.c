@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_pipeline.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_REPORT_MS 1000
+
+static volatile sig_atomic_t g_running = 1;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_running = 0;
+}
+
+/* --------------------------------------------------------------------------
+ * UTILS
+ * -------------------------------------------------------------------------- */
+
+static uint64_t time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *buf = (size >= 0) ? malloc((size_t)size + 1) : NULL;
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) buf[size] = '\0';
+    fclose(f);
+    return buf;
+}
+
+/* Per-stage rates since the previous report */
+static void report(const UsrlPipeStageStats *now, const UsrlPipeStageStats *prev,
+                   uint32_t n, double secs) {
+    printf("%-20s %-10s %-10s %12s %12s %10s %10s %s\n",
+           "STAGE", "OP", "THREAD", "IN/s", "OUT/s", "DROPPED", "LAG", "");
+    for (uint32_t i = 0; i < n; i++) {
+        const UsrlPipeStageStats *s = &now[i];
+        printf("%-20s %-10s %-10s %12.0f %12.0f %10lu %10lu %s\n",
+               s->name, s->op, s->thread,
+               (double)(s->in - prev[i].in) / secs,
+               (double)(s->out - prev[i].out) / secs,
+               s->dropped, s->lag,
+               s->fused ? "(fused)" : "");
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+/* --------------------------------------------------------------------------
+ * MAIN
+ * -------------------------------------------------------------------------- */
+
+static void usage(void) {
+    printf("Usage: usrl_pipeline <pipeline.json> [options]\n");
+    printf("Options:\n");
+    printf("  --report-ms <ms>   Stats interval (default %d, 0 = final only)\n", DEFAULT_REPORT_MS);
+    printf("  --duration <sec>   Stop after this long (default: until Ctrl+C)\n");
+    printf("  --check            Validate the graph and list topics, then exit\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) usage();
+
+    uint32_t report_ms = DEFAULT_REPORT_MS;
+    uint64_t duration_ms = 0;
+    int check = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--report-ms") == 0 && i + 1 < argc) report_ms = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) duration_ms = (uint64_t)atoi(argv[++i]) * 1000;
+        else if (strcmp(argv[i], "--check") == 0) check = 1;
+        else usage();
+    }
+
+    char *json = read_file(argv[1]);
+    if (!json) {
+        fprintf(stderr, "[PIPELINE] Cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    char err[256] = {0};
+    UsrlPipeline *p = usrl_pipeline_load(json, err, sizeof(err));
+    free(json);
+    if (!p) {
+        fprintf(stderr, "[PIPELINE] %s: %s\n", argv[1], err);
+        return 1;
+    }
+
+    UsrlTopicConfig topics[USRL_PIPE_MAX_TOPICS];
+    int topic_count = usrl_pipeline_topics(p, topics, USRL_PIPE_MAX_TOPICS);
+    printf("[PIPELINE] %u stages on %u threads, %d topics\n",
+           usrl_pipeline_stage_count(p), usrl_pipeline_thread_count(p), topic_count);
+    for (int i = 0; i < topic_count; i++) {
+        printf("  %-24s (Slots: %u, Size: %u, Type: %s)\n", topics[i].name,
+               topics[i].slot_count, topics[i].slot_size,
+               topics[i].type == USRL_RING_TYPE_SWMR ? "SWMR" : "MWMR");
+    }
+
+    if (check) {
+        usrl_pipeline_free(p);
+        return 0;
+    }
+
+    if (usrl_pipeline_open(p, err, sizeof(err)) != 0) {
+        fprintf(stderr, "[PIPELINE] %s\n", err);
+        usrl_pipeline_free(p);
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    if (usrl_pipeline_start(p) != 0) {
+        fprintf(stderr, "[PIPELINE] Failed to start executor threads\n");
+        usrl_pipeline_free(p);
+        return 1;
+    }
+    printf("[PIPELINE] Running (Ctrl+C to stop)\n\n");
+
+    uint32_t n = usrl_pipeline_stage_count(p);
+    UsrlPipeStageStats *now = calloc(n, sizeof(*now));
+    UsrlPipeStageStats *prev = calloc(n, sizeof(*prev));
+    uint64_t start = time_ms(), last = start;
+
+    while (g_running && now && prev) {
+        usleep(50 * 1000);
+        uint64_t t = time_ms();
+        if (duration_ms && t - start >= duration_ms) break;
+        if (report_ms == 0 || t - last < report_ms) continue;
+
+        usrl_pipeline_stats(p, now, n);
+        report(now, prev, n, (double)(t - last) / 1000.0);
+        memcpy(prev, now, n * sizeof(*now));
+        last = t;
+    }
+
+    usrl_pipeline_stop(p);
+    if (now && prev) {
+        uint64_t t = time_ms();
+        memset(prev, 0, n * sizeof(*prev));
+        usrl_pipeline_stats(p, now, n);
+        printf("[PIPELINE] Totals (average rates over %.1f s)\n", (double)(t - start) / 1000.0);
+        report(now, prev, n, (t > start) ? (double)(t - start) / 1000.0 : 1.0);
+    }
+
+    free(now);
+    free(prev);
+    usrl_pipeline_free(p);
+    return 0;
+}
@@ -0,0 +1,783 @@
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_ring.h"
+#include "usrl_lanes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <time.h>
+#include <math.h>
+
+#define SHM_PATH "/usrl_core"
+
+#define MAX_PLAN_TOPICS 1024
+#define MAX_PUBS 8              /* distinct writers remembered per ring */
+#define MIN_SLOTS 64
+#define SLOT_ALIGN 64           /* planned slots are whole cache lines */
+
+#define DEFAULT_DURATION_S 10
+#define DEFAULT_STALL_US 1000
+#define DEFAULT_TARGET 1e-6
+#define DEFAULT_HEADROOM 1.25
+#define DEFAULT_PAYLOAD_HEADROOM 1.25
+#define DEFAULT_OUT "config.plan.json"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __asm__ volatile("pause" ::: "memory")
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+/* --------------------------------------------------------------------------
+ * STATE
+ *
+ * The profiler follows each ring's slot headers the way a subscriber does,
+ * without copying payloads or registering anywhere, so the applications do
+ * not see it. Arrivals are binned by SlotHeader.timestamp_ns into windows
+ * of one reader stall (--stall-us), twice with a half-window phase shift so
+ * a burst straddling a boundary is still seen whole in one of them.
+ *
+ * A ring overruns a subscriber when more records arrive while it is stalled
+ * than the ring holds on top of its existing lag. Slots are therefore sized
+ * to the per-window arrival count exceeded in at most --target of windows,
+ * plus the worst stage lag seen (TopicExt cursors; plain subscribers keep
+ * their position in process memory and are covered by the stall window).
+ * -------------------------------------------------------------------------- */
+
+typedef struct {
+    uint64_t window;            /* current window index */
+    uint32_t count;             /* arrivals in it so far */
+    uint32_t *counts;           /* closed non-empty windows */
+    uint32_t n, cap;
+} Binner;
+
+typedef struct {
+    const TopicEntry *t;
+    RingDesc *d;
+    TopicExt *ext;
+    uint8_t *slots;
+    uint64_t mask;
+    uint64_t next;
+
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t lapped;            /* overwritten before the profiler saw them */
+    uint32_t unbinned;          /* lapped, charged to the next window seen */
+    uint32_t max_len;
+    uint16_t pubs[MAX_PUBS];
+    uint32_t pub_count;
+    uint64_t lag_max;           /* head - slowest stage cursor */
+    Binner bin[2];
+} RingProfile;
+
+typedef struct {
+    char name[USRL_MAX_TOPIC_NAME];
+    uint32_t slots;             /* as configured */
+    uint32_t payload;
+    uint32_t type;
+    uint32_t lanes;
+    int ring[USRL_MAX_LANES];   /* RingProfile index per lane, -1 = not in core */
+
+    /* Profile, worst lane */
+    double rate;                /* msgs/s */
+    uint64_t peak;              /* most arrivals in one stall window */
+    double mean_w, sd_w;        /* arrivals per stall window */
+    uint64_t windows;
+    uint64_t messages;
+    uint64_t lapped;
+    uint32_t max_len;
+    double avg_len;
+    uint32_t pubs;
+    uint64_t lag;
+    uint32_t *counts;           /* merged window counts, sorted descending */
+    uint32_t count_n;
+
+    /* Plan */
+    uint64_t required;
+    uint32_t new_slots;
+    uint32_t new_payload;
+    uint32_t fit_payload;       /* payload the traffic needs, before the shrink guard */
+    uint32_t new_type;
+    int extrapolated;
+    int under_budget;           /* shrunk below required to meet --budget-mb */
+} PlanTopic;
+
+typedef struct {
+    uint64_t duration_s;
+    uint64_t stall_ns;
+    double target;
+    double headroom;
+    double payload_headroom;
+    int shrink_payload;
+    double budget_mb;
+    int retype;
+    const char *out;
+} PlanOptions;
+
+static volatile sig_atomic_t g_running = 1;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_running = 0;
+}
+
+/* --------------------------------------------------------------------------
+ * UTILS
+ * -------------------------------------------------------------------------- */
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t next_power_of_two_u32(uint32_t v) {
+    if (v == 0) return 1;
+    v--;
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+    return ++v;
+}
+
+static uint64_t ring_bytes(uint32_t slots, uint32_t payload) {
+    return (uint64_t)next_power_of_two_u32(slots) * usrl_align_up(sizeof(SlotHeader) + payload, 8);
+}
+
+static uint64_t topic_bytes(const PlanTopic *p, uint32_t slots, uint32_t payload) {
+    return ring_bytes(slots, payload) * (p->lanes ? p->lanes : 1);
+}
+
+static void *map_system(void) {
+    int fd = shm_open(SHM_PATH, O_RDONLY, 0666);
+    if (fd < 0) {
+        perror("shm_open");
+        fprintf(stderr, "Hint: Have you run core_loader?\n");
+        return NULL;
+    }
+
+    CoreHeader hdr;
+    if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != USRL_MAGIC) {
+        fprintf(stderr, "Error: Invalid core header in SHM.\n");
+        close(fd);
+        return NULL;
+    }
+
+    void *base = mmap(NULL, hdr.mmap_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return (base == MAP_FAILED) ? NULL : base;
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *buf = (size >= 0) ? malloc((size_t)size + 1) : NULL;
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) buf[size] = '\0';
+    fclose(f);
+    return buf;
+}
+
+/* Value of "key" inside [obj, end), NULL if absent */
+static const char *find_key(const char *obj, const char *end, const char *key) {
+    char search[64];
+    snprintf(search, sizeof(search), "\"%s\"", key);
+    const char *loc = strstr(obj, search);
+    if (!loc || loc >= end) return NULL;
+
+    loc += strlen(search);
+    while (*loc && *loc != ':') loc++;
+    if (*loc == ':') loc++;
+    while (*loc && (unsigned char)*loc <= 32) loc++;
+    return loc;
+}
+
+static void parse_string_val(const char *p, char *dest, int max) {
+    dest[0] = '\0';
+    if (!p || *p != '\"') return;
+    p++;
+    int i = 0;
+    while (*p && *p != '\"' && i < max - 1) dest[i++] = *p++;
+    dest[i] = '\0';
+}
+
+/* Inverse of the standard normal upper tail (Abramowitz & Stegun 26.2.23) */
+static double normal_upper_z(double p) {
+    if (p >= 0.5) return 0.0;
+    double t = sqrt(-2.0 * log(p));
+    return t - (2.515517 + 0.802853 * t + 0.010328 * t * t) /
+               (1.0 + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t);
+}
+
+/* --------------------------------------------------------------------------
+ * PROFILER
+ * -------------------------------------------------------------------------- */
+
+static void binner_close(Binner *b) {
+    if (b->count == 0) return;
+    if (b->n == b->cap) {
+        uint32_t cap = b->cap ? b->cap * 2 : 1024;
+        uint32_t *c = realloc(b->counts, cap * sizeof(uint32_t));
+        if (!c) return;
+        b->counts = c;
+        b->cap = cap;
+    }
+    b->counts[b->n++] = b->count;
+    b->count = 0;
+}
+
+static inline void binner_add(Binner *b, uint64_t window, uint32_t n) {
+    /* MWMR writers may commit slightly out of timestamp order: count late
+     * arrivals in the open window rather than reopening an old one */
+    if (window > b->window) {
+        binner_close(b);
+        b->window = window;
+    }
+    b->count += n;
+}
+
+static void ring_record(RingProfile *r, const SlotHeader *hdr, uint32_t len, uint64_t stall_ns) {
+    uint64_t ts = hdr->timestamp_ns;
+    uint16_t pub = hdr->pub_id;
+
+    r->messages++;
+    r->bytes += len;
+    if (len > r->max_len) r->max_len = len;
+
+    uint32_t i = 0;
+    while (i < r->pub_count && r->pubs[i] != pub) i++;
+    if (i == r->pub_count && r->pub_count < MAX_PUBS) r->pubs[r->pub_count++] = pub;
+
+    /* Records lapped just before this one belong to the same burst */
+    uint32_t n = 1 + r->unbinned;
+    r->unbinned = 0;
+    binner_add(&r->bin[0], ts / stall_ns, n);
+    binner_add(&r->bin[1], (ts + stall_ns / 2) / stall_ns, n);
+}
+
+static inline void ring_lapped(RingProfile *r, uint64_t n) {
+    r->lapped += n;
+    r->unbinned = (r->unbinned + n > UINT32_MAX / 2) ? UINT32_MAX / 2 : r->unbinned + (uint32_t)n;
+}
+
+static int ring_poll(RingProfile *r, uint64_t stall_ns) {
+    RingDesc *d = r->d;
+    uint64_t head = atomic_load_explicit(&d->w_head, memory_order_acquire);
+
+    if (r->ext) {
+        uint32_t stages = (uint32_t)atomic_load_explicit(&r->ext->stage_count, memory_order_acquire);
+        if (stages > USRL_MAX_STAGES) stages = USRL_MAX_STAGES;
+        for (uint32_t k = 0; k < stages; k++) {
+            uint64_t s = atomic_load_explicit(&r->ext->stages[k].seq, memory_order_acquire);
+            if (head > s && head - s > r->lag_max) r->lag_max = head - s;
+        }
+    }
+
+    if (head >= r->next && head - r->next + 1 > d->slot_count) {
+        ring_lapped(r, head - d->slot_count + 1 - r->next);
+        r->next = head - d->slot_count + 1;
+    }
+
+    int n = 0;
+    while (r->next <= head) {
+        const SlotHeader *hdr = (const SlotHeader *)(r->slots + ((r->next - 1) & r->mask) * d->slot_size);
+        uint64_t seq = atomic_load_explicit(&hdr->seq, memory_order_acquire);
+        if (seq < r->next) break; /* claimed, not yet committed */
+        if (seq > r->next) {
+            ring_lapped(r, 1);
+            r->next++;
+            continue;
+        }
+
+        uint32_t len = hdr->payload_len;
+        uint8_t flags = hdr->flags;
+        if (atomic_load_explicit(&hdr->seq, memory_order_acquire) != seq) {
+            ring_lapped(r, 1);
+        } else if (!(flags & USRL_SLOT_F_PROBE)) {
+            ring_record(r, hdr, len, stall_ns);
+        }
+        r->next++;
+        n++;
+    }
+    return n;
+}
+
+static void profile(RingProfile *rings, uint32_t count, const PlanOptions *o, uint64_t *elapsed_ns) {
+    for (uint32_t i = 0; i < count; i++)
+        rings[i].next = atomic_load_explicit(&rings[i].d->w_head, memory_order_acquire) + 1;
+
+    uint64_t start = mono_ns();
+    uint64_t end = start + o->duration_s * 1000000000ULL;
+    uint32_t idle = 0;
+
+    while (g_running && mono_ns() < end) {
+        int n = 0;
+        for (uint32_t i = 0; i < count; i++) n += ring_poll(&rings[i], o->stall_ns);
+
+        if (n) idle = 0;
+        else if (++idle < 1024) CPU_RELAX();
+        else sched_yield();
+    }
+
+    *elapsed_ns = mono_ns() - start;
+    for (uint32_t i = 0; i < count; i++) {
+        binner_close(&rings[i].bin[0]);
+        binner_close(&rings[i].bin[1]);
+    }
+}
+
+/* --------------------------------------------------------------------------
+ * PLANNER
+ * -------------------------------------------------------------------------- */
+
+static int cmp_desc_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x < y) - (x > y);
+}
+
+/* Fold the lanes' profiles into the worst case and sort the window counts */
+static void plan_profile(PlanTopic *p, const RingProfile *rings, uint64_t elapsed_ns, uint64_t stall_ns) {
+    uint64_t windows = elapsed_ns / stall_ns;
+    if (windows == 0) windows = 1;
+
+    for (uint32_t l = 0; l < (p->lanes ? p->lanes : 1); l++) {
+        if (p->ring[l] < 0) continue;
+        const RingProfile *r = &rings[p->ring[l]];
+
+        p->messages += r->messages;
+        p->lapped += r->lapped;
+        if (r->max_len > p->max_len) p->max_len = r->max_len;
+        if (r->pub_count > p->pubs) p->pubs = r->pub_count;
+        if (r->lag_max > p->lag) p->lag = r->lag_max;
+
+        double rate = (double)r->messages * 1e9 / (double)elapsed_ns;
+        if (rate < p->rate) continue;
+
+        /* Window statistics come from the busiest lane */
+        p->rate = rate;
+        p->avg_len = r->messages ? (double)r->bytes / (double)r->messages : 0.0;
+
+        free(p->counts);
+        p->count_n = r->bin[0].n + r->bin[1].n;
+        p->counts = malloc(((size_t)p->count_n + 1) * sizeof(uint32_t));
+        if (!p->counts) {
+            p->count_n = 0;
+            continue;
+        }
+        memcpy(p->counts, r->bin[0].counts, r->bin[0].n * sizeof(uint32_t));
+        memcpy(p->counts + r->bin[0].n, r->bin[1].counts, r->bin[1].n * sizeof(uint32_t));
+        qsort(p->counts, p->count_n, sizeof(uint32_t), cmp_desc_u32);
+
+        p->windows = 2 * windows;
+        if (p->count_n > p->windows) p->windows = p->count_n;
+        double sum = 0.0, sq = 0.0;
+        for (uint32_t i = 0; i < p->count_n; i++) {
+            sum += p->counts[i];
+            sq += (double)p->counts[i] * p->counts[i];
+        }
+        p->mean_w = sum / (double)p->windows;
+        double var = sq / (double)p->windows - p->mean_w * p->mean_w;
+        p->sd_w = (var > 0.0) ? sqrt(var) : 0.0;
+        p->peak = p->count_n ? p->counts[0] : 0;
+    }
+}
+
+/* Fraction of stall windows that would overrun a ring of `slots` */
+static double plan_overrun(const PlanTopic *p, uint64_t slots) {
+    if (slots <= p->lag) return 1.0;
+    uint64_t room = slots - p->lag;
+    if (p->messages == 0) return 0.0;
+
+    uint64_t over = 0;
+    while (over < p->count_n && p->counts[over] > room) over++;
+    if (over) return (double)over / (double)p->windows;
+
+    /* Beyond the sample: normal tail of the per-window arrival count */
+    if (p->sd_w == 0.0) return 0.0;
+    double z = ((double)room - p->mean_w) / p->sd_w;
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+static void plan_topic(PlanTopic *p, const PlanOptions *o) {
+    p->new_slots = p->slots;
+    p->new_payload = p->payload;
+    p->fit_payload = p->payload;
+    p->new_type = p->type;
+    if (p->messages == 0) return; /* no data: keep the configured ring */
+
+    /* Slots: arrivals per stall window at the target quantile */
+    uint64_t allowed = (uint64_t)(o->target * (double)p->windows);
+    uint64_t need;
+    if (allowed < p->count_n && allowed > 0) {
+        need = p->counts[allowed];
+    } else if (allowed >= p->count_n) {
+        need = 0;
+    } else {
+        /* Target finer than 1 / windows sampled: extrapolate */
+        double tail = p->mean_w + normal_upper_z(o->target) * p->sd_w;
+        need = (uint64_t)ceil(tail);
+        if (need < p->peak) need = p->peak;
+        p->extrapolated = 1;
+    }
+    p->required = need + p->lag;
+
+    uint64_t slots = (uint64_t)ceil((double)p->required * o->headroom);
+    if (slots < MIN_SLOTS) slots = MIN_SLOTS;
+    if (slots > (1u << 31)) slots = 1u << 31;
+    p->new_slots = next_power_of_two_u32((uint32_t)slots);
+
+    /* Payload: largest record seen plus headroom, the slot rounded up to
+     * whole cache lines. A record over the payload is rejected, and a
+     * sample may miss the largest ones, so the configured payload is only
+     * reduced with --shrink-payload. */
+    double want = ceil((double)p->max_len * o->payload_headroom);
+    if (want > (double)(UINT32_MAX / 2)) want = (double)(UINT32_MAX / 2);
+    uint64_t slot = usrl_align_up(sizeof(SlotHeader) + (uint64_t)want, SLOT_ALIGN);
+    p->fit_payload = (uint32_t)(slot - sizeof(SlotHeader));
+    p->new_payload = p->fit_payload;
+    if (p->new_payload < p->payload && !o->shrink_payload) p->new_payload = p->payload;
+
+    /* Type: several writers on SWMR corrupt the ring; one writer on MWMR
+     * is only a candidate, since other writers may simply have been idle */
+    if (p->pubs > 1) p->new_type = USRL_RING_TYPE_MWMR;
+    else if (o->retype && p->pubs == 1) p->new_type = USRL_RING_TYPE_SWMR;
+}
+
+/* Halve the rings that cost the most until the plan fits the budget.
+ * Topics without traffic have no requirement to trade against and are kept. */
+static void plan_budget(PlanTopic *topics, uint32_t count, const PlanOptions *o) {
+    if (o->budget_mb <= 0.0) return;
+    uint64_t budget = (uint64_t)(o->budget_mb * 1024.0 * 1024.0);
+
+    for (;;) {
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < count; i++)
+            total += topic_bytes(&topics[i], topics[i].new_slots, topics[i].new_payload);
+        if (total <= budget) return;
+
+        /* Prefer rings with headroom above their requirement, then the largest */
+        int best = -1, best_spare = 0;
+        uint64_t best_bytes = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            PlanTopic *p = &topics[i];
+            if (p->new_slots <= MIN_SLOTS || p->messages == 0) continue;
+            int spare = (p->new_slots / 2 >= p->required);
+            uint64_t bytes = topic_bytes(p, p->new_slots, p->new_payload);
+            if (spare > best_spare || (spare == best_spare && bytes > best_bytes)) {
+                best = (int)i;
+                best_spare = spare;
+                best_bytes = bytes;
+            }
+        }
+        if (best < 0) {
+            fprintf(stderr, "Warning: %.1f MB of rings still exceeds the %.1f MB budget\n",
+                    (double)total / 1048576.0, o->budget_mb);
+            return;
+        }
+        topics[best].new_slots /= 2;
+        if (topics[best].new_slots < topics[best].required) topics[best].under_budget = 1;
+    }
+}
+
+/* --------------------------------------------------------------------------
+ * OUTPUT
+ * -------------------------------------------------------------------------- */
+
+static const char *type_name(uint32_t type) {
+    return type == USRL_RING_TYPE_MWMR ? "mwmr" : "swmr";
+}
+
+static void print_report(const PlanTopic *topics, uint32_t count, const PlanOptions *o) {
+    printf("\n%-24s %-5s %10s %8s %6s %7s %7s %4s %8s | %-17s %-13s %s\n",
+           "TOPIC", "TYPE", "MSG/s", "PEAK/W", "BURST", "AVG_B", "MAX_B",
+           "PUBS", "LAG", "SLOTS", "PAYLOAD", "OVERRUN");
+
+    uint64_t cur = 0, planned = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const PlanTopic *p = &topics[i];
+        cur += topic_bytes(p, p->slots, p->payload);
+        planned += topic_bytes(p, p->new_slots, p->new_payload);
+
+        char slots[32], payload[32];
+        snprintf(slots, sizeof(slots), "%u -> %u", next_power_of_two_u32(p->slots), p->new_slots);
+        snprintf(payload, sizeof(payload), "%u -> %u", p->payload, p->new_payload);
+
+        if (p->messages == 0) {
+            printf("%-24s %-5s %10s %8s %6s %7s %7s %4s %8s | %-17s %-13s %s\n",
+                   p->name, type_name(p->type), "0", "-", "-", "-", "-", "-", "-",
+                   slots, payload, "(no traffic, kept)");
+            continue;
+        }
+
+        double burst = (p->mean_w > 0.0) ? (double)p->peak / p->mean_w : 0.0;
+        double overrun = plan_overrun(p, p->new_slots);
+        char risk[16];
+        if (overrun < 1e-12) snprintf(risk, sizeof(risk), "<1e-12");
+        else snprintf(risk, sizeof(risk), "%.1e", overrun);
+
+        printf("%-24s %-5s %10.0f %8lu %6.1f %7.0f %7u %4u %8lu | %-17s %-13s %s%s%s\n",
+               p->name, type_name(p->type), p->rate, p->peak, burst, p->avg_len,
+               p->max_len, p->pubs, p->lag, slots, payload, risk,
+               p->extrapolated ? " (extrapolated)" : "",
+               p->under_budget ? " (over target: budget)" : "");
+
+        if (p->new_type != p->type)
+            printf("  %s: %s -> %s (%u writers seen)\n", p->name,
+                   type_name(p->type), type_name(p->new_type), p->pubs);
+        else if (p->type == USRL_RING_TYPE_MWMR && p->pubs == 1)
+            printf("  %s: one writer seen, SWMR candidate (--retype)\n", p->name);
+        if (p->fit_payload < p->new_payload)
+            printf("  %s: payload %u would fit the traffic seen (--shrink-payload)\n", p->name,
+                   p->fit_payload);
+        if (p->lapped)
+            printf("  %s: %lu records lapped before they were sampled\n", p->name, p->lapped);
+    }
+
+    printf("\nBURST = PEAK/W over the mean per %.0f us window; OVERRUN = share of windows\n"
+           "a subscriber stalled that long would be lapped (target %.1e).\n",
+           (double)o->stall_ns / 1000.0, o->target);
+    printf("Ring memory: %.1f MB -> %.1f MB", (double)cur / 1048576.0, (double)planned / 1048576.0);
+    if (o->budget_mb > 0.0) printf(" (budget %.1f MB)", o->budget_mb);
+    printf("\n");
+}
+
+static int write_config(const PlanTopic *topics, uint32_t count, uint32_t memory_mb, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    fprintf(f, "{\n  \"memory_size_mb\": %u,\n  \"topics\": [\n", memory_mb);
+    for (uint32_t i = 0; i < count; i++) {
+        const PlanTopic *p = &topics[i];
+        fprintf(f, "    {\n      \"name\": \"%s\",\n      \"slots\": %u,\n"
+                   "      \"payload_size\": %u,\n      \"type\": \"%s\"",
+                p->name, p->new_slots, p->new_payload, type_name(p->new_type));
+        if (p->lanes > 1) fprintf(f, ",\n      \"lanes\": %u", p->lanes);
+        fprintf(f, "\n    }%s\n", (i + 1 < count) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f);
+}
+
+/* Region size for core_loader: layout tables plus rings, 1 MB spare */
+static uint32_t plan_memory_mb(const PlanTopic *topics, uint32_t count) {
+    uint64_t rings = 0, entries = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        rings += topic_bytes(&topics[i], topics[i].new_slots, topics[i].new_payload);
+        entries += topics[i].lanes ? topics[i].lanes : 1;
+    }
+    uint64_t tables = entries * (sizeof(TopicEntry) + sizeof(RingDesc) + sizeof(TopicExt)) + 4 * USRL_ALIGNMENT;
+    uint64_t mb = (rings + tables + 1048575) / 1048576 + 1;
+    return (uint32_t)(mb < 64 ? 64 : mb); /* core_loader minimum */
+}
+
+/* --------------------------------------------------------------------------
+ * TOPICS
+ * -------------------------------------------------------------------------- */
+
+/* Topics from config.json (lanes folded), or every ring in the core */
+static uint32_t load_topics(const char *config, void *base, PlanTopic *topics, uint32_t max) {
+    uint32_t count = 0;
+
+    if (!config) {
+        const CoreHeader *hdr = (const CoreHeader *)base;
+        const TopicEntry *t = (const TopicEntry *)((const uint8_t *)base + hdr->topic_table_offset);
+        for (uint32_t i = 0; i < hdr->topic_count && count < max; i++, count++) {
+            PlanTopic *p = &topics[count];
+            memcpy(p->name, t[i].name, USRL_MAX_TOPIC_NAME);
+            p->slots = t[i].slot_count;
+            p->payload = t[i].slot_size - (uint32_t)sizeof(SlotHeader);
+            p->type = t[i].type;
+            p->lanes = 1;
+        }
+        return count;
+    }
+
+    char *json = read_file(config);
+    if (!json) {
+        fprintf(stderr, "Cannot read %s\n", config);
+        return 0;
+    }
+
+    const char *obj = strstr(json, "\"topics\"");
+    obj = obj ? strchr(obj, '[') : NULL;
+    while (obj && (obj = strchr(obj, '{')) != NULL && count < max) {
+        const char *end = strchr(obj, '}');
+        if (!end) break;
+
+        const char *name = find_key(obj, end, "name");
+        const char *slots = find_key(obj, end, "slots");
+        const char *size = find_key(obj, end, "payload_size");
+        const char *type = find_key(obj, end, "type");
+        const char *lanes = find_key(obj, end, "lanes");
+
+        if (name && slots && size) {
+            PlanTopic *p = &topics[count++];
+            char type_str[16];
+            parse_string_val(name, p->name, USRL_MAX_TOPIC_NAME);
+            p->slots = (uint32_t)atoi(slots);
+            p->payload = (uint32_t)atoi(size);
+            parse_string_val(type, type_str, sizeof(type_str));
+            p->type = (strstr(type_str, "mwmr") || strstr(type_str, "MWMR"))
+                          ? USRL_RING_TYPE_MWMR : USRL_RING_TYPE_SWMR;
+            p->lanes = lanes ? (uint32_t)atoi(lanes) : 1;
+            if (p->lanes < 1) p->lanes = 1;
+            if (p->lanes > USRL_MAX_LANES) p->lanes = USRL_MAX_LANES;
+        }
+        obj = end + 1;
+    }
+
+    free(json);
+    return count;
+}
+
+/* Map each topic (or lane) to its ring in the core */
+static uint32_t bind_rings(void *base, PlanTopic *topics, uint32_t count, RingProfile *rings) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        PlanTopic *p = &topics[i];
+        for (uint32_t l = 0; l < USRL_MAX_LANES; l++) p->ring[l] = -1;
+
+        for (uint32_t l = 0; l < p->lanes; l++) {
+            char name[USRL_MAX_TOPIC_NAME];
+            if (p->lanes > 1) snprintf(name, sizeof(name), USRL_LANE_NAME_FMT, p->name, l);
+            else snprintf(name, sizeof(name), "%s", p->name);
+
+            TopicEntry *t = usrl_get_topic(base, name);
+            if (!t) continue;
+
+            RingProfile *r = &rings[n];
+            memset(r, 0, sizeof(*r));
+            r->t = t;
+            r->d = (RingDesc *)((uint8_t *)base + t->ring_desc_offset);
+            r->ext = usrl_topic_ext(base, t);
+            r->slots = (uint8_t *)base + r->d->base_offset;
+            r->mask = r->d->slot_count - 1;
+            p->ring[l] = (int)n++;
+        }
+        if (p->ring[0] < 0 && (p->lanes <= 1 || p->ring[p->lanes - 1] < 0))
+            fprintf(stderr, "  %s: not in the running core, kept as configured\n", p->name);
+    }
+    return n;
+}
+
+/* --------------------------------------------------------------------------
+ * MAIN
+ * -------------------------------------------------------------------------- */
+
+static void usage(void) {
+    printf("Usage: usrl_plan [config.json] [options]\n");
+    printf("Samples the running core, then writes a right-sized config.\n");
+    printf("Options:\n");
+    printf("  --duration <sec>     Sampling period (default %d)\n", DEFAULT_DURATION_S);
+    printf("  --stall-us <us>      Longest subscriber stall to ride out (default %d)\n", DEFAULT_STALL_US);
+    printf("  --target <p>         Acceptable overrun probability per stall (default %.0e)\n", DEFAULT_TARGET);
+    printf("  --headroom <x>       Slot multiplier over the requirement (default %.2f)\n", DEFAULT_HEADROOM);
+    printf("  --payload-headroom <x>  Payload multiplier over the largest record (default %.2f)\n",
+           DEFAULT_PAYLOAD_HEADROOM);
+    printf("  --shrink-payload     Allow a payload below the configured one\n");
+    printf("  --budget-mb <mb>     Cap on total ring memory\n");
+    printf("  --retype             Turn single-writer MWMR topics into SWMR\n");
+    printf("  --out <path>         Planned config (default %s)\n", DEFAULT_OUT);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    PlanOptions o = {
+        .duration_s = DEFAULT_DURATION_S,
+        .stall_ns = (uint64_t)DEFAULT_STALL_US * 1000,
+        .target = DEFAULT_TARGET,
+        .headroom = DEFAULT_HEADROOM,
+        .payload_headroom = DEFAULT_PAYLOAD_HEADROOM,
+        .out = DEFAULT_OUT,
+    };
+    const char *config = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) o.duration_s = (uint64_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--stall-us") == 0 && i + 1 < argc) o.stall_ns = (uint64_t)atoi(argv[++i]) * 1000;
+        else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc) o.target = atof(argv[++i]);
+        else if (strcmp(argv[i], "--headroom") == 0 && i + 1 < argc) o.headroom = atof(argv[++i]);
+        else if (strcmp(argv[i], "--payload-headroom") == 0 && i + 1 < argc) o.payload_headroom = atof(argv[++i]);
+        else if (strcmp(argv[i], "--shrink-payload") == 0) o.shrink_payload = 1;
+        else if (strcmp(argv[i], "--budget-mb") == 0 && i + 1 < argc) o.budget_mb = atof(argv[++i]);
+        else if (strcmp(argv[i], "--retype") == 0) o.retype = 1;
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) o.out = argv[++i];
+        else if (argv[i][0] != '-' && !config) config = argv[i];
+        else usage();
+    }
+    if (o.duration_s == 0 || o.stall_ns == 0 || o.target <= 0.0 || o.target >= 1.0 || o.headroom < 1.0 ||
+        o.payload_headroom < 1.0)
+        usage();
+
+    void *base = map_system();
+    if (!base) return 1;
+
+    PlanTopic *topics = calloc(MAX_PLAN_TOPICS, sizeof(PlanTopic));
+    RingProfile *rings = calloc((size_t)MAX_PLAN_TOPICS * USRL_MAX_LANES, sizeof(RingProfile));
+    if (!topics || !rings) {
+        fprintf(stderr, "OOM\n");
+        return 1;
+    }
+
+    uint32_t count = load_topics(config, base, topics, MAX_PLAN_TOPICS);
+    if (count == 0) {
+        fprintf(stderr, "No topics to plan.\n");
+        return 1;
+    }
+    uint32_t ring_count = bind_rings(base, topics, count, rings);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    printf("Sampling %u rings (%u topics) for %lu s, stall window %.0f us...\n",
+           ring_count, count, o.duration_s, (double)o.stall_ns / 1000.0);
+    fflush(stdout);
+
+    uint64_t elapsed_ns = 0;
+    profile(rings, ring_count, &o, &elapsed_ns);
+
+    for (uint32_t i = 0; i < count; i++) {
+        plan_profile(&topics[i], rings, elapsed_ns, o.stall_ns);
+        plan_topic(&topics[i], &o);
+    }
+    plan_budget(topics, count, &o);
+    print_report(topics, count, &o);
+
+    int rc = 0;
+    uint32_t memory_mb = plan_memory_mb(topics, count);
+    if (write_config(topics, count, memory_mb, o.out) == 0) {
+        printf("Wrote %s (memory_size_mb %u)\n", o.out, memory_mb);
+    } else {
+        rc = 1;
+    }
+
+    for (uint32_t i = 0; i < ring_count; i++) {
+        free(rings[i].bin[0].counts);
+        free(rings[i].bin[1].counts);
+    }
+    for (uint32_t i = 0; i < count; i++) free(topics[i].counts);
+    free(rings);
+    free(topics);
+    return rc;
+}
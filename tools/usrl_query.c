@@ -0,0 +1,641 @@
+#define _GNU_SOURCE
+#include "usrl_core.h"
+#include "usrl_schema.h"
+#include "usrl_journal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <time.h>
+
+#define MAX_TOPICS 16
+#define MAX_PREDICATES 16
+#define HEX_PREVIEW 32
+#define JOB_WINDOW_PER_THREAD 4     /* segments scanned ahead of the output */
+
+/* --------------------------------------------------------------------------
+ * STATE
+ *
+ * Every (topic, segment) pair is a job. Workers map a segment, apply the
+ * predicates and keep the offsets of matching records; the main thread
+ * emits jobs strictly in order: one topic in seq order, several topics
+ * k-way merged by timestamp. Jobs are ordered by their first timestamp so
+ * the merge consumes them roughly in sequence, and workers stay at most
+ * a window of jobs ahead of the oldest one still held. When the output
+ * needs a job nobody has claimed yet, the main thread scans it inline.
+ * -------------------------------------------------------------------------- */
+
+enum { JOB_FREE, JOB_RUNNING, JOB_DONE, JOB_RELEASED };
+enum { OUT_TEXT, OUT_JSON, OUT_JOURNAL, OUT_COUNT };
+enum { OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE };
+
+typedef struct {
+    const UsrlField *field;
+    int op;
+    int64_t i;              /* integer fields */
+    double f;               /* float fields */
+    char s[256];            /* string / bytes fields */
+} Predicate;
+
+typedef struct {
+    char path[USRL_JOURNAL_PATH_MAX];
+    uint32_t topic;
+    uint64_t first_ns;      /* ordering key */
+    _Atomic int state;
+
+    UsrlJournalSegment seg;
+    int mapped;
+    uint64_t *hits;         /* record offsets */
+    uint32_t hit_count;
+    uint32_t hit_cap;
+    uint64_t last_seq;      /* highest seq in the segment */
+    uint64_t scanned;
+    uint64_t bytes;
+} Job;
+
+typedef struct {
+    const char *topics[MAX_TOPICS];
+    uint32_t topic_count;
+
+    uint64_t from_seq, to_seq;
+    uint64_t from_ns, to_ns;
+    int pub_id;             /* -1 = any */
+    UsrlSchema *schema;
+    Predicate preds[MAX_PREDICATES];
+    uint32_t pred_count;
+
+    Job *jobs;
+    uint32_t job_count;
+    _Atomic uint32_t low;   /* oldest job not released */
+    uint32_t window;
+    atomic_int stop;
+} Query;
+
+typedef struct {
+    uint32_t topic;
+    uint32_t *jobs;         /* indices in seq order */
+    uint32_t job_count;
+    uint32_t pos;           /* current job */
+    uint32_t hit;           /* next hit in it */
+    uint64_t seen;          /* highest seq emitted or covered */
+    const UsrlJournalRecord *rec;
+} Cursor;
+
+/* ---------------------------------------------------------------------------
+ * UTILS
+ * --------------------------------------------------------------------------- */
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(void) {
+    printf("Usage: usrl_query <journal_dir> <topic[,topic...]> [options]\n");
+    printf("Searches recorded journals; several topics are merged by timestamp.\n");
+    printf("Options:\n");
+    printf("  --from-seq <n> --to-seq <n>   Seq range (single topic)\n");
+    printf("  --from-ns <t> --to-ns <t>     Timestamp range (SlotHeader.timestamp_ns)\n");
+    printf("  --pub-id <id>                 Publisher\n");
+    printf("  --schema <f:type[:size],...>  Payload layout (u64 i64 f64 u32 i32 f32 bytes string)\n");
+    printf("  --where <field><op><value>    Field predicate, op one of == != < <= > >= (repeatable)\n");
+    printf("  --format <text|json|count>    Output (default text)\n");
+    printf("  --out <dir> [--out-topic t]   Write matches to a new journal instead\n");
+    printf("  --limit <n>                   Stop after n matches\n");
+    printf("  --threads <n>                 Scan threads (default: online CPUs)\n");
+    exit(1);
+}
+
+/* "price:f64,qty:u32,symbol:string:16" */
+static UsrlSchema *parse_schema(const char *spec) {
+    static const struct { const char *name; UsrlFieldType type; uint32_t size; } types[] = {
+        { "u64", USRL_FIELD_U64, 8 }, { "i64", USRL_FIELD_I64, 8 }, { "f64", USRL_FIELD_F64, 8 },
+        { "u32", USRL_FIELD_U32, 4 }, { "i32", USRL_FIELD_I32, 4 }, { "f32", USRL_FIELD_F32, 4 },
+        { "bytes", USRL_FIELD_BYTES, 0 }, { "string", USRL_FIELD_STRING, 0 },
+    };
+
+    UsrlSchema *sc = usrl_schema_create(1, "query");
+    char *copy = strdup(spec);
+    if (!sc || !copy) return NULL;
+
+    char *save = NULL;
+    for (char *f = strtok_r(copy, ",", &save); f; f = strtok_r(NULL, ",", &save)) {
+        char *type = strchr(f, ':');
+        if (!type) goto bad;
+        *type++ = '\0';
+        char *size = strchr(type, ':');
+        if (size) *size++ = '\0';
+
+        size_t k = 0;
+        while (k < sizeof(types) / sizeof(types[0]) && strcmp(types[k].name, type) != 0) k++;
+        if (k == sizeof(types) / sizeof(types[0])) goto bad;
+        uint32_t n = types[k].size ? types[k].size : (size ? (uint32_t)atoi(size) : 0);
+        if (n == 0 || usrl_schema_add_field(sc, f, types[k].type, n) != 0) goto bad;
+    }
+    if (usrl_schema_finalize(sc) != 0) goto bad;
+    free(copy);
+    return sc;
+
+bad:
+    fprintf(stderr, "Bad schema: %s\n", spec);
+    free(copy);
+    usrl_schema_free(sc);
+    return NULL;
+}
+
+static int parse_predicate(const UsrlSchema *sc, const char *expr, Predicate *p) {
+    static const struct { const char *s; int op; } ops[] = {
+        { "==", OP_EQ }, { "!=", OP_NE }, { "<=", OP_LE }, { ">=", OP_GE },
+        { "<", OP_LT }, { ">", OP_GT }, { "=", OP_EQ },
+    };
+
+    const char *at = NULL;
+    size_t k = 0;
+    for (const char *c = expr; *c && !at; c++) {
+        for (k = 0; k < sizeof(ops) / sizeof(ops[0]); k++) {
+            if (strncmp(c, ops[k].s, strlen(ops[k].s)) == 0) {
+                at = c;
+                break;
+            }
+        }
+    }
+    if (!at || !sc) return -1;
+
+    char name[64];
+    size_t n = (size_t)(at - expr);
+    if (n == 0 || n >= sizeof(name)) return -1;
+    memcpy(name, expr, n);
+    name[n] = '\0';
+
+    memset(p, 0, sizeof(*p));
+    p->field = usrl_schema_field(sc, name);
+    p->op = ops[k].op;
+    const char *value = at + strlen(ops[k].s);
+    if (!p->field) return -1;
+
+    if (usrl_field_numeric(p->field)) {
+        p->i = p->field->type == USRL_FIELD_U64 ? (int64_t)strtoull(value, NULL, 10) : strtoll(value, NULL, 10);
+        p->f = strtod(value, NULL);
+    } else {
+        snprintf(p->s, sizeof(p->s), "%s", value);
+        if (p->op != OP_EQ && p->op != OP_NE) return -1;
+    }
+    return 0;
+}
+
+static inline int compare(int op, int c) {
+    switch (op) {
+    case OP_EQ: return c == 0;
+    case OP_NE: return c != 0;
+    case OP_LT: return c < 0;
+    case OP_LE: return c <= 0;
+    case OP_GT: return c > 0;
+    default: return c >= 0;
+    }
+}
+
+static int match_field(const Predicate *p, const uint8_t *rec) {
+    const UsrlField *f = p->field;
+    int c;
+    if (f->type == USRL_FIELD_F64 || f->type == USRL_FIELD_F32) {
+        double v = usrl_field_f64(f, rec);
+        c = (v > p->f) - (v < p->f);
+    } else if (f->type == USRL_FIELD_U64) {
+        uint64_t v;
+        memcpy(&v, rec + f->offset, 8);
+        c = (v > (uint64_t)p->i) - (v < (uint64_t)p->i);
+    } else if (usrl_field_numeric(f)) {
+        int64_t v = usrl_field_i64(f, rec);
+        c = (v > p->i) - (v < p->i);
+    } else {
+        size_t n = strnlen((const char *)rec + f->offset, f->size);
+        c = (n == strlen(p->s) && memcmp(rec + f->offset, p->s, n) == 0) ? 0 : 1;
+    }
+    return compare(p->op, c);
+}
+
+/* ---------------------------------------------------------------------------
+ * SCAN
+ * --------------------------------------------------------------------------- */
+
+static inline int matches(const Query *q, const UsrlJournalRecord *r) {
+    if (r->timestamp_ns < q->from_ns || r->timestamp_ns > q->to_ns) return 0;
+    if (q->pub_id >= 0 && r->pub_id != (uint16_t)q->pub_id) return 0;
+    if (q->pred_count == 0) return 1;
+    if (r->len < q->schema->total_size) return 0;
+
+    const uint8_t *rec = usrl_jseg_payload(r);
+    for (uint32_t i = 0; i < q->pred_count; i++)
+        if (!match_field(&q->preds[i], rec)) return 0;
+    return 1;
+}
+
+static void scan_job(Query *q, Job *j) {
+    UsrlJournalSegment *s = &j->seg;
+    if (usrl_jseg_open(s, j->path) != 0) {
+        atomic_store_explicit(&j->state, JOB_DONE, memory_order_release);
+        return;
+    }
+    j->mapped = 1;
+
+    const UsrlJournalSegHeader *h = s->hdr;
+    int sealed = h->flags & USRL_JSEG_F_SEALED;
+    j->last_seq = sealed ? h->last_seq : 0;
+
+    /* Sealed headers bound the segment's time range: skip it unopened */
+    if (sealed && h->count && (h->last_ns < q->from_ns || h->first_ns > q->to_ns)) {
+        atomic_store_explicit(&j->state, JOB_DONE, memory_order_release);
+        return;
+    }
+
+    uint64_t off = usrl_jseg_begin(s);
+    if (q->from_seq > h->first_seq) off = usrl_jseg_seek_seq(s, q->from_seq);
+    else if (q->from_ns) off = usrl_jseg_seek_time(s, q->from_ns);
+
+    const UsrlJournalRecord *r;
+    for (; (r = usrl_jseg_record(s, off)) != NULL; off = usrl_jseg_next(r, off)) {
+        if (r->seq > j->last_seq) j->last_seq = r->seq;
+        if (r->seq > q->to_seq) break;
+        if (r->seq < q->from_seq) continue;
+        j->scanned++;
+        j->bytes += r->len;
+        if (!matches(q, r)) continue;
+
+        if (j->hit_count == j->hit_cap) {
+            uint32_t cap = j->hit_cap ? j->hit_cap * 2 : 1024;
+            uint64_t *g = realloc(j->hits, (size_t)cap * sizeof(*g));
+            if (!g) break;
+            j->hits = g;
+            j->hit_cap = cap;
+        }
+        j->hits[j->hit_count++] = off;
+    }
+    atomic_store_explicit(&j->state, JOB_DONE, memory_order_release);
+}
+
+static void *worker_main(void *arg) {
+    Query *q = arg;
+    uint32_t next = 0;
+    while (!atomic_load(&q->stop)) {
+        uint32_t low = atomic_load(&q->low);
+        uint32_t end = low + q->window < q->job_count ? low + q->window : q->job_count;
+        if (next < low) next = low;
+        if (low >= q->job_count) break;
+
+        int ran = 0;
+        for (uint32_t i = next; i < end; i++) {
+            int expected = JOB_FREE;
+            if (atomic_compare_exchange_strong(&q->jobs[i].state, &expected, JOB_RUNNING)) {
+                scan_job(q, &q->jobs[i]);
+                next = i + 1;
+                ran = 1;
+                break;
+            }
+        }
+        if (!ran) {
+            if (next >= q->job_count) break;
+            usleep(100);
+        }
+    }
+    return NULL;
+}
+
+/* Wait for a job, scanning it here if no worker has picked it up */
+static Job *job_get(Query *q, uint32_t idx) {
+    Job *j = &q->jobs[idx];
+    int expected = JOB_FREE;
+    if (atomic_compare_exchange_strong(&j->state, &expected, JOB_RUNNING)) scan_job(q, j);
+    while (atomic_load_explicit(&j->state, memory_order_acquire) != JOB_DONE) usleep(50);
+    return j;
+}
+
+static void job_release(Query *q, uint32_t idx) {
+    Job *j = &q->jobs[idx];
+    if (j->mapped) usrl_jseg_close(&j->seg);
+    free(j->hits);
+    j->hits = NULL;
+    atomic_store(&j->state, JOB_RELEASED);
+
+    uint32_t low = atomic_load(&q->low);
+    while (low < q->job_count && atomic_load(&q->jobs[low].state) == JOB_RELEASED) low++;
+    atomic_store(&q->low, low);
+}
+
+/* ---------------------------------------------------------------------------
+ * PLAN
+ * --------------------------------------------------------------------------- */
+
+/* First timestamp of a segment without mapping it */
+static uint64_t segment_first_ns(const char *path) {
+    uint64_t ns = UINT64_MAX;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return ns;
+
+    UsrlJournalSegHeader h;
+    UsrlJournalRecord r;
+    if (pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && h.magic == USRL_JOURNAL_MAGIC) {
+        if ((h.flags & USRL_JSEG_F_SEALED) && h.count) ns = h.first_ns;
+        else if (pread(fd, &r, sizeof(r), h.hdr_size) == (ssize_t)sizeof(r) && r.seq) ns = r.timestamp_ns;
+    }
+    close(fd);
+    return ns;
+}
+
+static int cmp_job(const void *a, const void *b) {
+    const Job *x = a, *y = b;
+    if (x->first_ns != y->first_ns) return (x->first_ns > y->first_ns) - (x->first_ns < y->first_ns);
+    if (x->topic != y->topic) return (x->topic > y->topic) - (x->topic < y->topic);
+    return strcmp(x->path, y->path);
+}
+
+static int plan_jobs(Query *q, const char *dir) {
+    uint32_t cap = 0;
+    for (uint32_t t = 0; t < q->topic_count; t++) {
+        int n = usrl_journal_list(dir, q->topics[t], NULL, 0);
+        if (n < 0) return -1;
+        UsrlJournalSegInfo *segs = malloc((n > 0 ? (size_t)n : 1) * sizeof(*segs));
+        if (!segs) return -1;
+        n = usrl_journal_list(dir, q->topics[t], segs, (uint32_t)n);
+
+        for (int i = 0; i < n; i++) {
+            /* A segment covers first_seq up to the next segment's first_seq */
+            if (i + 1 < n && segs[i + 1].first_seq <= q->from_seq) continue;
+            if (segs[i].first_seq > q->to_seq) break;
+
+            if (q->job_count == cap) {
+                cap = cap ? cap * 2 : 256;
+                Job *g = realloc(q->jobs, (size_t)cap * sizeof(*g));
+                if (!g) {
+                    free(segs);
+                    return -1;
+                }
+                q->jobs = g;
+            }
+            Job *j = &q->jobs[q->job_count++];
+            memset(j, 0, sizeof(*j));
+            memcpy(j->path, segs[i].path, sizeof(j->path));
+            j->topic = t;
+            j->first_ns = segment_first_ns(segs[i].path);
+        }
+        free(segs);
+    }
+
+    /* Segments of one topic keep seq order (paths sort by first_seq) */
+    if (q->topic_count > 1) qsort(q->jobs, q->job_count, sizeof(Job), cmp_job);
+    for (uint32_t i = 0; i < q->job_count; i++) atomic_init(&q->jobs[i].state, JOB_FREE);
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * OUTPUT
+ * --------------------------------------------------------------------------- */
+
+/* Next unseen match of a topic in seq order, or NULL when exhausted */
+static const UsrlJournalRecord *cursor_next(Query *q, Cursor *c) {
+    while (c->pos < c->job_count) {
+        uint32_t idx = c->jobs[c->pos];
+        Job *j = job_get(q, idx);
+        while (c->hit < j->hit_count) {
+            const UsrlJournalRecord *r = usrl_jseg_record(&j->seg, j->hits[c->hit++]);
+            if (r && r->seq > c->seen) return r;
+        }
+        /* Seqs this segment covered are done: a later duplicate is skipped */
+        if (j->last_seq > c->seen) c->seen = j->last_seq;
+        job_release(q, idx);
+        c->pos++;
+        c->hit = 0;
+    }
+    return NULL;
+}
+
+static void print_hex(FILE *out, const uint8_t *p, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) fprintf(out, "%02x", p[i]);
+}
+
+static void print_json_str(FILE *out, const char *p, int n) {
+    fputc('"', out);
+    for (int i = 0; i < n; i++) {
+        unsigned char ch = (unsigned char)p[i];
+        if (ch == '"' || ch == '\\') fprintf(out, "\\%c", ch);
+        else if (ch < 0x20) fprintf(out, "\\u%04x", ch);
+        else fputc(ch, out);
+    }
+    fputc('"', out);
+}
+
+static void print_fields(FILE *out, const UsrlSchema *sc, const uint8_t *rec, int json) {
+    for (uint32_t i = 0; i < sc->field_count; i++) {
+        const UsrlField *f = &sc->fields[i];
+        fprintf(out, json ? ",\"%s\":" : " %s=", f->name);
+        switch (f->type) {
+        case USRL_FIELD_F64:
+        case USRL_FIELD_F32: fprintf(out, "%.15g", usrl_field_f64(f, rec)); break;
+        case USRL_FIELD_U64: { uint64_t v; memcpy(&v, rec + f->offset, 8); fprintf(out, "%" PRIu64, v); break; }
+        case USRL_FIELD_STRING: {
+            int n = (int)strnlen((const char *)rec + f->offset, f->size);
+            if (json) print_json_str(out, (const char *)rec + f->offset, n);
+            else fprintf(out, "%.*s", n, (const char *)rec + f->offset);
+            break;
+        }
+        case USRL_FIELD_BYTES:
+            if (json) fputc('"', out);
+            print_hex(out, rec + f->offset, f->size);
+            if (json) fputc('"', out);
+            break;
+        default: fprintf(out, "%" PRId64, usrl_field_i64(f, rec)); break;
+        }
+    }
+}
+
+static void emit(const Query *q, FILE *out, int format, uint32_t topic, const UsrlJournalRecord *r) {
+    const uint8_t *payload = usrl_jseg_payload(r);
+    int decoded = q->schema && r->len >= q->schema->total_size;
+    uint32_t preview = r->len < HEX_PREVIEW ? r->len : HEX_PREVIEW;
+
+    if (format == OUT_JSON) {
+        fputs("{\"topic\":", out);
+        print_json_str(out, q->topics[topic], (int)strlen(q->topics[topic]));
+        fprintf(out, ",\"seq\":%" PRIu64 ",\"ts\":%" PRIu64 ",\"pub_id\":%u,\"len\":%u",
+                r->seq, r->timestamp_ns, r->pub_id, r->len);
+        if (decoded) {
+            print_fields(out, q->schema, payload, 1);
+        } else {
+            fputs(",\"hex\":\"", out);
+            print_hex(out, payload, preview);
+            fputc('"', out);
+        }
+        fputs("}\n", out);
+    } else {
+        fprintf(out, "%-12s seq=%-12" PRIu64 " ts=%-20" PRIu64 " pub=%-4u len=%-6u",
+                q->topics[topic], r->seq, r->timestamp_ns, r->pub_id, r->len);
+        if (decoded) {
+            print_fields(out, q->schema, payload, 0);
+        } else {
+            fputc(' ', out);
+            print_hex(out, payload, preview);
+            if (r->len > preview) fputs("...", out);
+        }
+        fputc('\n', out);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * MAIN
+ * --------------------------------------------------------------------------- */
+
+int main(int argc, char **argv) {
+    if (argc < 3) usage();
+    const char *dir = argv[1];
+
+    static Query q;
+    q.to_seq = UINT64_MAX;
+    q.to_ns = UINT64_MAX;
+    q.pub_id = -1;
+
+    char *topics = strdup(argv[2]);
+    char *save = NULL;
+    for (char *t = strtok_r(topics, ",", &save); t && q.topic_count < MAX_TOPICS; t = strtok_r(NULL, ",", &save))
+        q.topics[q.topic_count++] = t;
+    if (q.topic_count == 0) usage();
+
+    int format = OUT_TEXT;
+    const char *out_dir = NULL, *out_topic = NULL;
+    const char *wheres[MAX_PREDICATES];
+    uint32_t where_count = 0;
+    uint64_t limit = UINT64_MAX;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--from-seq") == 0 && i + 1 < argc) q.from_seq = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--to-seq") == 0 && i + 1 < argc) q.to_seq = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--from-ns") == 0 && i + 1 < argc) q.from_ns = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--to-ns") == 0 && i + 1 < argc) q.to_ns = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--pub-id") == 0 && i + 1 < argc) q.pub_id = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--schema") == 0 && i + 1 < argc) {
+            if (!(q.schema = parse_schema(argv[++i]))) return 1;
+        }
+        else if (strcmp(argv[i], "--where") == 0 && i + 1 < argc && where_count < MAX_PREDICATES) wheres[where_count++] = argv[++i];
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char *f = argv[++i];
+            if (strcmp(f, "json") == 0) format = OUT_JSON;
+            else if (strcmp(f, "count") == 0) format = OUT_COUNT;
+            else if (strcmp(f, "text") == 0) format = OUT_TEXT;
+            else usage();
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) out_dir = argv[++i];
+        else if (strcmp(argv[i], "--out-topic") == 0 && i + 1 < argc) out_topic = argv[++i];
+        else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) limit = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else usage();
+    }
+    if (threads < 1) threads = 1;
+    if (q.topic_count > 1 && (q.from_seq || q.to_seq != UINT64_MAX)) {
+        fprintf(stderr, "Seq ranges apply to a single topic.\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < where_count; i++) {
+        if (parse_predicate(q.schema, wheres[i], &q.preds[q.pred_count++]) != 0) {
+            fprintf(stderr, "Bad predicate '%s' (needs --schema and a known field)\n", wheres[i]);
+            return 1;
+        }
+    }
+
+    /* Merged topics get fresh seqs in the output journal */
+    UsrlJournalWriter w;
+    if (out_dir) {
+        format = OUT_JOURNAL;
+        if (!out_topic) out_topic = q.topic_count > 1 ? "merged" : q.topics[0];
+        if (usrl_journal_writer_open(&w, out_dir, out_topic, 0) != 0) {
+            perror("usrl_journal_writer_open");
+            return 1;
+        }
+    }
+
+    if (plan_jobs(&q, dir) != 0) {
+        perror("usrl_journal_list");
+        return 1;
+    }
+    q.window = (uint32_t)threads * JOB_WINDOW_PER_THREAD;
+
+    Cursor cursors[MAX_TOPICS];
+    memset(cursors, 0, sizeof(cursors));
+    for (uint32_t t = 0; t < q.topic_count; t++) {
+        cursors[t].topic = t;
+        cursors[t].jobs = malloc((q.job_count ? q.job_count : 1) * sizeof(uint32_t));
+        if (!cursors[t].jobs) return 1;
+    }
+    for (uint32_t i = 0; i < q.job_count; i++) {
+        Cursor *c = &cursors[q.jobs[i].topic];
+        c->jobs[c->job_count++] = i;
+    }
+
+    uint64_t t0 = mono_ns();
+    pthread_t *tids = calloc((size_t)threads, sizeof(pthread_t));
+    long started = 0;
+    while (tids && started < threads && pthread_create(&tids[started], NULL, worker_main, &q) == 0) started++;
+
+    /* k-way merge by timestamp (one topic: plain seq order) */
+    for (uint32_t t = 0; t < q.topic_count; t++) cursors[t].rec = cursor_next(&q, &cursors[t]);
+
+    FILE *out = stdout;
+    uint64_t matched = 0, next_seq = out_dir ? w.last_seq : 0;
+    int rc = 0;
+    while (matched < limit) {
+        Cursor *best = NULL;
+        for (uint32_t t = 0; t < q.topic_count; t++) {
+            Cursor *c = &cursors[t];
+            if (c->rec && (!best || c->rec->timestamp_ns < best->rec->timestamp_ns)) best = c;
+        }
+        if (!best) break;
+
+        const UsrlJournalRecord *r = best->rec;
+        if (format == OUT_JOURNAL) {
+            uint64_t seq = q.topic_count > 1 ? ++next_seq : r->seq;
+            if (usrl_journal_append_traced(&w, seq, r->timestamp_ns, r->pub_id, r->flags,
+                                           usrl_jrec_trailer(r), usrl_jseg_payload(r), r->len) != 0) {
+                perror("usrl_journal_append");
+                rc = 1;
+                break;
+            }
+        } else if (format != OUT_COUNT) {
+            emit(&q, out, format, best->topic, r);
+        }
+        matched++;
+        best->seen = r->seq;
+        best->rec = cursor_next(&q, best);
+    }
+
+    atomic_store(&q.stop, 1);
+    for (long i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    double s = (double)(mono_ns() - t0) / 1e9;
+    fflush(out);
+
+    uint64_t scanned = 0, bytes = 0;
+    for (uint32_t i = 0; i < q.job_count; i++) {
+        scanned += q.jobs[i].scanned;
+        bytes += q.jobs[i].bytes;
+        if (atomic_load(&q.jobs[i].state) != JOB_RELEASED) {
+            if (q.jobs[i].mapped) usrl_jseg_close(&q.jobs[i].seg);
+            free(q.jobs[i].hits);
+        }
+    }
+    if (format == OUT_JOURNAL) usrl_journal_writer_close(&w);
+    if (format == OUT_COUNT) printf("%" PRIu64 "\n", matched);
+
+    fprintf(stderr, "%" PRIu64 " matches, %" PRIu64 " records scanned (%.1f MB) in %u segments, "
+            "%.3f s, %ld threads\n", matched, scanned, (double)bytes / (1024.0 * 1024.0),
+            q.job_count, s, started);
+
+    for (uint32_t t = 0; t < q.topic_count; t++) free(cursors[t].jobs);
+    free(tids);
+    free(q.jobs);
+    if (q.schema) usrl_schema_free(q.schema);
+    free(topics);
+    return rc;
+}
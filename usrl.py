@@ -62,9 +62,18 @@ class UsrlPubConfig(Structure):
 class UsrlHealth(Structure):
     _fields_ = [
         ("operations", c_uint64), ("errors", c_uint64),
-        ("rate_hz", c_uint64), ("lag", c_uint64), ("healthy", c_bool)
+        ("rate_hz", c_uint64), ("lag", c_uint64), ("healthy", c_bool),
+        ("expired", c_uint64)
     ]
 
+class UsrlIntern(Structure):
+    _fields_ = [
+        ("hdr", c_void_p), ("entries", c_void_p), ("index", c_void_p),
+        ("mask", c_uint32), ("map_size", c_size_t)
+    ]
+
+USRL_INTERN_INVALID = 0xFFFFFFFF
+
 # Opaque Handles
 UsrlCtxPtr = c_void_p
 UsrlPubPtr = c_void_p
@@ -104,12 +113,29 @@ _lib.usrl_sub_create.restype = UsrlSubPtr
 _lib.usrl_sub_recv.argtypes = [UsrlSubPtr, c_void_p, c_uint32]
 _lib.usrl_sub_recv.restype = c_int
 
+_lib.usrl_sub_set_ttl.argtypes = [UsrlSubPtr, c_uint64]
+_lib.usrl_sub_set_ttl.restype = None
+
 _lib.usrl_sub_get_health.argtypes = [UsrlSubPtr, POINTER(UsrlHealth)]
 _lib.usrl_sub_get_health.restype = None
 
 _lib.usrl_sub_destroy.argtypes = [UsrlSubPtr]
 _lib.usrl_sub_destroy.restype = None
 
+# Symbol interning
+_lib.usrl_intern_create.argtypes = [c_char_p, c_uint32]
+_lib.usrl_intern_create.restype = c_int
+_lib.usrl_intern_open.argtypes = [POINTER(UsrlIntern), c_char_p]
+_lib.usrl_intern_open.restype = c_int
+_lib.usrl_intern_close.argtypes = [POINTER(UsrlIntern)]
+_lib.usrl_intern_close.restype = None
+_lib.usrl_intern_id.argtypes = [POINTER(UsrlIntern), c_char_p, c_uint32]
+_lib.usrl_intern_id.restype = c_uint32
+_lib.usrl_intern_lookup.argtypes = [POINTER(UsrlIntern), c_char_p, c_uint32]
+_lib.usrl_intern_lookup.restype = c_uint32
+_lib.usrl_intern_name.argtypes = [POINTER(UsrlIntern), c_uint32]
+_lib.usrl_intern_name.restype = c_char_p
+
 # Optional schema validation (if exported)
 if hasattr(_lib, 'usrl_schema_validate'):
     _lib.usrl_schema_validate.argtypes = [c_void_p, c_char_p, c_void_p, c_uint32]
@@ -306,12 +332,17 @@ class Subscriber:
             return None
         return None
 
+    def set_ttl(self, max_age_sec):
+        """Skip messages older than max_age_sec (0 disables)."""
+        _lib.usrl_sub_set_ttl(self._handle, int(max_age_sec * 1e9))
+
     def stats(self):
         h = UsrlHealth()
         _lib.usrl_sub_get_health(self._handle, byref(h))
         return {
             "ops": int(h.operations), "skips": int(h.errors),
-            "lag": int(h.lag), "healthy": bool(h.healthy)
+            "lag": int(h.lag), "healthy": bool(h.healthy),
+            "expired": int(h.expired)
         }
 
     def destroy(self):
@@ -326,5 +357,75 @@ class Subscriber:
             pass
 
 
+class SymbolTable:
+    """Shared symbol <-> dense id table (usrl_intern.h)."""
+
+    def __init__(self, path="/usrl-symbols", capacity=65536):
+        self._path_b = path.encode('utf-8')
+        if _lib.usrl_intern_create(self._path_b, int(capacity)) < 0:
+            raise RuntimeError(f"Failed to create symbol table {path}")
+        self._t = UsrlIntern()
+        if _lib.usrl_intern_open(byref(self._t), self._path_b) != 0:
+            raise RuntimeError(f"Failed to open symbol table {path}")
+
+    def id(self, symbol):
+        """Return the dense id for symbol, assigning one on first use."""
+        b = symbol.encode('utf-8')
+        v = _lib.usrl_intern_id(byref(self._t), b, len(b))
+        return None if v == USRL_INTERN_INVALID else int(v)
+
+    def lookup(self, symbol):
+        b = symbol.encode('utf-8')
+        v = _lib.usrl_intern_lookup(byref(self._t), b, len(b))
+        return None if v == USRL_INTERN_INVALID else int(v)
+
+    def name(self, sym_id):
+        n = _lib.usrl_intern_name(byref(self._t), int(sym_id))
+        return n.decode('utf-8') if n else None
+
+    def close(self):
+        if getattr(self, "_t", None) is not None and self._t.hdr:
+            _lib.usrl_intern_close(byref(self._t))
+
+    def __del__(self):
+        try:
+            self.close()
+        except Exception:
+            pass
+
+
+_IND_HDR = "<QQIHH16s"
+_IND_HDR_SIZE = 40
+
+
+def unpack_indicators(buf):
+    """Decode a UsrlIndRecord (usrl_indicators.h) into a dict."""
+    import struct
+    ts, samples, key_id, count, warm, key = struct.unpack_from(_IND_HDR, buf, 0)
+    values = struct.unpack_from(f"<{count}d", buf, _IND_HDR_SIZE)
+    return {
+        "ts": ts,
+        "samples": samples,
+        "key_id": key_id,
+        "key": key.split(b"\0", 1)[0].decode("utf-8", "replace"),
+        "warm": [bool(warm >> i & 1) for i in range(count)],
+        "values": list(values),
+    }
+
+
+_BAR_FMT = "<QQII16s6d"
+
+
+def unpack_bar(buf):
+    """Decode a UsrlBar (usrl_window.h) into a dict."""
+    import struct
+    start, end, key_id, count, key, o, h, l, c, v, vwap = struct.unpack_from(_BAR_FMT, buf, 0)
+    return {
+        "start_ns": start, "end_ns": end, "key_id": key_id, "count": count,
+        "key": key.split(b"\0", 1)[0].decode("utf-8", "replace"),
+        "open": o, "high": h, "low": l, "close": c, "volume": v, "vwap": vwap,
+    }
+
+
 if __name__ == "__main__":
     print("USRL Python Bindings Loaded")